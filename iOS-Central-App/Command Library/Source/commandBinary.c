@@ -0,0 +1,600 @@
+/*********************************************************************************
+*
+*                          Proprietary Information of
+*
+*                            Precision Systems, Inc.
+*                    1355 Business Center Drive, Suite C
+*                                 Horsham, PA
+*                               (215) 672-1860
+*
+*                   Copyright (C) 2020, Precision Systems, Inc.
+*                            All Rights Reserved
+*
+*             The information and design as detailed in this document is
+*     the property of Precision Systems, Inc., and/or its Associates
+*     and must be returned on demand. It is issued on the strict
+*     condition that except with our written permission it must not be
+*     reproduced, copied or communicated to any third party, nor be
+*     used for any purpose other than that stated in the particular
+*     inquiry, order or contract with which it is issued. The
+*     reservation of copyright in this document extends from each date
+*     appearing thereon and in respect of the subject matter as it
+*     appeared at the relevant date.
+*
+********************************************************************************/
+/********************************************************************************
+*
+* PROJECT:     Project MIDAS
+*
+* COMPILER:    
+*
+* TOOLS:       Microsoft Visual Studio 2019
+*
+* DESCRIPTION: Binary ("PH+B") payload encoding
+*
+* NOTES:       Record tag ids are the position of the tag in m_pszTags plus
+*              one, the same as EParamTag. Both are expanded from TAG_SCHEMA.
+*              They are sent over the link, so new tags are only ever added
+*              at the end of the schema.
+*
+********************************************************************************/
+#include <string.h>
+#include "commandAtomic.h"
+#include "commandBinary.h"
+#include "commandBuilder.h"
+
+/********************************************************************************
+*                          D E F I N I T I O N S
+********************************************************************************/
+#define VARINT_BITS        7
+#define VARINT_MORE        0x80
+#define VARINT_MASK        0x7F
+
+// tag hash table, 2^TAG_HASH_BITS slots
+#define TAG_HASH_BITS       7
+#define TAG_HASH_SIZE       (1 << TAG_HASH_BITS)
+// chosen so every tag in m_pszTags has its own slot
+#define TAG_HASH_MULTIPLIER 0x0DD35FE9u
+// slot shared by tags appended since, searched instead
+#define TAG_SLOT_SHARED     0xFF
+
+// m_pszTags entry expanded from TAG_SCHEMA
+#define SCHEMA_TAG_TEXT(eTag, szTag) szTag,
+
+// states of m_nTagSlots
+#define TAG_SLOTS_EMPTY     0
+#define TAG_SLOTS_BUILDING  1
+#define TAG_SLOTS_BUILT     2
+
+/*********************************************************************************
+*                               D A T A
+*********************************************************************************/
+// parameter tags in tag id order, from TAG_SCHEMA
+static const char* const m_pszTags[] =
+{
+   TAG_SCHEMA(SCHEMA_TAG_TEXT)
+};
+
+#define BINARY_TAG_COUNT (sizeof(m_pszTags) / sizeof(m_pszTags[0]))
+
+// fails to compile if m_pszTags and EParamTag don't match
+typedef char TagTableCheck[(BINARY_TAG_COUNT == ETagMax - 1) ? 1 : -1];
+
+// tag id of the tag hashed to each slot, 0 if none
+static uint8_t m_nTagSlots[TAG_HASH_SIZE];
+
+// TAG_SLOTS_xxx, m_nTagSlots may only be read once it is TAG_SLOTS_BUILT
+static volatile uint8_t m_nTagSlotsState = TAG_SLOTS_EMPTY;
+
+/*********************************************************************************
+*                    F U N C T I O N   D E F I N I T I O N S
+*********************************************************************************/
+/********************************************************************************
+ *
+ * Name:    IsBinaryPayload
+ *
+ * Purpose: Checks for the binary payload header
+ *
+ * Inputs:  pData   - payload bytes
+ *          nLength - number of bytes in pData
+ *
+ * Outputs: None
+ *
+ * Returns: true if the payload is binary
+ *
+ * Notes:   ASCII payloads start with a digit, "RSP" or ACK/NAK, so the
+ *          header can't be mistaken for one.
+ *
+ *******************************************************************************/
+LIB_API
+bool IsBinaryPayload(const char* pData, size_t nLength)
+{
+   return pData != NULL
+       && nLength >= BINARY_HEADER_LENGTH
+       && memcmp(pData, HEADER_BIN, BINARY_MARKER_LENGTH) == 0;
+}
+
+/********************************************************************************
+ *
+ * Name:    BinaryReadHeader
+ *
+ * Purpose: Reads the binary payload header
+ *
+ * Inputs:  pReader - binary payload, advanced to the first record
+ *
+ * Outputs: peCode  - command code
+ *          pnFlags - flags byte, may be NULL
+ *
+ * Returns: true if the header was read
+ *
+ * Notes:   The command code isn't range checked here.
+ *
+ *******************************************************************************/
+LIB_API
+bool BinaryReadHeader(FrameView* pReader, ECommandCode* peCode, uint8_t* pnFlags)
+{
+   bool bRead = IsBinaryPayload(pReader->pData, pReader->nLength);
+
+   if (bRead)
+   {
+      *peCode = (ECommandCode)(uint8_t)pReader->pData[BINARY_MARKER_LENGTH];
+
+      if (pnFlags != NULL)
+      {
+         *pnFlags = (uint8_t)pReader->pData[BINARY_MARKER_LENGTH + 1];
+      }
+
+      pReader->pData   += BINARY_HEADER_LENGTH;
+      pReader->nLength -= BINARY_HEADER_LENGTH;
+   }
+
+   return bRead;
+}
+
+/********************************************************************************
+ *
+ * Name:    BinaryNextRecord
+ *
+ * Purpose: Reads the next record
+ *
+ * Inputs:  pReader - remaining records, advanced past the record
+ *
+ * Outputs: pRecord - tag and value of the record
+ *
+ * Returns: true if a complete record was read
+ *
+ * Notes:   A record cut short by the end of the payload is not read and the
+ *          reader is left where it was. Unknown tag ids give an empty name.
+ *
+ *******************************************************************************/
+LIB_API
+bool BinaryNextRecord(FrameView* pReader, BinaryRecord* pRecord)
+{
+   FrameView value      = { NULL, 0 };
+   FrameView name       = { NULL, 0 };
+   const char* pszName  = NULL;
+   size_t nRecordLength = 0;
+   bool bRead           = false;
+
+   // tag id and value length, then the value
+   if (pReader->nLength >= 2
+   && (uint8_t)pReader->pData[1] <= pReader->nLength - 2)
+   {
+      value.pData   = pReader->pData + 2;
+      value.nLength = (uint8_t)pReader->pData[1];
+      name.pData    = value.pData;
+      bRead         = true;
+
+      if ((uint8_t)pReader->pData[0] == BINARY_TAG_NAMED)
+      {
+         // name length and name come first in the value
+         bRead = BinaryReadString(&value, &name);
+      }
+      else
+      {
+         pszName = BinaryTagName((uint8_t)pReader->pData[0]);
+
+         if (pszName != NULL)
+         {
+            name.pData   = pszName;
+            name.nLength = strlen(pszName);
+         }
+      }
+   }
+
+   if (bRead)
+   {
+      pRecord->nTagId = (uint8_t)pReader->pData[0];
+      pRecord->name   = name;
+      pRecord->value  = value;
+
+      nRecordLength     = 2 + (size_t)(uint8_t)pReader->pData[1];
+      pReader->pData   += nRecordLength;
+      pReader->nLength -= nRecordLength;
+   }
+
+   return bRead;
+}
+
+/********************************************************************************
+ *
+ * Name:    TagHash
+ *
+ * Purpose: Hashes a parameter tag to its slot
+ *
+ * Inputs:  pTag    - tag text, not NULL terminated
+ *          nLength - number of bytes in pTag, 2 or more
+ *
+ * Outputs: None
+ *
+ * Returns: Slot number, under TAG_HASH_SIZE
+ *
+ * Notes:   The first two bytes, the last byte and the length are enough to
+ *          tell every tag apart. Multiplying mixes them into the top bits.
+ *
+ *******************************************************************************/
+static size_t TagHash(const char* pTag, size_t nLength)
+{
+   uint32_t nKey = (uint32_t)(uint8_t)pTag[0]
+                 | ((uint32_t)(uint8_t)pTag[1] << 8)
+                 | ((uint32_t)(uint8_t)pTag[nLength - 1] << 16)
+                 | ((uint32_t)(nLength & 0xFF) << 24);
+
+   return (size_t)((uint32_t)(nKey * TAG_HASH_MULTIPLIER) >> (32 - TAG_HASH_BITS));
+}
+
+/********************************************************************************
+ *
+ * Name:    BuildTagSlots
+ *
+ * Purpose: Fills the tag hash table from m_pszTags
+ *
+ * Inputs:  None
+ *
+ * Outputs: None
+ *
+ * Returns: None
+ *
+ * Notes:   The first caller builds the table, any other thread that gets
+ *          here meanwhile waits for it; the build takes a few microseconds.
+ *          If a tag added later shares a slot, the slot is marked and those
+ *          tags are found by searching, so lookups stay correct until
+ *          TAG_HASH_MULTIPLIER is chosen again.
+ *
+ *******************************************************************************/
+static void BuildTagSlots(void)
+{
+   uint8_t nState = TAG_SLOTS_EMPTY;
+   size_t nIdx    = 0;
+   size_t nSlot   = 0;
+
+   if (COMPARE_EXCHANGE(m_nTagSlotsState, nState, TAG_SLOTS_BUILDING))
+   {
+      for (nIdx = 0; nIdx < BINARY_TAG_COUNT; nIdx++)
+      {
+         nSlot = TagHash(m_pszTags[nIdx], strlen(m_pszTags[nIdx]));
+         m_nTagSlots[nSlot] = (m_nTagSlots[nSlot] == 0) ? (uint8_t)(nIdx + 1) : TAG_SLOT_SHARED;
+      }
+
+      STORE_RELEASE(m_nTagSlotsState, TAG_SLOTS_BUILT);
+   }
+
+   while (LOAD_ACQUIRE(m_nTagSlotsState) != TAG_SLOTS_BUILT)
+   {
+      // another thread is building it
+   }
+}
+
+/********************************************************************************
+ *
+ * Name:    ParamTagLookup
+ *
+ * Purpose: Maps parameter tag text to its id
+ *
+ * Inputs:  pTag    - tag text, not NULL terminated
+ *          nLength - number of bytes in pTag
+ *
+ * Outputs: None
+ *
+ * Returns: Tag id, ETagNone if the text isn't a parameter tag
+ *
+ * Notes:   One hash and one compare, whatever the number of tags.
+ *
+ *******************************************************************************/
+LIB_API
+EParamTag ParamTagLookup(const char* pTag, size_t nLength)
+{
+   EParamTag eTag  = ETagNone;
+   uint8_t nTagId  = 0;
+   size_t nIdx     = 0;
+
+   if (pTag != NULL && nLength >= 2 && nLength <= 0xFF)
+   {
+      if (LOAD_ACQUIRE(m_nTagSlotsState) != TAG_SLOTS_BUILT)
+      {
+         BuildTagSlots();
+      }
+
+      nTagId = m_nTagSlots[TagHash(pTag, nLength)];
+
+      if (nTagId == TAG_SLOT_SHARED)
+      {
+         for (nIdx = 0; nIdx < BINARY_TAG_COUNT && eTag == ETagNone; nIdx++)
+         {
+            if (strlen(m_pszTags[nIdx]) == nLength
+            &&  memcmp(m_pszTags[nIdx], pTag, nLength) == 0)
+            {
+               eTag = (EParamTag)(nIdx + 1);
+            }
+         }
+      }
+      else if (nTagId != 0
+           &&  strlen(m_pszTags[nTagId - 1]) == nLength
+           &&  memcmp(m_pszTags[nTagId - 1], pTag, nLength) == 0)
+      {
+         eTag = (EParamTag)nTagId;
+      }
+   }
+
+   return eTag;
+}
+
+/********************************************************************************
+ *
+ * Name:    BinaryTagId
+ *
+ * Purpose: Looks up the record tag id of a parameter tag
+ *
+ * Inputs:  pszTag - parameter tag
+ *
+ * Outputs: None
+ *
+ * Returns: Tag id, BINARY_TAG_NAMED if the tag has no id
+ *
+ * Notes:   None.
+ *
+ *******************************************************************************/
+LIB_API
+uint8_t BinaryTagId(const char* pszTag)
+{
+   EParamTag eTag = ETagNone;
+
+   if (pszTag != NULL)
+   {
+      eTag = ParamTagLookup(pszTag, strlen(pszTag));
+   }
+
+   return (eTag != ETagNone) ? (uint8_t)eTag : BINARY_TAG_NAMED;
+}
+
+/********************************************************************************
+ *
+ * Name:    BinaryTagName
+ *
+ * Purpose: Looks up the parameter tag of a record tag id
+ *
+ * Inputs:  nTagId - record tag id
+ *
+ * Outputs: None
+ *
+ * Returns: Parameter tag, NULL if the id is unknown
+ *
+ * Notes:   None.
+ *
+ *******************************************************************************/
+LIB_API
+const char* BinaryTagName(uint8_t nTagId)
+{
+   const char* pszName = NULL;
+
+   if (nTagId >= 1 && nTagId <= BINARY_TAG_COUNT)
+   {
+      pszName = m_pszTags[nTagId - 1];
+   }
+
+   return pszName;
+}
+
+/********************************************************************************
+ *
+ * Name:    BinaryEncodeInt
+ *
+ * Purpose: Encodes an integer record value
+ *
+ * Inputs:  nValue - value to encode
+ *
+ * Outputs: pBytes - value bytes
+ *
+ * Returns: Number of bytes written
+ *
+ * Notes:   Bytes are dropped from the top while the byte below still
+ *          carries the sign, so 100 takes one byte and 200 takes two.
+ *
+ *******************************************************************************/
+LIB_API
+size_t BinaryEncodeInt(int nValue, uint8_t* pBytes)
+{
+   uint32_t nBits   = (uint32_t)nValue;
+   size_t nLength   = BINARY_INT_BYTES;
+   size_t nIdx      = 0;
+
+   for (nIdx = 0; nIdx < BINARY_INT_BYTES; nIdx++)
+   {
+      pBytes[nIdx] = (uint8_t)(nBits >> (8 * nIdx));
+   }
+
+   while (nLength > 1)
+   {
+      // top byte is only sign extension of the one below
+      if ((pBytes[nLength - 1] == 0x00 && (pBytes[nLength - 2] & 0x80) == 0)
+      ||  (pBytes[nLength - 1] == 0xFF && (pBytes[nLength - 2] & 0x80) != 0))
+      {
+         nLength--;
+      }
+      else
+      {
+         break;
+      }
+   }
+
+   return nLength;
+}
+
+/********************************************************************************
+ *
+ * Name:    BinaryValueToInt
+ *
+ * Purpose: Decodes an integer record value
+ *
+ * Inputs:  pValue - record value
+ *
+ * Outputs: None
+ *
+ * Returns: Decoded value
+ *
+ * Notes:   Bytes past BINARY_INT_BYTES are ignored.
+ *
+ *******************************************************************************/
+LIB_API
+int BinaryValueToInt(const FrameView* pValue)
+{
+   const uint8_t* pBytes = (const uint8_t*)pValue->pData;
+   size_t nLength        = pValue->nLength;
+   uint32_t nBits        = 0;
+   size_t nIdx           = 0;
+
+   if (nLength > BINARY_INT_BYTES)
+   {
+      nLength = BINARY_INT_BYTES;
+   }
+
+   if (nLength > 0)
+   {
+      for (nIdx = 0; nIdx < nLength; nIdx++)
+      {
+         nBits |= (uint32_t)pBytes[nIdx] << (8 * nIdx);
+      }
+
+      // sign extend from the top byte sent
+      if (nLength < BINARY_INT_BYTES && (pBytes[nLength - 1] & 0x80) != 0)
+      {
+         nBits |= 0xFFFFFFFFu << (8 * nLength);
+      }
+   }
+
+   return (int)nBits;
+}
+
+/********************************************************************************
+ *
+ * Name:    BinaryEncodeVarint
+ *
+ * Purpose: Encodes a list item integer
+ *
+ * Inputs:  nValue - value to encode
+ *
+ * Outputs: pBytes - value bytes
+ *
+ * Returns: Number of bytes written
+ *
+ * Notes:   Zigzag maps 0, -1, 1, -2 ... to 0, 1, 2, 3 ... then 7 bits are
+ *          sent per byte, low bits first, top bit set on all but the last.
+ *
+ *******************************************************************************/
+LIB_API
+size_t BinaryEncodeVarint(int nValue, uint8_t* pBytes)
+{
+   uint32_t nBits = ((uint32_t)nValue << 1) ^ (nValue < 0 ? 0xFFFFFFFFu : 0);
+   size_t nLength = 0;
+
+   while (nBits > VARINT_MASK)
+   {
+      pBytes[nLength++] = (uint8_t)((nBits & VARINT_MASK) | VARINT_MORE);
+      nBits >>= VARINT_BITS;
+   }
+
+   pBytes[nLength++] = (uint8_t)nBits;
+
+   return nLength;
+}
+
+/********************************************************************************
+ *
+ * Name:    BinaryReadVarint
+ *
+ * Purpose: Reads a list item integer
+ *
+ * Inputs:  pReader - list data, advanced past the value
+ *
+ * Outputs: pValue - decoded value
+ *
+ * Returns: true if a complete value was read
+ *
+ * Notes:   None.
+ *
+ *******************************************************************************/
+LIB_API
+bool BinaryReadVarint(FrameView* pReader, int* pValue)
+{
+   const uint8_t* pBytes = (const uint8_t*)pReader->pData;
+   uint32_t nBits        = 0;
+   size_t nIdx           = 0;
+   bool bRead            = false;
+
+   for (nIdx = 0; !bRead && nIdx < pReader->nLength && nIdx < BINARY_VARINT_BYTES; nIdx++)
+   {
+      nBits |= (uint32_t)(pBytes[nIdx] & VARINT_MASK) << (VARINT_BITS * nIdx);
+
+      // last byte of the value has the top bit clear
+      bRead = (pBytes[nIdx] & VARINT_MORE) == 0;
+   }
+
+   if (bRead)
+   {
+      *pValue = (int)((nBits >> 1) ^ (0u - (nBits & 1)));
+
+      pReader->pData   += nIdx;
+      pReader->nLength -= nIdx;
+   }
+
+   return bRead;
+}
+
+/********************************************************************************
+ *
+ * Name:    BinaryReadString
+ *
+ * Purpose: Reads a length prefixed list item string
+ *
+ * Inputs:  pReader - list data, advanced past the value
+ *
+ * Outputs: pValue - string bytes
+ *
+ * Returns: true if a complete value was read
+ *
+ * Notes:   None.
+ *
+ *******************************************************************************/
+LIB_API
+bool BinaryReadString(FrameView* pReader, FrameView* pValue)
+{
+   size_t nLength = 0;
+   bool bRead     = false;
+
+   if (pReader->nLength >= 1)
+   {
+      nLength = (uint8_t)pReader->pData[0];
+      bRead   = nLength <= pReader->nLength - 1;
+   }
+
+   if (bRead)
+   {
+      pValue->pData   = pReader->pData + 1;
+      pValue->nLength = nLength;
+
+      pReader->pData   += 1 + nLength;
+      pReader->nLength -= 1 + nLength;
+   }
+
+   return bRead;
+}
@@ -40,14 +40,220 @@
 #include <stdio.h>
 #include <string.h>
 #include "commandBuilder.h"
+#include "commandWriter.h"
+#include "commandBinary.h"
 
 #define RSP            "RSP"
 #define PARAM_FORMAT   "%d,%s="
 #define FW_FORMAT      "%X.%X.%X"
 
+// index of a command in m_schemaTags
+#define SCHEMA_INDEX(eCode)   ((size_t)(eCode) - (size_t)ECommandCodeMin)
+
+// m_schemaTags entry for one COMMAND_SCHEMA row, by shape
+#define SCHEMA_TAGS(eCode, eShape, eTag, nMin, nMax, handler) SCHEMA_TAGS_##eShape(eTag)
+#define SCHEMA_TAGS_SET_BOOL(eTag)  { eTag, ETagNone },
+#define SCHEMA_TAGS_SET_INT(eTag)   { eTag, ETagNone },
+#define SCHEMA_TAGS_GET_INT(eTag)   { ETagNone, eTag },
+#define SCHEMA_TAGS_NONE(eTag)      { ETagNone, ETagNone },
+#define SCHEMA_TAGS_VIEW(eTag)      { ETagNone, ETagNone },
+#define SCHEMA_TAGS_RUN(eTag)       { ETagNone, ETagNone },
+#define SCHEMA_TAGS_FRAME(eTag)     { ETagNone, ETagNone },
+
+// writes one CONFIG_FIELDS field, by field type
+#define SCHEMA_CONFIG_WRITE(eSlot, eTag, eType, nMin, nMax, bRequired, member) \
+   SCHEMA_WRITE_##eType(pWriter, BinaryTagName((uint8_t)eTag), pConfig->member);
+#define SCHEMA_WRITE_EParamInt(pWriter, pszTag, value)  PayloadWriter_IntParam(pWriter, pszTag, value)
+#define SCHEMA_WRITE_EParamText(pWriter, pszTag, value) PayloadWriter_StringParam(pWriter, pszTag, value)
+
+// writes one integer field of a field list from anValues, by slot. Fields
+// that aren't required are left out and the device uses its default
+#define SCHEMA_FIELD_WRITE(eSlot, eTag, eType, nMin, nMax, bRequired) \
+   if (bRequired) \
+   { \
+      PayloadWriter_IntParam(&writer, BinaryTagName((uint8_t)eTag), anValues[eSlot]); \
+   }
+
+// single parameter tags of a command
+typedef struct _SchemaTags
+{
+   EParamTag eRequest;     // SET_BOOL and SET_INT parameter
+   EParamTag eResponse;    // GET_INT response parameter
+} SchemaTags;
+
+/*********************************************************************************
+*                               D A T A
+*********************************************************************************/
+// indexed by command code less ECommandCodeMin, expanded from COMMAND_SCHEMA
+static const SchemaTags m_schemaTags[SCHEMA_INDEX(ECommandCodeMax)] =
+{
+   { ETagNone, ETagNone },    // ECommandCodeMin
+   COMMAND_SCHEMA(SCHEMA_TAGS)
+};
+
 /*********************************************************************************
 *                        H E L P E R   F U N C T I O N   
 *********************************************************************************/
+/********************************************************************************
+ *
+ * Name:    WriteConfigParameters
+ *
+ * Purpose: Writes the configuration data parameters
+ *
+ * Inputs:  pConfig - configuration data
+ *
+ * Outputs: pWriter - parameters appended
+ *
+ * Returns: None
+ *
+ * Notes:   Shared by the configuration data and screen ready payloads.
+ *          The fields are written in CONFIG_FIELDS order.
+ *
+ *******************************************************************************/
+static void WriteConfigParameters(PayloadWriter* pWriter, const ConfigData* pConfig)
+{
+   CONFIG_FIELDS(SCHEMA_CONFIG_WRITE)
+}
+
+/********************************************************************************
+ *
+ * Name:    WriteProcedureLogList
+ *
+ * Purpose: Writes the count and list parameters of a procedure log list
+ *
+ * Inputs:  nCount   - number of records
+ *          pEntries - array of nCount records
+ *
+ * Outputs: pWriter - parameters appended
+ *
+ * Returns: None
+ *
+ * Notes:   Shared by the payload and message responses.
+ *
+ *******************************************************************************/
+static void WriteProcedureLogList(PayloadWriter* pWriter, int nCount, const ProcedureLog* pEntries)
+{
+   int nIdx = 0;
+   int nDate = 0;
+
+   PayloadWriter_IntParam(pWriter, TAG_COUNT, nCount);
+   PayloadWriter_BeginList(pWriter, TAG_LOG_ENTRIES);
+
+   // serialize each entry straight into the payload
+   for(nIdx = 0 ; nIdx < nCount ; nIdx++)
+   {
+      PayloadWriter_BeginItem(pWriter);
+      PayloadWriter_ItemString(pWriter, pEntries[nIdx].szName);
+      PayloadWriter_ItemInt(pWriter, pEntries[nIdx].nDuration);
+      PayloadWriter_ItemInt(pWriter, pEntries[nIdx].nEntryCount);
+
+      for (nDate = 0; nDate < DATE_TIME_BYTES; nDate++)
+      {
+         PayloadWriter_ItemInt(pWriter, pEntries[nIdx].szDate[nDate]);
+      }
+
+      PayloadWriter_EndItem(pWriter);
+   }
+
+   PayloadWriter_EndList(pWriter);
+}
+
+/********************************************************************************
+ *
+ * Name:    WriteLogEntryList
+ *
+ * Purpose: Writes the count and list parameters of a log entry list
+ *
+ * Inputs:  nCount   - number of records
+ *          pEntries - array of nCount records
+ *
+ * Outputs: pWriter - parameters appended
+ *
+ * Returns: None
+ *
+ * Notes:   Shared by the payload and message responses.
+ *
+ *******************************************************************************/
+static void WriteLogEntryList(PayloadWriter* pWriter, int nCount, const LogEntry* pEntries)
+{
+   int nIdx = 0;
+   int nValue = 0;
+
+   PayloadWriter_IntParam(pWriter, TAG_COUNT, nCount);
+   PayloadWriter_BeginList(pWriter, TAG_LOG_ENTRIES);
+
+   // serialize each entry straight into the payload
+   for(nIdx = 0 ; nIdx < nCount ; nIdx++)
+   {
+      PayloadWriter_BeginItem(pWriter);
+      PayloadWriter_ItemInt(pWriter, pEntries[nIdx].eId);
+
+      for (nValue = 0; nValue < LOG_ENTRY_CNT; nValue++)
+      {
+         PayloadWriter_ItemInt(pWriter, pEntries[nIdx].nValues[nValue]);
+      }
+
+      PayloadWriter_EndItem(pWriter);
+   }
+
+   PayloadWriter_EndList(pWriter);
+}
+
+/********************************************************************************
+ *
+ * Name:    BuildLogListMessage
+ *
+ * Purpose: Builds a log list response message for the transport layer
+ *
+ * Inputs:  eResponse   - command handler response code
+ *          eCode       - command being answered
+ *          nCount      - number of records
+ *          pEntries    - array of nCount records, type depends on eCode
+ *          nBufferSize - size of pBuffer
+ *
+ * Outputs: pBuffer - NULL terminated response message
+ *
+ * Returns: Length of the message, 0 if it didn't fit
+ *
+ * Notes:   Errors are answered the same way as in a single payload.
+ *
+ *******************************************************************************/
+static size_t BuildLogListMessage(EHandlerResponse eResponse,
+                                  ECommandCode eCode,
+                                  int nCount,
+                                  const void* pEntries,
+                                  char* pBuffer,
+                                  size_t nBufferSize)
+{
+   PayloadWriter writer;
+   size_t nLength = 0;
+
+   if (pBuffer != NULL && nBufferSize > 0 && (pEntries != NULL || eResponse != EResponseOk))
+   {
+      PayloadWriter_BeginResponseMessage(&writer, pBuffer, nBufferSize, eCode);
+
+      if (eResponse != EResponseOk)
+      {
+         PayloadWriter_IntParam(&writer, ERROR_PREFIX, (int)eResponse);
+      }
+      else if (eCode == EGetProcedureList)
+      {
+         WriteProcedureLogList(&writer, nCount, (const ProcedureLog*)pEntries);
+      }
+      else
+      {
+         WriteLogEntryList(&writer, nCount, (const LogEntry*)pEntries);
+      }
+
+      if (PayloadWriter_End(&writer))
+      {
+         nLength = writer.nLength;
+      }
+   }
+
+   return nLength;
+}
+
 /********************************************************************************
  *
  * Name:    BuildCommandWithNoParameter
@@ -65,16 +271,13 @@
  *******************************************************************************/
 void BuildCommandWithNoParameter(ECommandCode eId, MsgPayload* pPayload)
 {
+   PayloadWriter writer;
+
    if (pPayload != NULL)
    {
-      // clear buffer
-      // format message
-      // calculate length & checksum
-      memset(pPayload, 0, sizeof(MsgPayload));
-
-      sprintf(pPayload->szPayload, "%d", eId);
-      pPayload->nLength = strlen(pPayload->szPayload);
-      pPayload->nChecksum = CalculateChecksum(pPayload);
+      // format message, length & checksum are kept as it is written
+      PayloadWriter_BeginCommand(&writer, pPayload, eId);
+      PayloadWriter_End(&writer);
    }
 }
 
@@ -96,18 +299,14 @@ void BuildCommandWithNoParameter(ECommandCode eId, MsgPayload* pPayload)
  *******************************************************************************/
 void BuildCommandWithIntParameter(ECommandCode eId, char* pTag, int nValue, MsgPayload* pPayload)
 {
-   char szFormat[TMP_BUFF_SIZE] = { 0 };
+   PayloadWriter writer;
+
    if (pPayload != NULL && pTag != NULL)
    {
-      // clear buffer
-      memset(pPayload, 0, sizeof(MsgPayload));
-
       // build message payload
-      sprintf(pPayload->szPayload, "%d,%s=%d", eId, pTag, nValue);
-      pPayload->nLength = strlen(pPayload->szPayload);
-
-      // compute the checksum and write the data to the buffer
-      pPayload->nChecksum = CalculateChecksum(pPayload);
+      PayloadWriter_BeginCommand(&writer, pPayload, eId);
+      PayloadWriter_IntParam(&writer, pTag, nValue);
+      PayloadWriter_End(&writer);
    }
 }
 
@@ -129,18 +328,14 @@ void BuildCommandWithIntParameter(ECommandCode eId, char* pTag, int nValue, MsgP
  *******************************************************************************/
 void BuildCommandWithFloatParameter(ECommandCode eId, char* pTag, float dValue, MsgPayload* pPayload)
 {
+   PayloadWriter writer;
+
    if (pPayload != NULL && pTag != NULL)
    {
-      // clear buffer
-      memset(pPayload, 0, sizeof(MsgPayload));
-
       // build message payload
-       sprintf(pPayload->szPayload,  "%d,%s=%f", eId, pTag, dValue);
-
-      pPayload->nLength = strlen(pPayload->szPayload);
-
-      // compute the checksum and write the data to the buffer
-      pPayload->nChecksum = CalculateChecksum(pPayload);
+      PayloadWriter_BeginCommand(&writer, pPayload, eId);
+      PayloadWriter_FloatParam(&writer, pTag, dValue);
+      PayloadWriter_End(&writer);
    }
 }
 
@@ -163,18 +358,14 @@ void BuildCommandWithFloatParameter(ECommandCode eId, char* pTag, float dValue,
  *******************************************************************************/
 void BuildCommandWithStringParameter(ECommandCode eId, char* pTag, const char* szValue, MsgPayload* pPayload)
 {
+   PayloadWriter writer;
+
    if (pPayload != NULL && pTag != NULL)
    {
-      // clear buffer
-      memset(pPayload, 0, sizeof(MsgPayload));
-
       // build message payload
-      sprintf(pPayload->szPayload,  "%d,%s=%s", eId, pTag, szValue);
-
-      pPayload->nLength = strlen(pPayload->szPayload);
-
-      // compute the checksum and write the data to the buffer
-      pPayload->nChecksum = CalculateChecksum(pPayload);
+      PayloadWriter_BeginCommand(&writer, pPayload, eId);
+      PayloadWriter_StringParam(&writer, pTag, szValue);
+      PayloadWriter_End(&writer);
    }
 }
 /*********************************************************************************
@@ -187,29 +378,21 @@ void BuildCommandResponseWithIntParameter(EHandlerResponse eResponse,
                                           int nValue, 
                                           MsgPayload* pPayload)
 {
+   PayloadWriter writer;
+
    // check buffer before processing
    if(pPayload)
    {
-      // clear previous data
-      // format message payload
-      memset(pPayload, 0, sizeof(MsgPayload));
-
       if (eResponse == EResponseOk)
       {
-         sprintf(pPayload->szPayload,
-            "%s,%d,%s=%d",
-            RESPONSE_PREFIX,
-            eCode,
-            pTag,
-            nValue);
+         PayloadWriter_BeginResponse(&writer, pPayload, eCode);
+         PayloadWriter_IntParam(&writer, pTag, nValue);
+         PayloadWriter_End(&writer);
       }
       else
       {
          BuildCommandErrorResponse(eResponse, eCode, pPayload);
       }
-
-      pPayload->nLength = strlen(pPayload->szPayload);
-      pPayload->nChecksum = CalculateChecksum(pPayload);
    }
 }
 
@@ -218,6 +401,7 @@ void BuildCommandResponseWithIntParameter(EHandlerResponse eResponse,
  * Name:    BuildCommandEchoResponse
  *
  * Purpose: Builds generic command response. Prefixes RSP to original payload.
+ *          A binary payload is echoed with the response flag set instead.
  *
  * Inputs:  eResponse      - the response to the received command
  *          pReceived      - received command payload
@@ -232,18 +416,32 @@ void BuildCommandResponseWithIntParameter(EHandlerResponse eResponse,
  *
  *******************************************************************************/
 LIB_API
-void BuildCommandEchoResponse(EHandlerResponse eResponse, ECommandCode eCode, MsgPayload* pReceived, MsgPayload* pResponse)
+void BuildCommandEchoResponse(EHandlerResponse eResponse, ECommandCode eCode, const MsgPayload* pReceived, MsgPayload* pResponse)
 {
-  
+   PayloadWriter writer;
+
    if(pReceived != NULL && pResponse != NULL)
    {
       if (eResponse == EResponseOk)
       {
-         if (pReceived->nLength + strlen(RESPONSE_PREFIX) < PAYLOAD_LENGTH)
+         if (IsBinaryPayload(pReceived->szPayload, pReceived->nLength))
+         {
+            // same header and records, flagged as a response
+            PayloadWriter_Begin(&writer, pResponse);
+            PayloadWriter_Bytes(&writer, pReceived->szPayload, BINARY_HEADER_LENGTH - 1);
+            PayloadWriter_Char(&writer, (char)(pReceived->szPayload[BINARY_HEADER_LENGTH - 1] | BINARY_FLAG_RESPONSE));
+            PayloadWriter_Bytes(&writer,
+                                pReceived->szPayload + BINARY_HEADER_LENGTH,
+                                pReceived->nLength - BINARY_HEADER_LENGTH);
+            PayloadWriter_End(&writer);
+         }
+         else if (pReceived->nLength + strlen(RESPONSE_PREFIX) < PAYLOAD_LENGTH)
          {
-            sprintf(pResponse->szPayload,  "%s,%s", RESPONSE_PREFIX, pReceived->szPayload);
-            pResponse->nLength   = strlen(pResponse->szPayload);
-            pResponse->nChecksum = CalculateChecksum(pResponse);
+            PayloadWriter_Begin(&writer, pResponse);
+            PayloadWriter_String(&writer, RESPONSE_PREFIX);
+            PayloadWriter_Char(&writer, ',');
+            PayloadWriter_Bytes(&writer, pReceived->szPayload, pReceived->nLength);
+            PayloadWriter_End(&writer);
          }
       }
       else
@@ -274,22 +472,92 @@ void BuildCommandEchoResponse(EHandlerResponse eResponse, ECommandCode eCode, Ms
 LIB_API
 void BuildCommandErrorResponse(EHandlerResponse eResponse,  ECommandCode eCode, MsgPayload* pResponse)
 {
+   PayloadWriter writer;
+
    // check buffer before processing
    if(pResponse)
    {
-      // clear previous data
       // format response
-      memset(pResponse, 0, sizeof(MsgPayload));
+      PayloadWriter_BeginResponse(&writer, pResponse, eCode);
+      PayloadWriter_IntParam(&writer, ERROR_PREFIX, (int)eResponse);
+      PayloadWriter_End(&writer);
+   }
+}
+
+/********************************************************************************
+ *
+ * Name:    BuildSchemaCommand
+ *
+ * Purpose: Builds a command payload from its COMMAND_SCHEMA row
+ *
+ * Inputs:  eCode  - command code
+ *          nValue - parameter value, SET_BOOL and SET_INT rows only
+ *
+ * Outputs: pPayload - populated with command payload
+ *
+ * Returns: None
+ *
+ * Notes:   Rows without a request tag are built without parameters.
+ *
+ *******************************************************************************/
+LIB_API
+void BuildSchemaCommand(ECommandCode eCode, int nValue, MsgPayload* pPayload)
+{
+   PayloadWriter writer;
+   EParamTag eTag = ETagNone;
+
+   if (pPayload != NULL)
+   {
+      if (eCode > ECommandCodeMin && eCode < ECommandCodeMax)
+      {
+         eTag = m_schemaTags[SCHEMA_INDEX(eCode)].eRequest;
+      }
+
+      PayloadWriter_BeginCommand(&writer, pPayload, eCode);
+
+      if (eTag != ETagNone)
+      {
+         PayloadWriter_IntParam(&writer, BinaryTagName((uint8_t)eTag), nValue);
+      }
+
+      PayloadWriter_End(&writer);
+   }
+}
+
+/********************************************************************************
+ *
+ * Name:    BuildSchemaResponse
+ *
+ * Purpose: Builds the response of a GET_INT row of COMMAND_SCHEMA
+ *
+ * Inputs:  eResponse - result from command handler
+ *          eCode     - command code
+ *          nValue    - value from the command handler
+ *
+ * Outputs: pPayload - populated with response payload
+ *
+ * Returns: None
+ *
+ * Notes:   Codes that aren't GET_INT rows are answered with EOpNotAllowed.
+ *
+ *******************************************************************************/
+LIB_API
+void BuildSchemaResponse(EHandlerResponse eResponse, ECommandCode eCode, int nValue, MsgPayload* pPayload)
+{
+   EParamTag eTag = ETagNone;
 
-      sprintf(pResponse->szPayload,
-         "%s,%d,%s=%d",
-         RESPONSE_PREFIX,
-         (int)eCode,
-         ERROR_PREFIX,
-         (int)eResponse);
+   if (eCode > ECommandCodeMin && eCode < ECommandCodeMax)
+   {
+      eTag = m_schemaTags[SCHEMA_INDEX(eCode)].eResponse;
+   }
 
-      pResponse->nLength = strlen(pResponse->szPayload);
-      pResponse->nChecksum = CalculateChecksum(pResponse);
+   if (eTag != ETagNone)
+   {
+      BuildCommandResponseWithIntParameter(eResponse, eCode, BinaryTagName((uint8_t)eTag), nValue, pPayload);
+   }
+   else
+   {
+      BuildCommandErrorResponse(EOpNotAllowed, eCode, pPayload);
    }
 }
 
@@ -333,63 +601,24 @@ void BuildGetFirmwareInfoCommand(MsgPayload* pPayload)
 LIB_API
 void BuildGetFirmwareInfoCommandResponse(EHandlerResponse eResponse, FirmwareInfo* pInfo, MsgPayload* pPayload)
 {
-   char szMainFW[10] = { 0 };
-   char szSoft[10] = { 0 };
-   char szBt[10] = { 0 };
-   char szGui[10] = { 0 };
-   char szScavenger[10] = { 0 };
+   PayloadWriter writer;
 
    if (pInfo != NULL && pPayload != NULL)
    {
-      memset(pPayload, 0, sizeof(MsgPayload));
-
       if (eResponse == EResponseOk)
       {
-         sprintf(szMainFW, 
-            "%X.%X.%X", 
-            pInfo->mainController.nMajor,
-            pInfo->mainController.nMinor,
-            pInfo->mainController.nRevision);
-
-         sprintf(szBt, 
-            "%X.%X.%X", 
-            pInfo->blueTooth.nMajor,
-            pInfo->blueTooth.nMinor,
-            pInfo->blueTooth.nRevision);
-
-         sprintf(szGui, 
-            "%X.%X.%X", 
-            pInfo->gui.nMajor,
-            pInfo->gui.nMinor,
-            pInfo->gui.nRevision);
-
-         sprintf(szScavenger, 
-            "%X.%X.%X", 
-            pInfo->scavenger.nMajor,
-            pInfo->scavenger.nMinor,
-            pInfo->scavenger.nRevision);
-
-
          // format command payload
-         sprintf(pPayload->szPayload,
-            "RSP,%d,%s=%s,%s=%s,%s=%s,%s=%s",
-            EGetFirmwareInfo,
-            TAG_FW_MAIN,
-            szMainFW,
-            TAG_FW_BT,
-            szBt,
-            TAG_FW_GUI,
-            szGui,
-            TAG_FW_SCAV,
-            szScavenger);
+         PayloadWriter_BeginResponse(&writer, pPayload, EGetFirmwareInfo);
+         PayloadWriter_VersionParam(&writer, TAG_FW_MAIN, &pInfo->mainController);
+         PayloadWriter_VersionParam(&writer, TAG_FW_BT, &pInfo->blueTooth);
+         PayloadWriter_VersionParam(&writer, TAG_FW_GUI, &pInfo->gui);
+         PayloadWriter_VersionParam(&writer, TAG_FW_SCAV, &pInfo->scavenger);
+         PayloadWriter_End(&writer);
       }
       else
       {
          BuildCommandErrorResponse(eResponse, EGetFirmwareInfo, pPayload);
       }
-
-      pPayload->nLength    = strlen(pPayload->szPayload);
-      pPayload->nChecksum  = CalculateChecksum(pPayload);
    }
 }
 /********************************************************************************
@@ -410,7 +639,7 @@ void BuildGetFirmwareInfoCommandResponse(EHandlerResponse eResponse, FirmwareInf
 LIB_API
 void BuildVacuumIncreaseCommand(MsgPayload* pPayload)
 {
-   BuildCommandWithNoParameter(EVacuumIncrease, pPayload);
+   BuildSchemaCommand(EVacuumIncrease, 0, pPayload);
 }
 
 /********************************************************************************
@@ -431,7 +660,7 @@ void BuildVacuumIncreaseCommand(MsgPayload* pPayload)
 LIB_API
 void BuildVacuumDecreaseCommand(MsgPayload* pPayload)
 {
-   BuildCommandWithNoParameter(EVacuumDecrease, pPayload);
+   BuildSchemaCommand(EVacuumDecrease, 0, pPayload);
 }
 
 /********************************************************************************
@@ -455,7 +684,7 @@ void BuildEnableDisablePinCommand(bool bEnabled, MsgPayload* pPayload)
 {
    // convert boolean to integer and build command
    int nEnabled = bEnabled ? ENABLED : DISABLED;
-   BuildCommandWithIntParameter(EEnableDisablePin, TAG_TOGGLE_PIN, nEnabled, pPayload);  
+   BuildSchemaCommand(EEnableDisablePin, nEnabled, pPayload);
 }
 
 /********************************************************************************
@@ -498,7 +727,7 @@ void BuildChangePinCommand(char* pszNewPin, MsgPayload* pPayload)
 LIB_API
 void BuildStartProcedureCommand(MsgPayload* pPayload)
 {
-   BuildCommandWithNoParameter(EStartProcedure, pPayload);
+   BuildSchemaCommand(EStartProcedure, 0, pPayload);
 }
 
 /********************************************************************************
@@ -519,7 +748,7 @@ void BuildStartProcedureCommand(MsgPayload* pPayload)
 LIB_API
 void BuildEndProcedureCommand(MsgPayload* pPayload)
 {
-   BuildCommandWithNoParameter(EEndProcedure, pPayload);
+   BuildSchemaCommand(EEndProcedure, 0, pPayload);
 }
 
 /********************************************************************************
@@ -625,7 +854,7 @@ void BuildResetLogsCommand(ELogId eLogId, MsgPayload* pPayload)
 LIB_API
 void BuildSetLanguageCommand(ELanguage eLanguage, MsgPayload* pPayload)
 {
-   BuildCommandWithIntParameter(ESetLanguage, TAG_SET_LANGUAGE, eLanguage, pPayload);
+   BuildSchemaCommand(ESetLanguage, eLanguage, pPayload);
 }
 
 /********************************************************************************
@@ -691,7 +920,7 @@ void BuildGetLanguageCommandResponse(EHandlerResponse eResponse, ELanguage eLang
 LIB_API
 void BuildSetTotalFlowRateCommand(int nFlowRate, MsgPayload* pPayload)
 {
-   BuildCommandWithIntParameter(ESetTotalFlowRate, TAG_FLOW_RATE, nFlowRate, pPayload);
+   BuildSchemaCommand(ESetTotalFlowRate, nFlowRate, pPayload);
 }
 
 /********************************************************************************
@@ -714,7 +943,7 @@ void BuildSetTotalFlowRateCommand(int nFlowRate, MsgPayload* pPayload)
 LIB_API
 void BuildGetTotalFlowRateCommand(MsgPayload* pPayload)
 {
-   BuildCommandWithNoParameter(EGetTotalFlowRate, pPayload);
+   BuildSchemaCommand(EGetTotalFlowRate, 0, pPayload);
 }
 
 /********************************************************************************
@@ -764,32 +993,23 @@ void BuildGetFlowRatesCommandResponse(EHandlerResponse eResponse,
                                       int nScavengerFlowRate, 
                                       MsgPayload* pPayload)
 {
+   PayloadWriter writer;
+
    if(pPayload)
    {
-      // clear buffer
-      // format message
-      // calculate length & checksum
-      memset(pPayload, 0, sizeof(MsgPayload));
-
+      // format message, length & checksum are kept as it is written
       if (eResponse == EResponseOk)
       {
-         sprintf(pPayload->szPayload, 
-            "%s,%d,%s=%d,%s=%d,%s=%d",
-            RESPONSE_PREFIX,
-            EGetFlowRates,
-            TAG_O2_FLOW,
-            nO2FlowRate,
-            TAG_N2O_FLOW,
-            nN2OFlowRate,
-            TAG_SCAV_FLOW,
-            nScavengerFlowRate);
+         PayloadWriter_BeginResponse(&writer, pPayload, EGetFlowRates);
+         PayloadWriter_IntParam(&writer, TAG_O2_FLOW, nO2FlowRate);
+         PayloadWriter_IntParam(&writer, TAG_N2O_FLOW, nN2OFlowRate);
+         PayloadWriter_IntParam(&writer, TAG_SCAV_FLOW, nScavengerFlowRate);
+         PayloadWriter_End(&writer);
       }
       else
       {
          BuildCommandErrorResponse(eResponse, EGetFlowRates, pPayload);
       }
-      pPayload->nLength = strlen(pPayload->szPayload);
-      pPayload->nChecksum = CalculateChecksum(pPayload);
    }
 }
 
@@ -820,25 +1040,7 @@ void BuildGetTotalFlowRateCommandResponse(EHandlerResponse eResponse,
    // check buffer before processing
    if(pPayload)
    {
-      // clear previous data
-      // format message payload
-      memset(pPayload, 0, sizeof(MsgPayload));
-      if (eResponse == EResponseOk)
-      {
-         sprintf(pPayload->szPayload,
-            "%s,%d,%s=%d",
-            RESPONSE_PREFIX,
-            EGetTotalFlowRate,
-            TAG_FLOW_RATE,
-            flowRate);
-      }
-      else
-      {
-         BuildCommandErrorResponse(eResponse, EGetTotalFlowRate, pPayload);
-      }
-
-      pPayload->nLength = strlen(pPayload->szPayload);
-      pPayload->nChecksum = CalculateChecksum(pPayload);
+      BuildSchemaResponse(eResponse, EGetTotalFlowRate, flowRate, pPayload);
    }
 }
 
@@ -862,7 +1064,7 @@ void BuildGetTotalFlowRateCommandResponse(EHandlerResponse eResponse,
 LIB_API
 void BuildSetO2MixCommand(int nPercentage, MsgPayload* pPayload)
 {
-   BuildCommandWithIntParameter(ESetO2MixPercentage, "O2", nPercentage, pPayload);
+   BuildSchemaCommand(ESetO2MixPercentage, nPercentage, pPayload);
 }
 
 /********************************************************************************
@@ -884,7 +1086,7 @@ void BuildSetO2MixCommand(int nPercentage, MsgPayload* pPayload)
 LIB_API
 void BuildGetO2MixCommand(MsgPayload* pPayload)
 {
-   BuildCommandWithNoParameter(EGetO2MixPercentage, pPayload);
+   BuildSchemaCommand(EGetO2MixPercentage, 0, pPayload);
 }
 
 /********************************************************************************
@@ -907,7 +1109,7 @@ void BuildGetO2MixCommand(MsgPayload* pPayload)
 LIB_API
 void BuildGetO2MixCommandResponse(EHandlerResponse eResponse, int nPercentage, MsgPayload* pPayload)
 {
-   BuildCommandResponseWithIntParameter(eResponse, EGetO2MixPercentage, TAG_O2_MIX, nPercentage, pPayload);
+   BuildSchemaResponse(eResponse, EGetO2MixPercentage, nPercentage, pPayload);
 }
 
 
@@ -929,7 +1131,7 @@ void BuildGetO2MixCommandResponse(EHandlerResponse eResponse, int nPercentage, M
 LIB_API
 void BuildStopGasCommand(MsgPayload* pPayload)
 {
-   BuildCommandWithNoParameter(EStopGas, pPayload);
+   BuildSchemaCommand(EStopGas, 0, pPayload);
 }
 
 /********************************************************************************
@@ -951,7 +1153,7 @@ LIB_API
 void BuildEnableDisableBTCommand(bool bEnabled, MsgPayload* pPayload)
 {
    int nEnabled = bEnabled ? ENABLED : DISABLED;
-   BuildCommandWithIntParameter(EEnableDisableBT, "BT_EN", nEnabled, pPayload);
+   BuildSchemaCommand(EEnableDisableBT, nEnabled, pPayload);
 }
 
 /********************************************************************************
@@ -972,7 +1174,7 @@ void BuildEnableDisableBTCommand(bool bEnabled, MsgPayload* pPayload)
 LIB_API
 void BuildRestoreDefaultsCommand(MsgPayload* pPayload)
 {
-   BuildCommandWithNoParameter(ERestoreDefaults, pPayload);
+   BuildSchemaCommand(ERestoreDefaults, 0, pPayload);
 }
 
 /********************************************************************************
@@ -993,7 +1195,7 @@ void BuildRestoreDefaultsCommand(MsgPayload* pPayload)
 LIB_API
 void BuildHeartbeatCommand(MsgPayload* pPayload)
 {
-   BuildCommandWithNoParameter(EHeartbeat, pPayload);
+   BuildSchemaCommand(EHeartbeat, 0, pPayload);
 }
 
 /********************************************************************************
@@ -1014,40 +1216,21 @@ void BuildHeartbeatCommand(MsgPayload* pPayload)
 LIB_API
 void BuildSyncDataCommand(SyncDataInfo* pSyncData, MsgPayload* pPayload)
 {
-   int nPowerState = pSyncData->bTouchscreenPowerState ? 1 : 0;
-   int nInProgress = pSyncData->bInProgress ? 1 : 0;
-   int nStopGas    = pSyncData->bStopGas ? 1 : 0;
-   int nEnding     = pSyncData->bEnding ? 1 : 0;
+   PayloadWriter writer;
 
    if (pPayload != NULL && pSyncData != NULL)
    {
-      // clear buffer
-      // format message
-      // calculate length & checksum
-      memset(pPayload, 0, sizeof(MsgPayload));
-
-      sprintf(pPayload->szPayload,
-         "%d,%s=%d,%s=%d,%s=%d,%s=%d,%s=%d,%s=%d,%s=%d,%s=%d", 
-         ESyncData,
-         TAG_O2_MIX,
-         pSyncData->nO2MixPercentage,
-         TAG_FLOW_RATE,
-         pSyncData->nTotalFlowRate,
-         TAG_SCAV_FLOW,
-         pSyncData->nScavengerFlowRate,
-         TAG_TS_POWER,
-         nPowerState,
-         TAG_IN_PROGRESS,
-         nInProgress,
-         TAG_ENDING,
-         nEnding,
-         TAG_STOP_GAS,
-         nStopGas,
-         TAG_LANGUAGE,
-         pSyncData->eDefaultLanguage);
-
-      pPayload->nLength   = strlen(pPayload->szPayload);
-      pPayload->nChecksum = CalculateChecksum(pPayload);
+      // format message, length & checksum are kept as it is written
+      PayloadWriter_BeginCommand(&writer, pPayload, ESyncData);
+      PayloadWriter_IntParam(&writer, TAG_O2_MIX, pSyncData->nO2MixPercentage);
+      PayloadWriter_IntParam(&writer, TAG_FLOW_RATE, pSyncData->nTotalFlowRate);
+      PayloadWriter_IntParam(&writer, TAG_SCAV_FLOW, pSyncData->nScavengerFlowRate);
+      PayloadWriter_IntParam(&writer, TAG_TS_POWER, pSyncData->bTouchscreenPowerState ? 1 : 0);
+      PayloadWriter_IntParam(&writer, TAG_IN_PROGRESS, pSyncData->bInProgress ? 1 : 0);
+      PayloadWriter_IntParam(&writer, TAG_ENDING, pSyncData->bEnding ? 1 : 0);
+      PayloadWriter_IntParam(&writer, TAG_STOP_GAS, pSyncData->bStopGas ? 1 : 0);
+      PayloadWriter_IntParam(&writer, TAG_LANGUAGE, pSyncData->eDefaultLanguage);
+      PayloadWriter_End(&writer);
    }
 }
 
@@ -1090,30 +1273,22 @@ void BuildGetFirmwareVersionCommand(MsgPayload* pPayload)
 LIB_API
 void BuildGetFirmwareVersionCommandResponse(EHandlerResponse eResponse, FirmwareVersion* pVersion, MsgPayload* pPayload)
 {
+   PayloadWriter writer;
+
    // check values and buffer before processing
    if(pPayload != NULL)
    {
-      // clear buffer
-      memset(pPayload, 0, sizeof(MsgPayload));
-
       if (eResponse == EResponseOk)
       {
          // format the payload with the command code and FW version information
-       sprintf(pPayload->szPayload,
-            "RSP,%d,%s=%X.%X.%X",
-            EGetFirmwareVersion,
-            TAG_FW_VERSION,
-            pVersion->nMajor,
-            pVersion->nMinor,
-            pVersion->nRevision);
+         PayloadWriter_BeginResponse(&writer, pPayload, EGetFirmwareVersion);
+         PayloadWriter_VersionParam(&writer, TAG_FW_VERSION, pVersion);
+         PayloadWriter_End(&writer);
       }
       else
       {
          BuildCommandErrorResponse(eResponse, EGetFirmwareVersion, pPayload);
       }
-
-      pPayload->nLength = strlen(pPayload->szPayload);
-      pPayload->nChecksum = CalculateChecksum(pPayload);
    }
 }
 
@@ -1157,41 +1332,22 @@ void BuildGetConfigurationDataCommand(MsgPayload* pPayload)
 LIB_API
 void BuildGetConfigurationDataCommandResponse(EHandlerResponse eResponse, ConfigData* pConfig, MsgPayload* pPayload)
 {
+   PayloadWriter writer;
 
-      if (pConfig != NULL
-      && pPayload != NULL)
+   if (pConfig != NULL
+   && pPayload != NULL)
+   {
+      if (eResponse == EResponseOk)
       {
-         memset(pPayload, 0, sizeof(MsgPayload));
-         memset(pPayload, 0, sizeof(MsgPayload));
-
-         if (eResponse == EResponseOk)
-         {
-            sprintf(pPayload->szPayload,
-               "%d,%s=%d,%s=%d,%s=%d,%s=%d,%s=%d,%s=%s",
-               EGetConfigData,
-               TAG_N2O_MAX,
-               pConfig->nMaxN20,
-               TAG_MIX_STEP,
-               pConfig->eMixStepSize,
-               TAG_FLOW_STEP,
-               pConfig->eFlowStepSize,
-               TAG_CLOCK_FORMAT,
-               pConfig->eClockFormat,
-               TAG_LANGUAGE,
-               pConfig->eLanguage,
-               TAG_T_AND_D,
-               pConfig->szTime);
-         }
-         else
-         {
-            BuildCommandErrorResponse(eResponse, EGetConfigData, pPayload);
-         }
-
-         pPayload->nLength    = strlen(pPayload->szPayload);
-         pPayload->nChecksum = CalculateChecksum(pPayload);
+         PayloadWriter_BeginCommand(&writer, pPayload, EGetConfigData);
+         WriteConfigParameters(&writer, pConfig);
+         PayloadWriter_End(&writer);
       }
- 
-
+      else
+      {
+         BuildCommandErrorResponse(eResponse, EGetConfigData, pPayload);
+      }
+   }
 }
 
 /********************************************************************************
@@ -1212,28 +1368,13 @@ void BuildGetConfigurationDataCommandResponse(EHandlerResponse eResponse, Config
 LIB_API
 void BuildSetConfigurationDataCommand(ConfigData* pConfig, MsgPayload* pPayload)
 {
+   PayloadWriter writer;
+
    if(pPayload != NULL && pConfig != NULL)
    {
-      memset(pPayload, 0, sizeof(MsgPayload));
-
-      sprintf(pPayload->szPayload,
-         "%d,%s=%d,%s=%d,%s=%d,%s=%d,%s=%d,%s=%s",
-         EGetConfigData,
-         TAG_N2O_MAX,
-         pConfig->nMaxN20,
-         TAG_MIX_STEP,
-         pConfig->eMixStepSize,
-         TAG_FLOW_STEP,
-         pConfig->eFlowStepSize,
-         TAG_CLOCK_FORMAT,
-         pConfig->eClockFormat,
-         TAG_LANGUAGE,
-         pConfig->eLanguage,
-         TAG_T_AND_D,
-         pConfig->szTime);
-
-      pPayload->nLength    = strlen(pPayload->szPayload);
-      pPayload->nChecksum = CalculateChecksum(pPayload);
+      PayloadWriter_BeginCommand(&writer, pPayload, EGetConfigData);
+      WriteConfigParameters(&writer, pConfig);
+      PayloadWriter_End(&writer);
    }
 }
 
@@ -1277,18 +1418,14 @@ void BuildGetTimeAndDateCommand(MsgPayload* pPayload)
 LIB_API
 void BuildGetTimeAndDateCommandResponse(EHandlerResponse eResponse, char* pDateTime, MsgPayload* pPayload)
 {
+   PayloadWriter writer;
+
    if (pPayload != NULL && pDateTime != NULL)
    {
-      // clear buffer
-      memset(pPayload, 0, sizeof(MsgPayload));
-
       // build message payload
-      sprintf(pPayload->szPayload,  "RSP,%d,%s=%s", EGetTimeAndDate, TAG_T_AND_D, pDateTime);
-
-      pPayload->nLength = strlen(pPayload->szPayload);
-
-      // compute the checksum and write the data to the buffer
-      pPayload->nChecksum = CalculateChecksum(pPayload);
+      PayloadWriter_BeginResponse(&writer, pPayload, EGetTimeAndDate);
+      PayloadWriter_StringParam(&writer, TAG_T_AND_D, pDateTime);
+      PayloadWriter_End(&writer);
    }
 }
 
@@ -1331,24 +1468,18 @@ void BuildSetTimeAndDateCommand(const char* pDateTime, MsgPayload* pPayload)
 LIB_API
 void BuildSetValveCommand(int nPosition, EGasId eId, MsgPayload* pPayload)
 {
+   PayloadWriter writer;
+   int anValues[EGasFieldCount];
+
    if (pPayload != NULL)
    {
-      // clear buffer
-      memset(pPayload, 0, sizeof(MsgPayload));
+      anValues[EGasSelection] = eId;
+      anValues[EGasValue]     = nPosition;
 
       // build message payload
-      sprintf(pPayload->szPayload,
-         "%d,%s=%d,%s=%d",
-         ESetValve,
-         TAG_GAS_SELECTION,
-         eId,
-         TAG_VALVE_POS,
-         nPosition);
-
-      pPayload->nLength = strlen(pPayload->szPayload);
-
-      // compute the checksum and write the data to the buffer
-      pPayload->nChecksum = CalculateChecksum(pPayload);
+      PayloadWriter_BeginCommand(&writer, pPayload, ESetValve);
+      VALVE_FIELDS(SCHEMA_FIELD_WRITE)
+      PayloadWriter_End(&writer);
    }
 }
 
@@ -1392,31 +1523,25 @@ void BuildGetValveCommand(EGasId eId, MsgPayload* pPayload)
 LIB_API
 void BuildGetValveCommandResponse(EHandlerResponse eResponse, EGasId eId, int nPosition, MsgPayload* pPayload)
 {
+   PayloadWriter writer;
+   int anValues[EGasFieldCount];
+
    // check buffer before processing
    if(pPayload)
    {
-      // clear previous data
-      // format message payload
-      memset(pPayload, 0, sizeof(MsgPayload));
-
       if (eResponse == EResponseOk)
       {
-         sprintf(pPayload->szPayload,
-            "%s,%d,%s=%d,%s=%d",
-            RESPONSE_PREFIX,
-            EGetValve,
-            TAG_GAS_SELECTION,
-            eId,
-            TAG_VALVE_POS,
-            nPosition);
+         anValues[EGasSelection] = eId;
+         anValues[EGasValue]     = nPosition;
+
+         PayloadWriter_BeginResponse(&writer, pPayload, EGetValve);
+         VALVE_FIELDS(SCHEMA_FIELD_WRITE)
+         PayloadWriter_End(&writer);
       }
       else
       {
          BuildCommandErrorResponse(eResponse, EGetValve, pPayload);
       }
-
-      pPayload->nLength = strlen(pPayload->szPayload);
-      pPayload->nChecksum = CalculateChecksum(pPayload);
    }
 }
 
@@ -1438,7 +1563,7 @@ void BuildGetValveCommandResponse(EHandlerResponse eResponse, EGasId eId, int nP
 LIB_API
 void BuildFirmwareDownloadCommand(MsgPayload* pPayload)
 {
-   BuildCommandWithNoParameter(EFirmwareDownload, pPayload);
+   BuildSchemaCommand(EFirmwareDownload, 0, pPayload);
 }
 
 /********************************************************************************
@@ -1459,28 +1584,18 @@ void BuildFirmwareDownloadCommand(MsgPayload* pPayload)
 LIB_API
 void BuildEnableGasFlowCommand(EGasId eId, bool bEnabled, MsgPayload* pPayload)
 {
-   const int nEnabled = bEnabled ? ENABLED : DISABLED;
-
-   char szFormat[TMP_BUFF_SIZE] = { 0 };
+   PayloadWriter writer;
+   int anValues[EGasFieldCount];
 
    if (pPayload != NULL)
    {
-      // clear buffer
-      memset(pPayload, 0, sizeof(MsgPayload));
+      anValues[EGasSelection] = eId;
+      anValues[EGasValue]     = bEnabled ? ENABLED : DISABLED;
 
       // build message payload
-      sprintf(pPayload->szPayload,  
-         "%d,%s=%d,%s=%d", 
-         EEnableGasFlow,
-         TAG_GAS_SELECTION,
-         eId,
-         TAG_ENABLE_GAS_FLOW,
-         nEnabled);
-
-      pPayload->nLength = strlen(pPayload->szPayload);
-
-      // compute the checksum and write the data to the buffer
-      pPayload->nChecksum = CalculateChecksum(pPayload);
+      PayloadWriter_BeginCommand(&writer, pPayload, EEnableGasFlow);
+      GAS_FLOW_FIELDS(SCHEMA_FIELD_WRITE)
+      PayloadWriter_End(&writer);
    }
 }
 
@@ -1502,7 +1617,7 @@ void BuildEnableGasFlowCommand(EGasId eId, bool bEnabled, MsgPayload* pPayload)
 LIB_API
 void BuildBTFirmwareDownloadCommand(MsgPayload* pPayload)
 {
-   BuildCommandWithNoParameter(EBtFirmwareDownload, pPayload);
+   BuildSchemaCommand(EBtFirmwareDownload, 0, pPayload);
 }
 
 /********************************************************************************
@@ -1524,22 +1639,16 @@ void BuildBTFirmwareDownloadCommand(MsgPayload* pPayload)
 LIB_API
 void BuildWriteManufacturerFieldCommand(const char* pField, const char* pValue, MsgPayload* pPayload)
 {
+   PayloadWriter writer;
+
    // check pointers before formatting payload
    if(pPayload != NULL
    && pField   != NULL 
    && pValue   != NULL)
    {
-      // clear buffer and format the command payload
-      memset(pPayload, 0, sizeof(MsgPayload));
-
-      sprintf(pPayload->szPayload,
-         "%d,%s=%s",
-         EWriteManufacturerField,
-         pField,
-         pValue);
-
-      pPayload->nLength    = strlen(pPayload->szPayload);
-      pPayload->nChecksum = CalculateChecksum(pPayload);
+      PayloadWriter_BeginCommand(&writer, pPayload, EWriteManufacturerField);
+      PayloadWriter_StringParam(&writer, pField, pValue);
+      PayloadWriter_End(&writer);
    }
 }
 
@@ -1561,17 +1670,14 @@ void BuildWriteManufacturerFieldCommand(const char* pField, const char* pValue,
 LIB_API
 void BuildReadManufacturerFieldCommand(const char* pField, MsgPayload* pPayload)
 {
+   PayloadWriter writer;
+
    if(pField   != NULL
    && pPayload != NULL)
    {
-      sprintf(pPayload->szPayload,
-         "%d,%s=%s",
-         EReadManufacturerField,
-         TAG_MF_FIELD,
-         pField);
-
-      pPayload->nLength   = strlen(pPayload->szPayload);
-      pPayload->nChecksum = CalculateChecksum(pPayload);
+      PayloadWriter_BeginCommand(&writer, pPayload, EReadManufacturerField);
+      PayloadWriter_StringParam(&writer, TAG_MF_FIELD, pField);
+      PayloadWriter_End(&writer);
    }
 }
 
@@ -1593,11 +1699,15 @@ void BuildReadManufacturerFieldCommand(const char* pField, MsgPayload* pPayload)
 LIB_API
 void BuildReadManufacturerFieldCommandResponse(EHandlerResponse eResponse, 
                                                const char* pValue, 
-                                               MsgPayload* pPayload, 
+                                               const MsgPayload* pPayload, 
                                                MsgPayload* pResponse)
 {
-   char* pReader = pPayload->szPayload;
    char szFieldName[TMP_STR_SIZE] = { 0 };
+   PayloadWriter writer;
+   FrameView request;
+   FrameView field;
+   BinaryRecord record;
+   ECommandCode eCode;
 
    if (eResponse == EResponseOk)
    {
@@ -1605,32 +1715,28 @@ void BuildReadManufacturerFieldCommandResponse(EHandlerResponse eResponse,
       &&  pResponse != NULL
       &&  pValue    != NULL)
       {
-         // tokenize, split at the ,
-          StrTokenize(pReader, ",");
-
-         // skip the command code
-         // advance pointer to the inserted NULL
-         RestoreDelimiterAndMovePast(&pReader, ',');
-      
-         // split at the =
-         StrTokenize(pReader, "=");
-
-         RestoreDelimiterAndMovePast(&pReader, '=');
-
-         // copy tag
-         strcpy(szFieldName, pReader);
+         request.pData   = pPayload->szPayload;
+         request.nLength = pPayload->nLength;
 
-         memset(pResponse, 0, sizeof(MsgPayload));
-
-         sprintf(pResponse->szPayload,
-            "%s,%d,%s=%s",
-            RESPONSE_PREFIX,
-            EReadManufacturerField,
-            szFieldName,
-            pValue);
+         if (BinaryReadHeader(&request, &eCode, NULL))
+         {
+            // field name is the value of the first record
+            if (BinaryNextRecord(&request, &record) && record.value.nLength < sizeof(szFieldName))
+            {
+               memcpy(szFieldName, record.value.pData, record.value.nLength);
+            }
+         }
+         // skip the command code and the tag, field name is the rest
+         else if (ViewNextField(&request, ',', &field)
+              &&  ViewNextField(&request, '=', &field)
+              &&  request.nLength < sizeof(szFieldName))
+         {
+            ViewToString(&request, szFieldName, sizeof(szFieldName));
+         }
 
-         pResponse->nLength = strlen(pResponse->szPayload);
-         pResponse->nChecksum = CalculateChecksum(pResponse);
+         PayloadWriter_BeginResponse(&writer, pResponse, EReadManufacturerField);
+         PayloadWriter_StringParam(&writer, szFieldName, pValue);
+         PayloadWriter_End(&writer);
 
       }
    }
@@ -1658,16 +1764,12 @@ void BuildReadManufacturerFieldCommandResponse(EHandlerResponse eResponse,
 LIB_API
 void BuildAckCommand(MsgPayload* pPayload)
 {
+   PayloadWriter writer;
+
    if (pPayload != NULL)
    {
-      // clear buffer
-      // format message
-      // calculate length & checksum
-      memset(pPayload, 0, sizeof(MsgPayload));
-
-      sprintf(pPayload->szPayload, "%c", (char)EAck);
-      pPayload->nLength = strlen(pPayload->szPayload);
-      pPayload->nChecksum = CalculateChecksum(pPayload);
+      PayloadWriter_BeginCommand(&writer, pPayload, EAck);
+      PayloadWriter_End(&writer);
    }
 }
 
@@ -1689,16 +1791,13 @@ void BuildAckCommand(MsgPayload* pPayload)
 LIB_API
 void BuildNakCommand(int ErrorCode, MsgPayload* pPayload)
 {
+   PayloadWriter writer;
+
    if (pPayload != NULL)
    {
-      // clear buffer
-      // format message
-      // calculate length & checksum
-      memset(pPayload, 0, sizeof(MsgPayload));
-
-      sprintf(pPayload->szPayload, "%c,%d", (char)ENak, ErrorCode);
-      pPayload->nLength = strlen(pPayload->szPayload);
-      pPayload->nChecksum = CalculateChecksum(pPayload);
+      PayloadWriter_BeginCommand(&writer, pPayload, ENak);
+      PayloadWriter_Value(&writer, ErrorCode);
+      PayloadWriter_End(&writer);
    }
 }
 
@@ -1721,7 +1820,7 @@ LIB_API
 void BuildEnableDisableVacuumCommand(bool bEnabled, MsgPayload* pPayload)
 {
    int nEnabled = bEnabled ? ENABLED : DISABLED;
-   BuildCommandWithIntParameter(EEnableDisableVacuum, TAG_SCAV_ENABLED, nEnabled, pPayload);
+   BuildSchemaCommand(EEnableDisableVacuum, nEnabled, pPayload);
 }
 
 
@@ -1765,37 +1864,15 @@ void BuildScreenReadyCommand(MsgPayload* pPayload)
 LIB_API
 void BuildScreenReadyCommandResponse(EHandlerResponse eResponse, ScreenReady* pScreenReady, MsgPayload* pPayload)
 {
-   int nPowerState = 0;
+   PayloadWriter writer;
 
    if (pPayload != NULL && pScreenReady != NULL)
    {
-      // clear buffer
-      // format message
-      // calculate length & checksum
-      memset(pPayload, 0, sizeof(MsgPayload));
-
-      nPowerState = pScreenReady->bTouchscreenPowerState ? 1 : 0;
-
-      sprintf(pPayload->szPayload,
-         "%d,%s=%d,%s=%d,%s=%d,%s=%d,%s=%d,%s=%s,%s=%d", 
-         EScreenReady,
-         TAG_N2O_MAX,
-         pScreenReady->configData.nMaxN20,
-         TAG_MIX_STEP,
-         pScreenReady->configData.eMixStepSize,
-         TAG_FLOW_STEP,
-         pScreenReady->configData.eFlowStepSize,
-         TAG_CLOCK_FORMAT,
-         pScreenReady->configData.eClockFormat,
-         TAG_LANGUAGE,
-         pScreenReady->configData.eLanguage,
-         TAG_T_AND_D,
-         pScreenReady->configData.szTime,
-         TAG_TS_POWER,
-         nPowerState);
-
-      pPayload->nLength    = strlen(pPayload->szPayload);
-      pPayload->nChecksum = CalculateChecksum(pPayload);
+      // format message, length & checksum are kept as it is written
+      PayloadWriter_BeginCommand(&writer, pPayload, EScreenReady);
+      WriteConfigParameters(&writer, &pScreenReady->configData);
+      PayloadWriter_IntParam(&writer, TAG_TS_POWER, pScreenReady->bTouchscreenPowerState ? 1 : 0);
+      PayloadWriter_End(&writer);
    }
 }
 
@@ -1817,7 +1894,7 @@ void BuildScreenReadyCommandResponse(EHandlerResponse eResponse, ScreenReady* pS
 LIB_API
 void BuildMuteAlarmCommand(MsgPayload* pPayload)
 {
-   BuildCommandWithNoParameter(EMuteAlarm, pPayload);
+   BuildSchemaCommand(EMuteAlarm, 0, pPayload);
 }
 
 /********************************************************************************
@@ -1839,7 +1916,7 @@ LIB_API
 void BuildEnableDisableScreenPowerCommand(bool bEnabled, MsgPayload* pPayload)
 {
    int nEnabled = bEnabled ? ENABLED : DISABLED;
-   BuildCommandWithIntParameter(EEnableDisablePower, TAG_TS_POWER, nEnabled, pPayload);
+   BuildSchemaCommand(EEnableDisablePower, nEnabled, pPayload);
 }
 
 /********************************************************************************
@@ -1881,30 +1958,18 @@ void BuildGetScavengerInfoCommand(MsgPayload* pPayload)
 LIB_API
 void BuildGetScavengerInfoCommandResponse(EHandlerResponse eResponse, ScavengerInfo* pInfo, MsgPayload* pPayload)
 {
-   int nValveOpen    = 0;
-   int nSensorStatus = 0;
+   PayloadWriter writer;
 
    // check buffers before processing
    if(pInfo != NULL && pPayload != NULL)
    {
       if (eResponse == EResponseOk)
       {
-         nValveOpen = pInfo->bValveOpen == true ? 1 : 0;
-         nSensorStatus = pInfo->bSensorStatus == true ? 1 : 0;
-
-         memset(pPayload, 0, sizeof(MsgPayload));
-         sprintf(pPayload->szPayload, 
-            "RSP,%d,%s=%d,%s=%d,%s=%d",
-            EGetScavengerInfo,
-            TAG_SCAV_VALVE,
-            nValveOpen,
-            TAG_SCAV_SENSOR,
-            nSensorStatus,
-            TAG_SCAV_FLOW,
-            pInfo->nFlowRate);
-
-         pPayload->nLength = strlen(pPayload->szPayload);
-         pPayload->nChecksum = CalculateChecksum(pPayload);
+         PayloadWriter_BeginResponse(&writer, pPayload, EGetScavengerInfo);
+         PayloadWriter_IntParam(&writer, TAG_SCAV_VALVE, pInfo->bValveOpen == true ? 1 : 0);
+         PayloadWriter_IntParam(&writer, TAG_SCAV_SENSOR, pInfo->bSensorStatus == true ? 1 : 0);
+         PayloadWriter_IntParam(&writer, TAG_SCAV_FLOW, pInfo->nFlowRate);
+         PayloadWriter_End(&writer);
       }
       else
       {
@@ -1955,25 +2020,18 @@ void BuildGetGasVolumeInfoCommand(MsgPayload* pPayload)
 LIB_API
 void BuildGetGasVolumeInfoCommandResponse(EHandlerResponse eResponse, GasVolumeInfo* pInfo, MsgPayload* pPayload)
 {
+   PayloadWriter writer;
+
    if(pInfo != NULL && pPayload != NULL)
    {
       if (eResponse == EResponseOk)
       {
-         memset(pPayload, 0, sizeof(MsgPayload));
-         sprintf(pPayload->szPayload, 
-            "RSP,%d,%s=%d,%s=%d,%s=%s,%s=%s",
-            EGetGasVolume,
-            TAG_GV_O2,
-            pInfo->nO2VolumeDispensed,
-            TAG_GV_N2O,
-            pInfo->nN2OVolumeDispensed,
-            TAG_GV_RESET_O2,
-            pInfo->szO2LastReset,
-            TAG_GV_RESET_N2O,
-            pInfo->szN2OLastReset);
-
-         pPayload->nLength = strlen(pPayload->szPayload);
-         pPayload->nChecksum = CalculateChecksum(pPayload);
+         PayloadWriter_BeginResponse(&writer, pPayload, EGetGasVolume);
+         PayloadWriter_IntParam(&writer, TAG_GV_O2, pInfo->nO2VolumeDispensed);
+         PayloadWriter_IntParam(&writer, TAG_GV_N2O, pInfo->nN2OVolumeDispensed);
+         PayloadWriter_StringParam(&writer, TAG_GV_RESET_O2, pInfo->szO2LastReset);
+         PayloadWriter_StringParam(&writer, TAG_GV_RESET_N2O, pInfo->szN2OLastReset);
+         PayloadWriter_End(&writer);
       }
       else
       {
@@ -2000,7 +2058,7 @@ void BuildGetGasVolumeInfoCommandResponse(EHandlerResponse eResponse, GasVolumeI
 LIB_API
 void BuildResetGasVolumeInfoCommand(EGasId eId, MsgPayload* pPayload)
 {
-   BuildCommandWithIntParameter(EResetGasVolume, TAG_GAS_SELECTION, eId, pPayload);
+   BuildSchemaCommand(EResetGasVolume, eId, pPayload);
 }
 
 /********************************************************************************
@@ -2022,7 +2080,7 @@ LIB_API
 void BuildFlushO2Command(bool bEnabled, MsgPayload* pPayload)
 {
    int nEnabled = bEnabled ? ENABLED : DISABLED;
-   BuildCommandWithIntParameter(EFlushO2, TAG_FLUSH_O2, nEnabled, pPayload);
+   BuildSchemaCommand(EFlushO2, nEnabled, pPayload);
 }
 
 /********************************************************************************
@@ -2082,7 +2140,7 @@ void SetLogDateTime(uint8_t year,
 LIB_API
 void BuildGetProcedureLogCount(MsgPayload* pPayload)
 {
-   BuildCommandWithNoParameter(EGetProcedureLogCount, pPayload);
+   BuildSchemaCommand(EGetProcedureLogCount, 0, pPayload);
 }
 
 /********************************************************************************
@@ -2103,7 +2161,7 @@ void BuildGetProcedureLogCount(MsgPayload* pPayload)
 LIB_API
 void BuildGetProcedureLogCountResponse(EHandlerResponse eResponse, int nCount, MsgPayload* pPayload)
 {
-   BuildCommandResponseWithIntParameter(eResponse, EGetProcedureLogCount, TAG_P_LOG_COUNT, nCount, pPayload);
+   BuildSchemaResponse(eResponse, EGetProcedureLogCount, nCount, pPayload);
 }
 
 /********************************************************************************
@@ -2124,19 +2182,19 @@ void BuildGetProcedureLogCountResponse(EHandlerResponse eResponse, int nCount, M
 LIB_API
 void BuildGetProcedureLogList(int nOffset, int nCount, MsgPayload* pPayload)
 {
+   PayloadWriter writer;
+   int anValues[ELogListFieldCount];
+
    if(pPayload != NULL)
    {
-      memset(pPayload, 0, sizeof(MsgPayload));
-      sprintf(pPayload->szPayload,
-        "%d,%s=%d,%s=%d",
-         EGetProcedureList,
-         TAG_OFFSET,
-         nOffset,
-         TAG_COUNT,
-         nCount);
-
-      pPayload->nLength = strlen(pPayload->szPayload);
-      pPayload->nChecksum = CalculateChecksum(pPayload);
+      // the index is optional and not sent
+      anValues[ELogListIndex]  = 0;
+      anValues[ELogListOffset] = nOffset;
+      anValues[ELogListCount]  = nCount;
+
+      PayloadWriter_BeginCommand(&writer, pPayload, EGetProcedureList);
+      LOG_LIST_FIELDS(SCHEMA_FIELD_WRITE)
+      PayloadWriter_End(&writer);
    }
 }
       
@@ -2162,60 +2220,16 @@ void BuildGetProcedureLogList(int nOffset, int nCount, MsgPayload* pPayload)
 LIB_API
 void BuildGetProcedureLogListResponse(EHandlerResponse eResponse, int nCount, ProcedureLog* pEntries, MsgPayload* pPayload)
 {
-   char szEntries[PAYLOAD_LENGTH] = { 0 };
-   char* pWriter = szEntries;
-   int nBytesWritten = 0;
-   int nTotalWritten = 0;
-   int nIdx = 0;
+   PayloadWriter writer;
 
    // check buffers before processing
    if(eResponse == EResponseOk)
    {
       if (pPayload != NULL && pEntries != NULL)
       {
-         // clear previous data and format response message
-         memset(pPayload, 0, sizeof(MsgPayload));
-
-         // for each entry
-         for(nIdx = 0 ; nIdx < nCount ; nIdx++)
-         {
-            // Serialize the data
-            nBytesWritten = sprintf(pWriter,
-               "{%s,%d,%d,%hhu,%hhu,%hhu,%hhu,%hhu,%hhu},",
-               pEntries[nIdx].szName,
-               pEntries[nIdx].nDuration,
-               pEntries[nIdx].nEntryCount,
-               pEntries[nIdx].szDate[0],
-               pEntries[nIdx].szDate[1],
-               pEntries[nIdx].szDate[2],
-               pEntries[nIdx].szDate[3],
-               pEntries[nIdx].szDate[4],
-               pEntries[nIdx].szDate[5]);
-
-            pWriter += nBytesWritten;
-            nTotalWritten += nBytesWritten;
-         }
-         ;
-
-         if (nTotalWritten > 0)
-         {
-            // remove trailing comma
-            *(pWriter - 1) = '\0';
-         }
-        
-
-         // format the message payload
-         sprintf(pPayload->szPayload,
-            "%s,%d,%s=%d,%s=%s",
-            RESPONSE_PREFIX,
-            EGetProcedureList,
-            TAG_COUNT,
-            nCount,
-            TAG_LOG_ENTRIES,
-            szEntries);
-
-         pPayload->nLength = strlen(pPayload->szPayload);
-         pPayload->nChecksum = CalculateChecksum(pPayload);
+         PayloadWriter_BeginResponse(&writer, pPayload, EGetProcedureList);
+         WriteProcedureLogList(&writer, nCount, pEntries);
+         PayloadWriter_End(&writer);
       }
    }
    else
@@ -2263,25 +2277,19 @@ void BuildGetProcedureLogCommand(size_t nIndex, MsgPayload* pPayload)
 LIB_API
 void BuildGetProcedureLogEntryListCommand(int nIndex, int nOffset, int nCount, MsgPayload* pPayload)
 {
+   PayloadWriter writer;
+   int anValues[ELogListFieldCount];
+
    if (pPayload != NULL)
    {
-      // clear buffer
-      // format message
-      // calculate length & checksum
-      memset(pPayload, 0, sizeof(MsgPayload));
-
-      sprintf(pPayload->szPayload, 
-         "%d,%s=%d,%s=%d,%s=%d", 
-         EGetProcedureEntryList,
-         TAG_INDEX,
-         nIndex,
-         TAG_OFFSET,
-         nOffset,
-         TAG_COUNT,
-         nCount);
-
-      pPayload->nLength = strlen(pPayload->szPayload);
-      pPayload->nChecksum = CalculateChecksum(pPayload);
+      anValues[ELogListIndex]  = nIndex;
+      anValues[ELogListOffset] = nOffset;
+      anValues[ELogListCount]  = nCount;
+
+      // format message, length & checksum are kept as it is written
+      PayloadWriter_BeginCommand(&writer, pPayload, EGetProcedureEntryList);
+      LOG_ENTRY_LIST_FIELDS(SCHEMA_FIELD_WRITE)
+      PayloadWriter_End(&writer);
    }
 }
 
@@ -2303,60 +2311,16 @@ void BuildGetProcedureLogEntryListCommand(int nIndex, int nOffset, int nCount, M
 LIB_API
 void BuildGetProcedureLogEntryListCommandResponse(EHandlerResponse eResponse, int nCount, LogEntry* pEntries, MsgPayload* pPayload)
 {
-   char szEntries[PAYLOAD_LENGTH] = { 0 };
-   char* pWriter = szEntries;
-   int nBytesWritten = 0;
-   int nTotalWritten = 0;
-   int nIdx = 0;
+   PayloadWriter writer;
 
    // check buffers before processing
    if(eResponse == EResponseOk)
    {
       if (pPayload != NULL && pEntries != NULL)
       {
-         // clear previous data and format response message
-         memset(pPayload, 0, sizeof(MsgPayload));
-
-         // for each entry
-         for(nIdx = 0 ; nIdx < nCount ; nIdx++)
-         {
-            // Serialize the data
-            nBytesWritten = sprintf(pWriter,
-               "{%d,%hu,%hu,%hu,%hu,%hu,%hu,%hu,%hu},",
-               pEntries[nIdx].eId,
-               pEntries[nIdx].nValues[0],
-               pEntries[nIdx].nValues[1],
-               pEntries[nIdx].nValues[2],
-               pEntries[nIdx].nValues[3],
-               pEntries[nIdx].nValues[4],
-               pEntries[nIdx].nValues[5],
-               pEntries[nIdx].nValues[6],
-               pEntries[nIdx].nValues[7]);
-
-            pWriter += nBytesWritten;
-            nTotalWritten += nBytesWritten;
-         }
-         
-
-         if (nTotalWritten > 0)
-         {
-            // remove trailing comma
-            *(pWriter - 1) = '\0';
-         }
-        
-
-         // format the message payload
-         sprintf(pPayload->szPayload,
-            "%s,%d,%s=%d,%s=%s",
-            RESPONSE_PREFIX,
-            EGetProcedureEntryList,
-            TAG_COUNT,
-            nCount,
-            TAG_LOG_ENTRIES,
-            szEntries);
-
-         pPayload->nLength = strlen(pPayload->szPayload);
-         pPayload->nChecksum = CalculateChecksum(pPayload);
+         PayloadWriter_BeginResponse(&writer, pPayload, EGetProcedureEntryList);
+         WriteLogEntryList(&writer, nCount, pEntries);
+         PayloadWriter_End(&writer);
       }
    }
    else
@@ -2364,6 +2328,65 @@ void BuildGetProcedureLogEntryListCommandResponse(EHandlerResponse eResponse, in
       BuildCommandErrorResponse(eResponse, EGetProcedureEntryList, pPayload);
    }
 }
+
+/********************************************************************************
+ *
+ * Name:    BuildGetProcedureLogListMessageResponse
+ *
+ * Purpose: Builds the procedure log list response as one logical message,
+ *          for lists too long for a single payload.
+ *
+ * Inputs:  eResponse   - command handler response code
+ *          nCount      - the number of records in the response
+ *          pEntries    - pointer to array of nCount number of records.
+ *          nBufferSize - size of pBuffer
+ *
+ * Outputs: pBuffer - NULL terminated response message
+ *
+ * Returns: Length of the message, 0 if it didn't fit
+ *
+ * Notes:   The message is sent with Transport_BeginSend.
+ *
+ *******************************************************************************/
+LIB_API
+size_t BuildGetProcedureLogListMessageResponse(EHandlerResponse eResponse,
+                                               int nCount,
+                                               const ProcedureLog* pEntries,
+                                               char* pBuffer,
+                                               size_t nBufferSize)
+{
+   return BuildLogListMessage(eResponse, EGetProcedureList, nCount, pEntries, pBuffer, nBufferSize);
+}
+
+/********************************************************************************
+ *
+ * Name:    BuildGetProcedureLogEntryListMessageResponse
+ *
+ * Purpose: Builds the procedure log entry list response as one logical
+ *          message, so a whole procedure log is returned to one request.
+ *
+ * Inputs:  eResponse   - command handler response code
+ *          nCount      - the number of records in the response
+ *          pEntries    - pointer to array of nCount number of records.
+ *          nBufferSize - size of pBuffer
+ *
+ * Outputs: pBuffer - NULL terminated response message
+ *
+ * Returns: Length of the message, 0 if it didn't fit
+ *
+ * Notes:   The message is sent with Transport_BeginSend.
+ *
+ *******************************************************************************/
+LIB_API
+size_t BuildGetProcedureLogEntryListMessageResponse(EHandlerResponse eResponse,
+                                                    int nCount,
+                                                    const LogEntry* pEntries,
+                                                    char* pBuffer,
+                                                    size_t nBufferSize)
+{
+   return BuildLogListMessage(eResponse, EGetProcedureEntryList, nCount, pEntries, pBuffer, nBufferSize);
+}
+
 /********************************************************************************
  *
  * Name:    BuildSetMaxN20Command
@@ -2382,7 +2405,7 @@ void BuildGetProcedureLogEntryListCommandResponse(EHandlerResponse eResponse, in
 LIB_API
 void BuildSetMaxN20Command(int nMaxN2O, MsgPayload* pPayload)
 {
-   BuildCommandWithIntParameter(ESetN2OMax, TAG_N2O_MAX, nMaxN2O, pPayload);
+   BuildSchemaCommand(ESetN2OMax, nMaxN2O, pPayload);
 }
 
 /********************************************************************************
@@ -2403,7 +2426,7 @@ void BuildSetMaxN20Command(int nMaxN2O, MsgPayload* pPayload)
 LIB_API
 void BuildGetMaxN2OCommand(MsgPayload* pPayload)
 {
-   BuildCommandWithNoParameter(EGetN2OMax, pPayload);
+   BuildSchemaCommand(EGetN2OMax, 0, pPayload);
 }
 
 /********************************************************************************
@@ -2425,7 +2448,7 @@ LIB_API
 void BuildGetMaxN2OCommandResponse(EHandlerResponse eResponse, int nMaxN2O, MsgPayload* pPayload)
 {
    // populate buffer with command response
-   BuildCommandResponseWithIntParameter(eResponse, EGetN2OMax, TAG_N2O_MAX, nMaxN2O, pPayload);
+   BuildSchemaResponse(eResponse, EGetN2OMax, nMaxN2O, pPayload);
 }
 
 /********************************************************************************
@@ -2446,7 +2469,7 @@ void BuildGetMaxN2OCommandResponse(EHandlerResponse eResponse, int nMaxN2O, MsgP
 LIB_API
 void BuildSetMixStepSizeCommand(EMixStepSize eStepSize, MsgPayload* pPayload)
 {
-   BuildCommandWithIntParameter(ESetMixStepSize, TAG_MIX_STEP, eStepSize, pPayload);
+   BuildSchemaCommand(ESetMixStepSize, eStepSize, pPayload);
 }
 
 /********************************************************************************
@@ -2512,7 +2535,7 @@ void BuildGetMixStepSizeCommandResponse(EHandlerResponse eResponse,
 LIB_API
 void BuildSetFlowRateStepSizeCommand(EFlowRateStepSize eStepSize, MsgPayload* pPayload)
 {
-   BuildCommandWithIntParameter(ESetFlowRateStepSize, TAG_FLOW_STEP, eStepSize, pPayload);
+   BuildSchemaCommand(ESetFlowRateStepSize, eStepSize, pPayload);
 }
 
 /********************************************************************************
@@ -2579,7 +2602,7 @@ LIB_API
 void BuildSetClockFormatCommand(EClockFormat eFormat, MsgPayload* pPayload)
 {
    // build the command
-   BuildCommandWithIntParameter(ESetClockFormat, TAG_CLOCK_FORMAT, eFormat, pPayload);
+   BuildSchemaCommand(ESetClockFormat, eFormat, pPayload);
 }
 
 /********************************************************************************
@@ -2689,5 +2712,5 @@ LIB_API
 void BuildEnableDisableBtCommand(bool bEnable, MsgPayload* pPayload)
 {
    int nEnabled = bEnable ? ENABLED : DISABLED;
-   BuildCommandWithIntParameter(EEnableDisableBT, TAG_BT_ENABLED, nEnabled, pPayload);
+   BuildSchemaCommand(EEnableDisableBT, nEnabled, pPayload);
 }
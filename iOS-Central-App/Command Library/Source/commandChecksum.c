@@ -0,0 +1,369 @@
+/*********************************************************************************
+*
+*                          Proprietary Information of
+*
+*                            Precision Systems, Inc.
+*                    1355 Business Center Drive, Suite C
+*                                 Horsham, PA
+*                               (215) 672-1860
+*
+*                   Copyright (C) 2020, Precision Systems, Inc.
+*                            All Rights Reserved
+*
+*             The information and design as detailed in this document is
+*     the property of Precision Systems, Inc., and/or its Associates
+*     and must be returned on demand. It is issued on the strict
+*     condition that except with our written permission it must not be
+*     reproduced, copied or communicated to any third party, nor be
+*     used for any purpose other than that stated in the particular
+*     inquiry, order or contract with which it is issued. The
+*     reservation of copyright in this document extends from each date
+*     appearing thereon and in respect of the subject matter as it
+*     appeared at the relevant date.
+*
+********************************************************************************/
+/********************************************************************************
+*
+* PROJECT:     Project MIDAS
+*
+* COMPILER:    
+*
+* TOOLS:       Microsoft Visual Studio 2019
+*
+* DESCRIPTION: Frame checksum calculation
+*
+* NOTES:       x86 sums 16 or 32 bytes per instruction with psadbw (sum of
+*              absolute differences against zero). ARM uses NEON pairwise
+*              widening adds. Everything else adds a byte at a time.
+*
+********************************************************************************/
+#include <string.h>
+#include "commandChecksum.h"
+#include "commandAtomic.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+   #include <emmintrin.h>
+   #define CHECKSUM_SSE2
+#endif
+
+#if defined(__AVX2__)
+   #include <immintrin.h>
+   #define CHECKSUM_AVX2
+#elif defined(CHECKSUM_SSE2) && defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+   // AVX2 built for this function only, used if the CPU has it
+   #include <immintrin.h>
+   #define CHECKSUM_AVX2
+   #define CHECKSUM_AVX2_DISPATCH
+#endif
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+   #include <arm_neon.h>
+   #define CHECKSUM_NEON
+#endif
+
+/********************************************************************************
+*                          D E F I N I T I O N S
+********************************************************************************/
+// NEON 16 bit lanes can take this many 16 byte blocks before they overflow
+#define NEON_BLOCKS_PER_FLUSH 128
+
+typedef uint32_t(*FnSumBytes)(const uint8_t* pBytes, size_t nLength);
+
+/*********************************************************************************
+*                               D A T A
+*********************************************************************************/
+#ifdef CHECKSUM_AVX2_DISPATCH
+// selected on first use
+static FnSumBytes m_fpSumBytes = NULL;
+#endif
+
+/*********************************************************************************
+*                    F U N C T I O N   D E F I N I T I O N S
+*********************************************************************************/
+/********************************************************************************
+ *
+ * Name:    SumBytesScalar
+ *
+ * Purpose: Adds up bytes one at a time
+ *
+ * Inputs:  pBytes  - data to sum
+ *          nLength - number of bytes in pBytes
+ *
+ * Outputs: None
+ *
+ * Returns: Sum of the bytes
+ *
+ * Notes:   Used for short tails and on targets without vector instructions.
+ *
+ *******************************************************************************/
+static uint32_t SumBytesScalar(const uint8_t* pBytes, size_t nLength)
+{
+   uint32_t nSum  = 0;
+   size_t nCount  = 0;
+
+   for (nCount = 0; nCount < nLength; nCount++)
+   {
+      nSum += pBytes[nCount];
+   }
+
+   return nSum;
+}
+
+#ifdef CHECKSUM_SSE2
+/********************************************************************************
+ *
+ * Name:    SumBytesSse2
+ *
+ * Purpose: Adds up bytes 16 at a time
+ *
+ * Inputs:  pBytes  - data to sum
+ *          nLength - number of bytes in pBytes
+ *
+ * Outputs: None
+ *
+ * Returns: Sum of the bytes
+ *
+ * Notes:   psadbw leaves one partial sum in each 64 bit half.
+ *
+ *******************************************************************************/
+static uint32_t SumBytesSse2(const uint8_t* pBytes, size_t nLength)
+{
+   const __m128i zero = _mm_setzero_si128();
+   __m128i sum        = _mm_setzero_si128();
+   size_t nOffset     = 0;
+
+   for (nOffset = 0; nOffset + 16 <= nLength; nOffset += 16)
+   {
+      sum = _mm_add_epi64(sum, _mm_sad_epu8(_mm_loadu_si128((const __m128i*)(pBytes + nOffset)), zero));
+   }
+
+   sum = _mm_add_epi64(sum, _mm_srli_si128(sum, 8));
+
+   return (uint32_t)_mm_cvtsi128_si32(sum) + SumBytesScalar(pBytes + nOffset, nLength - nOffset);
+}
+#endif
+
+#ifdef CHECKSUM_AVX2
+/********************************************************************************
+ *
+ * Name:    SumBytesAvx2
+ *
+ * Purpose: Adds up bytes 32 at a time
+ *
+ * Inputs:  pBytes  - data to sum
+ *          nLength - number of bytes in pBytes
+ *
+ * Outputs: None
+ *
+ * Returns: Sum of the bytes
+ *
+ * Notes:   The 16 byte step for the tail is done here rather than in
+ *          SumBytesSse2. Calling non-VEX SSE code with the upper halves of
+ *          the registers in use costs more than the whole sum.
+ *
+ *******************************************************************************/
+#ifdef CHECKSUM_AVX2_DISPATCH
+__attribute__((target("avx2")))
+#endif
+static uint32_t SumBytesAvx2(const uint8_t* pBytes, size_t nLength)
+{
+   const __m256i zero = _mm256_setzero_si256();
+   __m256i sum        = _mm256_setzero_si256();
+   __m128i half;
+   size_t nOffset     = 0;
+
+   for (nOffset = 0; nOffset + 32 <= nLength; nOffset += 32)
+   {
+      sum = _mm256_add_epi64(sum, _mm256_sad_epu8(_mm256_loadu_si256((const __m256i*)(pBytes + nOffset)), zero));
+   }
+
+   half = _mm_add_epi64(_mm256_castsi256_si128(sum), _mm256_extracti128_si256(sum, 1));
+
+   if (nOffset + 16 <= nLength)
+   {
+      half = _mm_add_epi64(half, _mm_sad_epu8(_mm_loadu_si128((const __m128i*)(pBytes + nOffset)), _mm_setzero_si128()));
+      nOffset += 16;
+   }
+
+   half = _mm_add_epi64(half, _mm_srli_si128(half, 8));
+
+   return (uint32_t)_mm_cvtsi128_si32(half) + SumBytesScalar(pBytes + nOffset, nLength - nOffset);
+}
+#endif
+
+#ifdef CHECKSUM_NEON
+/********************************************************************************
+ *
+ * Name:    SumBytesNeon
+ *
+ * Purpose: Adds up bytes 16 at a time
+ *
+ * Inputs:  pBytes  - data to sum
+ *          nLength - number of bytes in pBytes
+ *
+ * Outputs: None
+ *
+ * Returns: Sum of the bytes
+ *
+ * Notes:   Bytes are added in pairs into 16 bit lanes, which are folded
+ *          into 32 bit lanes before they can overflow.
+ *
+ *******************************************************************************/
+static uint32_t SumBytesNeon(const uint8_t* pBytes, size_t nLength)
+{
+   uint32x4_t sum32 = vdupq_n_u32(0);
+   uint16x8_t sum16 = vdupq_n_u16(0);
+   size_t nBlocks   = 0;
+   size_t nOffset   = 0;
+
+   for (nOffset = 0; nOffset + 16 <= nLength; nOffset += 16)
+   {
+      sum16 = vpadalq_u8(sum16, vld1q_u8(pBytes + nOffset));
+
+      if (++nBlocks == NEON_BLOCKS_PER_FLUSH)
+      {
+         sum32   = vpadalq_u16(sum32, sum16);
+         sum16   = vdupq_n_u16(0);
+         nBlocks = 0;
+      }
+   }
+
+   sum32 = vpadalq_u16(sum32, sum16);
+
+   return vgetq_lane_u32(sum32, 0) + vgetq_lane_u32(sum32, 1)
+        + vgetq_lane_u32(sum32, 2) + vgetq_lane_u32(sum32, 3)
+        + SumBytesScalar(pBytes + nOffset, nLength - nOffset);
+}
+#endif
+
+/********************************************************************************
+ *
+ * Name:    SumBytes
+ *
+ * Purpose: Adds up bytes with the widest method the build and CPU support
+ *
+ * Inputs:  pBytes  - data to sum
+ *          nLength - number of bytes in pBytes
+ *
+ * Outputs: None
+ *
+ * Returns: Sum of the bytes
+ *
+ * Notes:   None
+ *
+ *******************************************************************************/
+static uint32_t SumBytes(const uint8_t* pBytes, size_t nLength)
+{
+#if defined(CHECKSUM_AVX2_DISPATCH)
+   FnSumBytes fpSumBytes = LOAD_ACQUIRE(m_fpSumBytes);
+
+   if (fpSumBytes == NULL)
+   {
+      __builtin_cpu_init();
+      fpSumBytes = __builtin_cpu_supports("avx2") ? SumBytesAvx2 : SumBytesSse2;
+      STORE_RELEASE(m_fpSumBytes, fpSumBytes);
+   }
+
+   return fpSumBytes(pBytes, nLength);
+#elif defined(CHECKSUM_AVX2)
+   return SumBytesAvx2(pBytes, nLength);
+#elif defined(CHECKSUM_SSE2)
+   return SumBytesSse2(pBytes, nLength);
+#elif defined(CHECKSUM_NEON)
+   return SumBytesNeon(pBytes, nLength);
+#else
+   return SumBytesScalar(pBytes, nLength);
+#endif
+}
+
+/********************************************************************************
+ *
+ * Name:    ChecksumInit
+ *
+ * Purpose: Starts a new checksum
+ *
+ * Inputs:  None
+ *
+ * Outputs: pState - cleared
+ *
+ * Returns: None
+ *
+ * Notes:   None
+ *
+ *******************************************************************************/
+LIB_API
+void ChecksumInit(ChecksumState* pState)
+{
+   if (pState != NULL)
+   {
+      pState->nSum = 0;
+   }
+}
+
+/********************************************************************************
+ *
+ * Name:    ChecksumUpdate
+ *
+ * Purpose: Adds bytes to a running checksum
+ *
+ * Inputs:  pBytes  - data to add
+ *          nLength - number of bytes in pBytes
+ *
+ * Outputs: pState - updated with the data
+ *
+ * Returns: None
+ *
+ * Notes:   The sum wraps at 32 bits, which doesn't change the low 8 bits.
+ *
+ *******************************************************************************/
+LIB_API
+void ChecksumUpdate(ChecksumState* pState, const void* pBytes, size_t nLength)
+{
+   if (pState != NULL && pBytes != NULL)
+   {
+      pState->nSum += SumBytes((const uint8_t*)pBytes, nLength);
+   }
+}
+
+/********************************************************************************
+ *
+ * Name:    ChecksumFinal
+ *
+ * Purpose: Returns the frame checksum for the data added so far
+ *
+ * Inputs:  pState - running checksum
+ *
+ * Outputs: None
+ *
+ * Returns: 8 bit frame checksum
+ *
+ * Notes:   The state can still be updated afterwards.
+ *
+ *******************************************************************************/
+LIB_API
+uint8_t ChecksumFinal(const ChecksumState* pState)
+{
+   return (pState != NULL) ? (uint8_t)pState->nSum : 0;
+}
+
+/********************************************************************************
+ *
+ * Name:    ChecksumBytes
+ *
+ * Purpose: Calculates the frame checksum of a buffer in one call
+ *
+ * Inputs:  pBytes  - data to sum
+ *          nLength - number of bytes in pBytes
+ *
+ * Outputs: None
+ *
+ * Returns: 8 bit frame checksum
+ *
+ * Notes:   None
+ *
+ *******************************************************************************/
+LIB_API
+uint8_t ChecksumBytes(const void* pBytes, size_t nLength)
+{
+   return (pBytes != NULL) ? (uint8_t)SumBytes((const uint8_t*)pBytes, nLength) : 0;
+}
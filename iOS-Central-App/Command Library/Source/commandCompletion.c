@@ -0,0 +1,363 @@
+/*********************************************************************************
+*
+*                          Proprietary Information of
+*
+*                            Precision Systems, Inc.
+*                    1355 Business Center Drive, Suite C
+*                                 Horsham, PA
+*                               (215) 672-1860
+*
+*                   Copyright (C) 2020, Precision Systems, Inc.
+*                            All Rights Reserved
+*
+*             The information and design as detailed in this document is
+*     the property of Precision Systems, Inc., and/or its Associates
+*     and must be returned on demand. It is issued on the strict
+*     condition that except with our written permission it must not be
+*     reproduced, copied or communicated to any third party, nor be
+*     used for any purpose other than that stated in the particular
+*     inquiry, order or contract with which it is issued. The
+*     reservation of copyright in this document extends from each date
+*     appearing thereon and in respect of the subject matter as it
+*     appeared at the relevant date.
+*
+********************************************************************************/
+/********************************************************************************
+*
+* PROJECT:     Project MIDAS
+*
+* COMPILER:    
+*
+* TOOLS:       Microsoft Visual Studio 2019
+*
+* DESCRIPTION: Completion of commands run by async handlers
+*
+* NOTES:       A token is the slot number plus one in its low bits and the
+*              slot's generation above them, so a token from a completed
+*              command no longer matches once its slot is reused.
+*
+*              Slots are handed from the dispatch thread to the completing
+*              thread by nState, which holds the slot's state and generation.
+*              It is claimed with a compare-exchange against the token and
+*              set free or waiting with a release store, so the rest of the
+*              slot is written before it is handed over and read after.
+*
+********************************************************************************/
+#include <string.h>
+#include "commandAtomic.h"
+#include "commandCompletion.h"
+#include "commandBuilder.h"
+#include "commandSession.h"
+
+/********************************************************************************
+*                          D E F I N I T I O N S
+********************************************************************************/
+#define PENDING_SLOT_BITS   4
+#define PENDING_SLOT_MASK   ((1u << PENDING_SLOT_BITS) - 1u)
+
+// PendingCommand nState, generation above the EPendingState
+#define PENDING_STATE_BITS              2
+#define PENDING_STATE_MASK              ((1u << PENDING_STATE_BITS) - 1u)
+#define PENDING_STATE(nGeneration, e)   (((uint32_t)(nGeneration) << PENDING_STATE_BITS) | (uint32_t)(e))
+#define PENDING_GENERATION(nState)      ((uint32_t)(nState) >> PENDING_STATE_BITS)
+
+// state of a slot
+typedef enum _EPendingState
+{
+   EPendingFree,           // may be taken by BeginPendingCommand
+   EPendingWaiting,        // handed to an async handler
+   EPendingCompleting      // response being built and sent
+} EPendingState;
+
+/*********************************************************************************
+*                        H E L P E R   F U N C T I O N S
+*********************************************************************************/
+/********************************************************************************
+ *
+ * Name:    ClaimPending
+ *
+ * Purpose: Finds the waiting command for a token and marks it completing
+ *
+ * Inputs:  token - token from BeginPendingCommand
+ *
+ * Outputs: None
+ *
+ * Returns: Command slot, NULL if the token is unknown or already completed
+ *
+ * Notes:   The generation is compared in the same exchange as the state, so
+ *          a stale token can't claim a slot that has been taken again.
+ *
+ *******************************************************************************/
+static PendingCommand* ClaimPending(CommandToken token)
+{
+   PendingCommand* pSlot = NULL;
+   uint32_t nSlot        = token & PENDING_SLOT_MASK;
+   uint32_t nGeneration  = token >> PENDING_SLOT_BITS;
+   uint32_t nWaiting     = PENDING_STATE(nGeneration, EPendingWaiting);
+
+   if (nSlot >= 1 && nSlot <= PENDING_COMMAND_MAX)
+   {
+      pSlot = &CmdSession_Current()->pending.commands[nSlot - 1];
+
+      if (!COMPARE_EXCHANGE(pSlot->nState, nWaiting, PENDING_STATE(nGeneration, EPendingCompleting)))
+      {
+         pSlot = NULL;
+      }
+   }
+
+   return pSlot;
+}
+
+/********************************************************************************
+ *
+ * Name:    FreePending
+ *
+ * Purpose: Hands a claimed slot back to BeginPendingCommand
+ *
+ * Inputs:  pSlot - slot from ClaimPending
+ *
+ * Outputs: None
+ *
+ * Returns: None
+ *
+ * Notes:   The generation is kept, BeginPendingCommand advances it.
+ *
+ *******************************************************************************/
+static void FreePending(PendingCommand* pSlot)
+{
+   STORE_RELEASE(pSlot->nState, PENDING_STATE(PENDING_GENERATION(pSlot->nState), EPendingFree));
+}
+
+/********************************************************************************
+ *
+ * Name:    SendCompletion
+ *
+ * Purpose: Sends the response for a completed command and frees its slot
+ *
+ * Inputs:  pSlot     - slot from ClaimPending
+ *          pResponse - response, sequence number not yet set
+ *
+ * Outputs: None
+ *
+ * Returns: EResponseOk if the response was sent, EOpNotAllowed if there is
+ *          no fpSendResponse handler and the session can't write it
+ *
+ * Notes:   Without fpSendResponse the response goes to the session's
+ *          fpWrite, see CmdSession_Init.
+ *
+ *******************************************************************************/
+static EHandlerResponse SendCompletion(PendingCommand* pSlot, MsgPayload* pResponse)
+{
+   const CommandHandlers* pHandlers = AcquireCommandHandlers();
+   EHandlerResponse eResponse = EOpNotAllowed;
+
+   // answered with the sequence number it was asked with
+   pResponse->bSequenced = pSlot->request.bSequenced;
+   pResponse->nSequence  = pSlot->request.nSequence;
+
+   if (pHandlers->fpSendResponse != NULL)
+   {
+      pHandlers->fpSendResponse(pResponse);
+      eResponse = EResponseOk;
+   }
+   else if (CmdSession_SendPayload(CmdSession_Current(), pResponse))
+   {
+      eResponse = EResponseOk;
+   }
+
+   ReleaseCommandHandlers(pHandlers);
+   FreePending(pSlot);
+
+   return eResponse;
+}
+
+/*********************************************************************************
+*                    F U N C T I O N   D E F I N I T I O N S
+*********************************************************************************/
+/********************************************************************************
+ *
+ * Name:    BeginPendingCommand
+ *
+ * Purpose: Keeps a command for an async handler
+ *
+ * Inputs:  pRequest - received command payload
+ *          eCode    - command code
+ *
+ * Outputs: pToken - token for the handler
+ *
+ * Returns: false if PENDING_COMMAND_MAX commands are already pending
+ *
+ * Notes:   Only the dispatch thread takes free slots.
+ *
+ *******************************************************************************/
+LIB_API
+bool BeginPendingCommand(const MsgPayload* pRequest, ECommandCode eCode, CommandToken* pToken)
+{
+   PendingCommand* pPending = CmdSession_Current()->pending.commands;
+   PendingCommand* pSlot    = NULL;
+   uint32_t nGeneration     = 0;
+   size_t nIdx              = 0;
+
+   for (nIdx = 0; nIdx < PENDING_COMMAND_MAX && pSlot == NULL; nIdx++)
+   {
+      if ((LOAD_ACQUIRE(pPending[nIdx].nState) & PENDING_STATE_MASK) == EPendingFree)
+      {
+         pSlot = &pPending[nIdx];
+      }
+   }
+
+   if (pSlot != NULL)
+   {
+      nGeneration    = (PENDING_GENERATION(pSlot->nState) + 1) & (UINT32_MAX >> PENDING_SLOT_BITS);
+      pSlot->eCode   = eCode;
+      pSlot->request = *pRequest;
+      STORE_RELEASE(pSlot->nState, PENDING_STATE(nGeneration, EPendingWaiting));
+
+      // slot number counts from 1 so no token is COMMAND_TOKEN_NONE
+      *pToken = (nGeneration << PENDING_SLOT_BITS) | (uint32_t)(pSlot - pPending + 1);
+   }
+
+   return pSlot != NULL;
+}
+
+/********************************************************************************
+ *
+ * Name:    CancelPendingCommand
+ *
+ * Purpose: Releases a pending command without answering it
+ *
+ * Inputs:  token - token from BeginPendingCommand
+ *
+ * Outputs: None
+ *
+ * Returns: None
+ *
+ * Notes:   None.
+ *
+ *******************************************************************************/
+LIB_API
+void CancelPendingCommand(CommandToken token)
+{
+   PendingCommand* pSlot = ClaimPending(token);
+
+   if (pSlot != NULL)
+   {
+      FreePending(pSlot);
+   }
+}
+
+/********************************************************************************
+ *
+ * Name:    CompleteCommand
+ *
+ * Purpose: Answers a command an async handler has finished
+ *
+ * Inputs:  token   - token the handler was given
+ *          eResult - handler result, EResponseOk or an error
+ *
+ * Outputs: None
+ *
+ * Returns: EResponseOk if the response was sent, EInvalidParameters for an
+ *          unknown or completed token, EOpNotAllowed if there is no
+ *          fpSendResponse handler and the session can't write it
+ *
+ * Notes:   Runs fpSendResponse on the calling thread.
+ *
+ *******************************************************************************/
+LIB_API
+EHandlerResponse CompleteCommand(CommandToken token, EHandlerResponse eResult)
+{
+   EHandlerResponse eResponse = EInvalidParameters;
+   PendingCommand* pSlot      = ClaimPending(token);
+   MsgPayload response;
+
+   if (pSlot != NULL)
+   {
+      if (eResult == EResponseOk)
+      {
+         BuildCommandEchoResponse(eResult, pSlot->eCode, &pSlot->request, &response);
+      }
+      else
+      {
+         BuildCommandErrorResponse(eResult, pSlot->eCode, &response);
+      }
+
+      eResponse = SendCompletion(pSlot, &response);
+   }
+
+   return eResponse;
+}
+
+/********************************************************************************
+ *
+ * Name:    CompleteReadManufacturerField
+ *
+ * Purpose: Answers a read manufacturer field command
+ *
+ * Inputs:  token    - token the handler was given
+ *          eResult  - handler result, EResponseOk or an error
+ *          pszValue - field value, used when eResult is EResponseOk
+ *
+ * Outputs: None
+ *
+ * Returns: See CompleteCommand
+ *
+ * Notes:   None.
+ *
+ *******************************************************************************/
+LIB_API
+EHandlerResponse CompleteReadManufacturerField(CommandToken token, EHandlerResponse eResult, const char* pszValue)
+{
+   EHandlerResponse eResponse = EInvalidParameters;
+   PendingCommand* pSlot      = ClaimPending(token);
+   MsgPayload response;
+
+   if (pSlot != NULL)
+   {
+      if (eResult == EResponseOk && pSlot->eCode == EReadManufacturerField && pszValue != NULL)
+      {
+         BuildReadManufacturerFieldCommandResponse(eResult, pszValue, &pSlot->request, &response);
+      }
+      else
+      {
+         BuildCommandErrorResponse(eResult == EResponseOk ? EInvalidParameters : eResult, pSlot->eCode, &response);
+      }
+
+      eResponse = SendCompletion(pSlot, &response);
+   }
+
+   return eResponse;
+}
+
+/********************************************************************************
+ *
+ * Name:    PendingCommandCount
+ *
+ * Purpose: Counts the commands waiting for an async handler
+ *
+ * Inputs:  None
+ *
+ * Outputs: None
+ *
+ * Returns: Number of pending commands
+ *
+ * Notes:   None.
+ *
+ *******************************************************************************/
+LIB_API
+size_t PendingCommandCount(void)
+{
+   const PendingCommand* pPending = CmdSession_Current()->pending.commands;
+   size_t nCount                  = 0;
+   size_t nIdx                    = 0;
+
+   for (nIdx = 0; nIdx < PENDING_COMMAND_MAX; nIdx++)
+   {
+      if ((LOAD_ACQUIRE(pPending[nIdx].nState) & PENDING_STATE_MASK) != EPendingFree)
+      {
+         nCount++;
+      }
+   }
+
+   return nCount;
+}
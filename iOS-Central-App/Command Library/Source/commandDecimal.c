@@ -0,0 +1,428 @@
+/*********************************************************************************
+*
+*                          Proprietary Information of
+*
+*                            Precision Systems, Inc.
+*                    1355 Business Center Drive, Suite C
+*                                 Horsham, PA
+*                               (215) 672-1860
+*
+*                   Copyright (C) 2020, Precision Systems, Inc.
+*                            All Rights Reserved
+*
+*             The information and design as detailed in this document is
+*     the property of Precision Systems, Inc., and/or its Associates
+*     and must be returned on demand. It is issued on the strict
+*     condition that except with our written permission it must not be
+*     reproduced, copied or communicated to any third party, nor be
+*     used for any purpose other than that stated in the particular
+*     inquiry, order or contract with which it is issued. The
+*     reservation of copyright in this document extends from each date
+*     appearing thereon and in respect of the subject matter as it
+*     appeared at the relevant date.
+*
+********************************************************************************/
+/********************************************************************************
+*
+* PROJECT:     Project MIDAS
+*
+* COMPILER:    
+*
+* TOOLS:       Microsoft Visual Studio 2019
+*
+* DESCRIPTION: Decimal number parsing and formatting
+*
+* NOTES:       Parsing checks and converts eight digits at a time held in a
+*              64 bit integer (SWAR, SIMD within a register), then four,
+*              then one at a time for what is left. Bytes are assembled
+*              into the integer with shifts so byte order doesn't matter.
+*
+*              Formatting writes two digits per step from a table of the
+*              pairs "00" to "99", halving the divides.
+*
+********************************************************************************/
+#include <limits.h>
+#include "commandDecimal.h"
+
+/********************************************************************************
+*                          D E F I N I T I O N S
+********************************************************************************/
+#define SWAR_ZEROS8     0x3030303030303030ull
+#define SWAR_SIXES8     0x0606060606060606ull
+#define SWAR_HIGH8      0xF0F0F0F0F0F0F0F0ull
+#define SWAR_ZEROS4     0x30303030u
+#define SWAR_SIXES4     0x06060606u
+#define SWAR_HIGH4      0xF0F0F0F0u
+
+/*********************************************************************************
+*                               D A T A
+*********************************************************************************/
+// "00" to "99", the pair for n starts at index 2n
+static const char m_szDigitPairs[] =
+   "0001020304050607080910111213141516171819"
+   "2021222324252627282930313233343536373839"
+   "4041424344454647484950515253545556575859"
+   "6061626364656667686970717273747576777879"
+   "8081828384858687888990919293949596979899";
+
+// smallest value with n + 2 digits
+static const uint32_t m_nPowers[] =
+{
+   10u, 100u, 1000u, 10000u, 100000u, 1000000u, 10000000u, 100000000u, 1000000000u
+};
+
+/*********************************************************************************
+*                    F U N C T I O N   D E F I N I T I O N S
+*********************************************************************************/
+/********************************************************************************
+ *
+ * Name:    ParseEight
+ *
+ * Purpose: Checks and converts eight decimal digits
+ *
+ * Inputs:  pText - the digits, first is the most significant
+ *
+ * Outputs: pnValue - converted value, 0 to 99999999
+ *
+ * Returns: false if any of the bytes is not a digit
+ *
+ * Notes:   A byte is a digit if its high nibble is 3 and adding 6 leaves
+ *          it at 3. Adding 6 can't carry between bytes once every high
+ *          nibble is known to be 3. The conversion then combines
+ *          neighbouring bytes into pairs, pairs into fours and fours into
+ *          the eight digit value, three multiplies in all.
+ *
+ *******************************************************************************/
+static bool ParseEight(const char* pText, uint32_t* pnValue)
+{
+   const uint8_t* pBytes = (const uint8_t*)pText;
+   uint64_t nChunk = (uint64_t)pBytes[0]         | ((uint64_t)pBytes[1] << 8)
+                   | ((uint64_t)pBytes[2] << 16) | ((uint64_t)pBytes[3] << 24)
+                   | ((uint64_t)pBytes[4] << 32) | ((uint64_t)pBytes[5] << 40)
+                   | ((uint64_t)pBytes[6] << 48) | ((uint64_t)pBytes[7] << 56);
+   bool bDigits    = ((nChunk & SWAR_HIGH8) == SWAR_ZEROS8)
+                  && (((nChunk + SWAR_SIXES8) & SWAR_HIGH8) == SWAR_ZEROS8);
+
+   if (bDigits)
+   {
+      nChunk -= SWAR_ZEROS8;
+      nChunk  = ((nChunk * 10) + (nChunk >> 8)) & 0x00FF00FF00FF00FFull;
+      nChunk  = ((nChunk * 100) + (nChunk >> 16)) & 0x0000FFFF0000FFFFull;
+      nChunk  = ((nChunk * 10000) + (nChunk >> 32)) & 0x00000000FFFFFFFFull;
+      *pnValue = (uint32_t)nChunk;
+   }
+
+   return bDigits;
+}
+
+/********************************************************************************
+ *
+ * Name:    ParseFour
+ *
+ * Purpose: Checks and converts four decimal digits
+ *
+ * Inputs:  pText - the digits, first is the most significant
+ *
+ * Outputs: pnValue - converted value, 0 to 9999
+ *
+ * Returns: false if any of the bytes is not a digit
+ *
+ * Notes:   Same as ParseEight in a 32 bit integer.
+ *
+ *******************************************************************************/
+static bool ParseFour(const char* pText, uint32_t* pnValue)
+{
+   const uint8_t* pBytes = (const uint8_t*)pText;
+   uint32_t nChunk = (uint32_t)pBytes[0]         | ((uint32_t)pBytes[1] << 8)
+                   | ((uint32_t)pBytes[2] << 16) | ((uint32_t)pBytes[3] << 24);
+   bool bDigits    = ((nChunk & SWAR_HIGH4) == SWAR_ZEROS4)
+                  && (((nChunk + SWAR_SIXES4) & SWAR_HIGH4) == SWAR_ZEROS4);
+
+   if (bDigits)
+   {
+      nChunk -= SWAR_ZEROS4;
+      nChunk  = ((nChunk * 10) + (nChunk >> 8)) & 0x00FF00FFu;
+      nChunk  = ((nChunk * 100) + (nChunk >> 16)) & 0x0000FFFFu;
+      *pnValue = nChunk;
+   }
+
+   return bDigits;
+}
+
+/********************************************************************************
+ *
+ * Name:    CountDigits
+ *
+ * Purpose: Returns the number of decimal digits in a value
+ *
+ * Inputs:  nValue - value to check
+ *
+ * Outputs: None
+ *
+ * Returns: 1 to 10
+ *
+ * Notes:   None
+ *
+ *******************************************************************************/
+static size_t CountDigits(uint32_t nValue)
+{
+   size_t nDigits = 1;
+
+   while (nDigits <= sizeof(m_nPowers) / sizeof(m_nPowers[0]) && nValue >= m_nPowers[nDigits - 1])
+   {
+      nDigits++;
+   }
+
+   return nDigits;
+}
+
+/********************************************************************************
+ *
+ * Name:    WriteDigits
+ *
+ * Purpose: Writes the low digits of a value, two at a time
+ *
+ * Inputs:  nValue  - value to write
+ *          nDigits - number of digits to write
+ *
+ * Outputs: pDest - digits written
+ *
+ * Returns: None
+ *
+ * Notes:   Zero padded when the value has fewer digits than nDigits.
+ *
+ *******************************************************************************/
+static void WriteDigits(char* pDest, uint32_t nValue, size_t nDigits)
+{
+   size_t nPair = 0;
+
+   while (nDigits >= 2)
+   {
+      nPair    = (size_t)(nValue % 100) * 2;
+      nValue  /= 100;
+      nDigits -= 2;
+
+      pDest[nDigits]     = m_szDigitPairs[nPair];
+      pDest[nDigits + 1] = m_szDigitPairs[nPair + 1];
+   }
+
+   if (nDigits == 1)
+   {
+      pDest[0] = (char)('0' + nValue % 10);
+   }
+}
+
+/********************************************************************************
+ *
+ * Name:    DecimalDigitRun
+ *
+ * Purpose: Counts the decimal digits at the start of some text
+ *
+ * Inputs:  pText   - text to check
+ *          nLength - number of bytes in pText
+ *
+ * Outputs: None
+ *
+ * Returns: Number of leading digits
+ *
+ * Notes:   Skips whole blocks of eight digits, then finds the end of the
+ *          run a byte at a time.
+ *
+ *******************************************************************************/
+LIB_API
+size_t DecimalDigitRun(const char* pText, size_t nLength)
+{
+   size_t nRun     = 0;
+   uint32_t nValue = 0;
+
+   while (nLength - nRun >= 8 && ParseEight(pText + nRun, &nValue))
+   {
+      nRun += 8;
+   }
+
+   while (nRun < nLength && pText[nRun] >= '0' && pText[nRun] <= '9')
+   {
+      nRun++;
+   }
+
+   return nRun;
+}
+
+/********************************************************************************
+ *
+ * Name:    DecimalParse
+ *
+ * Purpose: Converts text that must be nothing but decimal digits
+ *
+ * Inputs:  pText   - digits to convert
+ *          nLength - number of digits
+ *
+ * Outputs: pValue - converted value, unchanged on failure
+ *
+ * Returns: false if there is a non digit or the value overflows 32 bits
+ *
+ * Notes:   The value is built in 64 bits, so it is enough to check for
+ *          overflow after each block of eight digits and at the end.
+ *
+ *******************************************************************************/
+LIB_API
+bool DecimalParse(const char* pText, size_t nLength, uint32_t* pValue)
+{
+   uint64_t nValue = 0;
+   uint32_t nChunk = 0;
+   bool bValid     = true;
+
+   while (bValid && nLength >= 8)
+   {
+      bValid   = ParseEight(pText, &nChunk);
+      nValue   = (nValue * 100000000u) + nChunk;
+      bValid   = bValid && nValue <= UINT32_MAX;
+      pText   += 8;
+      nLength -= 8;
+   }
+
+   if (bValid && nLength >= 4)
+   {
+      bValid   = ParseFour(pText, &nChunk);
+      nValue   = (nValue * 10000u) + nChunk;
+      pText   += 4;
+      nLength -= 4;
+   }
+
+   while (bValid && nLength > 0)
+   {
+      bValid = (*pText >= '0' && *pText <= '9');
+      nValue = (nValue * 10) + (uint64_t)(*pText++ & 0x0F);
+      nLength--;
+   }
+
+   bValid = bValid && nValue <= UINT32_MAX;
+
+   if (bValid)
+   {
+      *pValue = (uint32_t)nValue;
+   }
+
+   return bValid;
+}
+
+/********************************************************************************
+ *
+ * Name:    DecimalParseInt
+ *
+ * Purpose: Converts text that must be nothing but a signed decimal value
+ *
+ * Inputs:  pText   - text to convert
+ *          nLength - number of bytes in pText
+ *
+ * Outputs: pValue - converted value, unchanged on failure
+ *
+ * Returns: false if there are no digits, a non digit or the value
+ *          overflows an int
+ *
+ * Notes:   An optional leading sign is allowed.
+ *
+ *******************************************************************************/
+LIB_API
+bool DecimalParseInt(const char* pText, size_t nLength, int* pValue)
+{
+   uint32_t nMagnitude = 0;
+   bool bNegative      = false;
+   bool bValid         = false;
+
+   if (nLength > 0 && (*pText == '-' || *pText == '+'))
+   {
+      bNegative = (*pText == '-');
+      pText++;
+      nLength--;
+   }
+
+   bValid = nLength > 0
+         && DecimalParse(pText, nLength, &nMagnitude)
+         && nMagnitude <= (uint32_t)INT_MAX + (bNegative ? 1u : 0u);
+
+   if (bValid)
+   {
+      // -2147483648 has no positive int, negate in unsigned
+      *pValue = bNegative ? (int)(0u - nMagnitude) : (int)nMagnitude;
+   }
+
+   return bValid;
+}
+
+/********************************************************************************
+ *
+ * Name:    DecimalFormatUnsigned
+ *
+ * Purpose: Writes an unsigned value in decimal
+ *
+ * Inputs:  nValue - value to write
+ *
+ * Outputs: pDest - digits written
+ *
+ * Returns: Number of digits written
+ *
+ * Notes:   No NULL is written.
+ *
+ *******************************************************************************/
+LIB_API
+size_t DecimalFormatUnsigned(char* pDest, uint32_t nValue)
+{
+   size_t nDigits = CountDigits(nValue);
+
+   WriteDigits(pDest, nValue, nDigits);
+
+   return nDigits;
+}
+
+/********************************************************************************
+ *
+ * Name:    DecimalFormatInt
+ *
+ * Purpose: Writes a signed value in decimal
+ *
+ * Inputs:  nValue - value to write
+ *
+ * Outputs: pDest - digits written
+ *
+ * Returns: Number of bytes written
+ *
+ * Notes:   The magnitude is taken in unsigned so INT_MIN works.
+ *
+ *******************************************************************************/
+LIB_API
+size_t DecimalFormatInt(char* pDest, int nValue)
+{
+   size_t nSign = 0;
+
+   if (nValue < 0)
+   {
+      pDest[nSign++] = '-';
+   }
+
+   return nSign + DecimalFormatUnsigned(pDest + nSign, nValue < 0 ? 0u - (uint32_t)nValue : (uint32_t)nValue);
+}
+
+/********************************************************************************
+ *
+ * Name:    DecimalFormatFixed
+ *
+ * Purpose: Writes a fixed width, zero padded decimal value
+ *
+ * Inputs:  nValue  - value to write
+ *          nDigits - number of digits to write
+ *
+ * Outputs: pDest - nDigits digits written
+ *
+ * Returns: false if nValue needs more than nDigits digits
+ *
+ * Notes:   A value that doesn't fit keeps its low digits.
+ *
+ *******************************************************************************/
+LIB_API
+bool DecimalFormatFixed(char* pDest, uint32_t nValue, size_t nDigits)
+{
+   WriteDigits(pDest, nValue, nDigits);
+
+   return CountDigits(nValue) <= nDigits;
+}
@@ -0,0 +1,937 @@
+/*********************************************************************************
+*
+*                          Proprietary Information of
+*
+*                            Precision Systems, Inc.
+*                    1355 Business Center Drive, Suite C
+*                                 Horsham, PA
+*                               (215) 672-1860
+*
+*                   Copyright (C) 2020, Precision Systems, Inc.
+*                            All Rights Reserved
+*
+*             The information and design as detailed in this document is
+*     the property of Precision Systems, Inc., and/or its Associates
+*     and must be returned on demand. It is issued on the strict
+*     condition that except with our written permission it must not be
+*     reproduced, copied or communicated to any third party, nor be
+*     used for any purpose other than that stated in the particular
+*     inquiry, order or contract with which it is issued. The
+*     reservation of copyright in this document extends from each date
+*     appearing thereon and in respect of the subject matter as it
+*     appeared at the relevant date.
+*
+********************************************************************************/
+/********************************************************************************
+*
+* PROJECT:     Project MIDAS
+*
+* COMPILER:    
+*
+* TOOLS:       Microsoft Visual Studio 2019
+*
+* DESCRIPTION: Command dispatcher for received frames
+*
+* NOTES:       Each command has one entry in m_dispatch, expanded from its
+*              COMMAND_SCHEMA row. Most commands answer with an echo of the
+*              request and are run by HandleSchemaCommand. Commands that
+*              return a single int share one form, and the rest have a Run
+*              function that calls the parser and builds the response.
+*
+********************************************************************************/
+#include <stddef.h>
+#include <string.h>
+#include "commandDispatch.h"
+#include "commandParser.h"
+#include "commandBuilder.h"
+#include "commandBinary.h"
+#include "commandCompletion.h"
+
+/********************************************************************************
+*                          D E F I N I T I O N S
+********************************************************************************/
+typedef EHandlerResponse(*FnRunCommand)(const MessageFrame* pFrame, const FrameView* pPayload, MsgPayload* pResponse);
+typedef EHandlerResponse(*FnRunAsync)(const FrameView* pPayload, CommandToken token, const MessageFrame* pFrame, MsgPayload* pResponse);
+
+// how a command is run and answered
+typedef enum _EDispatchForm
+{
+   EDispatchNotRun,        // the caller runs it
+   EDispatchEcho,          // HandleSchemaCommand, response echoes the command
+   EDispatchGetInt,        // GetSchemaValue, BuildSchemaResponse
+   EDispatchRun            // fpCommand builds its own response
+} EDispatchForm;
+
+// one command
+typedef struct _DispatchEntry
+{
+   EDispatchForm eForm;
+   FnRunCommand  fpCommand;   // EDispatchRun only
+} DispatchEntry;
+
+// m_dispatch entry for one COMMAND_SCHEMA row, by shape
+#define SCHEMA_DISPATCH(eCode, eShape, eTag, nMin, nMax, handler) DISPATCH_##eShape(handler),
+#define DISPATCH_NONE(handler)      { EDispatchEcho, NULL }
+#define DISPATCH_SET_BOOL(handler)  { EDispatchEcho, NULL }
+#define DISPATCH_SET_INT(handler)   { EDispatchEcho, NULL }
+#define DISPATCH_VIEW(handler)      { EDispatchEcho, NULL }
+#define DISPATCH_GET_INT(handler)   { EDispatchGetInt, NULL }
+#define DISPATCH_RUN(handler)       { EDispatchRun, handler }
+#define DISPATCH_FRAME(handler)     { EDispatchNotRun, NULL }
+
+// index of a command in m_dispatch
+#define DISPATCH_INDEX(eCode)   ((size_t)(eCode) - (size_t)ECommandCodeMin)
+
+/*********************************************************************************
+*                        H E L P E R   F U N C T I O N S
+*********************************************************************************/
+/********************************************************************************
+ *
+ * Name:    RunGetLanguage
+ *
+ * Purpose: Runs the get language command
+ *
+ * Inputs:  pFrame   - received command, not used
+ *          pPayload - payload of the command, not used
+ *
+ * Outputs: pResponse - response, built if the handler succeeds
+ *
+ * Returns: EResponseOk if successful, error code otherwise
+ *
+ * Notes:   None
+ *
+ *******************************************************************************/
+static EHandlerResponse RunGetLanguage(const MessageFrame* pFrame, const FrameView* pPayload, MsgPayload* pResponse)
+{
+   ELanguage eLanguage        = (ELanguage)0;
+   EHandlerResponse eResponse = GetLanguage(&eLanguage);
+
+   (void)pFrame;
+   (void)pPayload;
+
+   if (eResponse == EResponseOk)
+   {
+      BuildGetLanguageCommandResponse(eResponse, eLanguage, pResponse);
+   }
+
+   return eResponse;
+}
+
+/********************************************************************************
+ *
+ * Name:    RunGetFlowRates
+ *
+ * Purpose: Runs the get flow rates command
+ *
+ * Inputs:  pFrame   - received command, not used
+ *          pPayload - payload of the command, not used
+ *
+ * Outputs: pResponse - response, built if the handler succeeds
+ *
+ * Returns: EResponseOk if successful, error code otherwise
+ *
+ * Notes:   None
+ *
+ *******************************************************************************/
+static EHandlerResponse RunGetFlowRates(const MessageFrame* pFrame, const FrameView* pPayload, MsgPayload* pResponse)
+{
+   int nO2                    = 0;
+   int nN2O                   = 0;
+   int nScavenger             = 0;
+   EHandlerResponse eResponse = GetFlowRates(&nO2, &nN2O, &nScavenger);
+
+   (void)pFrame;
+   (void)pPayload;
+
+   if (eResponse == EResponseOk)
+   {
+      BuildGetFlowRatesCommandResponse(eResponse, nO2, nN2O, nScavenger, pResponse);
+   }
+
+   return eResponse;
+}
+
+/********************************************************************************
+ *
+ * Name:    RunGetTimeAndDate
+ *
+ * Purpose: Runs the get time and date command
+ *
+ * Inputs:  pFrame   - received command, not used
+ *          pPayload - payload of the command, not used
+ *
+ * Outputs: pResponse - response, built if the handler succeeds
+ *
+ * Returns: EResponseOk if successful, error code otherwise
+ *
+ * Notes:   None
+ *
+ *******************************************************************************/
+static EHandlerResponse RunGetTimeAndDate(const MessageFrame* pFrame, const FrameView* pPayload, MsgPayload* pResponse)
+{
+   char szDateTime[DATE_TIME_BUFF_SIZE] = { 0 };
+   EHandlerResponse eResponse           = GetTimeAndDate(szDateTime);
+
+   (void)pFrame;
+   (void)pPayload;
+
+   if (eResponse == EResponseOk)
+   {
+      BuildGetTimeAndDateCommandResponse(eResponse, szDateTime, pResponse);
+   }
+
+   return eResponse;
+}
+
+/********************************************************************************
+ *
+ * Name:    RunGetGasVolumeInfo
+ *
+ * Purpose: Runs the get gas volume command
+ *
+ * Inputs:  pFrame   - received command, not used
+ *          pPayload - payload of the command, not used
+ *
+ * Outputs: pResponse - response, built if the handler succeeds
+ *
+ * Returns: EResponseOk if successful, error code otherwise
+ *
+ * Notes:   None
+ *
+ *******************************************************************************/
+static EHandlerResponse RunGetGasVolumeInfo(const MessageFrame* pFrame, const FrameView* pPayload, MsgPayload* pResponse)
+{
+   GasVolumeInfo info;
+   EHandlerResponse eResponse = EResponseOk;
+
+   (void)pFrame;
+   (void)pPayload;
+
+   memset(&info, 0, sizeof(info));
+   eResponse = GetGasVolumeInfo(&info);
+
+   if (eResponse == EResponseOk)
+   {
+      BuildGetGasVolumeInfoCommandResponse(eResponse, &info, pResponse);
+   }
+
+   return eResponse;
+}
+
+/********************************************************************************
+ *
+ * Name:    RunGetScavengerInfo
+ *
+ * Purpose: Runs the get scavenger info command
+ *
+ * Inputs:  pFrame   - received command, not used
+ *          pPayload - payload of the command, not used
+ *
+ * Outputs: pResponse - response, built if the handler succeeds
+ *
+ * Returns: EResponseOk if successful, error code otherwise
+ *
+ * Notes:   None
+ *
+ *******************************************************************************/
+static EHandlerResponse RunGetScavengerInfo(const MessageFrame* pFrame, const FrameView* pPayload, MsgPayload* pResponse)
+{
+   ScavengerInfo info;
+   EHandlerResponse eResponse = EResponseOk;
+
+   (void)pFrame;
+   (void)pPayload;
+
+   memset(&info, 0, sizeof(info));
+   eResponse = GetScavengerInfo(&info);
+
+   if (eResponse == EResponseOk)
+   {
+      BuildGetScavengerInfoCommandResponse(eResponse, &info, pResponse);
+   }
+
+   return eResponse;
+}
+
+/********************************************************************************
+ *
+ * Name:    RunScreenReady
+ *
+ * Purpose: Runs the screen ready command
+ *
+ * Inputs:  pFrame   - received command, not used
+ *          pPayload - payload of the command, not used
+ *
+ * Outputs: pResponse - response, built if the handler succeeds
+ *
+ * Returns: EResponseOk if successful, error code otherwise
+ *
+ * Notes:   None
+ *
+ *******************************************************************************/
+static EHandlerResponse RunScreenReady(const MessageFrame* pFrame, const FrameView* pPayload, MsgPayload* pResponse)
+{
+   ScreenReady screenReady;
+   EHandlerResponse eResponse = EResponseOk;
+
+   (void)pFrame;
+   (void)pPayload;
+
+   memset(&screenReady, 0, sizeof(screenReady));
+   eResponse = GetScreenReadyData(&screenReady);
+
+   if (eResponse == EResponseOk)
+   {
+      BuildScreenReadyCommandResponse(eResponse, &screenReady, pResponse);
+   }
+
+   return eResponse;
+}
+
+/********************************************************************************
+ *
+ * Name:    RunGetFirmwareVersion
+ *
+ * Purpose: Runs the get firmware version command
+ *
+ * Inputs:  pFrame   - received command, not used
+ *          pPayload - payload of the command, not used
+ *
+ * Outputs: pResponse - response, built if the handler succeeds
+ *
+ * Returns: EResponseOk if successful, error code otherwise
+ *
+ * Notes:   None
+ *
+ *******************************************************************************/
+static EHandlerResponse RunGetFirmwareVersion(const MessageFrame* pFrame, const FrameView* pPayload, MsgPayload* pResponse)
+{
+   FirmwareVersion version;
+   EHandlerResponse eResponse = EResponseOk;
+
+   (void)pFrame;
+   (void)pPayload;
+
+   memset(&version, 0, sizeof(version));
+   eResponse = GetFirmwareVersion(&version);
+
+   if (eResponse == EResponseOk)
+   {
+      BuildGetFirmwareVersionCommandResponse(eResponse, &version, pResponse);
+   }
+
+   return eResponse;
+}
+
+/********************************************************************************
+ *
+ * Name:    RunGetFirmwareInfo
+ *
+ * Purpose: Runs the get firmware info command
+ *
+ * Inputs:  pFrame   - received command, not used
+ *          pPayload - payload of the command, not used
+ *
+ * Outputs: pResponse - response, built if the handler succeeds
+ *
+ * Returns: EResponseOk if successful, error code otherwise
+ *
+ * Notes:   None
+ *
+ *******************************************************************************/
+static EHandlerResponse RunGetFirmwareInfo(const MessageFrame* pFrame, const FrameView* pPayload, MsgPayload* pResponse)
+{
+   FirmwareInfo info;
+   EHandlerResponse eResponse = EResponseOk;
+
+   (void)pFrame;
+   (void)pPayload;
+
+   memset(&info, 0, sizeof(info));
+   eResponse = GetFirmwareInfo(&info);
+
+   if (eResponse == EResponseOk)
+   {
+      BuildGetFirmwareInfoCommandResponse(eResponse, &info, pResponse);
+   }
+
+   return eResponse;
+}
+
+/********************************************************************************
+ *
+ * Name:    RunGetConfigurationData
+ *
+ * Purpose: Runs the get configuration data command
+ *
+ * Inputs:  pFrame   - received command, not used
+ *          pPayload - payload of the command, not used
+ *
+ * Outputs: pResponse - response, built if the handler succeeds
+ *
+ * Returns: EResponseOk if successful, error code otherwise
+ *
+ * Notes:   None
+ *
+ *******************************************************************************/
+static EHandlerResponse RunGetConfigurationData(const MessageFrame* pFrame, const FrameView* pPayload, MsgPayload* pResponse)
+{
+   ConfigData config;
+   EHandlerResponse eResponse = EResponseOk;
+
+   (void)pFrame;
+   (void)pPayload;
+
+   memset(&config, 0, sizeof(config));
+   eResponse = GetConfigurationData(&config);
+
+   if (eResponse == EResponseOk)
+   {
+      BuildGetConfigurationDataCommandResponse(eResponse, &config, pResponse);
+   }
+
+   return eResponse;
+}
+
+/********************************************************************************
+ *
+ * Name:    RunGetValvePosition
+ *
+ * Purpose: Runs the get valve command
+ *
+ * Inputs:  pFrame   - received command, not used
+ *          pPayload - payload of the command
+ *
+ * Outputs: pResponse - response, built if the handler succeeds
+ *
+ * Returns: EResponseOk if successful, error code otherwise
+ *
+ * Notes:   None
+ *
+ *******************************************************************************/
+static EHandlerResponse RunGetValvePosition(const MessageFrame* pFrame, const FrameView* pPayload, MsgPayload* pResponse)
+{
+   EGasId eId                 = EO2;
+   int nPosition              = 0;
+   EHandlerResponse eResponse = GetValvePositionView(pPayload, &eId, &nPosition);
+
+   (void)pFrame;
+
+   if (eResponse == EResponseOk)
+   {
+      BuildGetValveCommandResponse(eResponse, eId, nPosition, pResponse);
+   }
+
+   return eResponse;
+}
+
+/********************************************************************************
+ *
+ * Name:    RunReadManufacturerField
+ *
+ * Purpose: Runs the read manufacturer field command
+ *
+ * Inputs:  pFrame   - received command
+ *          pPayload - payload of the command
+ *
+ * Outputs: pResponse - response, built if the handler succeeds
+ *
+ * Returns: EResponseOk if successful, error code otherwise
+ *
+ * Notes:   None
+ *
+ *******************************************************************************/
+static EHandlerResponse RunReadManufacturerField(const MessageFrame* pFrame, const FrameView* pPayload, MsgPayload* pResponse)
+{
+   char szValue[TMP_STR_SIZE] = { 0 };
+   EHandlerResponse eResponse = ReadManufacturerFieldView(pPayload, szValue);
+
+   if (eResponse == EResponseOk)
+   {
+      BuildReadManufacturerFieldCommandResponse(eResponse, szValue, &pFrame->payload, pResponse);
+   }
+
+   return eResponse;
+}
+
+/********************************************************************************
+ *
+ * Name:    RunGetMixStepSize
+ *
+ * Purpose: Runs the get mix step size command
+ *
+ * Inputs:  pFrame   - received command, not used
+ *          pPayload - payload of the command, not used
+ *
+ * Outputs: pResponse - response, built if the handler succeeds
+ *
+ * Returns: EResponseOk if successful, error code otherwise
+ *
+ * Notes:   None
+ *
+ *******************************************************************************/
+static EHandlerResponse RunGetMixStepSize(const MessageFrame* pFrame, const FrameView* pPayload, MsgPayload* pResponse)
+{
+   EMixStepSize eStepSize     = EMixStepSizeMin;
+   EHandlerResponse eResponse = GetMixStepSize(&eStepSize);
+
+   (void)pFrame;
+   (void)pPayload;
+
+   if (eResponse == EResponseOk)
+   {
+      BuildGetMixStepSizeCommandResponse(eResponse, eStepSize, pResponse);
+   }
+
+   return eResponse;
+}
+
+/********************************************************************************
+ *
+ * Name:    RunGetFlowRateStepSize
+ *
+ * Purpose: Runs the get flow rate step size command
+ *
+ * Inputs:  pFrame   - received command, not used
+ *          pPayload - payload of the command, not used
+ *
+ * Outputs: pResponse - response, built if the handler succeeds
+ *
+ * Returns: EResponseOk if successful, error code otherwise
+ *
+ * Notes:   None
+ *
+ *******************************************************************************/
+static EHandlerResponse RunGetFlowRateStepSize(const MessageFrame* pFrame, const FrameView* pPayload, MsgPayload* pResponse)
+{
+   EFlowRateStepSize eStepSize = EFlowRateStepSizeMin;
+   EHandlerResponse eResponse  = GetFlowRateStepSize(&eStepSize);
+
+   (void)pFrame;
+   (void)pPayload;
+
+   if (eResponse == EResponseOk)
+   {
+      BuildGetFlowRateStepSizeCommandResponse(eResponse, eStepSize, pResponse);
+   }
+
+   return eResponse;
+}
+
+/********************************************************************************
+ *
+ * Name:    RunGetClockFormat
+ *
+ * Purpose: Runs the get clock format command
+ *
+ * Inputs:  pFrame   - received command, not used
+ *          pPayload - payload of the command, not used
+ *
+ * Outputs: pResponse - response, built if the handler succeeds
+ *
+ * Returns: EResponseOk if successful, error code otherwise
+ *
+ * Notes:   None
+ *
+ *******************************************************************************/
+static EHandlerResponse RunGetClockFormat(const MessageFrame* pFrame, const FrameView* pPayload, MsgPayload* pResponse)
+{
+   EClockFormat eFormat       = (EClockFormat)0;
+   EHandlerResponse eResponse = GetClockFormat(&eFormat);
+
+   (void)pFrame;
+   (void)pPayload;
+
+   if (eResponse == EResponseOk)
+   {
+      BuildGetClockFormatCommandResponse(eResponse, eFormat, pResponse);
+   }
+
+   return eResponse;
+}
+
+/********************************************************************************
+ *
+ * Name:    RunGetBtStatus
+ *
+ * Purpose: Runs the get Bluetooth status command
+ *
+ * Inputs:  pFrame   - received command, not used
+ *          pPayload - payload of the command, not used
+ *
+ * Outputs: pResponse - response, built if the handler succeeds
+ *
+ * Returns: EResponseOk if successful, error code otherwise
+ *
+ * Notes:   None
+ *
+ *******************************************************************************/
+static EHandlerResponse RunGetBtStatus(const MessageFrame* pFrame, const FrameView* pPayload, MsgPayload* pResponse)
+{
+   EBtStatus eStatus          = (EBtStatus)0;
+   EHandlerResponse eResponse = GetBtStatus(&eStatus);
+
+   (void)pFrame;
+   (void)pPayload;
+
+   if (eResponse == EResponseOk)
+   {
+      BuildGetBtStatusCommandResponse(eResponse, eStatus, pResponse);
+   }
+
+   return eResponse;
+}
+
+/********************************************************************************
+ *
+ * Name:    RunFirmwareDownloadAsync
+ *
+ * Purpose: Runs the firmware download command with its async handler
+ *
+ * Inputs:  pPayload - payload of the command, not used
+ *          token    - token from BeginPendingCommand
+ *          pFrame   - received command, not used
+ *
+ * Outputs: pResponse - not used, the handler always answers later
+ *
+ * Returns: EPending if the handler will answer through CompleteCommand,
+ *          else EResponseOk or an error code
+ *
+ * Notes:   None
+ *
+ *******************************************************************************/
+static EHandlerResponse RunFirmwareDownloadAsync(const FrameView* pPayload, CommandToken token, const MessageFrame* pFrame, MsgPayload* pResponse)
+{
+   (void)pFrame;
+   (void)pPayload;
+   (void)pResponse;
+
+   return FirmwareDownloadAsync(token);
+}
+
+/********************************************************************************
+ *
+ * Name:    RunBtFirmwareDownloadAsync
+ *
+ * Purpose: Runs the BT firmware download command with its async handler
+ *
+ * Inputs:  pPayload - payload of the command, not used
+ *          token    - token from BeginPendingCommand
+ *          pFrame   - received command, not used
+ *
+ * Outputs: pResponse - not used, the handler always answers later
+ *
+ * Returns: EPending if the handler will answer through CompleteCommand,
+ *          else EResponseOk or an error code
+ *
+ * Notes:   None
+ *
+ *******************************************************************************/
+static EHandlerResponse RunBtFirmwareDownloadAsync(const FrameView* pPayload, CommandToken token, const MessageFrame* pFrame, MsgPayload* pResponse)
+{
+   (void)pFrame;
+   (void)pPayload;
+   (void)pResponse;
+
+   return BtFirmwareDownloadAsync(token);
+}
+
+/********************************************************************************
+ *
+ * Name:    RunReadManufacturerFieldAsync
+ *
+ * Purpose: Runs the read manufacturer field command with its async handler
+ *
+ * Inputs:  pPayload - payload of the command
+ *          token    - token from BeginPendingCommand
+ *          pFrame   - received command, not used
+ *
+ * Outputs: pResponse - not written, errors are answered by DispatchFrame
+ *
+ * Returns: EPending if the handler will answer through
+ *          CompleteReadManufacturerField, else an error code
+ *
+ * Notes:   The value only comes back through CompleteReadManufacturerField,
+ *          so EResponseOk from the handler is answered as a missing value,
+ *          the same as CompleteReadManufacturerField with no value.
+ *
+ *******************************************************************************/
+static EHandlerResponse RunReadManufacturerFieldAsync(const FrameView* pPayload, CommandToken token, const MessageFrame* pFrame, MsgPayload* pResponse)
+{
+   EHandlerResponse eResponse = ReadManufacturerFieldAsyncView(pPayload, token);
+
+   (void)pFrame;
+   (void)pResponse;
+
+   if (eResponse == EResponseOk)
+   {
+      eResponse = EInvalidParameters;
+   }
+
+   return eResponse;
+}
+
+/********************************************************************************
+ *
+ * Name:    FindAsync
+ *
+ * Purpose: Looks up the async Run function for a command code
+ *
+ * Inputs:  pHandlers - handlers of the command
+ *          eCode     - command code
+ *
+ * Outputs: None
+ *
+ * Returns: Run function, NULL if the command has no async handler set
+ *
+ * Notes:   Only the slow commands have an async form.
+ *
+ *******************************************************************************/
+static FnRunAsync FindAsync(const CommandHandlers* pHandlers, ECommandCode eCode)
+{
+   FnRunAsync fpAsync = NULL;
+
+   switch (eCode)
+   {
+   case EFirmwareDownload:
+      if (pHandlers->fpHandleFirmwareDownloadAsync != NULL)
+      {
+         fpAsync = RunFirmwareDownloadAsync;
+      }
+      break;
+
+   case EBtFirmwareDownload:
+      if (pHandlers->fpHandleBtFirmwareDownloadAsync != NULL)
+      {
+         fpAsync = RunBtFirmwareDownloadAsync;
+      }
+      break;
+
+   case EReadManufacturerField:
+      if (pHandlers->fpHandleReadManufacturerFieldAsync != NULL)
+      {
+         fpAsync = RunReadManufacturerFieldAsync;
+      }
+      break;
+
+   default:
+      break;
+   }
+
+   return fpAsync;
+}
+
+/*********************************************************************************
+*                               D A T A
+*********************************************************************************/
+// indexed by command code less ECommandCodeMin, expanded from
+// COMMAND_SCHEMA. FRAME rows are not run by DispatchFrame, see CanDispatch
+static const DispatchEntry m_dispatch[DISPATCH_INDEX(ECommandCodeMax)] =
+{
+   { EDispatchNotRun, NULL },    // ECommandCodeMin
+   COMMAND_SCHEMA(SCHEMA_DISPATCH)
+};
+
+/*********************************************************************************
+*                    F U N C T I O N   D E F I N I T I O N S
+*********************************************************************************/
+/********************************************************************************
+ *
+ * Name:    FindEntry
+ *
+ * Purpose: Looks up the dispatch table entry for a command code
+ *
+ * Inputs:  eCode - command code
+ *
+ * Outputs: None
+ *
+ * Returns: Table entry, NULL if the code isn't a command
+ *
+ * Notes:   ECommandCodeMin itself is not a command, its entry is empty.
+ *
+ *******************************************************************************/
+static const DispatchEntry* FindEntry(ECommandCode eCode)
+{
+   const DispatchEntry* pEntry = NULL;
+
+   if (eCode > ECommandCodeMin && eCode < ECommandCodeMax)
+   {
+      pEntry = &m_dispatch[DISPATCH_INDEX(eCode)];
+   }
+
+   return pEntry;
+}
+
+/********************************************************************************
+ *
+ * Name:    IsResponsePayload
+ *
+ * Purpose: Checks whether a payload is a response rather than a command
+ *
+ * Inputs:  pPayload - received payload
+ *
+ * Outputs: None
+ *
+ * Returns: true for a response
+ *
+ * Notes:   Text responses start with RESPONSE_PREFIX, binary ones have
+ *          BINARY_FLAG_RESPONSE set in the header.
+ *
+ *******************************************************************************/
+LIB_API
+bool IsResponsePayload(const FrameView* pPayload)
+{
+   FrameView binary    = *pPayload;
+   ECommandCode eCode  = ECommandCodeMin;
+   uint8_t nFlags      = 0;
+   size_t nPrefix      = sizeof(RESPONSE_PREFIX) - 1;
+   bool bResponse      = false;
+
+   if (BinaryReadHeader(&binary, &eCode, &nFlags))
+   {
+      bResponse = (nFlags & BINARY_FLAG_RESPONSE) != 0;
+   }
+   else
+   {
+      bResponse = pPayload->nLength > nPrefix
+               && memcmp(pPayload->pData, RESPONSE_PREFIX, nPrefix) == 0
+               && pPayload->pData[nPrefix] == ',';
+   }
+
+   return bResponse;
+}
+
+/********************************************************************************
+ *
+ * Name:    CanDispatch
+ *
+ * Purpose: Checks whether DispatchFrame runs a command
+ *
+ * Inputs:  eCode - command code
+ *
+ * Outputs: None
+ *
+ * Returns: true if the command has an entry in the dispatch table
+ *
+ * Notes:   None
+ *
+ *******************************************************************************/
+LIB_API
+bool CanDispatch(ECommandCode eCode)
+{
+   const DispatchEntry* pEntry = FindEntry(eCode);
+
+   return pEntry != NULL && pEntry->eForm != EDispatchNotRun;
+}
+
+/********************************************************************************
+ *
+ * Name:    DispatchFrame
+ *
+ * Purpose: Runs a received command and builds its response
+ *
+ * Inputs:  pFrame - received frame
+ *
+ * Outputs: pResponse - response to send, nLength is 0 if there is none
+ *
+ * Returns: Result from the command handler, or why it wasn't called
+ *
+ * Notes:   Every failure is answered by BuildCommandErrorResponse, so the
+ *          Run functions only build the response for success.
+ *
+ *          A command with an async handler set is kept by
+ *          BeginPendingCommand first. If the handler returns EPending
+ *          nothing is sent now, otherwise the command is released and
+ *          answered here. With every pending slot in use the command
+ *          runs its normal handler.
+ *
+ *          The handlers are held from the lookup until the command has
+ *          run, so the parser gets the same table, see
+ *          AcquireCommandHandlers.
+ *
+ *******************************************************************************/
+LIB_API
+EHandlerResponse DispatchFrame(const MessageFrame* pFrame, MsgPayload* pResponse)
+{
+   EHandlerResponse eResponse       = EInputBufferError;
+   const CommandHandlers* pHandlers = NULL;
+   const DispatchEntry* pEntry      = NULL;
+   FnRunAsync fpAsync               = NULL;
+   CommandToken token               = COMMAND_TOKEN_NONE;
+   FrameView payload;
+   int nValue                       = 0;
+
+   if (pFrame != NULL && pResponse != NULL)
+   {
+      pResponse->nLength    = 0;
+      pResponse->nChecksum  = 0;
+      pResponse->bSequenced = false;
+      pResponse->nSequence  = 0;
+
+      payload.pData   = pFrame->payload.szPayload;
+      payload.nLength = pFrame->payload.nLength;
+
+      eResponse = EOpNotAllowed;
+      pHandlers = AcquireCommandHandlers();
+      pEntry    = FindEntry(pFrame->eCmdType);
+      fpAsync   = FindAsync(pHandlers, pFrame->eCmdType);
+
+      // ACK, NAK, transport fragments and responses are not answered
+      if (pEntry != NULL && !IsResponsePayload(&payload))
+      {
+         if (!pFrame->bChecksumOk)
+         {
+            eResponse = EDataCorrupt;
+         }
+         else if (fpAsync != NULL && BeginPendingCommand(&pFrame->payload, pFrame->eCmdType, &token))
+         {
+            eResponse = fpAsync(&payload, token, pFrame, pResponse);
+            if (eResponse != EPending)
+            {
+               CancelPendingCommand(token);
+               token = COMMAND_TOKEN_NONE;
+            }
+         }
+         else if (pEntry->eForm == EDispatchEcho)
+         {
+            eResponse = HandleSchemaCommand(pFrame->eCmdType, &payload);
+         }
+         else if (pEntry->eForm == EDispatchGetInt)
+         {
+            eResponse = GetSchemaValue(pFrame->eCmdType, &nValue);
+            if (eResponse == EResponseOk)
+            {
+               BuildSchemaResponse(eResponse, pFrame->eCmdType, nValue, pResponse);
+            }
+         }
+         else if (pEntry->eForm == EDispatchRun)
+         {
+            eResponse = pEntry->fpCommand(pFrame, &payload, pResponse);
+         }
+
+         if (token != COMMAND_TOKEN_NONE)
+         {
+            // answered later by CompleteCommand
+         }
+         else
+         {
+            if (eResponse != EResponseOk)
+            {
+               BuildCommandErrorResponse(eResponse, pFrame->eCmdType, pResponse);
+            }
+            else if (pEntry->eForm == EDispatchEcho)
+            {
+               BuildCommandEchoResponse(eResponse, pFrame->eCmdType, &pFrame->payload, pResponse);
+            }
+
+            // answered with the sequence number it was asked with
+            pResponse->bSequenced = pFrame->payload.bSequenced;
+            pResponse->nSequence  = pFrame->payload.nSequence;
+         }
+      }
+
+      ReleaseCommandHandlers(pHandlers);
+   }
+
+   return eResponse;
+}
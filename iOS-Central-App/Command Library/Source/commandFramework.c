@@ -1,7 +1,21 @@
+#include <stddef.h>
 #include <string.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include "commandFramework.h"
+#include "commandScanner.h"
+#include "commandBinary.h"
+#include "commandTransport.h"
+#include "commandCrc.h"
+#include "commandDecimal.h"
+#include "commandSession.h"
+
+// fail to compile if AddMessageFramingInPlace can't frame across the
+// MsgPayload members, szHeadroom, szPayload and szTailroom must be contiguous
+typedef char HeadroomCheck[(offsetof(MsgPayload, szPayload)
+                            == offsetof(MsgPayload, szHeadroom) + FRAME_HEADROOM) ? 1 : -1];
+typedef char TailroomCheck[(offsetof(MsgPayload, szTailroom)
+                            == offsetof(MsgPayload, szPayload) + PAYLOAD_LENGTH) ? 1 : -1];
 
 /********************************************************************************
  *
@@ -22,186 +36,472 @@
 LIB_API
 uint8_t CalculateChecksum(MsgPayload* pPayload)
 {
-   uint8_t  nChecksum   = 0;
-   uint32_t nCount      = 0;
-   char*    pReader     = pPayload->szPayload;
+   return ChecksumBytes(pPayload->szPayload, pPayload->nLength);
+}
+
+/********************************************************************************
+ *
+ * Name:    ParseCommandCode
+ *
+ * Purpose: Reads the command code from a validated payload.
+ *
+ * Inputs:  pPayload - payload data, does not need to be NULL terminated
+ *          nLength  - number of bytes in the payload
+ *
+ * Outputs: peCmdType - populated with the command code
+ *
+ * Returns: MFR_OK if the command code is valid, MFR_COMMAND_ERR otherwise
+ *
+ * Notes:   Binary payloads are recognized by their header. Transport
+ *          fragments are reported as ETransport.
+ *
+ *******************************************************************************/
+static MessageFrameResult ParseCommandCode(const char* pPayload, size_t nLength, ECommandCode* peCmdType)
+{
+   MessageFrameResult eResult = MFR_OK;
+   const char* pReader        = pPayload;
+   const char* pEnd           = pPayload + nLength;
+   int nCmdCode               = 0;
+   uint32_t nValue            = 0;
+   size_t nDigits             = 0;
+   FrameView binary           = { pPayload, nLength };
+
+   if (IsTransportPayload(pPayload, nLength))
+   {
+      nCmdCode = (int)ETransport;
+   }
+   else if (BinaryReadHeader(&binary, peCmdType, NULL))
+   {
+      // binary payload, code is a byte in the header
+      nCmdCode = (int)*peCmdType;
+   }
+   else
+   {
+      // if payload is for a command response, skip the prefix
+      if (nLength >= 4 && memcmp(pReader, "RSP,", 4) == 0)
+      {
+         pReader += 4;
+      }
+
+      // convert the decimal command code, too many digits is out of range
+      nDigits = DecimalDigitRun(pReader, (size_t)(pEnd - pReader));
+      if (!DecimalParse(pReader, nDigits, &nValue) || nValue > (uint32_t)ECommandCodeMax)
+      {
+         nValue = (uint32_t)ECommandCodeMax;
+      }
 
-   for (nCount = 0; nCount < pPayload->nLength; nCount++)
+      nCmdCode = (int)nValue;
+      pReader += nDigits;
+
+      // if command code is non printable (ACK or NAK)
+      // conversion fails, just read the character
+      if (nCmdCode == 0 && pReader < pEnd)
+      {
+         nCmdCode = (int)*pReader;
+      }
+   }
+
+   *peCmdType = (ECommandCode)nCmdCode;
+
+   // if command code is out of range
+   if ((*peCmdType != EAck && *peCmdType != ENak && *peCmdType != ETransport)
+   && ((*peCmdType <= ECommandCodeMin) || *peCmdType >= ECommandCodeMax))
    {
-      nChecksum += *pReader++;
+      eResult = MFR_COMMAND_ERR;
    }
 
-   return nChecksum;
+   return eResult;
 }
 
 /********************************************************************************
  *
- * Name:    ParseMessageFrames
+ * Name:    ParsePayloadCommandCode
  *
- * Purpose: cmbBuffer - reference to command buffer
- *          cmdBufferSize - total length of command buffer
- *          
+ * Purpose: Reads the command code from a payload or reassembled message.
  *
- * Inputs:  msgFrame - populated with message validation info.
+ * Inputs:  pPayload - payload, does not need to be NULL terminated
  *
- * Outputs: None.
+ * Outputs: peCmdType - populated with the command code
  *
- * Returns: None.
+ * Returns: MFR_OK if the command code is valid, MFR_COMMAND_ERR otherwise
+ *
+ * Notes:   See ParseCommandCode.
+ *
+ *******************************************************************************/
+LIB_API
+MessageFrameResult ParsePayloadCommandCode(const FrameView* pPayload, ECommandCode* peCmdType)
+{
+   return ParseCommandCode(pPayload->pData, pPayload->nLength, peCmdType);
+}
+
+/********************************************************************************
+ *
+ * Name:    ReadSequenceField
+ *
+ * Purpose: Reads the optional sequence number from the start of a payload
+ *
+ * Inputs:  pPayload - validated payload, advanced past the sequence field
+ *
+ * Outputs: pbSequenced - true if the payload had a sequence field
+ *          pnSequence  - sequence number, 0 if there was none
+ *
+ * Returns: None
+ *
+ * Notes:   A payload never starts with the marker, so one that does but
+ *          isn't followed by the digits and comma is left as it is.
+ *
+ *******************************************************************************/
+static void ReadSequenceField(FrameView* pPayload, bool* pbSequenced, uint16_t* pnSequence)
+{
+   const char* pReader = pPayload->pData;
+   uint32_t nSequence  = 0;
+   bool bSequenced     = (pPayload->nLength >= FRAME_SEQUENCE_LENGTH
+                       && pReader[0] == FRAME_SEQUENCE_MARKER
+                       && pReader[FRAME_SEQUENCE_LENGTH - 1] == ','
+                       && DecimalParse(pReader + 1, FRAME_SEQUENCE_DIGITS, &nSequence));
+
+   *pbSequenced = bSequenced;
+   *pnSequence  = bSequenced ? (uint16_t)nSequence : 0;
+
+   if (bSequenced)
+   {
+      pPayload->pData   += FRAME_SEQUENCE_LENGTH;
+      pPayload->nLength -= FRAME_SEQUENCE_LENGTH;
+   }
+}
+
+/********************************************************************************
+ *
+ * Name:    SequenceChecksum
+ *
+ * Purpose: Sums the bytes of a sequence number field
+ *
+ * Inputs:  nSequence - sequence number
+ *
+ * Outputs: None
+ *
+ * Returns: Sum of the "#nnn," bytes
+ *
+ * Notes:   Used to move a checksum between the payload and the frame.
+ *
+ *******************************************************************************/
+static int SequenceChecksum(uint16_t nSequence)
+{
+   int nSum    = FRAME_SEQUENCE_MARKER + ',';
+   int nDigits = 0;
+
+   for (nDigits = 0; nDigits < FRAME_SEQUENCE_DIGITS; nDigits++)
+   {
+      nSum      += '0' + (nSequence % 10);
+      nSequence /= 10;
+   }
+
+   return nSum;
+}
+
+/********************************************************************************
+ *
+ * Name:    FrameCheckDigits
+ *
+ * Purpose: Returns the number of digits in the frame check field
+ *
+ * Inputs:  eIntegrity - frame check
+ *
+ * Outputs: None
+ *
+ * Returns: Number of digits
  *
  * Notes:   None.
  *
  *******************************************************************************/
 LIB_API
-MessageFrameResult ParseMessageFrames(char* cmdBuffer, size_t cmdBufferSize, MessageFrame* msgFrame)
+size_t FrameCheckDigits(EFrameIntegrity eIntegrity)
 {
-   // assume success until we fail
-   MessageFrameResult eResult       = MFR_OK;
-   char szSpecifier[10] = { 0 };
-   char* pReader                    = cmdBuffer;
-   size_t nTotalRead                = 0;
-   char  szTmp[256] = { 0 };
-   char  nEtx                       = 0;
-   char  nStx                       = 0;
-   uint8_t  nComputedChecksum       = 0;
-   char* pCh                        = NULL;
-   char* pEnd                       = NULL;
-   int nScannedItems                = 0;
-   int nCmdCode                     = 0;
-   // check pointers
-   if(cmdBuffer != NULL
-	&& msgFrame  != NULL)
+   size_t nDigits = FRAME_CHECKSUM_DIGITS;
+
+   if (eIntegrity == EFrameIntegrityCrc16)
+   {
+      nDigits = FRAME_CRC16_DIGITS;
+   }
+   else if (eIntegrity == EFrameIntegrityCrc32c)
+   {
+      nDigits = FRAME_CRC32C_DIGITS;
+   }
+
+   return nDigits;
+}
+
+/********************************************************************************
+ *
+ * Name:    ReadFrameSeparator
+ *
+ * Purpose: Reads the frame check selected by the character after the length
+ *
+ * Inputs:  ch - character after the length digits
+ *
+ * Outputs: peIntegrity - frame check
+ *
+ * Returns: false if the character isn't a separator
+ *
+ * Notes:   None.
+ *
+ *******************************************************************************/
+LIB_API
+bool ReadFrameSeparator(char ch, EFrameIntegrity* peIntegrity)
+{
+   bool bRead = true;
+
+   switch (ch)
+   {
+   case FRAME_SEPARATOR:
+      *peIntegrity = EFrameIntegritySum8;
+      break;
+
+   case FRAME_SEPARATOR_CRC16:
+      *peIntegrity = EFrameIntegrityCrc16;
+      break;
+
+   case FRAME_SEPARATOR_CRC32C:
+      *peIntegrity = EFrameIntegrityCrc32c;
+      break;
+
+   default:
+      bRead = false;
+      break;
+   }
+
+   return bRead;
+}
+
+/********************************************************************************
+ *
+ * Name:    ReadCheckDigit
+ *
+ * Purpose: Adds one digit of the frame check field to its value
+ *
+ * Inputs:  ch         - digit
+ *          eIntegrity - frame check, decimal for the sum, hex for a CRC
+ *          pnValue    - value of the digits so far
+ *
+ * Outputs: pnValue - digit added
+ *
+ * Returns: false if the character isn't a digit
+ *
+ * Notes:   Hex digits may be either case.
+ *
+ *******************************************************************************/
+static bool ReadCheckDigit(char ch, EFrameIntegrity eIntegrity, uint32_t* pnValue)
+{
+   int nDigit = -1;
+
+   if (ch >= '0' && ch <= '9')
    {
+      nDigit = ch - '0';
+   }
+   else if (eIntegrity != EFrameIntegritySum8 && ch >= 'A' && ch <= 'F')
+   {
+      nDigit = ch - 'A' + 10;
+   }
+   else if (eIntegrity != EFrameIntegritySum8 && ch >= 'a' && ch <= 'f')
+   {
+      nDigit = ch - 'a' + 10;
+   }
+
+   if (nDigit >= 0)
+   {
+      *pnValue = (eIntegrity == EFrameIntegritySum8) ? (*pnValue * 10) + (uint32_t)nDigit
+                                                     : (*pnValue << 4) | (uint32_t)nDigit;
+   }
+
+   return nDigit >= 0;
+}
+
+/********************************************************************************
+ *
+ * Name:    FrameCheckInit
+ *
+ * Purpose: Returns the starting value of a frame check
+ *
+ * Inputs:  eIntegrity - frame check
+ *
+ * Outputs: None
+ *
+ * Returns: Starting value for FrameCheckUpdate
+ *
+ * Notes:   None.
+ *
+ *******************************************************************************/
+static uint32_t FrameCheckInit(EFrameIntegrity eIntegrity)
+{
+   return (eIntegrity == EFrameIntegrityCrc16) ? CRC16_INIT : 0;
+}
+
+/********************************************************************************
+ *
+ * Name:    FrameCheckUpdate
+ *
+ * Purpose: Adds bytes to a frame check
+ *
+ * Inputs:  eIntegrity - frame check
+ *          nCheck     - value so far
+ *          pBytes     - data to add
+ *          nLength    - number of bytes in pBytes
+ *
+ * Outputs: None
+ *
+ * Returns: Frame check of everything added so far
+ *
+ * Notes:   None.
+ *
+ *******************************************************************************/
+static uint32_t FrameCheckUpdate(EFrameIntegrity eIntegrity, uint32_t nCheck, const void* pBytes, size_t nLength)
+{
+   if (eIntegrity == EFrameIntegrityCrc16)
+   {
+      nCheck = Crc16Update((uint16_t)nCheck, pBytes, nLength);
+   }
+   else if (eIntegrity == EFrameIntegrityCrc32c)
+   {
+      nCheck = Crc32cUpdate(nCheck, pBytes, nLength);
+   }
+   else
+   {
+      nCheck = (nCheck + ChecksumBytes(pBytes, nLength)) & 0xFF;
+   }
+
+   return nCheck;
+}
+
+/********************************************************************************
+ *
+ * Name:    ParseFrameAt
+ *
+ * Purpose: Validates the frame that starts at the beginning of a buffer.
+ *
+ * Inputs:  pBuffer     - receive buffer
+ *          nBufferSize - number of bytes available in pBuffer
+ *
+ * Outputs: pFrame       - populated with validation info and payload view
+ *          pFrameLength - total length of the frame, including framing
+ *
+ * Returns: MFR_OK if the frame is valid, error code otherwise.
+ *
+ * Notes:   MFR_BUFF_LEN_ERR means everything up to the end of the buffer is
+ *          valid but the frame isn't complete. pFrameLength is set once the
+ *          length prefix has been read.
+ *
+ *******************************************************************************/
+static MessageFrameResult ParseFrameAt(const char* pBuffer,
+                                       size_t nBufferSize,
+                                       MessageFrameView* pFrame,
+                                       size_t* pFrameLength)
+{
+   MessageFrameResult eResult = MFR_OK;
+   const char* pReader        = pBuffer;
+   size_t nPayloadLength      = 0;
+   uint32_t nDigitValue       = 0;
+   uint32_t nCheck            = 0;
+   size_t nCheckDigits        = 0;
+   size_t nCount              = 0;
+
+   pFrame->payload.pData   = NULL;
+   pFrame->payload.nLength = 0;
+   pFrame->nChecksum       = 0;
+   pFrame->nCrc            = 0;
+   pFrame->eIntegrity      = EFrameIntegritySum8;
+   pFrame->bSequenced      = false;
+   pFrame->nSequence       = 0;
+   pFrame->eCmdType        = ECommandCodeMin;
+   pFrame->bStxFound       = false;
+   pFrame->bEtxFound       = false;
+   pFrame->bChecksumOk     = false;
+   *pFrameLength           = 0;
+
+   if (nBufferSize == 0 || *pReader != STX)
+   {
+      return MFR_STX_ERR;
+   }
+
+   pFrame->bStxFound = true;
+   pReader++;
+
+   // length digits and separating comma, checked as far as the buffer goes
+   nCount = nBufferSize - 1;
+   if (nCount > FRAME_LENGTH_DIGITS)
+   {
+      nCount = FRAME_LENGTH_DIGITS;
+   }
 
-      // read STX character from buffer
-      sscanf(pReader, "%c", szTmp);
-      // convert ascii to numeric
-      nStx = *(char*)szTmp;
-      pReader++;
-      nTotalRead++;
-      if (nStx != STX)
+   if (!DecimalParse(pReader, nCount, &nDigitValue))
+   {
+      return MFR_LENGTH_ERR;
+   }
+
+   nPayloadLength = nDigitValue;
+   pReader       += nCount;
+
+   if (pReader == pBuffer + nBufferSize)
+   {
+      return MFR_BUFF_LEN_ERR;
+   }
+
+   if (!ReadFrameSeparator(*pReader++, &pFrame->eIntegrity))
+   {
+      return MFR_LENGTH_ERR;
+   }
+
+   // payload, checksum and ETX must all be in the buffer
+   nCheckDigits  = FrameCheckDigits(pFrame->eIntegrity);
+   *pFrameLength = 1 + FRAME_LENGTH_DIGITS + 1 + nPayloadLength + nCheckDigits + 1;
+   if (*pFrameLength > nBufferSize)
+   {
+      return MFR_BUFF_LEN_ERR;
+   }
+
+   pFrame->payload.pData   = pReader;
+   pFrame->payload.nLength = nPayloadLength;
+   pReader += nPayloadLength;
+
+   // if ETX isn't where expected
+   if (pReader[nCheckDigits] != ETX)
+   {
+      return MFR_ETX_ERR;
+   }
+
+   for (nCount = 0; nCount < nCheckDigits; nCount++, pReader++)
+   {
+      if (!ReadCheckDigit(*pReader, pFrame->eIntegrity, &nCheck))
       {
-         eResult = MFR_STX_ERR;
+         return MFR_CHKSUM_ERR;
       }
-      else
-      {
-         msgFrame->bStxFound = true;
+   }
 
-         // tokenize string. read until the comma
-         pCh = StrTokenize(pReader, ",");
-         msgFrame->payload.nLength = atoi(pCh);
-         pReader     += strlen(pCh);
-         nTotalRead  += strlen(pCh);
+   if (pFrame->eIntegrity == EFrameIntegritySum8)
+   {
+      pFrame->nChecksum = (int)nCheck;
+   }
+   else
+   {
+      pFrame->nCrc = nCheck;
+   }
 
-         // restore destructive change from strtok
-         *pReader = ',';
+   pFrame->bEtxFound = true;
 
-         // skip the comma
-         if(*pReader == ',')
-         {
-            pReader++;
-            nTotalRead++;
+   // validate the checksum
+   if (FrameCheckUpdate(pFrame->eIntegrity,
+                        FrameCheckInit(pFrame->eIntegrity),
+                        pFrame->payload.pData,
+                        nPayloadLength) != nCheck)
+   {
+      eResult = MFR_CHKSUM_ERR;
+   }
+   else
+   {
+      pFrame->bChecksumOk = true;
 
-            // buffer length check
-            if((nTotalRead + msgFrame->payload.nLength) <= cmdBufferSize)
-            {
-               // copy payload from message frame
-               memcpy(msgFrame->payload.szPayload, pReader, msgFrame->payload.nLength);
-
-               // move pointer past payload
-               pReader     += msgFrame->payload.nLength;
-               nTotalRead  += msgFrame->payload.nLength;
-
-               // if ETX isn't where expected
-               if (*(pReader + 3) != ETX)
-               {
-                  eResult = MFR_ETX_ERR;
-               }
-               // if the end of the command isn't where expected
-               else if (*(pReader + 4) != 0)
-               {
-                  eResult = MFR_LENGTH_ERR;
-               }
-               else
-               {
-                  // only checksum(3 bytes) & ETX remain in the buffer
-                  if((nTotalRead + 4) <= cmdBufferSize)
-                  {
-                     // reset temp buffer
-                     memset(szTmp, 0, sizeof(szTmp));
-
-                     // read checksum from buffer and convert from ascii
-                     sscanf(pReader, "%3c", szTmp);
-                     msgFrame->payload.nChecksum = atoi(szTmp);
-                     pReader += 3;
-
-                     // reset temp buffer. read ETX and convert from ascii
-                     memset(szTmp, 0, sizeof(szTmp));
-                  
-                     sscanf(pReader, "%c", szTmp);
-                     nEtx = *(char*)szTmp;
-
-                     // validate the checksum
-                     nComputedChecksum = CalculateChecksum(&msgFrame->payload);
-                     if (nComputedChecksum == msgFrame->payload.nChecksum)
-                     {
-                        msgFrame->bChecksumOk = true;
-
-                        // check for ETX
-                        if(nEtx == ETX)
-                        {
-                           msgFrame->bEtxFound = true;
-
-                           // read until comma for command code
-                           pCh = StrTokenize(msgFrame->payload.szPayload, ",");
-
-                           // if payload is for a command response
-                           if(strcmp(pCh, "RSP") == 0)
-                           {
-                              // skip the prefix, and restore delimiter
-                              RestoreDelimiterAndMovePast(&pCh, ',');
-                           }
-
-                           // try to convert string to int
-                           nCmdCode = strtol(pCh, &pEnd, 10);
-
-                           // if command code is non printable (ACK or NAK)
-                           // conversion fails, just read the character
-                           if(nCmdCode == 0)
-                           {
-                              // just read it's value
-                              nCmdCode = (int)*pCh;
-                           }
-                           // convert command code from hex string to int
-                           msgFrame->eCmdType = (ECommandCode)nCmdCode;
-
-                           // skip the prefix, and restore delimiter
-                           RestoreDelimiterAndMovePast(&pCh, ',');
-
-                           // if command code is out of range
-                           if ((msgFrame->eCmdType != EAck && msgFrame->eCmdType != ENak)
-                           && ((msgFrame->eCmdType <= ECommandCodeMin) || msgFrame->eCmdType >= ECommandCodeMax))
-                           {
-                              eResult = MFR_COMMAND_ERR;
-                           }
-                        }
-                        else
-                        {
-                           eResult = MFR_ETX_ERR;
-                        }
-                     }
-                     else
-                     {
-                        eResult = MFR_CHKSUM_ERR;
-                     }
-                  }
-               }
-            }
-            else
-            {
-               eResult = MFR_BUFF_LEN_ERR;
-            }
-         }
-      }
+      // read sequence number and command code from the payload
+      ReadSequenceField(&pFrame->payload, &pFrame->bSequenced, &pFrame->nSequence);
+      eResult = ParseCommandCode(pFrame->payload.pData, pFrame->payload.nLength, &pFrame->eCmdType);
    }
 
    return eResult;
@@ -209,37 +509,818 @@ MessageFrameResult ParseMessageFrames(char* cmdBuffer, size_t cmdBufferSize, Mes
 
 /********************************************************************************
  *
- * Name:    AddMessageFraming
+ * Name:    ParseMessageFrameView
  *
- * Purpose: Adds message framing to an outgoing message.
+ * Purpose: Validates message framing in place, without copying the payload.
  *
- * Inputs:  pPayload - command payload
+ * Inputs:  pBuffer     - receive buffer holding one complete frame
+ *          nBufferSize - number of bytes in pBuffer
  *
- * Outputs: pCmdBuffer - output buffer
+ * Outputs: pFrame - populated with validation info. The payload view points
+ *                   into pBuffer.
  *
- * Returns: TODO:
+ * Returns: MFR_OK if the frame is valid, error code otherwise.
  *
- * Notes:   TODO:
+ * Notes:   Anything other than a NULL after the ETX is a length error.
  *
  *******************************************************************************/
 LIB_API
-void AddMessageFraming(MsgPayload* pPayload, size_t cmdBufferSize, char* pCmdBuffer)
+MessageFrameResult ParseMessageFrameView(const char* pBuffer, size_t nBufferSize, MessageFrameView* pFrame)
 {
-   char szHeader[5] = {0};
+   MessageFrameResult eResult = MFR_STX_ERR;
+   size_t nFrameLength        = 0;
 
-   // if buffer is valid and data will fit
-   if (pCmdBuffer != NULL
-   && (pPayload->nLength + PREAMBLE_LENGTH + 1) <= cmdBufferSize)
+   if (pBuffer != NULL && pFrame != NULL)
    {
-      // clear previous data before populating buffer
-      memset(pCmdBuffer, 0, cmdBufferSize);
+      eResult = ParseFrameAt(pBuffer, nBufferSize, pFrame, &nFrameLength);
 
-      sprintf(pCmdBuffer,
-         "%c%04d,%s%03d%c", 
-         (char)STX,
-         pPayload->nLength,
-         pPayload->szPayload,
-         pPayload->nChecksum,
-         (char)ETX);
+      // if the end of the command isn't where expected
+      if (eResult == MFR_OK
+      && nFrameLength < nBufferSize
+      && pBuffer[nFrameLength] != '\0')
+      {
+         eResult = MFR_LENGTH_ERR;
+      }
    }
-}
\ No newline at end of file
+
+   return eResult;
+}
+
+/********************************************************************************
+ *
+ * Name:    ParseMessageFrameBatch
+ *
+ * Purpose: Validates every frame in a buffer of back to back frames.
+ *
+ * Inputs:  pBuffer     - receive buffer, may hold several frames
+ *          nBufferSize - number of bytes in pBuffer
+ *          nMaxFrames  - number of entries in pFrames
+ *
+ * Outputs: pFrames    - populated with one entry per frame found
+ *          pnTrailing - number of bytes at the end of the buffer that were
+ *                       not consumed
+ *
+ * Returns: Number of entries written to pFrames
+ *
+ * Notes:   After a bad frame, or bytes that don't start with STX, the
+ *          garbage up to the next plausible frame is reported as one error
+ *          entry. Its length is the number of bytes skipped. A frame cut
+ *          off by the end of the buffer is left in the trailing bytes, as
+ *          are any frames that didn't fit in pFrames. Keep the trailing
+ *          bytes and pass them in again with the next read.
+ *
+ *******************************************************************************/
+LIB_API
+size_t ParseMessageFrameBatch(const char* pBuffer,
+                              size_t nBufferSize,
+                              FrameBatchEntry* pFrames,
+                              size_t nMaxFrames,
+                              size_t* pnTrailing)
+{
+   FrameBatchEntry* pEntry = NULL;
+   size_t nOffset          = 0;
+   size_t nFrameLength     = 0;
+   size_t nFrames          = 0;
+
+   if (pBuffer == NULL || pFrames == NULL)
+   {
+      nBufferSize = 0;
+   }
+
+   while (nOffset < nBufferSize && nFrames < nMaxFrames)
+   {
+      pEntry          = &pFrames[nFrames];
+      pEntry->nOffset = nOffset;
+      pEntry->eResult = ParseFrameAt(pBuffer + nOffset,
+                                     nBufferSize - nOffset,
+                                     &pEntry->frame,
+                                     &nFrameLength);
+
+      if (pEntry->eResult == MFR_BUFF_LEN_ERR
+      && (nFrameLength == 0 || nFrameLength < PAYLOAD_LENGTH + PREAMBLE_LENGTH))
+      {
+         // incomplete frame at the end of the buffer. A length prefix
+         // too big for any frame is an error instead, or it would never end
+         break;
+      }
+
+      if (pEntry->eResult == MFR_OK)
+      {
+         pEntry->nLength = nFrameLength;
+      }
+      else
+      {
+         // resync, drop everything up to the next plausible frame
+         pEntry->nLength = 1 + FindNextFrame(pBuffer + nOffset + 1, nBufferSize - nOffset - 1);
+      }
+
+      nOffset += pEntry->nLength;
+      nFrames++;
+   }
+
+   if (pnTrailing != NULL)
+   {
+      *pnTrailing = nBufferSize - nOffset;
+   }
+
+   return nFrames;
+}
+
+/********************************************************************************
+ *
+ * Name:    ParseMessageFrames
+ *
+ * Purpose: cmbBuffer - reference to command buffer
+ *          cmdBufferSize - total length of command buffer
+ *          
+ *
+ * Inputs:  msgFrame - populated with message validation info.
+ *
+ * Outputs: None.
+ *
+ * Returns: None.
+ *
+ * Notes:   Validates the frame in place, then copies the payload into
+ *          msgFrame. Use ParseMessageFrameView to avoid the copy.
+ *
+ *******************************************************************************/
+LIB_API
+MessageFrameResult ParseMessageFrames(char* cmdBuffer, size_t cmdBufferSize, MessageFrame* msgFrame)
+{
+   MessageFrameResult eResult = MFR_STX_ERR;
+   MessageFrameView view;
+
+   // check pointers
+   if(cmdBuffer != NULL
+   && msgFrame  != NULL)
+   {
+      eResult = ParseMessageFrameView(cmdBuffer, cmdBufferSize, &view);
+
+      msgFrame->bStxFound   = view.bStxFound;
+      msgFrame->bEtxFound   = view.bEtxFound;
+      msgFrame->bChecksumOk = view.bChecksumOk;
+      msgFrame->eCmdType    = view.eCmdType;
+      msgFrame->eIntegrity  = view.eIntegrity;
+
+      // payload must fit with its NULL terminator
+      if (view.payload.nLength >= PAYLOAD_LENGTH)
+      {
+         eResult = MFR_BUFF_LEN_ERR;
+      }
+      else if (view.payload.pData != NULL)
+      {
+         // copy payload from message frame
+         memcpy(msgFrame->payload.szPayload, view.payload.pData, view.payload.nLength);
+         msgFrame->payload.szPayload[view.payload.nLength] = '\0';
+         msgFrame->payload.nLength    = view.payload.nLength;
+         msgFrame->payload.nChecksum  = view.nChecksum;
+         msgFrame->payload.bSequenced = view.bSequenced;
+         msgFrame->payload.nSequence  = view.nSequence;
+
+         // payload checksum, without the sequence field
+         if (view.eIntegrity != EFrameIntegritySum8)
+         {
+            msgFrame->payload.nChecksum = ChecksumBytes(view.payload.pData, view.payload.nLength);
+         }
+         else if (view.bSequenced)
+         {
+            msgFrame->payload.nChecksum = (view.nChecksum - SequenceChecksum(view.nSequence)) & 0xFF;
+         }
+      }
+   }
+
+   return eResult;
+}
+
+/********************************************************************************
+ *
+ * Name:    FrameHeaderLength
+ *
+ * Purpose: Returns the length of the frame header for a payload
+ *
+ * Inputs:  pPayload - outgoing payload
+ *
+ * Outputs: None
+ *
+ * Returns: Header length, including the sequence field if the payload has one
+ *
+ * Notes:   None.
+ *
+ *******************************************************************************/
+static size_t FrameHeaderLength(const MsgPayload* pPayload)
+{
+   return FRAME_HEADER_LENGTH + (pPayload->bSequenced ? FRAME_SEQUENCE_LENGTH : 0);
+}
+
+/********************************************************************************
+ *
+ * Name:    CanFrame
+ *
+ * Purpose: Checks a payload fits in a frame
+ *
+ * Inputs:  pPayload   - outgoing payload
+ *          eIntegrity - frame check
+ *
+ * Outputs: None
+ *
+ * Returns: true if the payload, its sequence field and frame check fit
+ *
+ * Notes:   The sequence field and longer frame checks take room from the
+ *          payload so these frames are no longer than any other frame.
+ *
+ *******************************************************************************/
+static bool CanFrame(const MsgPayload* pPayload, EFrameIntegrity eIntegrity)
+{
+   size_t nExtra = FrameHeaderLength(pPayload) - FRAME_HEADER_LENGTH
+                 + FrameCheckDigits(eIntegrity) - FRAME_CHECKSUM_DIGITS;
+
+   return pPayload->nLength + nExtra < PAYLOAD_LENGTH
+       && (!pPayload->bSequenced || pPayload->nSequence < FRAME_SEQUENCE_COUNT);
+}
+
+/********************************************************************************
+ *
+ * Name:    WriteFrameHeader
+ *
+ * Purpose: Writes the frame header, STX, length and separator, followed by
+ *          the sequence field if the payload has one
+ *
+ * Inputs:  pPayload   - outgoing payload
+ *          eIntegrity - frame check
+ *
+ * Outputs: pDest - FrameHeaderLength bytes written
+ *
+ * Returns: Frame check for the frame trailer
+ *
+ * Notes:   The 8 bit sum comes from the payload, a CRC is calculated here
+ *          over the sequence field and payload.
+ *
+ *******************************************************************************/
+static uint32_t WriteFrameHeader(char* pDest, const MsgPayload* pPayload, EFrameIntegrity eIntegrity)
+{
+   size_t nHeaderLength = FrameHeaderLength(pPayload);
+   uint32_t nCheck      = (uint32_t)pPayload->nChecksum;
+   const char chSeparator[] = { FRAME_SEPARATOR, FRAME_SEPARATOR_CRC16, FRAME_SEPARATOR_CRC32C };
+
+   pDest[0] = STX;
+   DecimalFormatFixed(pDest + 1, (uint32_t)(pPayload->nLength + nHeaderLength - FRAME_HEADER_LENGTH), FRAME_LENGTH_DIGITS);
+   pDest[1 + FRAME_LENGTH_DIGITS] = chSeparator[eIntegrity];
+
+   if (pPayload->bSequenced)
+   {
+      pDest[FRAME_HEADER_LENGTH] = FRAME_SEQUENCE_MARKER;
+      DecimalFormatFixed(pDest + FRAME_HEADER_LENGTH + 1, pPayload->nSequence, FRAME_SEQUENCE_DIGITS);
+      pDest[FRAME_HEADER_LENGTH + FRAME_SEQUENCE_LENGTH - 1] = ',';
+
+      nCheck += (uint32_t)SequenceChecksum(pPayload->nSequence);
+   }
+
+   if (eIntegrity != EFrameIntegritySum8)
+   {
+      nCheck = FrameCheckInit(eIntegrity);
+      nCheck = FrameCheckUpdate(eIntegrity, nCheck, pDest + FRAME_HEADER_LENGTH, nHeaderLength - FRAME_HEADER_LENGTH);
+      nCheck = FrameCheckUpdate(eIntegrity, nCheck, pPayload->szPayload, pPayload->nLength);
+   }
+
+   return nCheck;
+}
+
+/********************************************************************************
+ *
+ * Name:    WriteFrameTrailer
+ *
+ * Purpose: Writes the frame trailer, frame check and ETX, NULL terminated
+ *
+ * Inputs:  eIntegrity - frame check
+ *          nCheck     - frame check value
+ *
+ * Outputs: pDest - frame check digits, ETX and NULL written
+ *
+ * Returns: Number of bytes written, not counting the NULL
+ *
+ * Notes:   CRCs are written in upper case hex.
+ *
+ *******************************************************************************/
+static size_t WriteFrameTrailer(char* pDest, EFrameIntegrity eIntegrity, uint32_t nCheck)
+{
+   static const char szHex[] = "0123456789ABCDEF";
+   size_t nDigits = FrameCheckDigits(eIntegrity);
+   size_t nCount  = nDigits;
+
+   if (eIntegrity == EFrameIntegritySum8)
+   {
+      DecimalFormatFixed(pDest, nCheck & 0xFF, nDigits);
+   }
+   else
+   {
+      while (nCount > 0)
+      {
+         pDest[--nCount] = szHex[nCheck & 0xF];
+         nCheck >>= 4;
+      }
+   }
+
+   pDest[nDigits]     = ETX;
+   pDest[nDigits + 1] = '\0';
+
+   return nDigits + 1;
+}
+
+/********************************************************************************
+ *
+ * Name:    SetFrameIntegrity
+ *
+ * Purpose: Selects the frame check used for frames built from now on
+ *
+ * Inputs:  eIntegrity - frame check
+ *
+ * Outputs: None
+ *
+ * Returns: None
+ *
+ * Notes:   Set for the current session, see CmdSession_Enter.
+ *
+ *******************************************************************************/
+LIB_API
+void SetFrameIntegrity(EFrameIntegrity eIntegrity)
+{
+   if (eIntegrity >= EFrameIntegritySum8 && eIntegrity <= EFrameIntegrityCrc32c)
+   {
+      CmdSession_Current()->eIntegrity = eIntegrity;
+   }
+}
+
+/********************************************************************************
+ *
+ * Name:    GetFrameIntegrity
+ *
+ * Purpose: Returns the frame check used for frames built from now on
+ *
+ * Inputs:  None
+ *
+ * Outputs: None
+ *
+ * Returns: Frame check
+ *
+ * Notes:   None.
+ *
+ *******************************************************************************/
+LIB_API
+EFrameIntegrity GetFrameIntegrity(void)
+{
+   return CmdSession_Current()->eIntegrity;
+}
+
+/********************************************************************************
+ *
+ * Name:    AddMessageFraming
+ *
+ * Purpose: Adds message framing to an outgoing message.
+ *
+ * Inputs:  pPayload - command payload
+ *
+ * Outputs: pCmdBuffer - output buffer
+ *
+ * Returns: TODO:
+ *
+ * Notes:   Only the framed bytes and the NULL after them are written, the
+ *          rest of pCmdBuffer is left as it was.
+ *
+ *******************************************************************************/
+LIB_API
+void AddMessageFraming(MsgPayload* pPayload, size_t cmdBufferSize, char* pCmdBuffer)
+{
+   EFrameIntegrity eIntegrity = GetFrameIntegrity();
+   size_t nHeaderLength       = 0;
+   uint32_t nCheck            = 0;
+
+   // if buffer is valid and data will fit
+   if (pCmdBuffer != NULL
+   && pPayload != NULL
+   && CanFrame(pPayload, eIntegrity)
+   && (FrameHeaderLength(pPayload) + pPayload->nLength + FrameCheckDigits(eIntegrity) + 2) <= cmdBufferSize)
+   {
+      nHeaderLength = FrameHeaderLength(pPayload);
+      nCheck        = WriteFrameHeader(pCmdBuffer, pPayload, eIntegrity);
+      memcpy(pCmdBuffer + nHeaderLength, pPayload->szPayload, pPayload->nLength);
+      WriteFrameTrailer(pCmdBuffer + nHeaderLength + pPayload->nLength, eIntegrity, nCheck);
+   }
+}
+
+/********************************************************************************
+ *
+ * Name:    AddMessageFramingInPlace
+ *
+ * Purpose: Adds framing in the headroom and tailroom around the payload
+ *
+ * Inputs:  pPayload - payload with nLength and nChecksum set
+ *
+ * Outputs: pPayload - header and trailer written around szPayload
+ *          ppFrame  - start of the framed bytes
+ *
+ * Returns: Number of framed bytes, 0 if the payload is too long
+ *
+ * Notes:   The payload is not copied. The header goes in szHeadroom and the
+ *          trailer directly after the last payload byte, which is inside
+ *          szPayload or szTailroom depending on the length. The frame
+ *          crosses the member arrays, so its pointers are taken from the
+ *          start of szHeadroom in the whole MsgPayload, not from one member.
+ *
+ *******************************************************************************/
+LIB_API
+size_t AddMessageFramingInPlace(MsgPayload* pPayload, const char** ppFrame)
+{
+   EFrameIntegrity eIntegrity = GetFrameIntegrity();
+   size_t nFrameLength        = 0;
+   size_t nHeaderLength       = 0;
+   char* pRoom                = NULL;
+   char* pFrame               = NULL;
+   uint32_t nCheck            = 0;
+
+   if (pPayload != NULL
+   && ppFrame != NULL
+   && CanFrame(pPayload, eIntegrity))
+   {
+      // szHeadroom, szPayload and szTailroom as one buffer
+      pRoom = (char*)pPayload + offsetof(MsgPayload, szHeadroom);
+
+      // header ends where the payload starts
+      nHeaderLength = FrameHeaderLength(pPayload);
+      pFrame        = pRoom + FRAME_HEADROOM - nHeaderLength;
+      nCheck        = WriteFrameHeader(pFrame, pPayload, eIntegrity);
+
+      *ppFrame     = pFrame;
+      nFrameLength = nHeaderLength + pPayload->nLength
+                   + WriteFrameTrailer(pRoom + FRAME_HEADROOM + pPayload->nLength, eIntegrity, nCheck);
+   }
+
+   return nFrameLength;
+}
+
+/********************************************************************************
+ *
+ * Name:    AddMessageFramingSegments
+ *
+ * Purpose: Adds framing as separate header, payload and trailer pieces
+ *
+ * Inputs:  pPayload - payload with nLength and nChecksum set
+ *
+ * Outputs: pSegments - header and trailer built, payload piece points
+ *                      into pPayload
+ *
+ * Returns: Number of framed bytes, 0 if the payload is too long
+ *
+ * Notes:   For links that can send a list of buffers in one call.
+ *
+ *******************************************************************************/
+LIB_API
+size_t AddMessageFramingSegments(const MsgPayload* pPayload, FrameSegments* pSegments)
+{
+   EFrameIntegrity eIntegrity = GetFrameIntegrity();
+   size_t nFrameLength        = 0;
+   uint32_t nCheck            = 0;
+
+   if (pPayload != NULL
+   && pSegments != NULL
+   && CanFrame(pPayload, eIntegrity))
+   {
+      nCheck = WriteFrameHeader(pSegments->szHeader, pPayload, eIntegrity);
+
+      pSegments->segments[0].pData   = pSegments->szHeader;
+      pSegments->segments[0].nLength = FrameHeaderLength(pPayload);
+      pSegments->segments[1].pData   = pPayload->szPayload;
+      pSegments->segments[1].nLength = pPayload->nLength;
+      pSegments->segments[2].pData   = pSegments->szTrailer;
+      pSegments->segments[2].nLength = WriteFrameTrailer(pSegments->szTrailer, eIntegrity, nCheck);
+
+      nFrameLength = pSegments->segments[0].nLength + pPayload->nLength + pSegments->segments[2].nLength;
+   }
+
+   return nFrameLength;
+}
+
+/********************************************************************************
+ *
+ * Name:    FrameDecoder_Init
+ *
+ * Purpose: Initializes a streaming frame decoder.
+ *
+ * Inputs:  fpCallback - called for each completed frame
+ *          pContext   - passed back to fpCallback
+ *
+ * Outputs: pDecoder - ready to receive bytes
+ *
+ * Returns: None.
+ *
+ * Notes:   None.
+ *
+ *******************************************************************************/
+LIB_API
+void FrameDecoder_Init(FrameDecoder* pDecoder, FnFrameDecoded fpCallback, void* pContext)
+{
+   if (pDecoder != NULL)
+   {
+      pDecoder->fpCallback = fpCallback;
+      pDecoder->pContext   = pContext;
+      pDecoder->nSkipped   = 0;
+      FrameDecoder_Reset(pDecoder);
+   }
+}
+
+/********************************************************************************
+ *
+ * Name:    FrameDecoder_Reset
+ *
+ * Purpose: Discards any partially received frame.
+ *
+ * Inputs:  None.
+ *
+ * Outputs: pDecoder - waiting for the next STX
+ *
+ * Returns: None.
+ *
+ * Notes:   None.
+ *
+ *******************************************************************************/
+LIB_API
+void FrameDecoder_Reset(FrameDecoder* pDecoder)
+{
+   if (pDecoder != NULL)
+   {
+      pDecoder->eState    = EDecodeStx;
+      pDecoder->nDigits   = 0;
+      pDecoder->nReceived = 0;
+      pDecoder->nCrc        = 0;
+      pDecoder->nFrameCheck = 0;
+      ChecksumInit(&pDecoder->checksum);
+
+      pDecoder->frame.payload.nLength    = 0;
+      pDecoder->frame.payload.nChecksum  = 0;
+      pDecoder->frame.payload.bSequenced = false;
+      pDecoder->frame.payload.nSequence  = 0;
+      pDecoder->frame.eCmdType          = ECommandCodeMin;
+      pDecoder->frame.eIntegrity        = EFrameIntegritySum8;
+      pDecoder->frame.bStxFound         = false;
+      pDecoder->frame.bEtxFound         = false;
+      pDecoder->frame.bChecksumOk       = false;
+   }
+}
+
+/********************************************************************************
+ *
+ * Name:    CompleteFrame
+ *
+ * Purpose: Reports a finished frame to the decoder callback and gets ready
+ *          for the next one.
+ *
+ * Inputs:  pDecoder - streaming decoder
+ *          eResult  - result of decoding the frame
+ *
+ * Outputs: None.
+ *
+ * Returns: None.
+ *
+ * Notes:   None.
+ *
+ *******************************************************************************/
+static void CompleteFrame(FrameDecoder* pDecoder, MessageFrameResult eResult)
+{
+   if (pDecoder->fpCallback != NULL)
+   {
+      pDecoder->fpCallback(pDecoder->pContext, eResult, &pDecoder->frame);
+   }
+
+   FrameDecoder_Reset(pDecoder);
+}
+
+/********************************************************************************
+ *
+ * Name:    StripSequenceField
+ *
+ * Purpose: Moves the sequence number of a received payload into its fields
+ *
+ * Inputs:  pPayload - validated payload
+ *
+ * Outputs: pPayload - sequence field removed, bSequenced, nSequence and
+ *                     nChecksum updated
+ *
+ * Returns: None
+ *
+ * Notes:   None.
+ *
+ *******************************************************************************/
+static void StripSequenceField(MsgPayload* pPayload)
+{
+   FrameView payload = { pPayload->szPayload, pPayload->nLength };
+
+   ReadSequenceField(&payload, &pPayload->bSequenced, &pPayload->nSequence);
+
+   if (pPayload->bSequenced)
+   {
+      // includes the NULL terminator
+      memmove(pPayload->szPayload, payload.pData, payload.nLength + 1);
+      pPayload->nLength   = payload.nLength;
+      pPayload->nChecksum = (pPayload->nChecksum - SequenceChecksum(pPayload->nSequence)) & 0xFF;
+   }
+}
+
+/********************************************************************************
+ *
+ * Name:    FrameDecoder_Feed
+ *
+ * Purpose: Runs received bytes through the frame state machine.
+ *
+ * Inputs:  pBytes  - received data, may start or end in the middle of a frame
+ *          nLength - number of bytes in pBytes
+ *
+ * Outputs: pDecoder - position is kept between calls
+ *
+ * Returns: Number of frames passed to the callback
+ *
+ * Notes:   Payload bytes are copied straight from the input chunk into the
+ *          frame being assembled, and added to the checksum on the way.
+ *          A frame that fails validation is reported with its error code
+ *          and the decoder starts looking for the next STX. When the byte
+ *          that broke the frame is itself an STX it is left in place, so a
+ *          frame cut short by the start of the next one doesn't take that
+ *          frame down with it.
+ *
+ *******************************************************************************/
+LIB_API
+size_t FrameDecoder_Feed(FrameDecoder* pDecoder, const char* pBytes, size_t nLength)
+{
+   const char* pReader  = pBytes;
+   const char* pEnd     = pBytes + nLength;
+   MsgPayload* pPayload = NULL;
+   size_t nFrames       = 0;
+   size_t nCopy         = 0;
+   char   ch            = 0;
+
+   if (pDecoder == NULL || pBytes == NULL)
+   {
+      return 0;
+   }
+
+   pPayload = &pDecoder->frame.payload;
+
+   while (pReader < pEnd)
+   {
+      switch (pDecoder->eState)
+      {
+      case EDecodeStx:
+         // skip anything between frames
+         nCopy = ScanForByte(pReader, (size_t)(pEnd - pReader), STX);
+         pDecoder->nSkipped += nCopy;
+         pReader            += nCopy;
+
+         if (pReader < pEnd)
+         {
+            pReader++;
+            pDecoder->frame.bStxFound = true;
+            pDecoder->eState = EDecodeLength;
+         }
+         break;
+
+      case EDecodeLength:
+         ch = *pReader++;
+         if (ch < '0' || ch > '9')
+         {
+            CompleteFrame(pDecoder, MFR_LENGTH_ERR);
+            nFrames++;
+
+            // an STX here starts the next frame, so scan from it again
+            if (ch == STX)
+            {
+               pReader--;
+            }
+            break;
+         }
+
+         pPayload->nLength = (pPayload->nLength * 10) + (size_t)(ch - '0');
+
+         if (++pDecoder->nDigits == FRAME_LENGTH_DIGITS)
+         {
+            pDecoder->nDigits = 0;
+
+            // payload must fit with its NULL terminator
+            if (pPayload->nLength >= PAYLOAD_LENGTH)
+            {
+               CompleteFrame(pDecoder, MFR_BUFF_LEN_ERR);
+               nFrames++;
+            }
+            else
+            {
+               pDecoder->eState = EDecodeSeparator;
+            }
+         }
+         break;
+
+      case EDecodeSeparator:
+         ch = *pReader++;
+         if (!ReadFrameSeparator(ch, &pDecoder->frame.eIntegrity))
+         {
+            CompleteFrame(pDecoder, MFR_LENGTH_ERR);
+            nFrames++;
+
+            // an STX here starts the next frame, so scan from it again
+            if (ch == STX)
+            {
+               pReader--;
+            }
+         }
+         else
+         {
+            pDecoder->nCrc   = FrameCheckInit(pDecoder->frame.eIntegrity);
+            pDecoder->eState = (pPayload->nLength > 0) ? EDecodePayload : EDecodeChecksum;
+         }
+         break;
+
+      case EDecodePayload:
+         // copy as much of the payload as this chunk holds
+         nCopy = pPayload->nLength - pDecoder->nReceived;
+         if (nCopy > (size_t)(pEnd - pReader))
+         {
+            nCopy = (size_t)(pEnd - pReader);
+         }
+
+         memcpy(pPayload->szPayload + pDecoder->nReceived, pReader, nCopy);
+         ChecksumUpdate(&pDecoder->checksum, pReader, nCopy);
+
+         if (pDecoder->frame.eIntegrity != EFrameIntegritySum8)
+         {
+            pDecoder->nCrc = FrameCheckUpdate(pDecoder->frame.eIntegrity, pDecoder->nCrc, pReader, nCopy);
+         }
+
+         pReader              += nCopy;
+         pDecoder->nReceived  += nCopy;
+
+         if (pDecoder->nReceived == pPayload->nLength)
+         {
+            pPayload->szPayload[pPayload->nLength] = '\0';
+            pDecoder->eState = EDecodeChecksum;
+         }
+         break;
+
+      case EDecodeChecksum:
+         ch = *pReader++;
+         if (!ReadCheckDigit(ch, pDecoder->frame.eIntegrity, &pDecoder->nFrameCheck))
+         {
+            CompleteFrame(pDecoder, MFR_CHKSUM_ERR);
+            nFrames++;
+
+            // an STX here starts the next frame, so scan from it again
+            if (ch == STX)
+            {
+               pReader--;
+            }
+            break;
+         }
+
+         if (++pDecoder->nDigits == FrameCheckDigits(pDecoder->frame.eIntegrity))
+         {
+            pDecoder->eState = EDecodeEtx;
+         }
+         break;
+
+      case EDecodeEtx:
+      default:
+         ch = *pReader++;
+         if (ch != ETX)
+         {
+            CompleteFrame(pDecoder, MFR_ETX_ERR);
+
+            // an STX here starts the next frame, so scan from it again
+            if (ch == STX)
+            {
+               pReader--;
+            }
+         }
+         else
+         {
+            pDecoder->frame.bEtxFound = true;
+
+            // validate the checksum, then the command code
+            pPayload->nChecksum = ChecksumFinal(&pDecoder->checksum);
+
+            if ((pDecoder->frame.eIntegrity == EFrameIntegritySum8 ? (uint32_t)pPayload->nChecksum
+                                                                   : pDecoder->nCrc) != pDecoder->nFrameCheck)
+            {
+               CompleteFrame(pDecoder, MFR_CHKSUM_ERR);
+            }
+            else
+            {
+               pDecoder->frame.bChecksumOk = true;
+               StripSequenceField(pPayload);
+               CompleteFrame(pDecoder, ParseCommandCode(pPayload->szPayload,
+                                                        pPayload->nLength,
+                                                        &pDecoder->frame.eCmdType));
+            }
+         }
+
+         nFrames++;
+         break;
+      }
+   }
+
+   return nFrames;
+}
@@ -1,7 +1,65 @@
 #include <string.h>
+#include "commandAtomic.h"
 #include "commandHandlers.h"
+#include "commandSession.h"
 
-CommandHandlers m_pHandlers = { 0 };
+// The active table is swapped with one pointer store, so a thread parsing a
+// command sees either the old table or the new one, never a mix. Each table
+// counts the commands using it, and a table is only written while its count
+// is zero and it is not active. A reader counts itself before checking the
+// table is still active, and the writer publishes before checking counts, so
+// with full barriers on both sides one of them always sees the other.
+//
+// A thread that already holds a table of the session gets the same table
+// again, so DispatchFrame can hold one table for the whole command and the
+// parser's own reads can't pick up a newer one part way through.
+
+// table the calling thread holds and how many times, see AcquireCommandHandlers
+static THREAD_LOCAL CommandHandlers* m_pHeld = NULL;
+static THREAD_LOCAL size_t m_nHeld = 0;
+
+/********************************************************************************
+ *
+ * Name:    IsSessionTable
+ *
+ * Purpose: Checks whether a table belongs to a session
+ *
+ * Inputs:  pTables   - handler tables of a session
+ *          pHandlers - table to check
+ *
+ * Outputs: None
+ *
+ * Returns: true if pHandlers is one of pTables
+ *
+ * Notes:   None
+ *
+ *******************************************************************************/
+static bool IsSessionTable(const HandlerTable* pTables, const CommandHandlers* pHandlers)
+{
+   return pHandlers >= pTables->tables && pHandlers < pTables->tables + HANDLER_TABLE_COUNT;
+}
+
+/********************************************************************************
+ *
+ * Name:    ActiveTable
+ *
+ * Purpose: Returns the table SetCommandHandlers last made active
+ *
+ * Inputs:  pTables - handler tables of a session
+ *
+ * Outputs: None
+ *
+ * Returns: Active table, tables[0] before the first swap
+ *
+ * Notes:   None
+ *
+ *******************************************************************************/
+static CommandHandlers* ActiveTable(HandlerTable* pTables)
+{
+   CommandHandlers* pTable = LOAD_SEQ_CST(pTables->pActive);
+
+   return pTable != NULL ? pTable : &pTables->tables[0];
+}
 
 /********************************************************************************
  *
@@ -13,14 +71,133 @@ CommandHandlers m_pHandlers = { 0 };
  *
  * Outputs: None
  *
- * Returns: None
+ * Returns: false if every spare table stayed in use, nothing was changed
  *
- * Notes:   None
+ * Notes:   The handlers are copied into a table of the current session that
+ *          is neither active nor in use, which is then made active, so
+ *          commands being parsed keep the table they started with. If all
+ *          the spare tables are in use this checks again, up to
+ *          HANDLER_SWAP_ATTEMPTS times, so a handler that blocks inside a
+ *          command can't hang the caller. Called from one thread at a time.
  *
  *******************************************************************************/
-void SetCommandHandlers(CommandHandlers* pHandlers)
+bool SetCommandHandlers(CommandHandlers* pHandlers)
 {
-   m_pHandlers = *pHandlers; 
+   HandlerTable* pTables    = &CmdSession_Current()->handlers;
+   CommandHandlers* pActive = ActiveTable(pTables);
+   CommandHandlers* pTable  = NULL;
+   size_t nAttempt          = 0;
+   size_t nIdx              = 0;
+
+   for (nAttempt = 0; nAttempt < HANDLER_SWAP_ATTEMPTS && pTable == NULL; nAttempt++)
+   {
+      for (nIdx = 0; nIdx < HANDLER_TABLE_COUNT && pTable == NULL; nIdx++)
+      {
+         if (&pTables->tables[nIdx] != pActive && LOAD_SEQ_CST(pTables->nReaders[nIdx]) == 0)
+         {
+            pTable = &pTables->tables[nIdx];
+         }
+      }
+   }
+
+   if (pTable != NULL)
+   {
+      *pTable = *pHandlers;
+      STORE_SEQ_CST(pTables->pActive, pTable);
+   }
+
+   return pTable != NULL;
 }
 
+/********************************************************************************
+ *
+ * Name:    AcquireCommandHandlers
+ *
+ * Purpose: Returns the active command handler table
+ *
+ * Inputs:  None
+ *
+ * Outputs: None
+ *
+ * Returns: Active table, all handlers NULL before SetCommandHandlers
+ *
+ * Notes:   Read it once per command so every handler the command uses comes
+ *          from the same table, and hand it back with ReleaseCommandHandlers.
+ *          If a swap replaces the table before it is counted, the count is
+ *          undone and the new table taken instead.
+ *
+ *          While the calling thread holds a table of the current session,
+ *          that table is returned and counted again.
+ *
+ *******************************************************************************/
+const CommandHandlers* AcquireCommandHandlers(void)
+{
+   HandlerTable* pTables   = &CmdSession_Current()->handlers;
+   CommandHandlers* pTable = NULL;
+   CommandHandlers* pCheck = NULL;
+
+   if (m_nHeld > 0 && IsSessionTable(pTables, m_pHeld))
+   {
+      // already counted, so it can't be reused while this thread holds it
+      pTable = m_pHeld;
+      ATOMIC_INCREMENT(pTables->nReaders[pTable - pTables->tables]);
+   }
+   else
+   {
+      pCheck = ActiveTable(pTables);
+
+      while (pTable != pCheck)
+      {
+         if (pTable != NULL)
+         {
+            ATOMIC_DECREMENT(pTables->nReaders[pTable - pTables->tables]);
+         }
+
+         pTable = pCheck;
+         ATOMIC_INCREMENT(pTables->nReaders[pTable - pTables->tables]);
+         pCheck = ActiveTable(pTables);
+      }
+   }
+
+   if (m_nHeld == 0)
+   {
+      m_pHeld = pTable;
+   }
+
+   if (pTable == m_pHeld)
+   {
+      m_nHeld++;
+   }
 
+   return pTable;
+}
+
+/********************************************************************************
+ *
+ * Name:    ReleaseCommandHandlers
+ *
+ * Purpose: Hands back a table from AcquireCommandHandlers
+ *
+ * Inputs:  pHandlers - table from AcquireCommandHandlers
+ *
+ * Outputs: None
+ *
+ * Returns: None
+ *
+ * Notes:   A table from another session is ignored.
+ *
+ *******************************************************************************/
+void ReleaseCommandHandlers(const CommandHandlers* pHandlers)
+{
+   HandlerTable* pTables = &CmdSession_Current()->handlers;
+
+   if (IsSessionTable(pTables, pHandlers))
+   {
+      if (pHandlers == m_pHeld && m_nHeld > 0)
+      {
+         m_nHeld--;
+      }
+
+      ATOMIC_DECREMENT(pTables->nReaders[pHandlers - pTables->tables]);
+   }
+}
@@ -35,9 +35,12 @@
 * NOTES:       
 *
 ********************************************************************************/
+#include <limits.h>
 #include <string.h>
 #include <stdlib.h>
 #include "commandParameters.h"
+#include "commandDecimal.h"
+#include "commandSession.h"
 
 
 
@@ -72,6 +75,73 @@ void RestoreDelimiterAndMovePast(char** pCmdBuffer, char delimiter)
    (*pCmdBuffer)++;
 }
 
+/********************************************************************************
+ *
+ * Name:    StrTokenizeBegin
+ *
+ * Purpose: Starts tokenizing a string
+ *
+ * Inputs:  pCursor - caller owned position
+ *          s       - NULL terminated string to tokenize
+ *
+ * Outputs: pCursor - positioned at the first token
+ *
+ * Returns: None.
+ *
+ * Notes:   None.
+ *
+ *******************************************************************************/
+void StrTokenizeBegin(TokenCursor* pCursor, char* s)
+{
+   if (pCursor != NULL)
+   {
+      pCursor->pNext = s;
+   }
+}
+
+/********************************************************************************
+ *
+ * Name:    StrTokenizeNext
+ *
+ * Purpose: Returns the next token, replacing the delimiter after it with a NULL
+ *
+ * Inputs:  pCursor - position from StrTokenizeBegin
+ *          delim   - array of delimiters that end this token
+ *
+ * Outputs: pCursor - advanced past the delimiter
+ *
+ * Returns: Token, or NULL once the string is used up
+ *
+ * Notes:   All state is in the cursor, so any number of strings can be
+ *          tokenized at once. Empty tokens between two delimiters are
+ *          returned, which keeps parameters in their positions.
+ *
+ *******************************************************************************/
+char* StrTokenizeNext(TokenCursor* pCursor, const char* delim)
+{
+   char* pToken  = NULL;
+   char* pReader = NULL;
+
+   if (pCursor != NULL && pCursor->pNext != NULL && delim != NULL)
+   {
+      pToken  = pCursor->pNext;
+      pReader = pToken + strcspn(pToken, delim);
+
+      if (*pReader != '\0')
+      {
+         *pReader++ = '\0';
+         pCursor->pNext = pReader;
+      }
+      else
+      {
+         // last token
+         pCursor->pNext = NULL;
+      }
+   }
+
+   return pToken;
+}
+
 /********************************************************************************
  *
  * Name:    StrTokenize
@@ -81,74 +151,183 @@ void RestoreDelimiterAndMovePast(char** pCmdBuffer, char delimiter)
  *
  * Inputs:  s        - the string to tokenize
  *          delim    - array of delimiters
- *          savePtr  - position of last token.
  *
  * Outputs: None
  *
  * Returns: Pointer to last token
  *
- * Notes:   None
+ * Notes:   Keeps its position in the current session, so only one string
+ *          per session can be tokenized at a time. Use
+ *          StrTokenizeBegin/StrTokenizeNext.
  *
  *******************************************************************************/
-char* m_pStart = NULL;
-char* m_pLast = NULL;
-int m_nTokenLen = 0;
-
 char* StrTokenize(char* s, const char* delim)
 {
-   char* pStart = NULL;
-   char* pNext  = NULL;
-   char* pReader = NULL;
+   TokenCursor* pCursor = &CmdSession_Current()->tokenCursor;
+
+   if (s != NULL)
+   {
+      StrTokenizeBegin(pCursor, s);
+   }
+
+   return StrTokenizeNext(pCursor, delim);
+}
+
+/********************************************************************************
+ *
+ * Name:    ViewNextField
+ *
+ * Purpose: Splits the next field off the front of a payload view
+ *
+ * Inputs:  pReader   - remaining payload. Advanced past the field and delimiter.
+ *          delimiter - character that ends the field
+ *          
+ * Outputs: pField - populated with the field, without the delimiter
+ *
+ * Returns: true if the delimiter was found
+ *
+ * Notes:   If the delimiter isn't found the field is the rest of the payload.
+ *          The payload is never written to, so it may be const or shared
+ *          and each byte is looked at once.
+ *
+ *******************************************************************************/
+bool ViewNextField(FrameView* pReader, char delimiter, FrameView* pField)
+{
+   const char* pFound = NULL;
+
+   if (pReader->nLength > 0)
+   {
+      pFound = memchr(pReader->pData, delimiter, pReader->nLength);
+   }
+
+   pField->pData = pReader->pData;
 
-   // determine if string is new or continuation from previous
-   if (s == NULL)
+   if (pFound != NULL)
    {
-      pStart = m_pLast;
+      pField->nLength   = (size_t)(pFound - pReader->pData);
+      pReader->pData    = pFound + 1;
+      pReader->nLength -= pField->nLength + 1;
    }
    else
    {
-      pStart = s;
-      m_pStart = pStart;
-      m_nTokenLen = strlen(pStart);
+      pField->nLength   = pReader->nLength;
+      pReader->pData   += pReader->nLength;
+      pReader->nLength  = 0;
    }
 
-   pReader = pStart;
+   return pFound != NULL;
+}
+
+/********************************************************************************
+ *
+ * Name:    ViewEquals
+ *
+ * Purpose: Compares a view against a NULL terminated string
+ *
+ * Inputs:  pView  - text to compare
+ *          pszText - string to compare against
+ *          
+ * Outputs: None.
+ *
+ * Returns: true if the view holds exactly pszText
+ *
+ * Notes:   None.
+ *
+ *******************************************************************************/
+bool ViewEquals(const FrameView* pView, const char* pszText)
+{
+   size_t nLength = strlen(pszText);
+
+   return pView->nLength == nLength
+       && memcmp(pView->pData, pszText, nLength) == 0;
+}
 
-   if(pStart != NULL)
+/********************************************************************************
+ *
+ * Name:    ViewToInt
+ *
+ * Purpose: Converts a decimal value held in a view
+ *
+ * Inputs:  pView - text to convert
+ *          
+ * Outputs: None.
+ *
+ * Returns: Converted value
+ *
+ * Notes:   Stops at the first non digit and clamps values that
+ *          overflow, same as strtol.
+ *
+ *******************************************************************************/
+int ViewToInt(const FrameView* pView)
+{
+   const char* pReader = pView->pData;
+   size_t nLength      = pView->nLength;
+   size_t nSign        = 0;
+   int nValue          = 0;
+
+   if (nLength > 0 && (*pReader == '-' || *pReader == '+'))
    {
-      while (pReader - m_pStart < m_nTokenLen)
-      {
-         if (*pReader == *delim)
-         {
-            *pReader = '\0';
-            pNext = pReader;
-
-            if (pNext - m_pStart < m_nTokenLen)
-            {
-               pNext++;
-               m_pLast = pNext;
-            }
-            else
-            {
-               pNext = NULL;
-               m_pLast = NULL;
-            }
-
-            break;
-         }
-
-         pReader++;
-      }
+      nSign = 1;
+   }
+
+   nLength = nSign + DecimalDigitRun(pReader + nSign, nLength - nSign);
+
+   if (nLength > nSign && !DecimalParseInt(pReader, nLength, &nValue))
+   {
+      // out of range, clamped the same as strtol
+      nValue = (*pReader == '-') ? INT_MIN : INT_MAX;
    }
 
-   if(pStart == m_pLast)
+   return nValue;
+}
+
+/********************************************************************************
+ *
+ * Name:    ViewToString
+ *
+ * Purpose: Copies a view into a NULL terminated string
+ *
+ * Inputs:  pView       - text to copy
+ *          nBufferSize - size of szBuffer
+ *          
+ * Outputs: szBuffer - populated with the text, truncated to fit
+ *
+ * Returns: None.
+ *
+ * Notes:   None.
+ *
+ *******************************************************************************/
+void ViewToString(const FrameView* pView, char* szBuffer, size_t nBufferSize)
+{
+   size_t nLength = pView->nLength;
+
+   if (nLength >= nBufferSize)
    {
-      pStart = NULL;
-      m_pStart = NULL;
-      m_pLast = NULL;
+      nLength = nBufferSize - 1;
    }
-   
-   return pStart;
+
+   memcpy(szBuffer, pView->pData, nLength);
+   szBuffer[nLength] = '\0';
+}
+
+/********************************************************************************
+ *
+ * Name:    ViewParseInt
+ *
+ * Purpose: Converts a view that must hold nothing but a decimal value
+ *
+ * Inputs:  pView - text to convert
+ *          
+ * Outputs: pValue - converted value, unchanged on failure
+ *
+ * Returns: false if the view is empty, has a non digit or overflows an int
+ *
+ * Notes:   An optional leading sign is allowed.
+ *
+ *******************************************************************************/
+bool ViewParseInt(const FrameView* pView, int* pValue)
+{
+   return DecimalParseInt(pView->pData, pView->nLength, pValue);
 }
 
 //char* StrTokenize(char* s, const char* delim)
@@ -38,6 +38,7 @@
 /********************************************************************************
 *                         I N C L U D E    F I L E S                         
 ********************************************************************************/
+#include <limits.h>
 #include <stddef.h>
 #include <stdint.h>
 #include <stdio.h>
@@ -47,16 +48,124 @@
 #include "commandBuilder.h"
 #include "commandFramework.h"
 #include "commandParameters.h"
+#include "commandBinary.h"
+#include "commandScanner.h"
 /********************************************************************************
 *                          D E F I N I T I O N S
 ********************************************************************************/
-// number of parameters in a set config command payload
-// used for loop processing
-#define SET_CONFIG_PARAM_CNT 6
+// most fields in one ParamField table
+#define PARAM_FIELDS_MAX 8
+
+// parameters of a payload being parsed, ASCII or binary
+typedef struct _ParamReader
+{
+   FrameView  remaining;   // binary records not read yet, or the ASCII payload
+   FieldIndex fields;      // ASCII fields
+   size_t     nField;      // next ASCII field
+   bool       bBinary;
+} ParamReader;
+
+// value types of a tagged field
+typedef enum _EParamType
+{
+   EParamInt,              // nMin - nMax
+   EParamText              // nMin - nMax bytes
+} EParamType;
+
+// one field of a multi-field command
+typedef struct _ParamField
+{
+   EParamTag  eTag;
+   EParamType eType;
+   int        nMin;
+   int        nMax;
+   bool       bRequired;
+} ParamField;
+
+// fields decoded by DecodeParameters, slot n is field n of the table
+typedef struct _ParamValues
+{
+   uint32_t  nPresent;                    // bit n set if field n was received
+   int       nValue[PARAM_FIELDS_MAX];    // EParamInt fields
+   FrameView text[PARAM_FIELDS_MAX];      // EParamText fields, point into the payload
+} ParamValues;
+
+// ParamField table entries expanded from commandSchema.h
+#define SCHEMA_FIELD(eSlot, eTag, eType, nMin, nMax, bRequired) \
+   { eTag, eType, nMin, nMax, bRequired },
+#define SCHEMA_CONFIG_FIELD(eSlot, eTag, eType, nMin, nMax, bRequired, member) \
+   SCHEMA_FIELD(eSlot, eTag, eType, nMin, nMax, bRequired)
+
+// copies a received configuration field into ConfigData, by field type
+#define SCHEMA_CONFIG_DECODE(eSlot, eTag, eType, nMin, nMax, bRequired, member) \
+   if (values.nPresent & (1 << eSlot)) \
+   { \
+      SCHEMA_DECODE_##eType(data.member, values, eSlot); \
+   }
+#define SCHEMA_DECODE_EParamInt(member, values, eSlot)  member = values.nValue[eSlot]
+#define SCHEMA_DECODE_EParamText(member, values, eSlot) \
+   ViewToString(&values.text[eSlot], member, sizeof(member))
+
+// HandleSchemaCommand case for one COMMAND_SCHEMA row, by shape
+#define SCHEMA_HANDLE(eCode, eShape, eTag, nMin, nMax, handler) \
+   SCHEMA_HANDLE_##eShape(eCode, eTag, nMin, nMax, handler)
+#define SCHEMA_HANDLE_NONE(eCode, eTag, nMin, nMax, handler) \
+   case eCode: eResponse = HandleNoParameterCommand(pHandlers->handler); break;
+#define SCHEMA_HANDLE_SET_BOOL(eCode, eTag, nMin, nMax, handler) \
+   case eCode: eResponse = HandleToggleCommand(pPayload, eTag, pHandlers->handler); break;
+#define SCHEMA_HANDLE_SET_INT(eCode, eTag, nMin, nMax, handler) \
+   case eCode: eResponse = HandleIntCommand(pPayload, eTag, nMin, nMax, pHandlers->handler); break;
+#define SCHEMA_HANDLE_VIEW(eCode, eTag, nMin, nMax, handler) \
+   case eCode: eResponse = handler(pPayload); break;
+#define SCHEMA_HANDLE_GET_INT(eCode, eTag, nMin, nMax, handler)
+#define SCHEMA_HANDLE_RUN(eCode, eTag, nMin, nMax, handler)
+#define SCHEMA_HANDLE_FRAME(eCode, eTag, nMin, nMax, handler)
+
+// GetSchemaValue case for one COMMAND_SCHEMA row, GET_INT rows only
+#define SCHEMA_GET(eCode, eShape, eTag, nMin, nMax, handler) \
+   SCHEMA_GET_##eShape(eCode, handler)
+#define SCHEMA_GET_GET_INT(eCode, handler) \
+   case eCode: fpHandler = pHandlers->handler; break;
+#define SCHEMA_GET_NONE(eCode, handler)
+#define SCHEMA_GET_SET_BOOL(eCode, handler)
+#define SCHEMA_GET_SET_INT(eCode, handler)
+#define SCHEMA_GET_VIEW(eCode, handler)
+#define SCHEMA_GET_RUN(eCode, handler)
+#define SCHEMA_GET_FRAME(eCode, handler)
 
 /*********************************************************************************
 *                               D A T A
 *********************************************************************************/
+// tables expanded from commandSchema.h, see the lists there for the fields
+static const ParamField m_configFields[EConfigFieldCount] =
+{
+   CONFIG_FIELDS(SCHEMA_CONFIG_FIELD)
+};
+
+static const ParamField m_logListFields[ELogListFieldCount] =
+{
+   LOG_LIST_FIELDS(SCHEMA_FIELD)
+};
+
+static const ParamField m_logEntryListFields[ELogListFieldCount] =
+{
+   LOG_ENTRY_LIST_FIELDS(SCHEMA_FIELD)
+};
+
+static const ParamField m_valveFields[EGasFieldCount] =
+{
+   VALVE_FIELDS(SCHEMA_FIELD)
+};
+
+static const ParamField m_gasSelectionFields[EGasValue] =
+{
+   GAS_SELECTION_FIELDS(SCHEMA_FIELD)
+};
+
+static const ParamField m_gasFlowFields[EGasFieldCount] =
+{
+   GAS_FLOW_FIELDS(SCHEMA_FIELD)
+};
 
 
 /*********************************************************************************
@@ -64,32 +173,387 @@
 *********************************************************************************/
 /********************************************************************************
  *
- * Name:    GetTagAndValue
+ * Name:    GetPayloadView
+ *
+ * Purpose: Makes a view of a NULL terminated command payload
+ *
+ * Inputs:  pPayload - command payload, may be NULL
+ *          
+ * Outputs: None.
+ *
+ * Returns: View of the payload text.
+ *
+ * Notes:   A missing terminator gives a view that fails CheckPayload.
+ *          Binary payloads can hold NULLs, their length is taken from
+ *          nLength instead.
+ *
+ *******************************************************************************/
+static FrameView GetPayloadView(MsgPayload* pPayload)
+{
+   FrameView view        = { NULL, 0 };
+   const char* pTerminal = NULL;
+
+   if (pPayload != NULL)
+   {
+      view.pData = pPayload->szPayload;
+
+      if (pPayload->nLength < PAYLOAD_LENGTH
+      &&  IsBinaryPayload(pPayload->szPayload, pPayload->nLength))
+      {
+         view.nLength = pPayload->nLength;
+      }
+      else
+      {
+         pTerminal    = memchr(pPayload->szPayload, '\0', PAYLOAD_LENGTH);
+         view.nLength = (pTerminal != NULL) ? (size_t)(pTerminal - view.pData) : PAYLOAD_LENGTH;
+      }
+   }
+
+   return view;
+}
+
+/********************************************************************************
+ *
+ * Name:    CheckPayload
  *
- * Purpose: Retrieve a single tag and value from command payload
+ * Purpose: Checks a payload view before processing
  *
- * Inputs:  pBuffer - reference to command payload buffer
+ * Inputs:  pPayload - view of the command payload
  *          
- * Outputs: szTag    - populated with parameter tag
- *          szValue  - populated with 
+ * Outputs: None.
+ *
+ * Returns: EResponseOk if the payload can be parsed, error code otherwise.
+ *
+ * Notes:   None.
+ *
+ *******************************************************************************/
+static EHandlerResponse CheckPayload(const FrameView* pPayload)
+{
+   EHandlerResponse eResponse = EInputBufferError;
+
+   if (pPayload != NULL && pPayload->pData != NULL)
+   {
+      eResponse = EBuffSizeError;
+
+      if (pPayload->nLength < PAYLOAD_LENGTH)
+      {
+         eResponse = EResponseOk;
+      }
+   }
+
+   return eResponse;
+}
+
+/********************************************************************************
+ *
+ * Name:    BeginParameters
+ *
+ * Purpose: Starts reading the parameters of a payload
+ *
+ * Inputs:  pPayload - view of the command payload
+ *          
+ * Outputs: pReader - positioned at the first parameter
  *
  * Returns: None.
  *
+ * Notes:   The codec is picked from the payload header. ASCII payloads
+ *          are indexed once here, reading a parameter is then a lookup.
+ *
+ *******************************************************************************/
+static void BeginParameters(ParamReader* pReader, const FrameView* pPayload)
+{
+   ECommandCode eCode;
+
+   pReader->remaining = *pPayload;
+   pReader->bBinary   = BinaryReadHeader(&pReader->remaining, &eCode, NULL);
+
+   if (!pReader->bBinary)
+   {
+      // skip the command code
+      BuildFieldIndex(pPayload->pData, pPayload->nLength, &pReader->fields);
+      pReader->nField = 1;
+   }
+}
+
+/********************************************************************************
+ *
+ * Name:    ReadParameter
+ *
+ * Purpose: Reads the next parameter and checks its tag
+ *
+ * Inputs:  pReader - remaining payload, advanced to the next parameter
+ *          pszTag  - expected parameter tag
+ *          
+ * Outputs: pValue - populated with parameter value
+ *
+ * Returns: true if the parameter has the expected tag
+ *
+ * Notes:   None.
+ *
+ *******************************************************************************/
+static bool ReadParameter(ParamReader* pReader, const char* pszTag, FrameView* pValue)
+{
+   FrameView tag;
+   BinaryRecord record;
+   bool bFound = false;
+
+   if (pReader->bBinary)
+   {
+      if (BinaryNextRecord(&pReader->remaining, &record))
+      {
+         *pValue = record.value;
+         bFound  = ViewEquals(&record.name, pszTag);
+      }
+   }
+   else
+   {
+      bFound = FieldIndex_TagAndValue(&pReader->fields, pReader->nField++, &tag, pValue)
+            && ViewEquals(&tag, pszTag);
+   }
+
+   return bFound;
+}
+
+/********************************************************************************
+ *
+ * Name:    ReadNamedParameter
+ *
+ * Purpose: Reads a parameter whose tag is data, e.g. a manufacturer field
+ *
+ * Inputs:  pReader - remaining payload, advanced past the parameter
+ *          
+ * Outputs: pTag   - populated with parameter tag
+ *          pValue - populated with parameter value
+ *
+ * Returns: false if there is no parameter or its tag is empty
+ *
+ * Notes:   An ASCII value runs to the end of the payload, commas included.
+ *
+ *******************************************************************************/
+static bool ReadNamedParameter(ParamReader* pReader, FrameView* pTag, FrameView* pValue)
+{
+   BinaryRecord record;
+
+   if (pReader->bBinary)
+   {
+      // a missing record reads as an empty tag and value
+      pTag->pData     = pReader->remaining.pData;
+      pTag->nLength   = 0;
+      *pValue         = *pTag;
+
+      if (BinaryNextRecord(&pReader->remaining, &record))
+      {
+         *pTag   = record.name;
+         *pValue = record.value;
+      }
+   }
+   else
+   {
+      // value runs to the end of the payload
+      pTag->pData   = pReader->remaining.pData + pReader->remaining.nLength;
+      pTag->nLength = 0;
+      *pValue       = *pTag;
+
+      if (FieldIndex_TagAndValue(&pReader->fields, pReader->nField++, pTag, pValue))
+      {
+         pValue->nLength = (size_t)(pReader->remaining.pData + pReader->remaining.nLength - pValue->pData);
+      }
+   }
+
+   return pTag->nLength > 0;
+}
+
+/********************************************************************************
+ *
+ * Name:    ReadIntParameter
+ *
+ * Purpose: Reads the next parameter as an integer and checks its tag
+ *
+ * Inputs:  pReader - remaining payload, advanced to the next parameter
+ *          pszTag  - expected parameter tag
+ *          
+ * Outputs: pValue - populated with parameter value
+ *
+ * Returns: true if the parameter has the expected tag
+ *
  * Notes:   None.
  *
  *******************************************************************************/
-static void GetTagAndValue(char** pBuffer, char* szTag, char* szValue)
+static bool ReadIntParameter(ParamReader* pReader, const char* pszTag, int* pValue)
 {
-   // tokenize string, split at the equals
-   StrTokenize(*pBuffer, "=");
+   FrameView value;
+   bool bFound = ReadParameter(pReader, pszTag, &value);
 
-   // copy parameter tag from payload
-   strcpy(szTag, *pBuffer);
+   if (bFound)
+   {
+      *pValue = pReader->bBinary ? BinaryValueToInt(&value) : ViewToInt(&value);
+   }
 
-   RestoreDelimiterAndMovePast(&*pBuffer, '=');
+   return bFound;
+}
 
-   // copy value from paylaod
-   strcpy(szValue, *pBuffer);  
+/********************************************************************************
+ *
+ * Name:    NextTaggedParameter
+ *
+ * Purpose: Reads the next parameter, whatever its tag
+ *
+ * Inputs:  pReader - remaining payload, advanced to the next parameter
+ *          
+ * Outputs: peTag  - parameter tag, ETagNone if it isn't a known tag
+ *          pValue - populated with parameter value
+ *
+ * Returns: false once every parameter has been read
+ *
+ * Notes:   Binary records carry the tag id, ASCII tags are looked up.
+ *
+ *******************************************************************************/
+static bool NextTaggedParameter(ParamReader* pReader, EParamTag* peTag, FrameView* pValue)
+{
+   FrameView tag;
+   BinaryRecord record;
+   bool bRead = false;
+
+   if (pReader->bBinary)
+   {
+      bRead = BinaryNextRecord(&pReader->remaining, &record);
+
+      if (bRead)
+      {
+         *pValue = record.value;
+         *peTag  = (record.nTagId < ETagMax) ? (EParamTag)record.nTagId
+                                             : ParamTagLookup(record.name.pData, record.name.nLength);
+      }
+   }
+   else
+   {
+      bRead = FieldIndex_TagAndValue(&pReader->fields, pReader->nField++, &tag, pValue);
+
+      if (bRead)
+      {
+         *peTag = ParamTagLookup(tag.pData, tag.nLength);
+      }
+   }
+
+   return bRead;
+}
+
+/********************************************************************************
+ *
+ * Name:    FindField
+ *
+ * Purpose: Finds the field a tag belongs to
+ *
+ * Inputs:  pFields - fields the command takes
+ *          nFields - number of entries in pFields
+ *          eTag    - parameter tag
+ *          
+ * Outputs: None.
+ *
+ * Returns: Slot of the field, nFields if the command doesn't take the tag
+ *
+ * Notes:   Tables are a handful of fields, a search beats anything clever.
+ *
+ *******************************************************************************/
+static size_t FindField(const ParamField* pFields, size_t nFields, EParamTag eTag)
+{
+   size_t nSlot = 0;
+
+   while (nSlot < nFields && pFields[nSlot].eTag != eTag)
+   {
+      nSlot++;
+   }
+
+   return nSlot;
+}
+
+/********************************************************************************
+ *
+ * Name:    DecodeParameters
+ *
+ * Purpose: Reads TAG=value parameters in any order into a field set
+ *
+ * Inputs:  pPayload - view of the command payload
+ *          pFields  - fields the command takes
+ *          nFields  - number of entries in pFields
+ *          
+ * Outputs: pValues - values of the fields received, with presence bits
+ *
+ * Returns: EResponseOk, or EInvalidParameters if a value is out of range,
+ *          a field is repeated or a required field is missing
+ *
+ * Notes:   Tags the command doesn't take are skipped, so a sender may add
+ *          fields a receiver doesn't know yet. ASCII numbers must be all
+ *          digits, "12x" is rejected instead of read as 12.
+ *
+ *******************************************************************************/
+static EHandlerResponse DecodeParameters(const FrameView* pPayload,
+                                         const ParamField* pFields,
+                                         size_t nFields,
+                                         ParamValues* pValues)
+{
+   EHandlerResponse eResponse = EResponseOk;
+   ParamReader reader;
+   FrameView value;
+   EParamTag eTag             = ETagNone;
+   uint32_t nBit              = 0;
+   size_t nSlot               = 0;
+   int nValue                 = 0;
+
+   pValues->nPresent = 0;
+   BeginParameters(&reader, pPayload);
+
+   while (eResponse == EResponseOk && NextTaggedParameter(&reader, &eTag, &value))
+   {
+      nSlot = FindField(pFields, nFields, eTag);
+
+      // not a field of this command
+      if (nSlot == nFields)
+      {
+         continue;
+      }
+
+      nBit = (uint32_t)1 << nSlot;
+
+      if (pFields[nSlot].eType == EParamText)
+      {
+         nValue = (value.nLength <= INT_MAX) ? (int)value.nLength : INT_MAX;
+         pValues->text[nSlot] = value;
+      }
+      else if (reader.bBinary)
+      {
+         nValue = BinaryValueToInt(&value);
+
+         if (value.nLength == 0 || value.nLength > BINARY_INT_BYTES)
+         {
+            eResponse = EInvalidParameters;
+         }
+      }
+      else if (!ViewParseInt(&value, &nValue))
+      {
+         eResponse = EInvalidParameters;
+      }
+
+      if ((pValues->nPresent & nBit) != 0
+      ||  nValue < pFields[nSlot].nMin
+      ||  nValue > pFields[nSlot].nMax)
+      {
+         eResponse = EInvalidParameters;
+      }
+
+      pValues->nValue[nSlot] = nValue;
+      pValues->nPresent     |= nBit;
+   }
+
+   for (nSlot = 0; eResponse == EResponseOk && nSlot < nFields; nSlot++)
+   {
+      if (pFields[nSlot].bRequired && (pValues->nPresent & ((uint32_t)1 << nSlot)) == 0)
+      {
+         eResponse = EInvalidParameters;
+      }
+   }
+
+   return eResponse;
 }
 
 /********************************************************************************
@@ -121,60 +585,171 @@ static EHandlerResponse HandleNoParameterCommand(FnHandleNoParameterCommand fpHa
 
 /********************************************************************************
  *
- * Name:    HandleNoParameterCommand
+ * Name:    HandleToggleCommand
  *
- * Purpose: Handles execution of commands without parameters
+ * Purpose: Handles execution of commands with a single on/off parameter
  *
- * Inputs:  fpHandle - command handler with no parameters
+ * Inputs:  pPayload  - view of the command payload
+ *          eTag      - parameter tag
+ *          fpHandler - command handler
  *
  * Outputs: None.
  *
  * Returns: EResponseOk if successful, error code otherwise.
  *
- * Notes:   None
+ * Notes:   Only 0 and 1 are accepted.
  *
  *******************************************************************************/
-static EHandlerResponse HandleToggleCommand(MsgPayload* pPayload, 
-                                            char* pszTag, 
+static EHandlerResponse HandleToggleCommand(const FrameView* pPayload, 
+                                            EParamTag eTag, 
                                             FnHandleSetBoolCommand fpHandler)
 {
-   EHandlerResponse eResponse = EInputBufferError;
-   char* pReader              = NULL;
-   char* pEnd                 = NULL;
-   char szTag[TMP_STR_SIZE]   = { 0 };
-   char szValue[TMP_STR_SIZE] = { 0 };
-   bool bEnabled              = 0;
+   EHandlerResponse eResponse = CheckPayload(pPayload);
+   ParamField field           = { eTag, EParamInt, 0, 1, true };
+   ParamValues values;
 
-   if (pPayload != NULL)
+   if (eResponse == EResponseOk)
    {
-      pReader = pPayload->szPayload;
-      eResponse = EBuffSizeError;
+      eResponse = DecodeParameters(pPayload, &field, 1, &values);
+   }
+
+   if (eResponse == EResponseOk)
+   {
+      eResponse = EOpNotAllowed;
 
-      if (strlen(pPayload->szPayload) <= PAYLOAD_LENGTH)
+      if (fpHandler)
       {
-         eResponse = EInvalidParameters;
-        
-         StrTokenize(pReader, ",");
-         RestoreDelimiterAndMovePast(&pReader, ',');
+         eResponse = fpHandler(values.nValue[0] != 0);
+      }
+   }
 
-         // grab tag and value from payload
-         GetTagAndValue(&pReader, szTag, szValue);
+   return eResponse;
+}
 
-         // if parameter tag is for scavenger enable
-         if(strcmp(pszTag, szTag) == 0)
-         {
-            if (fpHandler)
-            {
-               bEnabled = (bool)strtol(szValue, &pEnd, 10);
-               eResponse = fpHandler(bEnabled);
-            }
-         }
+/********************************************************************************
+ *
+ * Name:    HandleIntCommand
+ *
+ * Purpose: Handles execution of commands with a single integer parameter
+ *
+ * Inputs:  pPayload  - view of the command payload
+ *          eTag      - parameter tag
+ *          nMin      - lowest value accepted
+ *          nMax      - highest value accepted
+ *          fpHandler - command handler
+ *
+ * Outputs: None.
+ *
+ * Returns: EResponseOk if successful, error code otherwise.
+ *
+ * Notes:   None
+ *
+ *******************************************************************************/
+static EHandlerResponse HandleIntCommand(const FrameView* pPayload, 
+                                         EParamTag eTag, 
+                                         int nMin,
+                                         int nMax,
+                                         FnHandleSetIntValueCommand fpHandler)
+{
+   EHandlerResponse eResponse = CheckPayload(pPayload);
+   ParamField field           = { eTag, EParamInt, nMin, nMax, true };
+   ParamValues values;
+
+   if (eResponse == EResponseOk)
+   {
+      eResponse = DecodeParameters(pPayload, &field, 1, &values);
+   }
+
+   if (eResponse == EResponseOk)
+   {
+      eResponse = EOpNotAllowed;
+
+      if (fpHandler)
+      {
+         eResponse = fpHandler(values.nValue[0]);
       }
    }
 
    return eResponse;
 }
 
+/********************************************************************************
+ *
+ * Name:    HandleSchemaCommand
+ *
+ * Purpose: Parses and runs a command whose response echoes the command
+ *
+ * Inputs:  eCode    - command code
+ *          pPayload - view of the command payload
+ *
+ * Outputs: None.
+ *
+ * Returns: EResponseOk if successful, error code otherwise.
+ *
+ * Notes:   The cases are expanded from the NONE, SET_BOOL, SET_INT and
+ *          VIEW rows of COMMAND_SCHEMA. Other codes give EOpNotAllowed.
+ *
+ *******************************************************************************/
+LIB_API
+EHandlerResponse HandleSchemaCommand(ECommandCode eCode, const FrameView* pPayload)
+{
+   const CommandHandlers* pHandlers = AcquireCommandHandlers();
+   EHandlerResponse eResponse = EOpNotAllowed;
+
+   switch (eCode)
+   {
+      COMMAND_SCHEMA(SCHEMA_HANDLE)
+
+      default:
+         break;
+   }
+
+   ReleaseCommandHandlers(pHandlers);
+
+   return eResponse;
+}
+
+/********************************************************************************
+ *
+ * Name:    GetSchemaValue
+ *
+ * Purpose: Runs a command that returns a single integer
+ *
+ * Inputs:  eCode - command code
+ *
+ * Outputs: pValue - value from the command handler
+ *
+ * Returns: EResponseOk if successful, error code otherwise.
+ *
+ * Notes:   The cases are expanded from the GET_INT rows of COMMAND_SCHEMA.
+ *          Other codes give EOpNotAllowed.
+ *
+ *******************************************************************************/
+LIB_API
+EHandlerResponse GetSchemaValue(ECommandCode eCode, int* pValue)
+{
+   const CommandHandlers* pHandlers = AcquireCommandHandlers();
+   EHandlerResponse eResponse           = EOpNotAllowed;
+   FnHandleGetIntValueCommand fpHandler = NULL;
+
+   switch (eCode)
+   {
+      COMMAND_SCHEMA(SCHEMA_GET)
+
+      default:
+         break;
+   }
+
+   if (fpHandler)
+   {
+      eResponse = fpHandler(pValue);
+   }
+
+   ReleaseCommandHandlers(pHandlers);
+
+   return eResponse;
+}
+
 /********************************************************************************
  *
  * Name:    GetLogList
@@ -231,41 +806,28 @@ EHandlerResponse GetLogList(FnHandleGetLogList fpHandle,
  * Notes:   None.
  *
  *******************************************************************************/
-EHandlerResponse GetLogEntry(MsgPayload* pPayload, 
+EHandlerResponse GetLogEntry(const FrameView* pPayload, 
                              FnHandleGetLogEntry fpHandle, 
                              LogDetails* pDetails)
 {
-   EHandlerResponse eResponse    = EInputBufferError;
-   char* pReader                 = NULL;
-   char* pEnd                    = NULL;
-   char szTag[TMP_BUFF_SIZE] = { 0 };
-   char szValue[TMP_BUFF_SIZE] = { 0 };
-   size_t nIndex                 = 0;
+   EHandlerResponse eResponse    = CheckPayload(pPayload);
+   ParamReader reader;
+   int nIndex                    = 0;
 
-   if (pPayload != NULL)
+   if (eResponse == EResponseOk)
    {
-      pReader = pPayload->szPayload;
-      eResponse = EBuffSizeError;
+      eResponse = EInvalidParameters;
+      // skip the command code
+      BeginParameters(&reader, pPayload);
 
-      if (strlen(pPayload->szPayload) < PAYLOAD_LENGTH)
+      // if the tag is log entry index
+      if (ReadIntParameter(&reader, TAG_LOG_IDX, &nIndex))
       {
-         eResponse = EInvalidParameters;
-
-         // retrieve the tag and value from the payload
-         GetTagAndValue(&pReader, szTag, szValue);
-
-         // if the tag is log entry index
-         if(strcmp(szTag, TAG_LOG_IDX) == 0)
+         // check command handler
+         if(fpHandle)
          {
-            // check command handler
-           
-            if(fpHandle)
-            {
-               nIndex = strtol(szValue, &pEnd, 10);
-
-               // call command handler with index read from payload
-               //eResponse = fpHandle(nIndex, pDetails);
-            }
+            // call command handler with index read from payload
+            //eResponse = fpHandle(nIndex, pDetails);
          }
       }
    }
@@ -294,7 +856,7 @@ EHandlerResponse GetLogEntry(MsgPayload* pPayload,
  *******************************************************************************/
 EHandlerResponse IncreaseVacuumFlow()
 {
-   return HandleNoParameterCommand(m_pHandlers.fpHandleIncreaseVacuumFlow);
+   return HandleSchemaCommand(EVacuumIncrease, NULL);
 }
 
 /********************************************************************************
@@ -315,7 +877,7 @@ EHandlerResponse IncreaseVacuumFlow()
  *******************************************************************************/
 EHandlerResponse DecreaseVacuumFlow()
 {
-   return HandleNoParameterCommand(m_pHandlers.fpHandleDecreaseVacuumFlow);
+   return HandleSchemaCommand(EVacuumDecrease, NULL);
 }
 
 /********************************************************************************
@@ -335,26 +897,17 @@ EHandlerResponse DecreaseVacuumFlow()
  *******************************************************************************/
 EHandlerResponse GetProcedureLogCount(int* pCount)
 {
-   EHandlerResponse eResponse = EOpNotAllowed;
-
-   if (m_pHandlers.fpHandleGetProcedureLogCount)
-   {
-      eResponse = m_pHandlers.fpHandleGetProcedureLogCount(pCount);
-   }
-
-   return eResponse;
+   return GetSchemaValue(EGetProcedureLogCount, pCount);
 }
 
 /********************************************************************************
  *
- * Name:    GetProcedureLogList
+ * Name:    GetProcedureLogListView
  *
  * Purpose: Returns a list of all procedure logs available on the TSF
  *			   controller
  *
- * Inputs:  nIndex   - procedure log ID
- *          nOffset  - starting log to load
- *          nCount   - the number of logs to load begining at nOffset
+ * Inputs:  pPayload - view of the command payload
  *
  * Outputs: pEntries - array of log entries
  *
@@ -363,67 +916,111 @@ EHandlerResponse GetProcedureLogCount(int* pCount)
  * Notes:   EHandlerResponse EResponseOk if successful, error code otherwise
  *
  *******************************************************************************/
-EHandlerResponse GetProcedureLogList(MsgPayload* pPayload, ProcedureLog* pEntries, int* pCount)
+EHandlerResponse GetProcedureLogListView(const FrameView* pPayload, ProcedureLog* pEntries, int* pCount)
 {
-   EHandlerResponse eResponse = EInputBufferError;
-   char* pReader = pPayload->szPayload;
-   char* pEnd    = NULL;
-   char szTag[TMP_BUFF_SIZE] = { 0 };
-   char szValue[TMP_BUFF_SIZE] = { 0 };
-   int nOffset = 0;
-   int nCount  = 0;
+   const CommandHandlers* pHandlers = AcquireCommandHandlers();
+   EHandlerResponse eResponse = CheckPayload(pPayload);
+   ParamValues values;
 
-   if(pPayload != NULL && pEntries != NULL)
+   if (eResponse == EResponseOk && pEntries == NULL)
    {
-      eResponse = EInvalidParameters;
+      eResponse = EInputBufferError;
+   }
 
-      // skip over the command code
-      StrTokenize(pReader, ",");
-      RestoreDelimiterAndMovePast(&pReader, ',');
+   if (eResponse == EResponseOk)
+   {
+      eResponse = DecodeParameters(pPayload, m_logListFields, ELogListFieldCount, &values);
+   }
 
-      // split first parameter on equals
-      StrTokenize(pReader, "=");
+   if (eResponse == EResponseOk)
+   {
+      eResponse = EOpNotAllowed;
 
-      // read tag
-      strcpy(szTag, pReader);
+      if (pHandlers->fpHandleGetProcedureList)
+      {
+         eResponse = pHandlers->fpHandleGetProcedureList(values.nValue[ELogListOffset],
+                                                          values.nValue[ELogListCount],
+                                                          pEntries,
+                                                          pCount);
+      }
+   }
 
-      // restore and move past the equals
-      RestoreDelimiterAndMovePast(&pReader, '=');
+   ReleaseCommandHandlers(pHandlers);
 
-      // split on comma to get next parameter
-      StrTokenize(pReader, ",");
-      strcpy(szValue, pReader);
-      RestoreDelimiterAndMovePast(&pReader, ',');
+   return eResponse;
+}
 
-      // if tag offset
-      if(strcmp(szTag, TAG_OFFSET) == 0)
-      {
-         // grab offset value
-         nOffset = strtol(szValue, &pEnd, 10);
+/********************************************************************************
+ *
+ * Name:    GetProcedureLogList
+ *
+ * Purpose: Runs GetProcedureLogListView on a NULL terminated payload.
+ *
+ * Inputs:  pPayload - command payload
+ *
+ * Outputs: See GetProcedureLogListView
+ *
+ * Returns: EResponseOk if successful, error code otherwise
+ *
+ * Notes:   None
+ *
+ *******************************************************************************/
+EHandlerResponse GetProcedureLogList(MsgPayload* pPayload, ProcedureLog* pEntries, int* pCount)
+{
+   FrameView view = GetPayloadView(pPayload);
+
+   return GetProcedureLogListView(&view, pEntries, pCount);
+}
 
-         // clear temp buffers
-         memset(szTag, 0, TMP_BUFF_SIZE);
-         memset(szValue, 0, TMP_BUFF_SIZE);
+/********************************************************************************
+ *
+ * Name:    GetProcedureLogEntryListView
+ *
+ * Purpose: Returns a list of all procedure logs entries available on the TSF
+ *			   controller for a given procedure log
+ *
+ * Inputs:  pPayload - view of the command payload
+ *
+ * Outputs: pEntries - array of log entries
+ *
+ * Returns: None.
+ *
+ * Notes:   EHandlerResponse EResponseOk if successful, error code otherwise
+ *
+ *******************************************************************************/
+LIB_API
+EHandlerResponse GetProcedureLogEntryListView(const FrameView* pPayload, LogEntry* pEntries, int* pCount)
+{
+   const CommandHandlers* pHandlers = AcquireCommandHandlers();
+   EHandlerResponse eResponse = CheckPayload(pPayload);
+   ParamValues values;
 
-         // Tokenize string
-         StrTokenize(pReader, "=");
-         strcpy(szTag, pReader);
-         RestoreDelimiterAndMovePast(&pReader, '=');
-         strcpy(szValue, pReader);
+   if (eResponse == EResponseOk && (pEntries == NULL || pCount == NULL))
+   {
+      eResponse = EInputBufferError;
+   }
 
-         if(strcmp(szTag, TAG_COUNT) == 0)
-         {
-            nCount = strtol(szValue, &pEnd, 10);
-            eResponse = EOpNotAllowed;
+   if (eResponse == EResponseOk)
+   {
+      eResponse = DecodeParameters(pPayload, m_logEntryListFields, ELogListFieldCount, &values);
+   }
 
-            if (m_pHandlers.fpHandleGetProcedureList)
-            {
-               eResponse = m_pHandlers.fpHandleGetProcedureList(nOffset, nCount, pEntries, pCount);
-            }
-         }
+   if (eResponse == EResponseOk)
+   {
+      eResponse = EOpNotAllowed;
+
+      if (pHandlers->fpHandleGetProcedureEntryList)
+      {
+         eResponse = pHandlers->fpHandleGetProcedureEntryList(values.nValue[ELogListIndex],
+                                                               values.nValue[ELogListOffset],
+                                                               values.nValue[ELogListCount],
+                                                               pEntries,
+                                                               pCount);
       }
    }
 
+   ReleaseCommandHandlers(pHandlers);
+
    return eResponse;
 }
 
@@ -431,102 +1028,45 @@ EHandlerResponse GetProcedureLogList(MsgPayload* pPayload, ProcedureLog* pEntrie
  *
  * Name:    GetProcedureLogEntryList
  *
- * Purpose: Returns a list of all procedure logs entries available on the TSF
- *			   controller for a given procedure log
+ * Purpose: Runs GetProcedureLogEntryListView on a NULL terminated payload.
  *
- * Inputs:  nIndex   - procedure log ID
- *          nOffset  - starting log to load
- *          nCount   - the number of logs to load begining at nOffset
+ * Inputs:  pPayload - command payload
  *
- * Outputs: pEntries - array of log entries
+ * Outputs: See GetProcedureLogEntryListView
+ *
+ * Returns: EResponseOk if successful, error code otherwise
+ *
+ * Notes:   None
+ *
+ *******************************************************************************/
+EHandlerResponse GetProcedureLogEntryList(MsgPayload* pPayload, LogEntry* pEntries, int* pCount)
+{
+   FrameView view = GetPayloadView(pPayload);
+
+   return GetProcedureLogEntryListView(&view, pEntries, pCount);
+}
+
+/********************************************************************************
+ *
+ * Name:    GetProcedureLogEntryView
+ *
+ * Purpose: Returns details of a procedure log entry
+ *
+ * Inputs:  pPayload - view of the command payload
+ *
+ * Outputs: pDetails - populated with procedure log info
  *
  * Returns: None.
  *
  * Notes:   EHandlerResponse EResponseOk if successful, error code otherwise
  *
  *******************************************************************************/
-LIB_API
-EHandlerResponse GetProcedureLogEntryList(MsgPayload* pPayload, LogEntry* pEntries, int* pCount)
+EHandlerResponse GetProcedureLogEntryView(const FrameView* pPayload, LogDetails* pDetails)
 {
-   EHandlerResponse eResponse = EInputBufferError;
-   char* pReader = pPayload->szPayload;
-   char* pEnd    = NULL;
-   char szTag[TMP_BUFF_SIZE]     = { 0 };
-   char szValue[TMP_BUFF_SIZE]   = { 0 };
-   int nIndex  = 0;
-   int nOffset = 0;
-   int nCount  = 0;
-
-   if (pPayload != NULL && pEntries != NULL && pCount)
-   {
-      eResponse = EInvalidParameters;
-
-      // skip over the command code
-      StrTokenize(pReader, ",");
-      RestoreDelimiterAndMovePast(&pReader, ',');
-
-      // split first parameter on equals
-      // copy index tag
-      StrTokenize(pReader, "=");
-      strcpy(szTag, pReader);
-      RestoreDelimiterAndMovePast(&pReader, '=');
-
-      // copy index value
-      StrTokenize(pReader, ",");
-      strcpy(szValue, pReader);
-      RestoreDelimiterAndMovePast(&pReader, ',');
-
-      if(strcmp(szTag, TAG_INDEX) == 0)
-      {
-         // convert index value
-         nIndex = strtol(szValue, &pEnd, 10);
-
-         // clear buffers for next tag, value pair
-         memset(szTag, 0, TMP_BUFF_SIZE);
-         memset(szValue, 0, TMP_BUFF_SIZE);
-        
-
-         // copy the offset tag
-         StrTokenize(pReader, "=");
-         strcpy(szTag, pReader);
-         RestoreDelimiterAndMovePast(&pReader, '=');
-
-         // copy offset value
-         StrTokenize(pReader, ",");
-         strcpy(szValue, pReader);
-         RestoreDelimiterAndMovePast(&pReader, ',');
-
-         if(strcmp(szTag, TAG_OFFSET) == 0)
-         {
-            // convert count value
-            nOffset = strtol(szValue, &pEnd, 10);
-
-            // clear buffers for next tag, value pair
-            memset(szTag, 0, TMP_BUFF_SIZE);
-            memset(szValue, 0, TMP_BUFF_SIZE);
-
-            // copy count tag
-            StrTokenize(pReader, "=");
-            strcpy(szTag, pReader);
-            RestoreDelimiterAndMovePast(&pReader, '=');
-
-            // copy the count value
-            strcpy(szValue, pReader);
+   const CommandHandlers* pHandlers = AcquireCommandHandlers();
+   EHandlerResponse eResponse       = GetLogEntry(pPayload, pHandlers->fpHandleGetProcedureEntryList, pDetails);
 
-            if(strcmp(szTag, TAG_COUNT) == 0)
-            {
-               nCount = strtol(szValue, &pEnd, 10);
-
-               eResponse = EOpNotAllowed;
-
-               if (m_pHandlers.fpHandleGetProcedureEntryList)
-               {
-                  eResponse = m_pHandlers.fpHandleGetProcedureEntryList(nIndex, nOffset, nCount, pEntries, pCount);
-               }
-            }
-         }
-      }
-   }
+   ReleaseCommandHandlers(pHandlers);
 
    return eResponse;
 }
@@ -535,56 +1075,22 @@ EHandlerResponse GetProcedureLogEntryList(MsgPayload* pPayload, LogEntry* pEntri
  *
  * Name:    GetProcedureLogEntry
  *
- * Purpose: Returns details of a procedure log entry
+ * Purpose: Runs GetProcedureLogEntryView on a NULL terminated payload.
  *
- * Inputs:  m_cmdBuffer - command payload
- *          cmdBufferSize - size of payload buffer
+ * Inputs:  pPayload - command payload
  *
- * Outputs: pDetails - populated with procedure log info
+ * Outputs: See GetProcedureLogEntryView
  *
- * Returns: None.
+ * Returns: EResponseOk if successful, error code otherwise
  *
- * Notes:   EHandlerResponse EResponseOk if successful, error code otherwise
+ * Notes:   None
  *
  *******************************************************************************/
 EHandlerResponse GetProcedureLogEntry(MsgPayload* pPayload, LogDetails* pDetails)
 {
-   EHandlerResponse eResponse    = EInputBufferError;
-   char* pReader                 = NULL;
-   char* pEnd                    = NULL;
-   char szTag[TMP_BUFF_SIZE]     = {0};
-   char szValue[TMP_BUFF_SIZE]   = {0};
-   size_t nIndex                 = 0;
-
-   if(pPayload != NULL)
-   {
-      pReader = pPayload->szPayload;
-      eResponse = EBuffSizeError;
-
-      if (strlen(pPayload->szPayload) < PAYLOAD_LENGTH)
-      {
-         eResponse = EInvalidParameters;
-
-         // retrieve the tag and value from the payload
-         GetTagAndValue(&pReader, szTag, szValue);
-
-         // if the tag is log entry index
-         if (strcmp(szTag, TAG_LOG_IDX) == 0)
-         {
-            // check command handler
-           
-            if(m_pHandlers.fpHandleGetProcedureEntryList)
-            {
-               nIndex = strtol(szValue, &pEnd, 10);
-
-               // call command handler with index read from payload
-               //eResponse = m_pHandlers.fpHandleGetProcedureEntryList(nIndex, pDetails);
-            }
-         }
-      }
-   }
+   FrameView view = GetPayloadView(pPayload);
 
-   return eResponse;
+   return GetProcedureLogEntryView(&view, pDetails);
 }
 
 /********************************************************************************
@@ -608,17 +1114,16 @@ LIB_API
 EHandlerResponse GetAlarmLogList(int nIndex, int nOffset, LogEntry* pEntries, size_t nCount)
 {
    return EOpNotAllowed;
-   //return GetLogList(m_pHandlers.fpHandleGetAlarmLogList, nIndex, nOffset, nCount, pEntries);
+   //return GetLogList(AcquireCommandHandlers()->fpHandleGetAlarmLogList, nIndex, nOffset, nCount, pEntries);
 }
 
 /********************************************************************************
  *
- * Name:    GetSystemLogEntry
+ * Name:    GetAlarmLogEntryView
  *
- * Purpose: Returns the value for a single system log entry
+ * Purpose: Returns the value for a single alarm log entry
  *
- * Inputs:  m_cmdBuffer - command payload buffer
- *          cmdBufferSize - payload buffer size
+ * Inputs:  pPayload - view of the command payload
  *          
  * Outputs: pDetails - populated with log entry details
  *
@@ -628,19 +1133,45 @@ EHandlerResponse GetAlarmLogList(int nIndex, int nOffset, LogEntry* pEntries, si
  *
  *******************************************************************************/
 LIB_API
+EHandlerResponse GetAlarmLogEntryView(const FrameView* pPayload, LogDetails* pDetails)
+{
+   const CommandHandlers* pHandlers = AcquireCommandHandlers();
+   EHandlerResponse eResponse       = GetLogEntry(pPayload, pHandlers->fpHandleGetAlarmLogEntry, pDetails);
+
+   ReleaseCommandHandlers(pHandlers);
+
+   return eResponse;
+}
+
+/********************************************************************************
+ *
+ * Name:    GetAlarmLogEntry
+ *
+ * Purpose: Runs GetAlarmLogEntryView on a NULL terminated payload.
+ *
+ * Inputs:  pPayload - command payload
+ *
+ * Outputs: See GetAlarmLogEntryView
+ *
+ * Returns: EResponseOk if successful, error code otherwise
+ *
+ * Notes:   None
+ *
+ *******************************************************************************/
 EHandlerResponse GetAlarmLogEntry(MsgPayload* pPayload, LogDetails* pDetails)
 {
-   return GetLogEntry(pPayload, m_pHandlers.fpHandleGetAlarmLogEntry, pDetails);
+   FrameView view = GetPayloadView(pPayload);
+
+   return GetAlarmLogEntryView(&view, pDetails);
 }
 /********************************************************************************
  *
- * Name:    WriteManufacturerField
+ * Name:    WriteManufacturerFieldView
  *
  * Purpose: Writes a configuration value into flash memory into a
  *          specific location addressed by field name
  *
- * Inputs:  m_cmdBuffer      - command payload
- *          cmdBufferSize  - payload buffer size.
+ * Inputs:  pPayload - view of the command payload
  *
  * Outputs: None
  *
@@ -649,125 +1180,191 @@ EHandlerResponse GetAlarmLogEntry(MsgPayload* pPayload, LogDetails* pDetails)
  * Notes:   TODO: Check max field size. Will the string fit?
  *
  *******************************************************************************/
-EHandlerResponse WriteManufacturerField(MsgPayload* pPayload)
+EHandlerResponse WriteManufacturerFieldView(const FrameView* pPayload)
 {
-   EHandlerResponse eResponse       = EInputBufferError;
-   char* pTokenizer                 = NULL;
-   char* pReader                    = NULL;
+   const CommandHandlers* pHandlers = AcquireCommandHandlers();
+   EHandlerResponse eResponse       = CheckPayload(pPayload);
+   ParamReader reader;
+   FrameView field;
+   FrameView value;
    char  szFieldName[TMP_STR_SIZE]  = { 0 };
    char  szFieldValue[TMP_STR_SIZE] = { 0 };
 
    // check input buffer and data size before processing
-   if(pPayload != NULL)
+   if (eResponse == EResponseOk)
    {
-      pReader = pPayload->szPayload;
-      eResponse = EBuffSizeError;
+      eResponse = EInvalidParameters;
+      // skip the command code
+      BeginParameters(&reader, pPayload);
 
-      if (strlen(pPayload->szPayload) < PAYLOAD_LENGTH)
+      // field name is the tag, value is the rest of the payload
+      if (ReadNamedParameter(&reader, &field, &value))
       {
-         eResponse = EInvalidParameters;
-
-         // split at the comma
-         StrTokenize(pReader, ",");
-
-         // skip the command code
-         RestoreDelimiterAndMovePast(&pReader, ',');
-
-         // split at the equals
-         StrTokenize(pReader, "=");
-    
-         // grab field name
-         strcpy(szFieldName, pReader);
-
-         RestoreDelimiterAndMovePast(&pReader, '=');
+         // handler takes NULL terminated strings
+         ViewToString(&field, szFieldName, sizeof(szFieldName));
+         ViewToString(&value, szFieldValue, sizeof(szFieldValue));
 
-         // grab field value
-         strcpy(szFieldValue, pReader);
+         eResponse = EOpNotAllowed;
 
          // call command handler if it exists
-         if(m_pHandlers.fpHandleWriteManufacturerField != NULL)
-         {
-            eResponse = m_pHandlers.fpHandleWriteManufacturerField(szFieldName, szFieldValue);
-         }
-         else
+         if(pHandlers->fpHandleWriteManufacturerField != NULL)
          {
-            eResponse = EOpNotAllowed;
+            eResponse = pHandlers->fpHandleWriteManufacturerField(szFieldName, szFieldValue);
          }
       }
    }
 
+   ReleaseCommandHandlers(pHandlers);
+
    return eResponse;
 }
 
 /********************************************************************************
  *
- * Name:    ReadManufacturerField
+ * Name:    WriteManufacturerField
  *
- * Purpose: Reads a configuration value from  flash memory
+ * Purpose: Runs WriteManufacturerFieldView on a NULL terminated payload.
  *
- * Inputs:  m_cmdBuffer      - command payload
- *          cmdBufferSize  - length payload buffer
+ * Inputs:  pPayload - command payload
  *
- * Outputs: pRead - contains field read from flash.
+ * Outputs: See WriteManufacturerFieldView
  *
- * Returns: EHandlerResponse EResponseOk if successful, error code otherwise
+ * Returns: EResponseOk if successful, error code otherwise
  *
- * Notes:   None.
+ * Notes:   None
  *
  *******************************************************************************/
-EHandlerResponse ReadManufacturerField(MsgPayload* pPayload, char* pField)
+EHandlerResponse WriteManufacturerField(MsgPayload* pPayload)
 {
-   EHandlerResponse eResponse = EInputBufferError;
+   FrameView view = GetPayloadView(pPayload);
 
-   // store starting address for length comparison
-   char* pReader = NULL;
-   char  szFieldName[TMP_STR_SIZE] = { 0 };
-   char  szFieldValue[TMP_STR_SIZE] = { 0 };
-
-   if(pPayload != NULL)
-   {
-      pReader = pPayload->szPayload;
-      if (strlen(pPayload->szPayload) < PAYLOAD_LENGTH)
-      {
-         eResponse = EInvalidParameters;
-
-         // tokenize, split at the ,
-         StrTokenize(pReader, ",");
-
-         // skip the command code
-         // advance pointer to the inserted NULL
-         RestoreDelimiterAndMovePast(&pReader, ',');
-      
-         // split at the =
-         StrTokenize(pReader, "=");
+   return WriteManufacturerFieldView(&view);
+}
 
-         // verify tag
-         strcpy(szFieldName, pReader);
+/********************************************************************************
+ *
+ * Name:    ReadManufacturerFieldToken
+ *
+ * Purpose: Reads a configuration value from flash memory
+ *
+ * Inputs:  pPayload - view of the command payload
+ *          token    - token for the async handler, COMMAND_TOKEN_NONE to
+ *                     call the handler that answers at once
+ *
+ * Outputs: pField - contains field read from flash, not written by the
+ *                   async handler
+ *
+ * Returns: EHandlerResponse EResponseOk if successful, EPending from the
+ *          async handler, error code otherwise
+ *
+ * Notes:   None.
+ *
+ *******************************************************************************/
+static EHandlerResponse ReadManufacturerFieldToken(const FrameView* pPayload, char* pField, CommandToken token)
+{
+   const CommandHandlers* pHandlers = AcquireCommandHandlers();
+   EHandlerResponse eResponse       = CheckPayload(pPayload);
+   ParamReader reader;
+   FrameView value;
+   char  szFieldName[TMP_STR_SIZE]  = { 0 };
 
-         RestoreDelimiterAndMovePast(&pReader, '=');
+   if (eResponse == EResponseOk)
+   {
+      eResponse = EInvalidParameters;
+      // skip the command code
+      BeginParameters(&reader, pPayload);
 
-         // grab field name
-         strcpy(szFieldValue, pReader);
+      // if parameter is the field name
+      if (ReadParameter(&reader, TAG_MF_FIELD, &value))
+      {
+         eResponse = EOpNotAllowed;
+         ViewToString(&value, szFieldName, sizeof(szFieldName));
 
-         // if parameter is the field name
-         if(strcmp(szFieldName, TAG_MF_FIELD) == 0)
+         // call the command handler
+         if (token != COMMAND_TOKEN_NONE)
          {
-            // call the command handler
-            if(m_pHandlers.fpHandleReadManufacturerField != NULL)
-            {
-               eResponse = m_pHandlers.fpHandleReadManufacturerField(szFieldValue, pField);
-            }
-            else
+            if (pHandlers->fpHandleReadManufacturerFieldAsync != NULL)
             {
-               eResponse = EOpNotAllowed;
+               eResponse = pHandlers->fpHandleReadManufacturerFieldAsync(szFieldName, token);
             }
          }
+         else if(pHandlers->fpHandleReadManufacturerField != NULL)
+         {
+            eResponse = pHandlers->fpHandleReadManufacturerField(szFieldName, pField);
+         }
       }
    }
 
+   ReleaseCommandHandlers(pHandlers);
+
    return eResponse;
 }
 
+/********************************************************************************
+ *
+ * Name:    ReadManufacturerFieldView
+ *
+ * Purpose: Reads a configuration value from  flash memory
+ *
+ * Inputs:  pPayload - view of the command payload
+ *
+ * Outputs: pRead - contains field read from flash.
+ *
+ * Returns: EHandlerResponse EResponseOk if successful, error code otherwise
+ *
+ * Notes:   None.
+ *
+ *******************************************************************************/
+EHandlerResponse ReadManufacturerFieldView(const FrameView* pPayload, char* pField)
+{
+   return ReadManufacturerFieldToken(pPayload, pField, COMMAND_TOKEN_NONE);
+}
+
+/********************************************************************************
+ *
+ * Name:    ReadManufacturerFieldAsyncView
+ *
+ * Purpose: Runs ReadManufacturerFieldView with the async handler.
+ *
+ * Inputs:  pPayload - view of the command payload
+ *          token    - token from BeginPendingCommand
+ *
+ * Outputs: None
+ *
+ * Returns: EPending if the handler answers with
+ *          CompleteReadManufacturerField, else as ReadManufacturerFieldView
+ *
+ * Notes:   The field value only comes back through
+ *          CompleteReadManufacturerField.
+ *
+ *******************************************************************************/
+EHandlerResponse ReadManufacturerFieldAsyncView(const FrameView* pPayload, CommandToken token)
+{
+   return ReadManufacturerFieldToken(pPayload, NULL, token);
+}
+
+/********************************************************************************
+ *
+ * Name:    ReadManufacturerField
+ *
+ * Purpose: Runs ReadManufacturerFieldView on a NULL terminated payload.
+ *
+ * Inputs:  pPayload - command payload
+ *
+ * Outputs: See ReadManufacturerFieldView
+ *
+ * Returns: EResponseOk if successful, error code otherwise
+ *
+ * Notes:   None
+ *
+ *******************************************************************************/
+EHandlerResponse ReadManufacturerField(MsgPayload* pPayload, char* pField)
+{
+   FrameView view = GetPayloadView(pPayload);
+
+   return ReadManufacturerFieldView(&view, pField);
+}
+
 /********************************************************************************
  *
  * Name:    RestoreDefaultSettings
@@ -786,7 +1383,7 @@ EHandlerResponse ReadManufacturerField(MsgPayload* pPayload, char* pField)
  *******************************************************************************/
 EHandlerResponse RestoreDefaultSettings()
 {
-   return HandleNoParameterCommand(m_pHandlers.fpHandleRestoreDefaultSettings);
+   return HandleSchemaCommand(ERestoreDefaults, NULL);
 }
 
 /********************************************************************************
@@ -809,13 +1406,16 @@ EHandlerResponse RestoreDefaultSettings()
  *******************************************************************************/
 EHandlerResponse GetScreenReadyData(ScreenReady* pScreenReady)
 {
+   const CommandHandlers* pHandlers = AcquireCommandHandlers();
    EHandlerResponse eResponse = EOpNotAllowed;
 
-   if (m_pHandlers.fpHandleScreenReady)
+   if (pHandlers->fpHandleScreenReady)
    {
-      eResponse = m_pHandlers.fpHandleScreenReady(pScreenReady);
+      eResponse = pHandlers->fpHandleScreenReady(pScreenReady);
    }
 
+   ReleaseCommandHandlers(pHandlers);
+
    return eResponse;
 }
 
@@ -838,13 +1438,17 @@ EHandlerResponse GetScreenReadyData(ScreenReady* pScreenReady)
  *******************************************************************************/
 EHandlerResponse GetSyncData(SyncDataInfo* pSyncData)
 {
+   const CommandHandlers* pHandlers = AcquireCommandHandlers();
    EHandlerResponse eResponse = EOpNotAllowed;
 
-   if (m_pHandlers.fpHandleSyncData)
+   if (pHandlers->fpHandleSyncData)
    {
-      eResponse = m_pHandlers.fpHandleSyncData(pSyncData);        
+      eResponse = pHandlers->fpHandleSyncData(pSyncData);        
    }
       
+
+   ReleaseCommandHandlers(pHandlers);
+
    return eResponse;
 }
 
@@ -866,13 +1470,17 @@ EHandlerResponse GetSyncData(SyncDataInfo* pSyncData)
  *******************************************************************************/
 EHandlerResponse GetFirmwareVersion(FirmwareVersion* pVersion)
 {
+   const CommandHandlers* pHandlers = AcquireCommandHandlers();
    EHandlerResponse eResponse = EOpNotAllowed;
 
-   if (m_pHandlers.fpHandleGetFirmwareVersion)
+   if (pHandlers->fpHandleGetFirmwareVersion)
    {
-      eResponse = m_pHandlers.fpHandleGetFirmwareVersion(pVersion);
+      eResponse = pHandlers->fpHandleGetFirmwareVersion(pVersion);
    }
       
+
+   ReleaseCommandHandlers(pHandlers);
+
    return eResponse;
 }
 
@@ -894,13 +1502,16 @@ EHandlerResponse GetFirmwareVersion(FirmwareVersion* pVersion)
  *******************************************************************************/
 EHandlerResponse GetFirmwareInfo(FirmwareInfo* pInfo)
 {
+   const CommandHandlers* pHandlers = AcquireCommandHandlers();
    EHandlerResponse eResponse = EOpNotAllowed;
 
-   if(m_pHandlers.fpHandleGetFirmwareInfo)
+   if(pHandlers->fpHandleGetFirmwareInfo)
    {
-      eResponse = m_pHandlers.fpHandleGetFirmwareInfo(pInfo);
+      eResponse = pHandlers->fpHandleGetFirmwareInfo(pInfo);
    }
 
+   ReleaseCommandHandlers(pHandlers);
+
    return eResponse;
 }
 
@@ -922,150 +1533,98 @@ EHandlerResponse GetFirmwareInfo(FirmwareInfo* pInfo)
  *******************************************************************************/
 EHandlerResponse GetConfigurationData(ConfigData* pData)
 {
+   const CommandHandlers* pHandlers = AcquireCommandHandlers();
    EHandlerResponse eResponse = EOpNotAllowed;
 
-   if(m_pHandlers.fpHandleGetConfigurationData)
+   if(pHandlers->fpHandleGetConfigurationData)
    {
-      eResponse = m_pHandlers.fpHandleGetConfigurationData(pData);
+      eResponse = pHandlers->fpHandleGetConfigurationData(pData);
    }
   
+
+   ReleaseCommandHandlers(pHandlers);
+
    return eResponse;
 }
 /********************************************************************************
  *
- * Name:    SetConfigurationData
+ * Name:    SetConfigurationDataView
  *
  * Purpose: Loads configuation data from TSF controller
  *
- * Inputs:  m_cmdBuffer - command payload buffer
- *          cmdBufferSize - payload buffer length
+ * Inputs:  pPayload - view of the command payload
  *
  * Outputs: pConfig - populated with configuration data
  *
  * Returns: EResponseOk if successful, error code otherwise
  *
- * Notes:   None
+ * Notes:   Fields may come in any order. Fields left out keep the value
+ *          read through the get configuration handler, so a client can
+ *          send only what changed.
  *
  *******************************************************************************/
-EHandlerResponse SetConfigurationData(MsgPayload* pPayload)
+EHandlerResponse SetConfigurationDataView(const FrameView* pPayload)
 {
-   EHandlerResponse eResponse = EInputBufferError;
-   ConfigData data = { 0 };
-   char* pEnd                 = NULL;
-   bool bStop                 = false;
+   const CommandHandlers* pHandlers = AcquireCommandHandlers();
+   EHandlerResponse eResponse = CheckPayload(pPayload);
+   ConfigData data            = { 0 };
+   ParamValues values;
 
-   // create a buffer for each parameter value
-   char szParam[TMP_STR_SIZE] = { 0 };
-   char szTag[TMP_STR_SIZE]   = { 0 };
-   char szValue[TMP_STR_SIZE] = {0};
-   char* pReader              = NULL;
-   char* pParamReader         = NULL;
-   int nCnt                   = 0;
+   if (eResponse == EResponseOk)
+   {
+      eResponse = DecodeParameters(pPayload, m_configFields, EConfigFieldCount, &values);
+   }
 
-   if (pPayload != NULL)
+   // fields not sent keep their current values
+   if (eResponse == EResponseOk && values.nPresent != ((uint32_t)1 << EConfigFieldCount) - 1)
    {
-      pReader = pPayload->szPayload;
+      eResponse = EInvalidParameters;
 
-      eResponse = EBuffSizeError;
-      if (strlen(pPayload->szPayload) < PAYLOAD_LENGTH)
+      if (pHandlers->fpHandleGetConfigurationData)
       {
-         eResponse = EInvalidParameters;
-
-         // tokenize string, split at comma
-         StrTokenize(pReader, ",");
-         RestoreDelimiterAndMovePast(&pReader, ',');
-         
-         for (nCnt = 0; nCnt < SET_CONFIG_PARAM_CNT; nCnt++)
-         {
-            StrTokenize(pReader, ",");
-            strcpy(szParam, pReader);
-            pParamReader = szParam;
-            GetTagAndValue(&pParamReader, szTag, szValue);
-            switch (nCnt)
-            {
-            case 0:
-               if (strcmp(TAG_N2O_MAX, szTag) == 0)
-               {
-                  data.nMaxN20 = strtol(pParamReader, &pEnd, 10);
-               }
-               else
-               {
-                  bStop = true;
-               }
-               break;
-            case 1:
-               if (strcmp(TAG_MIX_STEP, szTag) == 0)
-               {
-                  data.eMixStepSize = strtol(pParamReader, &pEnd, 10);
-               }
-               else
-               {
-                  bStop = true;
-               }
-               break;
-            case 2:
-               if (strcmp(TAG_FLOW_STEP, szTag) == 0)
-               {
-                  data.eFlowStepSize = strtol(pParamReader, &pEnd, 10);
-               }
-               break;
-            case 3:
-               if (strcmp(TAG_CLOCK_FORMAT, szTag) == 0)
-               {
-                  data.eClockFormat = strtol(pParamReader, &pEnd, 10);
-               }
-               else
-               {
-                  bStop = true;
-               }
-               break;
-            case 4:
-               if (strcmp(TAG_LANGUAGE, szTag) == 0)
-               {
-                  data.eLanguage = strtol(pParamReader, &pEnd, 10);
-               }
-               else
-               {
-                  bStop = true;
-               }
-               break;
-            case 5:
-               if (strcmp(TAG_T_AND_D, szTag) == 0)
-               {
-                  strcpy(data.szTime, pParamReader);
-               }
-               else
-               {
-                  bStop = true;
-               }
-               break;
-            default:
-               // nothing to do here
-               break;
-            }
+         eResponse = pHandlers->fpHandleGetConfigurationData(&data);
+      }
+   }
 
-            if (bStop)
-            {
-               // invalid parameter found, stop processing
-               break;
-            }
+   if (eResponse == EResponseOk)
+   {
+      // copy the fields received
+      CONFIG_FIELDS(SCHEMA_CONFIG_DECODE)
 
-            if (nCnt < SET_CONFIG_PARAM_CNT - 1)
-               RestoreDelimiterAndMovePast(&pReader, ',');
-         }
+      eResponse = EOpNotAllowed;
 
-         if (bStop == false)
-         {
-            if (m_pHandlers.fpHandleSetConfigurationData)
-            {
-               eResponse = m_pHandlers.fpHandleSetConfigurationData(&data);
-            }
-         }
+      if (pHandlers->fpHandleSetConfigurationData)
+      {
+         eResponse = pHandlers->fpHandleSetConfigurationData(&data);
       }
    }
 
+   ReleaseCommandHandlers(pHandlers);
+
    return eResponse;
 }
+
+/********************************************************************************
+ *
+ * Name:    SetConfigurationData
+ *
+ * Purpose: Runs SetConfigurationDataView on a NULL terminated payload.
+ *
+ * Inputs:  pPayload - command payload
+ *
+ * Outputs: See SetConfigurationDataView
+ *
+ * Returns: EResponseOk if successful, error code otherwise
+ *
+ * Notes:   None
+ *
+ *******************************************************************************/
+EHandlerResponse SetConfigurationData(MsgPayload* pPayload)
+{
+   FrameView view = GetPayloadView(pPayload);
+
+   return SetConfigurationDataView(&view);
+}
 /********************************************************************************
  *
  * Name:    SetConfigurationData
@@ -1084,24 +1643,26 @@ EHandlerResponse SetConfigurationData(MsgPayload* pPayload)
  *******************************************************************************/
 EHandlerResponse GetTimeAndDate(char* pTime)
 {
+   const CommandHandlers* pHandlers = AcquireCommandHandlers();
    EHandlerResponse eResponse = EOpNotAllowed;
 
-   if (m_pHandlers.fpHandleGetTimeAndDate)
+   if (pHandlers->fpHandleGetTimeAndDate)
    {
-      eResponse = m_pHandlers.fpHandleGetTimeAndDate(pTime);
+      eResponse = pHandlers->fpHandleGetTimeAndDate(pTime);
    }
 
+   ReleaseCommandHandlers(pHandlers);
+
    return eResponse;
 }
 
 /********************************************************************************
  *
- * Name:    SetTimeAndDate
+ * Name:    SetTimeAndDateView
  *
  * Purpose: Sets the time and date for the system
  *
- * Inputs:  m_cmdBuffer - command payload buffer.
- *          cmdBufferSize - payload buffer length.
+ * Inputs:  pPayload - view of the command payload
  *
  * Outputs: None.
  *
@@ -1110,51 +1671,59 @@ EHandlerResponse GetTimeAndDate(char* pTime)
  * Notes:   None.
  *
  *******************************************************************************/
-EHandlerResponse SetTimeAndDate(MsgPayload* pPayload)
+EHandlerResponse SetTimeAndDateView(const FrameView* pPayload)
 {
-   EHandlerResponse eResponse    = EInputBufferError;
-   char szTag[TMP_STR_SIZE]      = {0};
-   char szTime[TMP_STR_SIZE]     = {0};
-   char* pReader                 = NULL;
+   const CommandHandlers* pHandlers = AcquireCommandHandlers();
+   EHandlerResponse eResponse = CheckPayload(pPayload);
+   ParamReader reader;
+   FrameView value;
+   char szValue[TMP_STR_SIZE] = {0};
 
-   // check buffer and data size before processing
-   if(pPayload != NULL)
+   if (eResponse == EResponseOk)
    {
-      pReader = pPayload->szPayload;
+      eResponse = EInvalidParameters;
+      // skip the command code
+      BeginParameters(&reader, pPayload);
 
-      if (strlen(pPayload->szPayload) < PAYLOAD_LENGTH)
+      // if the parameter tag is time & date
+      if (ReadParameter(&reader, TAG_T_AND_D, &value))
       {
-         eResponse = EInvalidParameters;
-
-         // tokenize string, split at the comma
-         StrTokenize(pReader, ",");
-
-         // skip command code and advance to next token
-         RestoreDelimiterAndMovePast(&pReader, ',');
-
-         // tokenize string, split on the equals
-         StrTokenize(pReader, "=");
-
-         strcpy(szTag, pReader);
+         eResponse = EOpNotAllowed;
 
-         // if the parameter tag is time & date
-         if(strcmp(TAG_T_AND_D, szTag) == 0)
+         if (pHandlers->fpHandleSetTimeAndDate)
          {
-            
-            RestoreDelimiterAndMovePast(&pReader, '=');
-
-            // grab the values and call the command handler
-            strcpy(szTime, pReader);
-
-            if(m_pHandlers.fpHandleSetTimeAndDate)
-            {
-               eResponse = m_pHandlers.fpHandleSetTimeAndDate(szTime);
-            }
+            // handler takes a NULL terminated string
+            ViewToString(&value, szValue, sizeof(szValue));
+            eResponse = pHandlers->fpHandleSetTimeAndDate(szValue);
          }
       }
    }
 
-   return eResponse;
+   ReleaseCommandHandlers(pHandlers);
+
+   return eResponse;
+}
+
+/********************************************************************************
+ *
+ * Name:    SetTimeAndDate
+ *
+ * Purpose: Runs SetTimeAndDateView on a NULL terminated payload.
+ *
+ * Inputs:  pPayload - command payload
+ *
+ * Outputs: See SetTimeAndDateView
+ *
+ * Returns: EResponseOk if successful, error code otherwise
+ *
+ * Notes:   None
+ *
+ *******************************************************************************/
+EHandlerResponse SetTimeAndDate(MsgPayload* pPayload)
+{
+   FrameView view = GetPayloadView(pPayload);
+
+   return SetTimeAndDateView(&view);
 }
 
 /********************************************************************************
@@ -1175,17 +1744,16 @@ EHandlerResponse SetTimeAndDate(MsgPayload* pPayload)
  *******************************************************************************/
 EHandlerResponse StopGasFlow()
 {
-   return HandleNoParameterCommand(m_pHandlers.fpHandleStopGasFlow);
+   return HandleSchemaCommand(EStopGas, NULL);
 }
 
 /********************************************************************************
  *
- * Name:    SetO2MixPercentage
+ * Name:    SetO2MixPercentageView
  *
  * Purpose: Parses parameters from command payload and calls command handler.
  *
- * Inputs:  m_cmdBuffer      - message payload
- *          cmdBufferSize  - total length of payload buffer
+ * Inputs:  pPayload - view of the command payload
  *
  * Outputs: None.
  *
@@ -1194,66 +1762,31 @@ EHandlerResponse StopGasFlow()
  * Notes:   None
  *
  *******************************************************************************/
-EHandlerResponse SetO2MixPercentage(MsgPayload* pPayload)
+EHandlerResponse SetO2MixPercentageView(const FrameView* pPayload)
 {
-   EHandlerResponse  eResponse = EInvalidParameters;
-   ECommandCode      eType;
-
-   char* pReader           = NULL;
-   // replace all commas with null terminator
-   char* pszCommand        = NULL;
-   char* pszPercentage     = NULL;
-   int   nPercentage       = 0;
-
-  
-
-   if (pPayload)
-   {
-      pReader = pPayload->szPayload;
-      pszCommand = StrTokenize(pReader, ",");
-
-      // read command code from buffer
-      eType = atoi(pszCommand);
-
-      // find null in buffer
-      while(*pszCommand != '\0')
-      {
-         pszCommand++;
-      }
-
-      // restore delimiter after destructive call to strtok & advance pointer
-      *pszCommand = ',';
-      pszCommand++;
-
-      if (strstr(pszCommand, TAG_O2_MIX))
-      {
-         pszPercentage = StrTokenize(pszCommand, "=");
-
-         // if token is the O2 tag
-         if(strcmp(pszPercentage, "O2") == 0)
-         {
-            while (*pszPercentage != '\0')
-            {
-               pszPercentage++;
-            }
-
-            // restore delimiter after destuctive call to strtok
-            *pszPercentage = '=';
-            pszPercentage++;
-
-            // remaining string should be the parameter
-            nPercentage = atoi(pszPercentage);
+   return HandleSchemaCommand(ESetO2MixPercentage, pPayload);
+}
 
-            // if handler has been set
-            if(m_pHandlers.fpHandleSetO2MixPercent != NULL)
-            {
-               eResponse = m_pHandlers.fpHandleSetO2MixPercent(nPercentage);
-            }
-         }
-      }
-   }
+/********************************************************************************
+ *
+ * Name:    SetO2MixPercentage
+ *
+ * Purpose: Runs SetO2MixPercentageView on a NULL terminated payload.
+ *
+ * Inputs:  pPayload - command payload
+ *
+ * Outputs: See SetO2MixPercentageView
+ *
+ * Returns: EResponseOk if successful, error code otherwise
+ *
+ * Notes:   None
+ *
+ *******************************************************************************/
+EHandlerResponse SetO2MixPercentage(MsgPayload* pPayload)
+{
+   FrameView view = GetPayloadView(pPayload);
 
-   return eResponse;
+   return SetO2MixPercentageView(&view);
 }
 
 /********************************************************************************
@@ -1273,24 +1806,16 @@ EHandlerResponse SetO2MixPercentage(MsgPayload* pPayload)
  *******************************************************************************/
 EHandlerResponse GetO2MixPercentage(int* pPercentage)
 {
-   EHandlerResponse eResponse = EOpNotAllowed;
-
-   if (m_pHandlers.fpHandleGetO2MixPercent)
-   {
-      eResponse = m_pHandlers.fpHandleGetO2MixPercent(pPercentage);
-   }
-
-   return eResponse;
+   return GetSchemaValue(EGetO2MixPercentage, pPercentage);
 }
 
 /********************************************************************************
  *
- * Name:    SetTotalFlowRate
+ * Name:    SetTotalFlowRateView
  *
  * Purpose: Sets the gas flow rate in LPM.
  *
- * Inputs:  m_cmdBuffer      - message payload
- *          cmdBufferSize  - total length of payload buffer
+ * Inputs:  pPayload - view of the command payload
  *
  * Outputs: None.
  *
@@ -1299,50 +1824,31 @@ EHandlerResponse GetO2MixPercentage(int* pPercentage)
  * Notes:   None
  *
  *******************************************************************************/
-EHandlerResponse SetTotalFlowRate(MsgPayload* pPayload)
+EHandlerResponse SetTotalFlowRateView(const FrameView* pPayload)
 {
-   EHandlerResponse eResponse = EInputBufferError;
-   char* pReader              = NULL;
-   char* pEnd                 = NULL;
-   char szTag[TMP_STR_SIZE]   = {0};
-   char szValue[TMP_STR_SIZE] = {0};
-   int nFlowRate              = 0;
-
-   // check buffer and size before processing
-   if(pPayload != NULL)
-   {
-      pReader = pPayload->szPayload;
-
-      if (strlen(pPayload->szPayload) < PAYLOAD_LENGTH)
-      {
-         eResponse = EInvalidParameters;
-
-         // tokenize string, split at comma & skip command code
-         StrTokenize(pReader, ",");
-         RestoreDelimiterAndMovePast(&pReader, ',');
-
-         // Read tag and value from the command payload
-         GetTagAndValue(&pReader, szTag, szValue);
-
-         // if the parameter is flow rate
-         if(strcmp(szTag, TAG_FLOW_RATE) == 0)
-         {
-            // convert string to decimal value
-            nFlowRate = strtol(szValue, &pEnd, 10);
+   return HandleSchemaCommand(ESetTotalFlowRate, pPayload);
+}
 
-            if (m_pHandlers.fpHandleSetTotalFlowRate)
-            {
-               eResponse = m_pHandlers.fpHandleSetTotalFlowRate(nFlowRate);
-            }
-            else
-            {
-               eResponse = EOpNotAllowed;
-            }
-         }
-      }
-   }
+/********************************************************************************
+ *
+ * Name:    SetTotalFlowRate
+ *
+ * Purpose: Runs SetTotalFlowRateView on a NULL terminated payload.
+ *
+ * Inputs:  pPayload - command payload
+ *
+ * Outputs: See SetTotalFlowRateView
+ *
+ * Returns: EResponseOk if successful, error code otherwise
+ *
+ * Notes:   None
+ *
+ *******************************************************************************/
+EHandlerResponse SetTotalFlowRate(MsgPayload* pPayload)
+{
+   FrameView view = GetPayloadView(pPayload);
 
-   return eResponse;
+   return SetTotalFlowRateView(&view);
 }
 
 /********************************************************************************
@@ -1362,14 +1868,7 @@ EHandlerResponse SetTotalFlowRate(MsgPayload* pPayload)
  *******************************************************************************/
 EHandlerResponse GetTotalFlowRate(int* pTotalFlowRate)
 {
-   EHandlerResponse eResponse = EOpNotAllowed;
-
-   if (m_pHandlers.fpHandleGetTotalFlowRate)
-   {
-      eResponse = m_pHandlers.fpHandleGetTotalFlowRate(pTotalFlowRate);
-   }
-
-   return eResponse;
+   return GetSchemaValue(EGetTotalFlowRate, pTotalFlowRate);
 }
 
 /********************************************************************************
@@ -1391,24 +1890,26 @@ EHandlerResponse GetTotalFlowRate(int* pTotalFlowRate)
  *******************************************************************************/
 EHandlerResponse GetFlowRates(int* pO2FlowRate, int* pN2OFlowRate, int* pScavFlowRate)
 {
+   const CommandHandlers* pHandlers = AcquireCommandHandlers();
    EHandlerResponse eResponse = EOpNotAllowed;
 
-   if (m_pHandlers.fpHandleGetFlowRates)
+   if (pHandlers->fpHandleGetFlowRates)
    {
-      eResponse = m_pHandlers.fpHandleGetFlowRates(pO2FlowRate, pN2OFlowRate, pScavFlowRate);
+      eResponse = pHandlers->fpHandleGetFlowRates(pO2FlowRate, pN2OFlowRate, pScavFlowRate);
    }
 
+   ReleaseCommandHandlers(pHandlers);
+
    return eResponse;
 }
 
 /********************************************************************************
  *
- * Name:    SetLanguage
+ * Name:    SetLanguageView
  *
  * Purpose: Sets the default display language.
  *
- * Inputs:  m_cmdBuffer      - message payload
- *          cmdBufferSize  - total length of payload buffer
+ * Inputs:  pPayload - view of the command payload
  *
  * Outputs: None.
  *
@@ -1417,46 +1918,31 @@ EHandlerResponse GetFlowRates(int* pO2FlowRate, int* pN2OFlowRate, int* pScavFlo
  * Notes:   None
  *
  *******************************************************************************/
-EHandlerResponse SetLanguage(MsgPayload* pPayload)
+EHandlerResponse SetLanguageView(const FrameView* pPayload)
 {
-   EHandlerResponse eResponse = EInputBufferError;
-   char szTag[TMP_STR_SIZE]   = {0};
-   char szValue[TMP_STR_SIZE] = {0};
-   char* pReader = NULL;
-   int nLanguage = 0;
-
-   // check reference buffer
-   if(pPayload != NULL)
-   {
-      pReader = pPayload->szPayload;
-      eResponse = EBuffSizeError;
-
-      // check data length
-      if(strlen(pPayload->szPayload) < PAYLOAD_LENGTH)
-      {
-         eResponse = EInvalidParameters;
-         StrTokenize(pReader, ",");
-         RestoreDelimiterAndMovePast(&pReader, ',');
-
-         GetTagAndValue(&pReader, szTag, szValue);
+   return HandleSchemaCommand(ESetLanguage, pPayload);
+}
 
-         // if the tag is for language
-         if(strcmp(TAG_LANGUAGE, szTag) == 0)
-         {
-            if (m_pHandlers.fpHandleSetLanguage)
-            {
-               nLanguage = atoi(szValue);
-               eResponse = m_pHandlers.fpHandleSetLanguage(nLanguage);
-            }
-            else
-            {
-               eResponse = EOpNotAllowed;
-            }
-         }
-      }
-   }
+/********************************************************************************
+ *
+ * Name:    SetLanguage
+ *
+ * Purpose: Runs SetLanguageView on a NULL terminated payload.
+ *
+ * Inputs:  pPayload - command payload
+ *
+ * Outputs: See SetLanguageView
+ *
+ * Returns: EResponseOk if successful, error code otherwise
+ *
+ * Notes:   None
+ *
+ *******************************************************************************/
+EHandlerResponse SetLanguage(MsgPayload* pPayload)
+{
+   FrameView view = GetPayloadView(pPayload);
 
-   return eResponse;
+   return SetLanguageView(&view);
 }
 
 /********************************************************************************
@@ -1476,13 +1962,16 @@ EHandlerResponse SetLanguage(MsgPayload* pPayload)
  *******************************************************************************/
 EHandlerResponse GetLanguage(ELanguage* pLanguage)
 {
+   const CommandHandlers* pHandlers = AcquireCommandHandlers();
    EHandlerResponse eResponse = EOpNotAllowed;
 
-   if (m_pHandlers.fpHandleGetLanguage)
+   if (pHandlers->fpHandleGetLanguage)
    {
-      eResponse = m_pHandlers.fpHandleGetLanguage(pLanguage);
+      eResponse = pHandlers->fpHandleGetLanguage(pLanguage);
    }
 
+   ReleaseCommandHandlers(pHandlers);
+
    return eResponse;
 }
 
@@ -1504,7 +1993,7 @@ EHandlerResponse GetLanguage(ELanguage* pLanguage)
  *******************************************************************************/
 EHandlerResponse StartProcedure()
 {
-   return HandleNoParameterCommand(m_pHandlers.fpHandleStartProcedure);
+   return HandleSchemaCommand(EStartProcedure, NULL);
 }
 
 /********************************************************************************
@@ -1525,75 +2014,95 @@ EHandlerResponse StartProcedure()
  *******************************************************************************/
 EHandlerResponse EndProcedure()
 {
-   return HandleNoParameterCommand(m_pHandlers.fpHandleStartProcedure);
+   return HandleSchemaCommand(EEndProcedure, NULL);
 }
 
 /********************************************************************************
  *
- * Name:    EndProcedure
+ * Name:    EnableDisablePinView
  *
  * Purpose: This command enables or disables the PIN security for dispensing N2O gas
  *
- * Inputs:  m_cmdBuffer      - message payload
- *          cmdBufferSize  - total length of payload buffer
+ * Inputs:  pPayload - view of the command payload
  *
  * Outputs: None.
  *
  * Returns: EHandlerResponse EResponseOk if successful, error code otherwise
  *
- * Notes:   This command instructs the TSF controller that the procedure
- *          is coming to an end
+ * Notes:   None
+ *******************************************************************************/
+EHandlerResponse EnableDisablePinView(const FrameView* pPayload)
+{
+   return HandleSchemaCommand(EEnableDisablePin, pPayload);
+}
+
+/********************************************************************************
+ *
+ * Name:    EnableDisablePin
+ *
+ * Purpose: Runs EnableDisablePinView on a NULL terminated payload.
+ *
+ * Inputs:  pPayload - command payload
+ *
+ * Outputs: See EnableDisablePinView
+ *
+ * Returns: EResponseOk if successful, error code otherwise
+ *
+ * Notes:   None
+ *
  *******************************************************************************/
 EHandlerResponse EnableDisablePin(MsgPayload* pPayload)
 {
-   EHandlerResponse eResponse = EInputBufferError;
-   char szTag[TMP_STR_SIZE]   = {0};
+   FrameView view = GetPayloadView(pPayload);
+
+   return EnableDisablePinView(&view);
+}
+
+/********************************************************************************
+ *
+ * Name:    ChangePinView
+ *
+ * Purpose: Updates the current security PIN.
+ *
+ * Inputs:  pPayload - view of the command payload
+ *
+ * Outputs: None.
+ *
+ * Returns: EResponseOk is successful, error code otherwise
+ *
+ * Notes:   TODO: Determine if the change PIN command should be protected
+ *
+ *******************************************************************************/
+EHandlerResponse ChangePinView(const FrameView* pPayload)
+{
+   const CommandHandlers* pHandlers = AcquireCommandHandlers();
+   EHandlerResponse eResponse = CheckPayload(pPayload);
+   ParamReader reader;
+   FrameView value;
    char szValue[TMP_STR_SIZE] = {0};
-   bool bEnabled              = false;
-   char* pReader              = NULL;
-   char* pEnd                 = NULL;
 
-   if(pPayload != NULL)
+   if (eResponse == EResponseOk)
    {
-      pReader = pPayload->szPayload;
-
-      eResponse = EBuffSizeError;
+      eResponse = EInvalidParameters;
+      // skip the command code
+      BeginParameters(&reader, pPayload);
 
-      if (strlen(pPayload->szPayload) < PAYLOAD_LENGTH)
+      // check parameter tag
+      if (ReadParameter(&reader, TAG_CHANGE_PIN, &value))
       {
-         eResponse = EInvalidParameters;
-
-         // tokenize payload, split at the comma
-         StrTokenize(pReader, ",");
-
-         // skip the command code, restore delimiter
-         RestoreDelimiterAndMovePast(&pReader, ',');
-
-         // tokenize parameters, split at the equals
-         StrTokenize(pReader, "=");
-
-         // copy the tag from the payload
-         strcpy(szTag, pReader);
-
-         RestoreDelimiterAndMovePast(&pReader, '=');
-
-         // copy the value from the payload
-         strcpy(szValue, pReader);
+         eResponse = EOpNotAllowed;
 
-         // if the tag matches PIN_EN
-         if (strcmp(TAG_TOGGLE_PIN, szTag) == 0)
+         if (pHandlers->fpHandleChangePin)
          {
-            eResponse = EInvalidParameters;
-            bEnabled = (bool) strtol(szValue, &pEnd, 10);
-
-            if(m_pHandlers.fpHandleEnableDisablePin)
-            {
-               eResponse = m_pHandlers.fpHandleEnableDisablePin(bEnabled);
-            }
+            // handler takes a NULL terminated string
+            ViewToString(&value, szValue, sizeof(szValue));
+            eResponse = pHandlers->fpHandleChangePin(szValue);
          }
       }
    }
 
+   ReleaseCommandHandlers(pHandlers);
+
    return eResponse;
 }
 
@@ -1601,64 +2110,115 @@ EHandlerResponse EnableDisablePin(MsgPayload* pPayload)
  *
  * Name:    ChangePin
  *
- * Purpose: Updates the current security PIN.
+ * Purpose: Runs ChangePinView on a NULL terminated payload.
+ *
+ * Inputs:  pPayload - command payload
+ *
+ * Outputs: See ChangePinView
+ *
+ * Returns: EResponseOk if successful, error code otherwise
+ *
+ * Notes:   None
+ *
+ *******************************************************************************/
+EHandlerResponse ChangePin(MsgPayload* pPayload)
+{
+   FrameView view = GetPayloadView(pPayload);
+
+   return ChangePinView(&view);
+}
+
+/********************************************************************************
+ *
+ * Name:    Heartbeat
+ *
+ * Purpose: Handles heartbeat command. Forwards request to command handler
  *
- * Inputs:  m_cmdBuffer - contains the command payload
- *          cmdBufferSize - length of payload buffer
+ * Inputs:  None
  *
  * Outputs: None.
  *
  * Returns: EResponseOk is successful, error code otherwise
  *
- * Notes:   TODO: Determine if the change PIN command should be protected
+ * Notes:   None
  *
  *******************************************************************************/
-EHandlerResponse ChangePin(MsgPayload* pPayload)
+EHandlerResponse Heartbeat()
 {
-   EHandlerResponse eResponse = EInputBufferError;
-   char szTag[TMP_STR_SIZE] = { 0 };
-   char szValue[TMP_STR_SIZE] = { 0 };
-   bool bEnabled              = false;
-   char* pReader              = NULL;
-   char* pEnd                 = NULL;
+   return HandleSchemaCommand(EHeartbeat, NULL);
+}
 
-   if(pPayload != NULL)
-   {
-      pReader = pPayload->szPayload;
-      eResponse = EBuffSizeError;
+/********************************************************************************
+ *
+ * Name:    SetValvePositionView
+ *
+ * Purpose: Sets the gas valve to a known position
+ *
+ * Inputs:  pPayload - view of the command payload
+ *          
+ * Outputs: None
+ *
+ * Returns: EResponseOk if successful, error code otherwise
+ *
+ * Notes:   Parameters expected, in any order
+ *          TAG_GAS_SELECTION
+ *          TAG_VALVE_POS (0 - 100)
+ *
+ *******************************************************************************/
+EHandlerResponse SetValvePositionView(const FrameView* pPayload)
+{
+   const CommandHandlers* pHandlers = AcquireCommandHandlers();
+   EHandlerResponse eResponse = CheckPayload(pPayload);
+   ParamValues values;
 
-      // check buffer length before processing
-      if(strlen(pPayload->szPayload) < PAYLOAD_LENGTH)
-      {
-         eResponse = EInvalidParameters;
+   if (eResponse == EResponseOk)
+   {
+      eResponse = DecodeParameters(pPayload, m_valveFields, EGasFieldCount, &values);
+   }
 
-         // tokenize string, split on the comma
-         StrTokenize(pReader, ",");
+   if (eResponse == EResponseOk)
+   {
+      eResponse = EOpNotAllowed;
 
-         // skip command code, run to next token
-         RestoreDelimiterAndMovePast(&pReader, ',');
+      if (pHandlers->fpHandleSetValve)
+      {
+         eResponse = pHandlers->fpHandleSetValve((EGasId)values.nValue[EGasSelection], values.nValue[EGasValue]);
+      }
+   }
 
-         // tokenize string, split on the equals
-         StrTokenize(pReader, "=");
+   ReleaseCommandHandlers(pHandlers);
 
-         // copy tag from payload
-         strcpy(szTag, pReader);
-         RestoreDelimiterAndMovePast(&pReader, '=');
+   return eResponse;
+}
 
-         // copy value from payload
-         strcpy(szValue, pReader);
+/********************************************************************************
+ *
+ * Name:    ReadSetValveGasView
+ *
+ * Purpose: Reads which gas a set valve command is for, without running it.
+ *
+ * Inputs:  pPayload - view of the command payload
+ *
+ * Outputs: peId - gas of the valve
+ *
+ * Returns: EResponseOk if successful, error code otherwise
+ *
+ * Notes:   Checks the whole payload, as SetValvePositionView does.
+ *
+ *******************************************************************************/
+EHandlerResponse ReadSetValveGasView(const FrameView* pPayload, EGasId* peId)
+{
+   EHandlerResponse eResponse = CheckPayload(pPayload);
+   ParamValues values;
 
-         // check parameter tag
-         if(strcmp(TAG_CHANGE_PIN, szTag) == 0)
-         {
-            eResponse = EOpNotAllowed;
+   if (eResponse == EResponseOk)
+   {
+      eResponse = DecodeParameters(pPayload, m_valveFields, EGasFieldCount, &values);
+   }
 
-            if (m_pHandlers.fpHandleChangePin)
-            {
-               eResponse = m_pHandlers.fpHandleChangePin(szValue);
-            }
-         }
-      }
+   if (eResponse == EResponseOk)
+   {
+      *peId = (EGasId)values.nValue[EGasSelection];
    }
 
    return eResponse;
@@ -1666,135 +2226,87 @@ EHandlerResponse ChangePin(MsgPayload* pPayload)
 
 /********************************************************************************
  *
- * Name:    Heartbeat
+ * Name:    SetValvePosition
  *
- * Purpose: Handles heartbeat command. Forwards request to command handler
+ * Purpose: Runs SetValvePositionView on a NULL terminated payload.
  *
- * Inputs:  None
+ * Inputs:  pPayload - command payload
  *
- * Outputs: None.
+ * Outputs: See SetValvePositionView
  *
- * Returns: EResponseOk is successful, error code otherwise
+ * Returns: EResponseOk if successful, error code otherwise
  *
  * Notes:   None
  *
  *******************************************************************************/
-EHandlerResponse Heartbeat()
+EHandlerResponse SetValvePosition(MsgPayload* pPayload)
 {
-   return HandleNoParameterCommand(m_pHandlers.fpHandleHeartbeat);
+   FrameView view = GetPayloadView(pPayload);
+
+   return SetValvePositionView(&view);
 }
 
 /********************************************************************************
  *
- * Name:    
+ * Name:    GetValvePosition
  *
- * Purpose: m_cmdBuffer      - message payload
- *          cmdBufferSize  - total length of payload buffer
+ * Purpose: Reads gas valve postion from TSF controller
  *
- * Inputs:  None
+ * Inputs:  m_cmdBuffer      - message payload
+ *          cmdBufferSize  - total length of payload buffer
  *          
- * Outputs: None
+ * Outputs: pPositon       - populated with gas valve position
  *
  * Returns: None.
  *
- * Notes:   None.
+ * Notes:   Reads gas valve position for O2 gas for N2O gas
  *
  *******************************************************************************/
-EHandlerResponse SetValvePosition(MsgPayload* pPayload)
+EHandlerResponse GetValvePosition(EGasId* pId, int* pPosition)
 {
-   EHandlerResponse eResponse = EInputBufferError;
-   char szParam1[TMP_STR_SIZE]      = {0};
-   char szParam2[TMP_STR_SIZE]      = {0};
-   char* pParam1 = szParam1;
-   char* pParam2 = szParam2;
-
-   char szPositionTag[TMP_STR_SIZE] = {0};
-   char szGasTag[TMP_STR_SIZE]      = {0};
-   char szPosition[TMP_STR_SIZE]    = {0};
-   char szGasId[TMP_STR_SIZE]       = {0};
-   EGasId eId;
-   int nPosition                    = 0;
-   char* pReader                    = NULL;
-   char* pEnd                       = NULL;
-
-   if(pPayload != NULL)
-   {
-      eResponse = EBuffSizeError;
-      pReader = pPayload->szPayload;
-
-      if (strlen(pPayload->szPayload) < PAYLOAD_LENGTH)
-      {
-         eResponse = EInvalidParameters;
-
-         // tokenize string, split at the comma
-         StrTokenize(pReader, ",");
-         RestoreDelimiterAndMovePast(&pReader, ',');
-
-         StrTokenize(NULL, ",");
-
-         // grab first parameter from payload
-         strcpy(szParam1, pReader);
-         RestoreDelimiterAndMovePast(&pReader, ',');
-
-         strcpy(szParam2, pReader);
-
-         StrTokenize(pParam1, "=");
-         strcpy(szGasTag, pParam1);
-
-         RestoreDelimiterAndMovePast(&pParam1, '=');
-
-         // convert gas ID 
-         eId = strtol(szParam1, &pEnd, 10);
-
-         StrTokenize(pParam2, "=");
-         strcpy(szPositionTag, szParam2);
-
-         RestoreDelimiterAndMovePast(&pParam2, '=');
-
-         // convert valve position
-         nPosition = strtol(pParam2, &pEnd, 10);
-
-         // if tags match expected parameters
-         if (strcmp(TAG_VALVE_POS, szPositionTag) == 0
-         &&  strcmp(TAG_GAS_SELECTION, szGasTag) == 0)
-         {
-            eResponse = EOpNotAllowed;
+   const CommandHandlers* pHandlers = AcquireCommandHandlers();
+   EHandlerResponse eResponse = EOpNotAllowed;
 
-            if (m_pHandlers.fpHandleSetValve)
-            {
-               eResponse = m_pHandlers.fpHandleSetValve(nPosition, eId);
-            }
-         }
-       
-      }
+   if(pHandlers->fpHandleGetValve)
+   {
+      eResponse = pHandlers->fpHandleGetValve(pId, pPosition);  
    }
 
+   ReleaseCommandHandlers(pHandlers);
+
    return eResponse;
 }
 
 /********************************************************************************
  *
- * Name:    GetValvePosition
+ * Name:    GetValvePositionView
  *
- * Purpose: Reads gas valve postion from TSF controller
+ * Purpose: Reads the position of the gas valve named in the request
  *
- * Inputs:  m_cmdBuffer      - message payload
- *          cmdBufferSize  - total length of payload buffer
+ * Inputs:  pPayload - view of the command payload
  *          
- * Outputs: pPositon       - populated with gas valve position
+ * Outputs: pId       - gas selection from the request
+ *          pPosition - populated with gas valve position
  *
- * Returns: None.
+ * Returns: EResponseOk if successful, error code otherwise
  *
- * Notes:   Reads gas valve position for O2 gas for N2O gas
+ * Notes:   TAG_GAS_SELECTION
  *
  *******************************************************************************/
-EHandlerResponse GetValvePosition(EGasId* pId, int* pPosition)
+EHandlerResponse GetValvePositionView(const FrameView* pPayload, EGasId* pId, int* pPosition)
 {
-   EHandlerResponse eResponse = EOpNotAllowed;
+   EHandlerResponse eResponse = CheckPayload(pPayload);
+   ParamValues values;
 
-   if(m_pHandlers.fpHandleGetValve)
+   if (eResponse == EResponseOk)
    {
-      eResponse = m_pHandlers.fpHandleGetValve(pId, pPosition);  
+      eResponse = DecodeParameters(pPayload, m_gasSelectionFields, EGasValue, &values);
+   }
+
+   if (eResponse == EResponseOk)
+   {
+      *pId      = (EGasId)values.nValue[EGasSelection];
+      eResponse = GetValvePosition(pId, pPosition);
    }
 
    return eResponse;
@@ -1818,6 +2330,7 @@ EHandlerResponse GetValvePosition(EGasId* pId, int* pPosition)
  *******************************************************************************/
 EHandlerResponse GetConfiguration(ConfigData* pConfig)
 {
+   const CommandHandlers* pHandlers = AcquireCommandHandlers();
    EHandlerResponse eResponse = EInputBufferError;
 
    // check buffer reference
@@ -1828,13 +2341,15 @@ EHandlerResponse GetConfiguration(ConfigData* pConfig)
 
       eResponse = EOpNotAllowed;
 
-      if(m_pHandlers.fpHandleGetConfigurationData)
+      if(pHandlers->fpHandleGetConfigurationData)
       {
-         eResponse = m_pHandlers.fpHandleGetConfigurationData(pConfig);
+         eResponse = pHandlers->fpHandleGetConfigurationData(pConfig);
       }
 
    }
 
+   ReleaseCommandHandlers(pHandlers);
+
    return eResponse;
 }
 
@@ -1842,12 +2357,11 @@ EHandlerResponse GetConfiguration(ConfigData* pConfig)
 
 /********************************************************************************
  *
- * Name:    EnableDisableVacuum
+ * Name:    EnableDisableVacuumView
  *
  * Purpose: Turns scavenger vacuum on/off
  *
- * Inputs:  m_cmdBuffer      - command payload buffer
- *          cmdBufferSize  - payload buffer length
+ * Inputs:  pPayload - view of the command payload
  *
  * Outputs: None
  *
@@ -1856,10 +2370,31 @@ EHandlerResponse GetConfiguration(ConfigData* pConfig)
  * Notes:   None.
  *
  *******************************************************************************/
+EHandlerResponse EnableDisableVacuumView(const FrameView* pPayload)
+{
+   return HandleSchemaCommand(EEnableDisableVacuum, pPayload);
+}
+
+/********************************************************************************
+ *
+ * Name:    EnableDisableVacuum
+ *
+ * Purpose: Runs EnableDisableVacuumView on a NULL terminated payload.
+ *
+ * Inputs:  pPayload - command payload
+ *
+ * Outputs: See EnableDisableVacuumView
+ *
+ * Returns: EResponseOk if successful, error code otherwise
+ *
+ * Notes:   None
+ *
+ *******************************************************************************/
 EHandlerResponse EnableDisableVacuum(MsgPayload* pPayload)
 {
+   FrameView view = GetPayloadView(pPayload);
 
-   return HandleToggleCommand(pPayload, TAG_SCAV_ENABLED, m_pHandlers.fpHandleEnableDisableVacuum);
+   return EnableDisableVacuumView(&view);
 }
 
 /********************************************************************************
@@ -1880,17 +2415,16 @@ EHandlerResponse EnableDisableVacuum(MsgPayload* pPayload)
  *******************************************************************************/
 EHandlerResponse MuteAlarm()
 {
-   return HandleNoParameterCommand(m_pHandlers.fpHandleMuteAlarm);
+   return HandleSchemaCommand(EMuteAlarm, NULL);
 }
 
 /********************************************************************************
  *
- * Name:    EnableDisableTouchscreenPower
+ * Name:    EnableDisableTouchscreenPowerView
  *
  * Purpose: Turns touchscreen power on/off
  *
- * Inputs:  m_cmdBuffer      - command payload buffer
- *          cmdBufferSize  - command buffer size
+ * Inputs:  pPayload - view of the command payload
  *
  * Outputs: None
  *
@@ -1899,9 +2433,31 @@ EHandlerResponse MuteAlarm()
  * Notes:   TODO:
  *
  *******************************************************************************/
+EHandlerResponse EnableDisableTouchscreenPowerView(const FrameView* pPayload)
+{
+   return HandleSchemaCommand(EEnableDisablePower, pPayload);
+}
+
+/********************************************************************************
+ *
+ * Name:    EnableDisableTouchscreenPower
+ *
+ * Purpose: Runs EnableDisableTouchscreenPowerView on a NULL terminated payload.
+ *
+ * Inputs:  pPayload - command payload
+ *
+ * Outputs: See EnableDisableTouchscreenPowerView
+ *
+ * Returns: EResponseOk if successful, error code otherwise
+ *
+ * Notes:   None
+ *
+ *******************************************************************************/
 EHandlerResponse EnableDisableTouchscreenPower(MsgPayload* pPayload)
 {
-   return HandleToggleCommand(pPayload, TAG_TS_POWER, m_pHandlers.fpHandleEnableDisablePower);
+   FrameView view = GetPayloadView(pPayload);
+
+   return EnableDisableTouchscreenPowerView(&view);
 }
 
 /********************************************************************************
@@ -1922,102 +2478,136 @@ EHandlerResponse EnableDisableTouchscreenPower(MsgPayload* pPayload)
  *******************************************************************************/
 EHandlerResponse FirmwareDownload()
 {
-   return HandleNoParameterCommand(m_pHandlers.fpHandleFirmwareDownload);
+   return HandleSchemaCommand(EFirmwareDownload, NULL);
 }
 
 /********************************************************************************
  *
- * Name:    EnableGasFlow
+ * Name:    FirmwareDownloadAsync
  *
- * Purpose: Enabled/disable gas flow for selected gas type.
+ * Purpose: Runs the firmware download command with its async handler.
  *
- * Inputs:  m_cmdBuffer      - command payload buffer
- *          cmdBufferSize  - command buffer size
+ * Inputs:  token - token from BeginPendingCommand
  *
  * Outputs: None
  *
- * Returns: EResponseOk if successful, error code otherwise
+ * Returns: EPending if the handler answers later with CompleteCommand,
+ *          EOpNotAllowed if there is no async handler
  *
- * Notes:   Parameters expected
- *          TAG_GAS_SELECTION (0 or 1)
- *          TAG_ENABLE_GAS_FLOW (0 or 1)
+ * Notes:   None
  *
  *******************************************************************************/
-EHandlerResponse EnableGasFlow(MsgPayload* pPayload)
+EHandlerResponse FirmwareDownloadAsync(CommandToken token)
 {
-   EHandlerResponse eResponse    = EInputBufferError;
-   char szParam1[TMP_STR_SIZE]   = {0};
-   char szParam2[TMP_STR_SIZE]   = {0};
-   char szTag1[TMP_STR_SIZE]     = {0};
-   char szTag2[TMP_STR_SIZE]     = {0};
-   char szValue1[TMP_STR_SIZE]   = {0};
-   char szValue2[TMP_STR_SIZE]   = {0};
-   EGasId eId;
-   bool bEnabled                 = false;
-   char* pReader                 = NULL;
-   char*  pEnd                   = NULL;
+   const CommandHandlers* pHandlers = AcquireCommandHandlers();
+   EHandlerResponse eResponse = EOpNotAllowed;
 
-   if(pPayload != NULL)
+   if (pHandlers->fpHandleFirmwareDownloadAsync != NULL)
    {
-      eResponse   = EBuffSizeError;
-      pReader     = pPayload->szPayload;
-
-      if (strlen(pPayload->szPayload) < PAYLOAD_LENGTH)
-      {
-         eResponse = EInvalidParameters;
-
-         // tokenize string. Split at the comma
-         StrTokenize(pReader, ",");
-         RestoreDelimiterAndMovePast(&pReader, ',');
+      eResponse = pHandlers->fpHandleFirmwareDownloadAsync(token);
+   }
 
-         StrTokenize(NULL, ",");
+   ReleaseCommandHandlers(pHandlers);
 
-         // copy the first parameter from the payload
-         strcpy(szParam1, pReader);
-         RestoreDelimiterAndMovePast(&pReader, ',');
+   return eResponse;
+}
 
-         // copy the second parameters from the payload
-         strcpy(szParam2, pReader);
+/********************************************************************************
+ *
+ * Name:    BtFirmwareDownloadAsync
+ *
+ * Purpose: Runs the BT firmware download command with its async handler.
+ *
+ * Inputs:  token - token from BeginPendingCommand
+ *
+ * Outputs: None
+ *
+ * Returns: See FirmwareDownloadAsync
+ *
+ * Notes:   None
+ *
+ *******************************************************************************/
+EHandlerResponse BtFirmwareDownloadAsync(CommandToken token)
+{
+   const CommandHandlers* pHandlers = AcquireCommandHandlers();
+   EHandlerResponse eResponse = EOpNotAllowed;
 
-         pReader = szParam1;
+   if (pHandlers->fpHandleBtFirmwareDownloadAsync != NULL)
+   {
+      eResponse = pHandlers->fpHandleBtFirmwareDownloadAsync(token);
+   }
 
-         // split param1 at the equals
-         StrTokenize(pReader, "=");
+   ReleaseCommandHandlers(pHandlers);
 
-         // copy the first parameter tag
-         strcpy(szTag1, pReader);
-         RestoreDelimiterAndMovePast(&pReader, '=');
+   return eResponse;
+}
 
-         // copy the first parameter value from payload
-         strcpy(szValue1, pReader);
-         RestoreDelimiterAndMovePast(&pReader, '=');
+/********************************************************************************
+ *
+ * Name:    EnableGasFlowView
+ *
+ * Purpose: Enabled/disable gas flow for selected gas type.
+ *
+ * Inputs:  pPayload - view of the command payload
+ *
+ * Outputs: None
+ *
+ * Returns: EResponseOk if successful, error code otherwise
+ *
+ * Notes:   Parameters expected, in any order
+ *          TAG_GAS_SELECTION (0 or 1)
+ *          TAG_ENABLE_GAS_FLOW (0 or 1)
+ *
+ *******************************************************************************/
+EHandlerResponse EnableGasFlowView(const FrameView* pPayload)
+{
+   const CommandHandlers* pHandlers = AcquireCommandHandlers();
+   EHandlerResponse eResponse    = CheckPayload(pPayload);
+   ParamValues values;
 
-         pReader = szParam2;
-         StrTokenize(pReader, "=");
-         strcpy(szTag2, pReader);
-         RestoreDelimiterAndMovePast(&pReader, '=');
+   if (eResponse == EResponseOk)
+   {
+      eResponse = DecodeParameters(pPayload, m_gasFlowFields, EGasFieldCount, &values);
+   }
 
-         strcpy(szValue2, pReader);
-         RestoreDelimiterAndMovePast(&pReader, '=');
+   if (eResponse == EResponseOk)
+   {
+      eResponse = EOpNotAllowed;
 
-         // if parameter tags are correct
-         if (strcmp(szTag1, TAG_GAS_SELECTION) == 0
-         &&  strcmp(szTag2, TAG_ENABLE_GAS_FLOW) == 0)
-         {
-            eResponse = EOpNotAllowed;
-            if(m_pHandlers.fpHandleEnableGasFlow)
-            {
-               eId = strtol(szValue1, &pEnd, 10);
-               bEnabled = (bool)strtol(szValue2, &pEnd, 10);
-               eResponse = m_pHandlers.fpHandleEnableGasFlow(eId, bEnabled);
-            }
-         }
+      if(pHandlers->fpHandleEnableGasFlow)
+      {
+         eResponse = pHandlers->fpHandleEnableGasFlow((EGasId)values.nValue[EGasSelection],
+                                                       (bool)values.nValue[EGasValue]);
       }
    }
 
+   ReleaseCommandHandlers(pHandlers);
+
    return eResponse;
 }
 
+/********************************************************************************
+ *
+ * Name:    EnableGasFlow
+ *
+ * Purpose: Runs EnableGasFlowView on a NULL terminated payload.
+ *
+ * Inputs:  pPayload - command payload
+ *
+ * Outputs: See EnableGasFlowView
+ *
+ * Returns: EResponseOk if successful, error code otherwise
+ *
+ * Notes:   None
+ *
+ *******************************************************************************/
+EHandlerResponse EnableGasFlow(MsgPayload* pPayload)
+{
+   FrameView view = GetPayloadView(pPayload);
+
+   return EnableGasFlowView(&view);
+}
+
 /********************************************************************************
  *
  * Name:    BTFirmwareDownload
@@ -2035,7 +2625,7 @@ EHandlerResponse EnableGasFlow(MsgPayload* pPayload)
  *******************************************************************************/
 EHandlerResponse BTFirmwareDownload()
 {
-   return HandleNoParameterCommand(m_pHandlers.fpHandleBtFirmwareDownload);
+   return HandleSchemaCommand(EBtFirmwareDownload, NULL);
 }
 
 /********************************************************************************
@@ -2055,13 +2645,16 @@ EHandlerResponse BTFirmwareDownload()
  *******************************************************************************/
 EHandlerResponse GetScavengerInfo(ScavengerInfo* pInfo)
 {
+   const CommandHandlers* pHandlers = AcquireCommandHandlers();
    EHandlerResponse eResponse = EOpNotAllowed;
 
-   if (m_pHandlers.fpHandleGetScavengerInfo)
+   if (pHandlers->fpHandleGetScavengerInfo)
    {
-      eResponse = m_pHandlers.fpHandleGetScavengerInfo(pInfo);
+      eResponse = pHandlers->fpHandleGetScavengerInfo(pInfo);
    }
 
+   ReleaseCommandHandlers(pHandlers);
+
    return eResponse;
 }
 
@@ -2082,23 +2675,26 @@ EHandlerResponse GetScavengerInfo(ScavengerInfo* pInfo)
  *******************************************************************************/
 EHandlerResponse GetGasVolumeInfo(GasVolumeInfo* pInfo)
 {
+   const CommandHandlers* pHandlers = AcquireCommandHandlers();
    EHandlerResponse eResponse = EOpNotAllowed;
 
-   if (m_pHandlers.fpHandleGetGasVolumeInfo)
+   if (pHandlers->fpHandleGetGasVolumeInfo)
    {
-      eResponse = m_pHandlers.fpHandleGetGasVolumeInfo(pInfo);
+      eResponse = pHandlers->fpHandleGetGasVolumeInfo(pInfo);
    }
 
+   ReleaseCommandHandlers(pHandlers);
+
    return eResponse;
 }
 
 /********************************************************************************
  *
- * Name:    FlushO2
+ * Name:    FlushO2View
  *
  * Purpose: Handles O2 flush command. Sets O2 mix to 100%
  *
- * Inputs:  None
+ * Inputs:  pPayload - view of the command payload
  *          
  * Outputs: None
  *
@@ -2107,114 +2703,174 @@ EHandlerResponse GetGasVolumeInfo(GasVolumeInfo* pInfo)
  * Notes:   None.
  *
  *******************************************************************************/
+EHandlerResponse FlushO2View(const FrameView* pPayload)
+{
+   return HandleSchemaCommand(EFlushO2, pPayload);
+}
+
+/********************************************************************************
+ *
+ * Name:    FlushO2
+ *
+ * Purpose: Runs FlushO2View on a NULL terminated payload.
+ *
+ * Inputs:  pPayload - command payload
+ *
+ * Outputs: See FlushO2View
+ *
+ * Returns: EResponseOk if successful, error code otherwise
+ *
+ * Notes:   None
+ *
+ *******************************************************************************/
 EHandlerResponse FlushO2(MsgPayload* pPayload)
 {
-   EHandlerResponse eResponse = EInputBufferError;
-   char szField[TMP_STR_SIZE] = { 0 };
-   char szValue[TMP_STR_SIZE] = { 0 };
-   char* pReader              = NULL;
-   char* pEnd                 = NULL;
-   bool  bEnabled             = false;
+   FrameView view = GetPayloadView(pPayload);
+
+   return FlushO2View(&view);
+}
+
+/********************************************************************************
+ *
+ * Name:    BtFirmwareDownload
+ *
+ * Purpose: Prepares BT chip for firmware download
+ *
+ * Inputs:  None
+ *          
+ * Outputs: None
+ *
+ * Returns: EResponseOk if successful, error code otherwise
+ *
+ * Notes:   None.
+ *
+ *******************************************************************************/
+EHandlerResponse BtFirmwareDownload()
+{
+   return HandleSchemaCommand(EBtFirmwareDownload, NULL);
+}
+
+/********************************************************************************
+ *
+ * Name:    WriteManufacturersFieldView
+ *
+ * Purpose: Handles the write manufacturer field command.
+ *
+ * Inputs:  pPayload - view of the command payload
+ *          
+ * Outputs: None
+ *
+ * Returns: EResponseOk if successful, error code otherwise
+ *
+ * Notes:   None.
+ *
+ *******************************************************************************/
+EHandlerResponse WriteManufacturersFieldView(const FrameView* pPayload)
+{
+   const CommandHandlers* pHandlers = AcquireCommandHandlers();
+   EHandlerResponse eResponse       = CheckPayload(pPayload);
+   ParamReader reader;
+   FrameView field;
+   FrameView value;
+   char  szFieldName[TMP_STR_SIZE]  = { 0 };
+   char  szFieldValue[TMP_STR_SIZE] = { 0 };
 
-   if(pPayload)
+   // check input buffer and data size before processing
+   if (eResponse == EResponseOk)
    {
-      eResponse = EBuffSizeError;
-      pReader = pPayload->szPayload;
+      eResponse = EInvalidParameters;
+      // skip the command code
+      BeginParameters(&reader, pPayload);
 
-      // check buffer length before processing
-      if(strlen(pPayload->szPayload) <= PAYLOAD_LENGTH)
+      // field name is the tag, value is the rest of the payload
+      if (ReadNamedParameter(&reader, &field, &value))
       {
-         eResponse = EInvalidParameters;
-         // tokenize string, split at the comma
-         // skip the comand code
-         StrTokenize(pReader, ",");
-         RestoreDelimiterAndMovePast(&pReader, ',');
+         // handler takes NULL terminated strings
+         ViewToString(&field, szFieldName, sizeof(szFieldName));
+         ViewToString(&value, szFieldValue, sizeof(szFieldValue));
 
-         // read the field name and value from payload
-         GetTagAndValue(&pReader, szField, szValue);
+         eResponse = EOpNotAllowed;
 
-         // if the tag is for O2 flush
-         if(strcmp(szField, TAG_FLUSH_O2) == 0)
+         // call command handler if it exists
+         if(pHandlers->fpHandleWriteManufacturerField != NULL)
          {
-            bEnabled = (bool)strtol(szValue, &pEnd, 10);
-            if(m_pHandlers.fpHandleO2Flush)
-            {
-               eResponse = m_pHandlers.fpHandleO2Flush(bEnabled);
-            }
+            eResponse = pHandlers->fpHandleWriteManufacturerField(szFieldName, szFieldValue);
          }
       }
    }
 
+   ReleaseCommandHandlers(pHandlers);
+
    return eResponse;
 }
 
 /********************************************************************************
  *
- * Name:    BtFirmwareDownload
+ * Name:    WriteManufacturersField
  *
- * Purpose: Prepares BT chip for firmware download
+ * Purpose: Runs WriteManufacturersFieldView on a NULL terminated payload.
  *
- * Inputs:  None
- *          
- * Outputs: None
+ * Inputs:  pPayload - command payload
+ *
+ * Outputs: See WriteManufacturersFieldView
  *
  * Returns: EResponseOk if successful, error code otherwise
  *
- * Notes:   None.
+ * Notes:   None
  *
  *******************************************************************************/
-EHandlerResponse BtFirmwareDownload()
+EHandlerResponse WriteManufacturersField(MsgPayload* pPayload)
 {
-   return HandleNoParameterCommand(m_pHandlers.fpHandleBtFirmwareDownload);
+   FrameView view = GetPayloadView(pPayload);
+
+   return WriteManufacturersFieldView(&view);
 }
 
 /********************************************************************************
  *
- * Name:    WriteManufacturersField
+ * Name:    ReadManufacturersFieldView
  *
- * Purpose: Handles the write manufacturer field command.
+ * Purpose: Handles reading manufacturers field command from flash.
  *
- * Inputs:  None
+ * Inputs:  pPayload - view of the command payload
  *          
- * Outputs: None
+ * Outputs: pszValue - populated with field value, read from flash
  *
  * Returns: EResponseOk if successful, error code otherwise
  *
  * Notes:   None.
  *
  *******************************************************************************/
-EHandlerResponse WriteManufacturersField(MsgPayload* pPayload)
+EHandlerResponse ReadManufacturersFieldView(const FrameView* pPayload, char* pszValue)
 {
-   EHandlerResponse eResponse = EInputBufferError;
-   char szField[TMP_STR_SIZE] = {0};
-   char szValue[TMP_STR_SIZE] = {0};
-   char* pReader              = NULL;
+   const CommandHandlers* pHandlers = AcquireCommandHandlers();
+   EHandlerResponse eResponse       = CheckPayload(pPayload);
+   ParamReader reader;
+   FrameView value;
+   char  szFieldName[TMP_STR_SIZE]  = { 0 };
 
-   // check buffer before processing
-   if(pPayload != NULL)
+   if (eResponse == EResponseOk)
    {
-      eResponse = EBuffSizeError;
-      pReader   = pPayload->szPayload;
+      eResponse = EInvalidParameters;
+      // skip the command code
+      BeginParameters(&reader, pPayload);
 
-      // check buffer length before processing
-      if(strlen(pPayload->szPayload) < PAYLOAD_LENGTH)
+      // if parameter is the field name
+      if (ReadParameter(&reader, TAG_MF_FIELD, &value))
       {
-         // tokenize string, split at the comma
-         // skip the comand code
-         StrTokenize(pReader, ",");
-         RestoreDelimiterAndMovePast(&pReader, ',');
-
-         // read the field name and value from payload
-         GetTagAndValue(&pReader, szField, szValue);
+         eResponse = EOpNotAllowed;
 
-         // check command handler before executing
-         if(m_pHandlers.fpHandleWriteManufacturerField)
+         // call the command handler
+         if(pHandlers->fpHandleReadManufacturerField != NULL)
          {
-            eResponse = m_pHandlers.fpHandleWriteManufacturerField(szField, szValue);
+            ViewToString(&value, szFieldName, sizeof(szFieldName));
+            eResponse = pHandlers->fpHandleReadManufacturerField(szFieldName, pszValue);
          }
       }
    }
 
+   ReleaseCommandHandlers(pHandlers);
+
    return eResponse;
 }
 
@@ -2222,67 +2878,31 @@ EHandlerResponse WriteManufacturersField(MsgPayload* pPayload)
  *
  * Name:    ReadManufacturersField
  *
- * Purpose: Handles reading manufacturers field command from flash.
+ * Purpose: Runs ReadManufacturersFieldView on a NULL terminated payload.
  *
- * Inputs:  m_cmdBuffer      - command payload buffer
- *          cmdBufferSize  - command buffer size
- *          
- * Outputs: pszValue - populated with field value, read from flash
+ * Inputs:  pPayload - command payload
+ *
+ * Outputs: See ReadManufacturersFieldView
  *
  * Returns: EResponseOk if successful, error code otherwise
  *
- * Notes:   None.
+ * Notes:   None
  *
  *******************************************************************************/
 EHandlerResponse ReadManufacturersField(MsgPayload* pPayload, char* pszValue)
 {
-   EHandlerResponse eResponse = EInputBufferError;
-   char szField[TMP_STR_SIZE] = { 0 };
-   char szValue[TMP_STR_SIZE] = { 0 };
-   char* pReader              = NULL;
-   
-   if(pPayload != NULL)
-   {
-      eResponse = EBuffSizeError;
-      pReader = pPayload->szPayload;
-
-      if (strlen(pPayload->szPayload) < PAYLOAD_LENGTH)
-      {
-         eResponse = EInvalidParameters;
-
-         // tokenize string, split at the comma
-         StrTokenize(pReader, ",");
-
-         // skip command code
-         RestoreDelimiterAndMovePast(&pReader, ',');
-
-         // get the parameter tag and value from command buffer
-         GetTagAndValue(&pReader, szField, szValue);
-
-         // if the tag is manufacturer field name
-         if (strcmp(TAG_MF_FIELD, szField) == 0)
-         {
-            eResponse = EOpNotAllowed;
-
-            if(m_pHandlers.fpHandleReadManufacturerField)
-            {
-               eResponse = m_pHandlers.fpHandleReadManufacturerField(szValue, pszValue);
-            }
-         }
-      }
-   }
+   FrameView view = GetPayloadView(pPayload);
 
-   return eResponse;
+   return ReadManufacturersFieldView(&view, pszValue);
 }
 
 /********************************************************************************
  *
- * Name:    SetMaxN2O
+ * Name:    SetMaxN2OView
  *
  * Purpose: Sets the max value for N2O gas percentage.
  *
- * Inputs:  m_cmdBuffer      - command payload buffer
- *          cmdBufferSize  - command buffer size
+ * Inputs:  pPayload - view of the command payload
  *          
  * Outputs: pszValue - populated with field value, read from flash
  *
@@ -2291,43 +2911,31 @@ EHandlerResponse ReadManufacturersField(MsgPayload* pPayload, char* pszValue)
  * Notes:   Must be 70 or below
  *
  *******************************************************************************/
-EHandlerResponse SetMaxN2O(MsgPayload* pPayload)
+EHandlerResponse SetMaxN2OView(const FrameView* pPayload)
 {
-   EHandlerResponse eResponse = EInputBufferError;
-   char szField[TMP_STR_SIZE] = { 0 };
-   char szValue[TMP_STR_SIZE] = { 0 };
-   char* pReader              = NULL;
-   char* pEnd                 = NULL;
-   uint8_t nMaxValue              = 0;
-   
-   if (pPayload != NULL)
-   {
-
-      pReader = pPayload->szPayload;
-      eResponse = EInvalidParameters;
-
-      // tokenize string, split at the comma
-      StrTokenize(pReader, ",");
-
-      // skip command code
-      RestoreDelimiterAndMovePast(&pReader, ',');
-
-      // get the parameter tag and value from command buffer
-      GetTagAndValue(&pReader, szField, szValue);
+   return HandleSchemaCommand(ESetN2OMax, pPayload);
+}
 
-      // if the tag is manufacturer field name
-      if(strcmp(TAG_N2O_MAX, szField) == 0)
-      {
-         eResponse = EOpNotAllowed;
-         nMaxValue = (uint8_t)strtol(szValue, &pEnd, 10);
-         if (m_pHandlers.fpHandleSetMaxN2OMixPercent)
-         {
-            eResponse = m_pHandlers.fpHandleSetMaxN2OMixPercent(nMaxValue);
-         }
-      }
-   }
+/********************************************************************************
+ *
+ * Name:    SetMaxN2O
+ *
+ * Purpose: Runs SetMaxN2OView on a NULL terminated payload.
+ *
+ * Inputs:  pPayload - command payload
+ *
+ * Outputs: See SetMaxN2OView
+ *
+ * Returns: EResponseOk if successful, error code otherwise
+ *
+ * Notes:   None
+ *
+ *******************************************************************************/
+EHandlerResponse SetMaxN2O(MsgPayload* pPayload)
+{
+   FrameView view = GetPayloadView(pPayload);
 
-   return eResponse;
+   return SetMaxN2OView(&view);
 }
 
 /********************************************************************************
@@ -2348,14 +2956,7 @@ EHandlerResponse SetMaxN2O(MsgPayload* pPayload)
  *******************************************************************************/
 EHandlerResponse GetMaxN2O(int* pMaxValue)
 {
-   EHandlerResponse eResponse = EOpNotAllowed;
-
-   if (m_pHandlers.fpHandleGetMaxN2OMixPercent)
-   {
-      eResponse = m_pHandlers.fpHandleGetMaxN2OMixPercent(pMaxValue);
-   }
-
-   return eResponse;
+   return GetSchemaValue(EGetN2OMax, pMaxValue);
 }
 
 /********************************************************************************
@@ -2376,24 +2977,26 @@ EHandlerResponse GetMaxN2O(int* pMaxValue)
  *******************************************************************************/
 EHandlerResponse GetMixStepSize(EMixStepSize* pStepSize)
 {
+   const CommandHandlers* pHandlers = AcquireCommandHandlers();
    EHandlerResponse eResponse = EOpNotAllowed;
 
-   if (m_pHandlers.fpHandleGetMixStepSize)
+   if (pHandlers->fpHandleGetMixStepSize)
    {
-      eResponse = m_pHandlers.fpHandleGetMixStepSize(pStepSize);
+      eResponse = pHandlers->fpHandleGetMixStepSize(pStepSize);
    }
 
+   ReleaseCommandHandlers(pHandlers);
+
    return eResponse;
 }
 
 /********************************************************************************
  *
- * Name:    SetMixStepSize
+ * Name:    SetMixStepSizeView
  *
  * Purpose: Sets the mix step size value.
  *
- * Inputs:  m_cmdBuffer      - command payload buffer
- *          cmdBufferSize  - command buffer size
+ * Inputs:  pPayload - view of the command payload
  *          
  * Outputs: None
  *
@@ -2402,52 +3005,40 @@ EHandlerResponse GetMixStepSize(EMixStepSize* pStepSize)
  * Notes:   None
  *
  *******************************************************************************/
-EHandlerResponse SetMixStepSize(MsgPayload* pPayload)
+EHandlerResponse SetMixStepSizeView(const FrameView* pPayload)
 {
-   EHandlerResponse eResponse = EInputBufferError;
-   char szField[TMP_STR_SIZE] = { 0 };
-   char szValue[TMP_STR_SIZE] = { 0 };
-   char* pReader              = NULL;
-   char* pEnd                 = NULL;
-   EMixStepSize eStepSize;
-   
-   if (pPayload != NULL)
-   {
-      pReader = pPayload->szPayload;
-      eResponse = EInvalidParameters;
-
-      // tokenize string, split at the comma
-      StrTokenize(pReader, ",");
-
-      // skip command code
-      RestoreDelimiterAndMovePast(&pReader, ',');
-
-      // get the parameter tag and value from command buffer
-      GetTagAndValue(&pReader, szField, szValue);
+   return HandleSchemaCommand(ESetMixStepSize, pPayload);
+}
 
-      // if the tag is manufacturer field name
-      if(strcmp(TAG_MIX_STEP, szField) == 0)
-      {
-         eResponse = EOpNotAllowed;
-         eStepSize = (EMixStepSize)strtol(szValue, &pEnd, 10);
-         if (m_pHandlers.fpHandleSetMixStepSize)
-         {
-            eResponse = m_pHandlers.fpHandleSetMixStepSize(eStepSize);
-         }
-      }
-   }
+/********************************************************************************
+ *
+ * Name:    SetMixStepSize
+ *
+ * Purpose: Runs SetMixStepSizeView on a NULL terminated payload.
+ *
+ * Inputs:  pPayload - command payload
+ *
+ * Outputs: See SetMixStepSizeView
+ *
+ * Returns: EResponseOk if successful, error code otherwise
+ *
+ * Notes:   None
+ *
+ *******************************************************************************/
+EHandlerResponse SetMixStepSize(MsgPayload* pPayload)
+{
+   FrameView view = GetPayloadView(pPayload);
 
-   return eResponse;
+   return SetMixStepSizeView(&view);
 }
 
 /********************************************************************************
  *
- * Name:    SetFlowRateStepSize
+ * Name:    SetFlowRateStepSizeView
  *
  * Purpose: Sets the flow rate step size value.
  *
- * Inputs:  m_cmdBuffer      - command payload buffer
- *          cmdBufferSize  - command buffer size
+ * Inputs:  pPayload - view of the command payload
  *          
  * Outputs: None
  *
@@ -2456,42 +3047,31 @@ EHandlerResponse SetMixStepSize(MsgPayload* pPayload)
  * Notes:   None
  *
  *******************************************************************************/
-EHandlerResponse SetFlowRateStepSize(MsgPayload* pPayload)
+EHandlerResponse SetFlowRateStepSizeView(const FrameView* pPayload)
 {
-   EHandlerResponse eResponse = EInputBufferError;
-   char szField[TMP_STR_SIZE] = { 0 };
-   char szValue[TMP_STR_SIZE] = { 0 };
-   char* pReader              = NULL;
-   char* pEnd                 = NULL;
-   EFlowRateStepSize          eStepSize;
-   
-   if (pPayload != NULL)
-   {
-      pReader = pPayload->szPayload;
-      eResponse = EInvalidParameters;
-
-      // tokenize string, split at the comma
-      StrTokenize(pReader, ",");
-
-      // skip command code
-      RestoreDelimiterAndMovePast(&pReader, ',');
-
-      // get the parameter tag and value from command buffer
-      GetTagAndValue(&pReader, szField, szValue);
+   return HandleSchemaCommand(ESetFlowRateStepSize, pPayload);
+}
 
-      // if the tag is manufacturer field name
-      if(strcmp(TAG_FLOW_STEP, szField) == 0)
-      {
-         eResponse = EOpNotAllowed;
-         eStepSize = (EFlowRateStepSize)strtol(szValue, &pEnd, 10);
-         if (m_pHandlers.fpHandleSetFlowRateStepSize)
-         {
-            eResponse = m_pHandlers.fpHandleSetFlowRateStepSize(eStepSize);
-         }
-      }
-   }
+/********************************************************************************
+ *
+ * Name:    SetFlowRateStepSize
+ *
+ * Purpose: Runs SetFlowRateStepSizeView on a NULL terminated payload.
+ *
+ * Inputs:  pPayload - command payload
+ *
+ * Outputs: See SetFlowRateStepSizeView
+ *
+ * Returns: EResponseOk if successful, error code otherwise
+ *
+ * Notes:   None
+ *
+ *******************************************************************************/
+EHandlerResponse SetFlowRateStepSize(MsgPayload* pPayload)
+{
+   FrameView view = GetPayloadView(pPayload);
 
-   return eResponse;
+   return SetFlowRateStepSizeView(&view);
 }
 
 /********************************************************************************
@@ -2512,13 +3092,16 @@ EHandlerResponse SetFlowRateStepSize(MsgPayload* pPayload)
  *******************************************************************************/
 EHandlerResponse GetFlowRateStepSize(EFlowRateStepSize* pStepSize)
 {
+   const CommandHandlers* pHandlers = AcquireCommandHandlers();
    EHandlerResponse eResponse = EOpNotAllowed;
 
-   if (m_pHandlers.fpHandleGetFlowRateStepSize)
+   if (pHandlers->fpHandleGetFlowRateStepSize)
    {
-      eResponse = m_pHandlers.fpHandleGetFlowRateStepSize(pStepSize);
+      eResponse = pHandlers->fpHandleGetFlowRateStepSize(pStepSize);
    }
 
+   ReleaseCommandHandlers(pHandlers);
+
    return eResponse;
 }
 
@@ -2540,24 +3123,26 @@ EHandlerResponse GetFlowRateStepSize(EFlowRateStepSize* pStepSize)
  *******************************************************************************/
 EHandlerResponse GetClockFormat(EClockFormat* pFormat)
 {
+   const CommandHandlers* pHandlers = AcquireCommandHandlers();
    EHandlerResponse eResponse = EOpNotAllowed;
 
-   if (m_pHandlers.fpHandleGetClockFormat)
+   if (pHandlers->fpHandleGetClockFormat)
    {
-      eResponse = m_pHandlers.fpHandleGetClockFormat(pFormat);
+      eResponse = pHandlers->fpHandleGetClockFormat(pFormat);
    }
 
+   ReleaseCommandHandlers(pHandlers);
+
    return eResponse;
 }
 
 /********************************************************************************
  *
- * Name:    SetClockFormat
+ * Name:    SetClockFormatView
  *
  * Purpose: Sets the clock format
  *
- * Inputs:  m_cmdBuffer      - command payload buffer
- *          cmdBufferSize  - command buffer size
+ * Inputs:  pPayload - view of the command payload
  *          
  * Outputs: None
  *
@@ -2566,41 +3151,31 @@ EHandlerResponse GetClockFormat(EClockFormat* pFormat)
  * Notes:   None
  *
  *******************************************************************************/
-EHandlerResponse SetClockFormat(MsgPayload* pPayload)
+EHandlerResponse SetClockFormatView(const FrameView* pPayload)
 {
-   EHandlerResponse eResponse = EInputBufferError;
-   char szField[TMP_STR_SIZE] = { 0 };
-   char szValue[TMP_STR_SIZE] = { 0 };
-   char* pReader              = NULL;
-   char* pEnd                 = NULL;
-   EClockFormat eFormat;
-   if (pPayload != NULL)
-   {
-      pReader = pPayload->szPayload;
-      eResponse = EInvalidParameters;
-
-      // tokenize string, split at the comma
-      StrTokenize(pReader, ",");
-
-      // skip command code
-      RestoreDelimiterAndMovePast(&pReader, ',');
-
-      // get the parameter tag and value from command buffer
-      GetTagAndValue(&pReader, szField, szValue);
+   return HandleSchemaCommand(ESetClockFormat, pPayload);
+}
 
-      // if the tag is manufacturer field name
-      if(strcmp(TAG_CLOCK_FORMAT, szField) == 0)
-      {
-         eResponse = EOpNotAllowed;
-         eFormat = (EClockFormat)strtol(szValue, &pEnd, 10);
-         if (m_pHandlers.fpHandleSetClockFormat)
-         {
-            eResponse = m_pHandlers.fpHandleSetClockFormat(eFormat);
-         }
-      }
-   }
+/********************************************************************************
+ *
+ * Name:    SetClockFormat
+ *
+ * Purpose: Runs SetClockFormatView on a NULL terminated payload.
+ *
+ * Inputs:  pPayload - command payload
+ *
+ * Outputs: See SetClockFormatView
+ *
+ * Returns: EResponseOk if successful, error code otherwise
+ *
+ * Notes:   None
+ *
+ *******************************************************************************/
+EHandlerResponse SetClockFormat(MsgPayload* pPayload)
+{
+   FrameView view = GetPayloadView(pPayload);
 
-   return eResponse;
+   return SetClockFormatView(&view);
 }
 
 /********************************************************************************
@@ -2621,24 +3196,26 @@ EHandlerResponse SetClockFormat(MsgPayload* pPayload)
  *******************************************************************************/
 EHandlerResponse GetBtStatus(EBtStatus* pStatus)
 {
+   const CommandHandlers* pHandlers = AcquireCommandHandlers();
    EHandlerResponse eResponse = EOpNotAllowed;
 
-   if (m_pHandlers.fpHandleGetBtStatus)
+   if (pHandlers->fpHandleGetBtStatus)
    {
-      eResponse = m_pHandlers.fpHandleGetBtStatus(pStatus);
+      eResponse = pHandlers->fpHandleGetBtStatus(pStatus);
    }
 
+   ReleaseCommandHandlers(pHandlers);
+
    return eResponse;
 }
 
 /********************************************************************************
  *
- * Name:    EnableDisableBt
+ * Name:    EnableDisableBtView
  *
  * Purpose: Enables or disables the BT connectivity on the device.
  *
- * Inputs:  m_cmdBuffer    - command payload buffer
- *          cmdBufferSize  - command buffer size
+ * Inputs:  pPayload - view of the command payload
  *          
  * Outputs: None
  *
@@ -2647,52 +3224,40 @@ EHandlerResponse GetBtStatus(EBtStatus* pStatus)
  * Notes:   None
  *
  *******************************************************************************/
-EHandlerResponse EnableDisableBt(MsgPayload* pPayload)
+EHandlerResponse EnableDisableBtView(const FrameView* pPayload)
 {
-   EHandlerResponse eResponse = EInputBufferError;
-   char szField[TMP_STR_SIZE] = { 0 };
-   char szValue[TMP_STR_SIZE] = { 0 };
-   char* pReader              = NULL;
-   char* pEnd                 = NULL;
-   bool bEnable               = false;
-
-   if (pPayload != NULL)
-   {
-      pReader = pPayload->szPayload;
-      eResponse = EInvalidParameters;
-
-      // tokenize string, split at the comma
-      StrTokenize(pReader, ",");
-
-      // skip command code
-      RestoreDelimiterAndMovePast(&pReader, ',');
-
-      // get the parameter tag and value from command buffer
-      GetTagAndValue(&pReader, szField, szValue);
+   return HandleSchemaCommand(EEnableDisableBT, pPayload);
+}
 
-      // if the tag is manufacturer field name
-      if(strcmp(TAG_BT_ENABLED, szField) == 0)
-      {
-         eResponse = EOpNotAllowed;
-         bEnable = (bool)strtol(szValue, &pEnd, 10);
-         if (m_pHandlers.fpHandleEnableDisableBt)
-         {
-            eResponse = m_pHandlers.fpHandleEnableDisableBt(bEnable);
-         }
-      }
-   }
+/********************************************************************************
+ *
+ * Name:    EnableDisableBt
+ *
+ * Purpose: Runs EnableDisableBtView on a NULL terminated payload.
+ *
+ * Inputs:  pPayload - command payload
+ *
+ * Outputs: See EnableDisableBtView
+ *
+ * Returns: EResponseOk if successful, error code otherwise
+ *
+ * Notes:   None
+ *
+ *******************************************************************************/
+EHandlerResponse EnableDisableBt(MsgPayload* pPayload)
+{
+   FrameView view = GetPayloadView(pPayload);
 
-   return eResponse;
+   return EnableDisableBtView(&view);
 }
 
 /********************************************************************************
  *
- * Name:    ResetGasVolume
+ * Name:    ResetGasVolumeView
  *
  * Purpose: Resets values for gas volume dispensed
  *
- * Inputs:  m_cmdBuffer    - command payload buffer
- *          cmdBufferSize  - command buffer size
+ * Inputs:  pPayload - view of the command payload
  *          
  * Outputs: None
  *
@@ -2701,42 +3266,29 @@ EHandlerResponse EnableDisableBt(MsgPayload* pPayload)
  * Notes:   None
  *
  *******************************************************************************/
-EHandlerResponse ResetGasVolume(MsgPayload* pPayload)
+EHandlerResponse ResetGasVolumeView(const FrameView* pPayload)
 {
-   EHandlerResponse eResponse = EInputBufferError;
-   char szField[TMP_STR_SIZE] = { 0 };
-   char szValue[TMP_STR_SIZE] = { 0 };
-   char* pReader              = NULL;
-   char* pEnd                 = NULL;
-   EGasId eId                 = EGasIdMax;
-
-   if (pPayload != NULL)
-   {
-      eResponse = EBuffSizeError;
-      pReader = pPayload->szPayload;
-
-      eResponse = EInvalidParameters;
-
-      // tokenize string, split at the comma
-      StrTokenize(pReader, ",");
-
-      // skip command code
-      RestoreDelimiterAndMovePast(&pReader, ',');
-
-      // get the parameter tag and value from command buffer
-      GetTagAndValue(&pReader, szField, szValue);
+   return HandleSchemaCommand(EResetGasVolume, pPayload);
+}
 
-      // if the tag is manufacturer field name
-      if(strcmp(TAG_GAS_SELECTION, szField) == 0)
-      {
-         eResponse = EOpNotAllowed;
-         eId = (EGasId)strtol(szValue, &pEnd, 10);
-         if (m_pHandlers.fpHandleResetGasVolumeInfo)
-         {
-            eResponse = m_pHandlers.fpHandleResetGasVolumeInfo(eId);
-         }
-      }
-   }
+/********************************************************************************
+ *
+ * Name:    ResetGasVolume
+ *
+ * Purpose: Runs ResetGasVolumeView on a NULL terminated payload.
+ *
+ * Inputs:  pPayload - command payload
+ *
+ * Outputs: See ResetGasVolumeView
+ *
+ * Returns: EResponseOk if successful, error code otherwise
+ *
+ * Notes:   None
+ *
+ *******************************************************************************/
+EHandlerResponse ResetGasVolume(MsgPayload* pPayload)
+{
+   FrameView view = GetPayloadView(pPayload);
 
-   return eResponse;
+   return ResetGasVolumeView(&view);
 }
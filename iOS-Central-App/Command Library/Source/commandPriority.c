@@ -0,0 +1,359 @@
+/*********************************************************************************
+*
+*                          Proprietary Information of
+*
+*                            Precision Systems, Inc.
+*                    1355 Business Center Drive, Suite C
+*                                 Horsham, PA
+*                               (215) 672-1860
+*
+*                   Copyright (C) 2020, Precision Systems, Inc.
+*                            All Rights Reserved
+*
+*             The information and design as detailed in this document is
+*     the property of Precision Systems, Inc., and/or its Associates
+*     and must be returned on demand. It is issued on the strict
+*     condition that except with our written permission it must not be
+*     reproduced, copied or communicated to any third party, nor be
+*     used for any purpose other than that stated in the particular
+*     inquiry, order or contract with which it is issued. The
+*     reservation of copyright in this document extends from each date
+*     appearing thereon and in respect of the subject matter as it
+*     appeared at the relevant date.
+*
+********************************************************************************/
+/********************************************************************************
+*
+* PROJECT:     Project MIDAS
+*
+* COMPILER:    
+*
+* TOOLS:       Microsoft Visual Studio 2019
+*
+* DESCRIPTION: Priority lanes for sending and running commands
+*
+* NOTES:       The lanes are fixed rings, nothing is allocated.
+*
+********************************************************************************/
+#include <string.h>
+#include "commandPriority.h"
+#include "commandSetpoints.h"
+
+/*********************************************************************************
+*                    F U N C T I O N   D E F I N I T I O N S
+*********************************************************************************/
+/********************************************************************************
+ *
+ * Name:    CommandPriority
+ *
+ * Purpose: Finds the class of a command
+ *
+ * Inputs:  eCode - command code
+ *
+ * Outputs: None
+ *
+ * Returns: Command class, control for a code that isn't listed
+ *
+ * Notes:   Responses carry the code of their request, so a response is in
+ *          the class of its request.
+ *
+ *******************************************************************************/
+LIB_API
+ECommandPriority CommandPriority(ECommandCode eCode)
+{
+   ECommandPriority ePriority = ECommandPriorityControl;
+
+   switch (eCode)
+   {
+   case EStopGas:
+   case EMuteAlarm:
+   case EEndProcedure:
+      ePriority = ECommandPrioritySafety;
+      break;
+
+   case EGetProcedureList:
+   case EGetProcedureLog:
+   case EGetProcedureEntryList:
+   case EGetAlarmLogList:
+   case EFirmwareDownload:
+   case EBtFirmwareDownload:
+   case EWriteManufacturerField:
+   case EReadManufacturerField:
+      ePriority = ECommandPriorityBulk;
+      break;
+
+   default:
+      break;
+   }
+
+   return ePriority;
+}
+
+/********************************************************************************
+ *
+ * Name:    PriorityLanes_Init
+ *
+ * Purpose: Empties all lanes.
+ *
+ * Inputs:  None
+ *
+ * Outputs: pLanes - nothing queued
+ *
+ * Returns: None
+ *
+ * Notes:   None
+ *
+ *******************************************************************************/
+LIB_API
+void PriorityLanes_Init(PriorityLanes* pLanes)
+{
+   memset(pLanes, 0, sizeof(*pLanes));
+}
+
+/********************************************************************************
+ *
+ * Name:    SendLane_PutRequest
+ *
+ * Purpose: Queues a request at the tail of a lane
+ *
+ * Inputs:  pLane           - lane
+ *          pRequest        - request payload, built and ready for framing
+ *          eCode           - command code of the request
+ *          pRequestContext - handed back with the response
+ *
+ * Outputs: pLane - request queued
+ *
+ * Returns: false if the lane is full
+ *
+ * Notes:   None.
+ *
+ *******************************************************************************/
+LIB_API
+bool SendLane_PutRequest(SendLane* pLane, const MsgPayload* pRequest, ECommandCode eCode, void* pRequestContext)
+{
+   QueuedSend* pSend = NULL;
+   bool bQueued      = (pLane->nCount < PRIORITY_LANE_DEPTH);
+
+   if (bQueued)
+   {
+      pSend = &pLane->sends[(pLane->nHead + pLane->nCount) % PRIORITY_LANE_DEPTH];
+
+      pSend->eCode           = eCode;
+      pSend->pRequestContext = pRequestContext;
+      pSend->bTransfer       = false;
+      pSend->payload         = *pRequest;
+      pLane->nCount++;
+   }
+
+   return bQueued;
+}
+
+/********************************************************************************
+ *
+ * Name:    SendLane_PutTransfer
+ *
+ * Purpose: Queues a logical message at the tail of a lane
+ *
+ * Inputs:  pLane      - lane
+ *          pRequest   - request the message answers, may be NULL
+ *          eCode      - command code of the request
+ *          nMessageId - transport message id
+ *          pMessage   - logical message
+ *          nLength    - number of bytes in pMessage
+ *
+ * Outputs: pLane - transfer queued
+ *
+ * Returns: false if the lane is full or the message is empty or too long
+ *
+ * Notes:   Only the sequence number of pRequest is kept.
+ *
+ *******************************************************************************/
+LIB_API
+bool SendLane_PutTransfer(SendLane* pLane,
+                          const MsgPayload* pRequest,
+                          ECommandCode eCode,
+                          uint8_t nMessageId,
+                          const char* pMessage,
+                          size_t nLength)
+{
+   QueuedSend* pSend = NULL;
+   bool bQueued      = (pLane->nCount < PRIORITY_LANE_DEPTH);
+
+   if (bQueued)
+   {
+      pSend   = &pLane->sends[(pLane->nHead + pLane->nCount) % PRIORITY_LANE_DEPTH];
+      bQueued = Transport_BeginSend(&pSend->transfer, nMessageId, pMessage, nLength);
+   }
+
+   if (bQueued)
+   {
+      pSend->eCode              = eCode;
+      pSend->pRequestContext    = NULL;
+      pSend->bTransfer          = true;
+      pSend->payload.bSequenced = (pRequest != NULL) && pRequest->bSequenced;
+      pSend->payload.nSequence  = (pRequest != NULL) ? pRequest->nSequence : 0;
+      pLane->nCount++;
+   }
+
+   return bQueued;
+}
+
+/********************************************************************************
+ *
+ * Name:    SendLane_Head
+ *
+ * Purpose: Returns the request or transfer to send next from a lane.
+ *
+ * Inputs:  pLane - lane
+ *
+ * Outputs: None
+ *
+ * Returns: Head of the lane, NULL if it is empty
+ *
+ * Notes:   None
+ *
+ *******************************************************************************/
+LIB_API
+QueuedSend* SendLane_Head(SendLane* pLane)
+{
+   return (pLane->nCount > 0) ? &pLane->sends[pLane->nHead] : NULL;
+}
+
+/********************************************************************************
+ *
+ * Name:    SendLane_Pop
+ *
+ * Purpose: Removes the head of a lane.
+ *
+ * Inputs:  pLane - lane
+ *
+ * Outputs: pLane - head removed
+ *
+ * Returns: None
+ *
+ * Notes:   None
+ *
+ *******************************************************************************/
+LIB_API
+void SendLane_Pop(SendLane* pLane)
+{
+   if (pLane->nCount > 0)
+   {
+      pLane->nHead = (pLane->nHead + 1) % PRIORITY_LANE_DEPTH;
+      pLane->nCount--;
+   }
+}
+
+/********************************************************************************
+ *
+ * Name:    FrameLane_Put
+ *
+ * Purpose: Queues a received command at the tail of a lane
+ *
+ * Inputs:  pLane         - lane
+ *          pFrame        - received command
+ *          nControlFirst - control commands that must run before it
+ *
+ * Outputs: pLane - command queued
+ *
+ * Returns: false if the lane is full
+ *
+ * Notes:   None.
+ *
+ *******************************************************************************/
+LIB_API
+bool FrameLane_Put(FrameLane* pLane, const MessageFrame* pFrame, size_t nControlFirst)
+{
+   QueuedFrame* pQueued = NULL;
+   bool bQueued         = (pLane->nCount < PRIORITY_LANE_DEPTH);
+
+   if (bQueued)
+   {
+      pQueued = &pLane->frames[(pLane->nHead + pLane->nCount) % PRIORITY_LANE_DEPTH];
+
+      pQueued->frame         = *pFrame;
+      pQueued->nControlFirst = nControlFirst;
+      pLane->nCount++;
+   }
+
+   return bQueued;
+}
+
+/********************************************************************************
+ *
+ * Name:    FrameLane_Head
+ *
+ * Purpose: Returns the command to run next from a lane.
+ *
+ * Inputs:  pLane - lane
+ *
+ * Outputs: None
+ *
+ * Returns: Head of the lane, NULL if it is empty
+ *
+ * Notes:   None
+ *
+ *******************************************************************************/
+LIB_API
+QueuedFrame* FrameLane_Head(FrameLane* pLane)
+{
+   return (pLane->nCount > 0) ? &pLane->frames[pLane->nHead] : NULL;
+}
+
+/********************************************************************************
+ *
+ * Name:    FrameLane_Pop
+ *
+ * Purpose: Removes the head of a lane.
+ *
+ * Inputs:  pLane - lane
+ *
+ * Outputs: pLane - head removed
+ *
+ * Returns: None
+ *
+ * Notes:   None
+ *
+ *******************************************************************************/
+LIB_API
+void FrameLane_Pop(FrameLane* pLane)
+{
+   if (pLane->nCount > 0)
+   {
+      pLane->nHead = (pLane->nHead + 1) % PRIORITY_LANE_DEPTH;
+      pLane->nCount--;
+   }
+}
+
+/********************************************************************************
+ *
+ * Name:    FrameLane_CountToLastSetpoint
+ *
+ * Purpose: Counts the commands from the head of a lane to its last setpoint
+ *
+ * Inputs:  pLane - lane
+ *
+ * Outputs: None
+ *
+ * Returns: Number of commands up to and including the last setpoint command,
+ *          0 if the lane holds none
+ *
+ * Notes:   None.
+ *
+ *******************************************************************************/
+LIB_API
+size_t FrameLane_CountToLastSetpoint(const FrameLane* pLane)
+{
+   size_t nCount = 0;
+   size_t nIdx   = 0;
+
+   for (nIdx = 0; nIdx < pLane->nCount; nIdx++)
+   {
+      if (IsSetpointCommand(pLane->frames[(pLane->nHead + nIdx) % PRIORITY_LANE_DEPTH].frame.eCmdType))
+      {
+         nCount = nIdx + 1;
+      }
+   }
+
+   return nCount;
+}
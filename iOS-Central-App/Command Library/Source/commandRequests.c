@@ -0,0 +1,333 @@
+/*********************************************************************************
+*
+*                          Proprietary Information of
+*
+*                            Precision Systems, Inc.
+*                    1355 Business Center Drive, Suite C
+*                                 Horsham, PA
+*                               (215) 672-1860
+*
+*                   Copyright (C) 2020, Precision Systems, Inc.
+*                            All Rights Reserved
+*
+*             The information and design as detailed in this document is
+*     the property of Precision Systems, Inc., and/or its Associates
+*     and must be returned on demand. It is issued on the strict
+*     condition that except with our written permission it must not be
+*     reproduced, copied or communicated to any third party, nor be
+*     used for any purpose other than that stated in the particular
+*     inquiry, order or contract with which it is issued. The
+*     reservation of copyright in this document extends from each date
+*     appearing thereon and in respect of the subject matter as it
+*     appeared at the relevant date.
+*
+********************************************************************************/
+/********************************************************************************
+*
+* PROJECT:     Project MIDAS
+*
+* COMPILER:    
+*
+* TOOLS:       Microsoft Visual Studio 2019
+*
+* DESCRIPTION: Outstanding request table for pipelined requests
+*
+* NOTES:       The table is small, so lookups walk all of it.
+*
+********************************************************************************/
+#include <string.h>
+#include "commandRequests.h"
+#include "commandFramework.h"
+
+/*********************************************************************************
+*                        H E L P E R   F U N C T I O N S
+*********************************************************************************/
+/********************************************************************************
+ *
+ * Name:    FindSequence
+ *
+ * Purpose: Finds the outstanding request with a sequence number
+ *
+ * Inputs:  pTable    - request table
+ *          nSequence - sequence number to look for
+ *
+ * Outputs: None
+ *
+ * Returns: Matching request, NULL if there is none
+ *
+ * Notes:   None.
+ *
+ *******************************************************************************/
+static PendingRequest* FindSequence(RequestTable* pTable, uint16_t nSequence)
+{
+   PendingRequest* pFound = NULL;
+   size_t nIdx            = 0;
+
+   for (nIdx = 0; nIdx < REQUEST_TABLE_SIZE && pFound == NULL; nIdx++)
+   {
+      if (pTable->requests[nIdx].bInUse && pTable->requests[nIdx].nSequence == nSequence)
+      {
+         pFound = &pTable->requests[nIdx];
+      }
+   }
+
+   return pFound;
+}
+
+/********************************************************************************
+ *
+ * Name:    RemoveRequest
+ *
+ * Purpose: Takes a request out of the table
+ *
+ * Inputs:  pTable - request table
+ *          pEntry - request to remove
+ *
+ * Outputs: pRequest - copy of the request, may be NULL
+ *
+ * Returns: None
+ *
+ * Notes:   None.
+ *
+ *******************************************************************************/
+static void RemoveRequest(RequestTable* pTable, PendingRequest* pEntry, PendingRequest* pRequest)
+{
+   if (pRequest != NULL)
+   {
+      *pRequest = *pEntry;
+   }
+
+   pEntry->bInUse = false;
+   pTable->nOutstanding--;
+}
+
+/*********************************************************************************
+*                    F U N C T I O N   D E F I N I T I O N S
+*********************************************************************************/
+/********************************************************************************
+ *
+ * Name:    RequestTable_Init
+ *
+ * Purpose: Empties a request table
+ *
+ * Inputs:  None
+ *
+ * Outputs: pTable - no requests outstanding
+ *
+ * Returns: None
+ *
+ * Notes:   None.
+ *
+ *******************************************************************************/
+LIB_API
+void RequestTable_Init(RequestTable* pTable)
+{
+   memset(pTable, 0, sizeof(*pTable));
+}
+
+/********************************************************************************
+ *
+ * Name:    RequestTable_Add
+ *
+ * Purpose: Records a request about to be sent
+ *
+ * Inputs:  pRequest - request payload, built and ready for framing
+ *          eCode    - command code of the request
+ *          nNow     - current time
+ *          pContext - caller data returned with the response
+ *
+ * Outputs: pTable   - request added
+ *          pRequest - bSequenced and nSequence set
+ *
+ * Returns: false if the table is full
+ *
+ * Notes:   Sequence numbers still held by a slow request are skipped.
+ *
+ *******************************************************************************/
+LIB_API
+bool RequestTable_Add(RequestTable* pTable,
+                      MsgPayload* pRequest,
+                      ECommandCode eCode,
+                      uint32_t nNow,
+                      void* pContext)
+{
+   PendingRequest* pEntry = NULL;
+   size_t nIdx            = 0;
+   bool bAdded            = false;
+
+   if (pTable->nOutstanding < REQUEST_TABLE_SIZE)
+   {
+      for (nIdx = 0; nIdx < REQUEST_TABLE_SIZE && pEntry == NULL; nIdx++)
+      {
+         if (!pTable->requests[nIdx].bInUse)
+         {
+            pEntry = &pTable->requests[nIdx];
+         }
+      }
+
+      while (FindSequence(pTable, pTable->nNextSequence) != NULL)
+      {
+         pTable->nNextSequence = (uint16_t)((pTable->nNextSequence + 1) % FRAME_SEQUENCE_COUNT);
+      }
+
+      pEntry->bInUse    = true;
+      pEntry->nSequence = pTable->nNextSequence;
+      pEntry->eCode     = eCode;
+      pEntry->nSentTime = nNow;
+      pEntry->pContext  = pContext;
+      pTable->nOutstanding++;
+      pTable->nNextSequence = (uint16_t)((pTable->nNextSequence + 1) % FRAME_SEQUENCE_COUNT);
+
+      pRequest->bSequenced = true;
+      pRequest->nSequence  = pEntry->nSequence;
+      bAdded = true;
+   }
+
+   return bAdded;
+}
+
+/********************************************************************************
+ *
+ * Name:    RequestTable_Complete
+ *
+ * Purpose: Matches a response to its request and removes the request
+ *
+ * Inputs:  nSequence - sequence number of the response frame
+ *          eCode     - command code of the response frame
+ *
+ * Outputs: pTable   - request removed
+ *          pRequest - the request answered, may be NULL
+ *
+ * Returns: false if no outstanding request matches
+ *
+ * Notes:   A response with the right sequence number but the wrong command
+ *          code is a stray and leaves the request waiting. So is a transport
+ *          fragment, see RequestTable_CompleteTransport.
+ *
+ *******************************************************************************/
+LIB_API
+bool RequestTable_Complete(RequestTable* pTable,
+                           uint16_t nSequence,
+                           ECommandCode eCode,
+                           PendingRequest* pRequest)
+{
+   PendingRequest* pEntry = FindSequence(pTable, nSequence);
+   bool bMatched          = false;
+
+   if (pEntry != NULL
+   && (eCode == pEntry->eCode || eCode == EAck || eCode == ENak))
+   {
+      RemoveRequest(pTable, pEntry, pRequest);
+      bMatched = true;
+   }
+
+   return bMatched;
+}
+
+/********************************************************************************
+ *
+ * Name:    RequestTable_CompleteTransport
+ *
+ * Purpose: Matches a transport response to its request once it is whole
+ *
+ * Inputs:  nSequence - sequence number of the fragment frames
+ *          eResult   - result of Transport_AddFragment for the last fragment
+ *          pMessage  - message from Transport_AddFragment
+ *
+ * Outputs: pTable   - request removed
+ *          pRequest - the request answered, may be NULL
+ *
+ * Returns: false if the message isn't complete or no request matches
+ *
+ * Notes:   Until the last fragment arrives the request keeps waiting, so
+ *          RequestTable_Expire still times out a transfer that stalls. The
+ *          command code inside the message must be the request's.
+ *
+ *******************************************************************************/
+LIB_API
+bool RequestTable_CompleteTransport(RequestTable* pTable,
+                                    uint16_t nSequence,
+                                    ETransportResult eResult,
+                                    const FrameView* pMessage,
+                                    PendingRequest* pRequest)
+{
+   PendingRequest* pEntry = FindSequence(pTable, nSequence);
+   ECommandCode eCode     = ECommandCodeMin;
+   bool bMatched          = false;
+
+   if (pEntry != NULL
+   &&  eResult == ETransportMessageDone
+   &&  pMessage != NULL
+   &&  ParsePayloadCommandCode(pMessage, &eCode) == MFR_OK
+   &&  eCode == pEntry->eCode)
+   {
+      RemoveRequest(pTable, pEntry, pRequest);
+      bMatched = true;
+   }
+
+   return bMatched;
+}
+
+/********************************************************************************
+ *
+ * Name:    RequestTable_Expire
+ *
+ * Purpose: Removes a request that has waited too long
+ *
+ * Inputs:  nNow     - current time
+ *          nTimeout - time a request may wait for its response
+ *
+ * Outputs: pTable   - request removed
+ *          pRequest - the request that timed out, may be NULL
+ *
+ * Returns: false if no request has timed out
+ *
+ * Notes:   Unsigned time differences, so the clock may wrap.
+ *
+ *******************************************************************************/
+LIB_API
+bool RequestTable_Expire(RequestTable* pTable,
+                         uint32_t nNow,
+                         uint32_t nTimeout,
+                         PendingRequest* pRequest)
+{
+   PendingRequest* pEntry = NULL;
+   size_t nIdx            = 0;
+
+   for (nIdx = 0; nIdx < REQUEST_TABLE_SIZE && pEntry == NULL; nIdx++)
+   {
+      if (pTable->requests[nIdx].bInUse
+      &&  nNow - pTable->requests[nIdx].nSentTime >= nTimeout)
+      {
+         pEntry = &pTable->requests[nIdx];
+      }
+   }
+
+   if (pEntry != NULL)
+   {
+      RemoveRequest(pTable, pEntry, pRequest);
+   }
+
+   return pEntry != NULL;
+}
+
+/********************************************************************************
+ *
+ * Name:    RequestTable_Outstanding
+ *
+ * Purpose: Returns the number of requests waiting for a response
+ *
+ * Inputs:  None
+ *
+ * Outputs: None
+ *
+ * Returns: Number of outstanding requests
+ *
+ * Notes:   None.
+ *
+ *******************************************************************************/
+LIB_API
+size_t RequestTable_Outstanding(const RequestTable* pTable)
+{
+   return pTable->nOutstanding;
+}
@@ -0,0 +1,815 @@
+/*********************************************************************************
+*
+*                          Proprietary Information of
+*
+*                            Precision Systems, Inc.
+*                    1355 Business Center Drive, Suite C
+*                                 Horsham, PA
+*                               (215) 672-1860
+*
+*                   Copyright (C) 2020, Precision Systems, Inc.
+*                            All Rights Reserved
+*
+*             The information and design as detailed in this document is
+*     the property of Precision Systems, Inc., and/or its Associates
+*     and must be returned on demand. It is issued on the strict
+*     condition that except with our written permission it must not be
+*     reproduced, copied or communicated to any third party, nor be
+*     used for any purpose other than that stated in the particular
+*     inquiry, order or contract with which it is issued. The
+*     reservation of copyright in this document extends from each date
+*     appearing thereon and in respect of the subject matter as it
+*     appeared at the relevant date.
+*
+********************************************************************************/
+/********************************************************************************
+*
+* PROJECT:     Project MIDAS
+*
+* COMPILER:    
+*
+* TOOLS:       Microsoft Visual Studio 2019
+*
+* DESCRIPTION: Fast search of receive buffers for frame boundaries, and of
+*              payloads for parameter delimiters
+*
+* NOTES:       The vector paths compare 16 or 32 bytes at a time and turn
+*              the result into a bit mask, one bit per byte. The lowest set
+*              bit is the first match.
+*
+********************************************************************************/
+#include <string.h>
+#include "commandScanner.h"
+#include "commandFramework.h"
+#include "commandDecimal.h"
+#include "commandAtomic.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+   #include <emmintrin.h>
+   #define SCANNER_SSE2
+#endif
+
+#if defined(__AVX2__)
+   #include <immintrin.h>
+   #define SCANNER_AVX2
+#elif defined(SCANNER_SSE2) && defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+   // AVX2 built for this function only, used if the CPU has it
+   #include <immintrin.h>
+   #define SCANNER_AVX2
+   #define SCANNER_AVX2_DISPATCH
+#endif
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+   #include <arm_neon.h>
+   #define SCANNER_NEON
+#endif
+
+/********************************************************************************
+*                          D E F I N I T I O N S
+********************************************************************************/
+// bytes from STX to the first payload byte
+#define FRAME_HEADER_BYTES (1 + FRAME_LENGTH_DIGITS + 1)
+
+// payload bytes classified per call, one bit each in a 64 bit mask
+#define STRUCTURAL_BLOCK 64
+
+typedef size_t(*FnScanForByte)(const char* pBuffer, size_t nLength, char ch);
+typedef void(*FnStructuralMasks)(const char* pBlock, uint64_t* pnCommas, uint64_t* pnEquals);
+
+/*********************************************************************************
+*                    F U N C T I O N   P R O T O T Y P E S
+*********************************************************************************/
+static size_t ScanForByteScalar(const char* pBuffer, size_t nLength, char ch);
+
+/*********************************************************************************
+*                               D A T A
+*********************************************************************************/
+#ifdef SCANNER_AVX2_DISPATCH
+// selected on first use
+static FnScanForByte m_fpScanForByte = NULL;
+static FnStructuralMasks m_fpStructuralMasks = NULL;
+#endif
+
+/*********************************************************************************
+*                    F U N C T I O N   D E F I N I T I O N S
+*********************************************************************************/
+/********************************************************************************
+ *
+ * Name:    FirstSetBit
+ *
+ * Purpose: Returns the index of the lowest set bit in a match mask
+ *
+ * Inputs:  nMask - match mask, must not be 0
+ *
+ * Outputs: None
+ *
+ * Returns: Bit index
+ *
+ * Notes:   None
+ *
+ *******************************************************************************/
+static size_t FirstSetBit(uint64_t nMask)
+{
+#if defined(__GNUC__)
+   return (size_t)__builtin_ctzll(nMask);
+#else
+   size_t nBit = 0;
+
+   while ((nMask & 1) == 0)
+   {
+      nMask >>= 1;
+      nBit++;
+   }
+
+   return nBit;
+#endif
+}
+
+/********************************************************************************
+ *
+ * Name:    ScanForByteScalar
+ *
+ * Purpose: Byte at a time search, used for short tails and on targets
+ *          without vector instructions
+ *
+ * Inputs:  pBuffer - data to search
+ *          nLength - number of bytes in pBuffer
+ *          ch      - byte to look for
+ *
+ * Outputs: None
+ *
+ * Returns: Offset of the byte, nLength if it isn't found
+ *
+ * Notes:   None
+ *
+ *******************************************************************************/
+static size_t ScanForByteScalar(const char* pBuffer, size_t nLength, char ch)
+{
+   const char* pFound = NULL;
+
+   if (nLength > 0)
+   {
+      pFound = memchr(pBuffer, ch, nLength);
+   }
+
+   return (pFound != NULL) ? (size_t)(pFound - pBuffer) : nLength;
+}
+
+#ifdef SCANNER_SSE2
+/********************************************************************************
+ *
+ * Name:    ScanForByteSse2
+ *
+ * Purpose: Searches 16 bytes at a time
+ *
+ * Inputs:  pBuffer - data to search
+ *          nLength - number of bytes in pBuffer
+ *          ch      - byte to look for
+ *
+ * Outputs: None
+ *
+ * Returns: Offset of the byte, nLength if it isn't found
+ *
+ * Notes:   None
+ *
+ *******************************************************************************/
+static size_t ScanForByteSse2(const char* pBuffer, size_t nLength, char ch)
+{
+   const __m128i needle = _mm_set1_epi8(ch);
+   size_t nOffset       = 0;
+   int nMask            = 0;
+
+   for (nOffset = 0; nOffset + 16 <= nLength; nOffset += 16)
+   {
+      nMask = _mm_movemask_epi8(_mm_cmpeq_epi8(_mm_loadu_si128((const __m128i*)(pBuffer + nOffset)), needle));
+
+      if (nMask != 0)
+      {
+         return nOffset + FirstSetBit((uint64_t)(unsigned int)nMask);
+      }
+   }
+
+   return nOffset + ScanForByteScalar(pBuffer + nOffset, nLength - nOffset, ch);
+}
+#endif
+
+#ifdef SCANNER_AVX2
+/********************************************************************************
+ *
+ * Name:    ScanForByteAvx2
+ *
+ * Purpose: Searches 32 bytes at a time
+ *
+ * Inputs:  pBuffer - data to search
+ *          nLength - number of bytes in pBuffer
+ *          ch      - byte to look for
+ *
+ * Outputs: None
+ *
+ * Returns: Offset of the byte, nLength if it isn't found
+ *
+ * Notes:   None
+ *
+ *******************************************************************************/
+#ifdef SCANNER_AVX2_DISPATCH
+__attribute__((target("avx2")))
+#endif
+static size_t ScanForByteAvx2(const char* pBuffer, size_t nLength, char ch)
+{
+   const __m256i needle = _mm256_set1_epi8(ch);
+   size_t nOffset       = 0;
+   int nMask            = 0;
+
+   for (nOffset = 0; nOffset + 32 <= nLength; nOffset += 32)
+   {
+      nMask = _mm256_movemask_epi8(_mm256_cmpeq_epi8(_mm256_loadu_si256((const __m256i*)(pBuffer + nOffset)), needle));
+
+      if (nMask != 0)
+      {
+         return nOffset + FirstSetBit((uint64_t)(unsigned int)nMask);
+      }
+   }
+
+   return nOffset + ScanForByteSse2(pBuffer + nOffset, nLength - nOffset, ch);
+}
+#endif
+
+#ifdef SCANNER_NEON
+/********************************************************************************
+ *
+ * Name:    ScanForByteNeon
+ *
+ * Purpose: Searches 16 bytes at a time
+ *
+ * Inputs:  pBuffer - data to search
+ *          nLength - number of bytes in pBuffer
+ *          ch      - byte to look for
+ *
+ * Outputs: None
+ *
+ * Returns: Offset of the byte, nLength if it isn't found
+ *
+ * Notes:   NEON has no movemask. Narrowing the compare result by 4 bits
+ *          gives a 64 bit mask with 4 bits per byte instead.
+ *
+ *******************************************************************************/
+static size_t ScanForByteNeon(const char* pBuffer, size_t nLength, char ch)
+{
+   const uint8x16_t needle = vdupq_n_u8((uint8_t)ch);
+   uint8x16_t equal;
+   uint64_t nMask          = 0;
+   size_t nOffset          = 0;
+
+   for (nOffset = 0; nOffset + 16 <= nLength; nOffset += 16)
+   {
+      equal = vceqq_u8(vld1q_u8((const uint8_t*)(pBuffer + nOffset)), needle);
+      nMask = vget_lane_u64(vreinterpret_u64_u8(vshrn_n_u16(vreinterpretq_u16_u8(equal), 4)), 0);
+
+      if (nMask != 0)
+      {
+         return nOffset + (FirstSetBit(nMask) >> 2);
+      }
+   }
+
+   return nOffset + ScanForByteScalar(pBuffer + nOffset, nLength - nOffset, ch);
+}
+#endif
+
+/********************************************************************************
+ *
+ * Name:    ScanForByte
+ *
+ * Purpose: Finds the first occurrence of a byte in a buffer
+ *
+ * Inputs:  pBuffer - data to search
+ *          nLength - number of bytes in pBuffer
+ *          ch      - byte to look for
+ *
+ * Outputs: None
+ *
+ * Returns: Offset of the byte, nLength if it isn't found
+ *
+ * Notes:   Picks the widest search the build and CPU support.
+ *
+ *******************************************************************************/
+LIB_API
+size_t ScanForByte(const char* pBuffer, size_t nLength, char ch)
+{
+#if defined(SCANNER_AVX2_DISPATCH)
+   FnScanForByte fpScanForByte = LOAD_ACQUIRE(m_fpScanForByte);
+
+   if (fpScanForByte == NULL)
+   {
+      __builtin_cpu_init();
+      fpScanForByte = __builtin_cpu_supports("avx2") ? ScanForByteAvx2 : ScanForByteSse2;
+      STORE_RELEASE(m_fpScanForByte, fpScanForByte);
+   }
+
+   return fpScanForByte(pBuffer, nLength, ch);
+#elif defined(SCANNER_AVX2)
+   return ScanForByteAvx2(pBuffer, nLength, ch);
+#elif defined(SCANNER_SSE2)
+   return ScanForByteSse2(pBuffer, nLength, ch);
+#elif defined(SCANNER_NEON)
+   return ScanForByteNeon(pBuffer, nLength, ch);
+#else
+   return ScanForByteScalar(pBuffer, nLength, ch);
+#endif
+}
+
+/********************************************************************************
+ *
+ * Name:    IsFrameCandidate
+ *
+ * Purpose: Checks that an STX starts something shaped like a frame
+ *
+ * Inputs:  pBuffer - data starting at the STX
+ *          nLength - number of bytes in pBuffer
+ *
+ * Outputs: None
+ *
+ * Returns: true if every byte that can be checked fits a frame
+ *
+ * Notes:   Checks the length digits, the separator after them, that the
+ *          length fits a payload, and the ETX at the end of the frame.
+ *
+ *******************************************************************************/
+static bool IsFrameCandidate(const char* pBuffer, size_t nLength)
+{
+   uint32_t nPayloadLength    = 0;
+   EFrameIntegrity eIntegrity = EFrameIntegritySum8;
+   size_t nEtx                = 0;
+   size_t nCount              = nLength - 1;
+
+   // length digits, as many of them as are in the buffer
+   if (nCount > FRAME_LENGTH_DIGITS)
+   {
+      nCount = FRAME_LENGTH_DIGITS;
+   }
+
+   if (!DecimalParse(pBuffer + 1, nCount, &nPayloadLength))
+   {
+      return false;
+   }
+
+   if (nCount < FRAME_LENGTH_DIGITS)
+   {
+      return true;
+   }
+
+   nCount = 1 + FRAME_LENGTH_DIGITS;
+
+   if (nPayloadLength >= PAYLOAD_LENGTH)
+   {
+      return false;
+   }
+
+   if (nCount >= nLength)
+   {
+      return true;
+   }
+
+   // the separator selects the length of the frame check
+   if (!ReadFrameSeparator(pBuffer[nCount], &eIntegrity))
+   {
+      return false;
+   }
+
+   nEtx = FRAME_HEADER_BYTES + nPayloadLength + FrameCheckDigits(eIntegrity);
+
+   return nEtx >= nLength || pBuffer[nEtx] == ETX;
+}
+
+/********************************************************************************
+ *
+ * Name:    FindNextFrame
+ *
+ * Purpose: Skips garbage up to the next plausible frame
+ *
+ * Inputs:  pBuffer - data to search
+ *          nLength - number of bytes in pBuffer
+ *
+ * Outputs: None
+ *
+ * Returns: Number of bytes skipped. nLength if no frame starts in pBuffer.
+ *
+ * Notes:   STX bytes inside a corrupted frame are rejected by the length
+ *          and ETX checks instead of being taken as a new frame.
+ *
+ *******************************************************************************/
+LIB_API
+size_t FindNextFrame(const char* pBuffer, size_t nLength)
+{
+   size_t nOffset = 0;
+
+   if (pBuffer == NULL)
+   {
+      return 0;
+   }
+
+   while (nOffset < nLength)
+   {
+      nOffset += ScanForByte(pBuffer + nOffset, nLength - nOffset, STX);
+
+      if (nOffset == nLength
+      ||  IsFrameCandidate(pBuffer + nOffset, nLength - nOffset))
+      {
+         break;
+      }
+
+      nOffset++;
+   }
+
+   return nOffset;
+}
+
+#if !defined(SCANNER_SSE2) && !(defined(SCANNER_NEON) && defined(__aarch64__))
+/********************************************************************************
+ *
+ * Name:    StructuralMasksScalar
+ *
+ * Purpose: Marks the commas and equals signs in a block, a byte at a time
+ *
+ * Inputs:  pBlock - STRUCTURAL_BLOCK bytes of payload
+ *
+ * Outputs: pnCommas - bit n set if byte n is ','
+ *          pnEquals - bit n set if byte n is '='
+ *
+ * Returns: None
+ *
+ * Notes:   None
+ *
+ *******************************************************************************/
+static void StructuralMasksScalar(const char* pBlock, uint64_t* pnCommas, uint64_t* pnEquals)
+{
+   size_t nCount = 0;
+
+   *pnCommas = 0;
+   *pnEquals = 0;
+
+   for (nCount = 0; nCount < STRUCTURAL_BLOCK; nCount++)
+   {
+      if (pBlock[nCount] == ',')
+      {
+         *pnCommas |= (uint64_t)1 << nCount;
+      }
+      else if (pBlock[nCount] == '=')
+      {
+         *pnEquals |= (uint64_t)1 << nCount;
+      }
+   }
+}
+#endif
+
+#if defined(SCANNER_SSE2) && (!defined(SCANNER_AVX2) || defined(SCANNER_AVX2_DISPATCH))
+/********************************************************************************
+ *
+ * Name:    StructuralMasksSse2
+ *
+ * Purpose: Marks the commas and equals signs in a block, 16 bytes at a time
+ *
+ * Inputs:  pBlock - STRUCTURAL_BLOCK bytes of payload
+ *
+ * Outputs: pnCommas - bit n set if byte n is ','
+ *          pnEquals - bit n set if byte n is '='
+ *
+ * Returns: None
+ *
+ * Notes:   None
+ *
+ *******************************************************************************/
+static void StructuralMasksSse2(const char* pBlock, uint64_t* pnCommas, uint64_t* pnEquals)
+{
+   const __m128i comma  = _mm_set1_epi8(',');
+   const __m128i equals = _mm_set1_epi8('=');
+   __m128i data;
+   size_t nOffset       = 0;
+
+   *pnCommas = 0;
+   *pnEquals = 0;
+
+   for (nOffset = 0; nOffset < STRUCTURAL_BLOCK; nOffset += 16)
+   {
+      data = _mm_loadu_si128((const __m128i*)(pBlock + nOffset));
+      *pnCommas |= (uint64_t)(unsigned int)_mm_movemask_epi8(_mm_cmpeq_epi8(data, comma)) << nOffset;
+      *pnEquals |= (uint64_t)(unsigned int)_mm_movemask_epi8(_mm_cmpeq_epi8(data, equals)) << nOffset;
+   }
+}
+#endif
+
+#ifdef SCANNER_AVX2
+/********************************************************************************
+ *
+ * Name:    StructuralMasksAvx2
+ *
+ * Purpose: Marks the commas and equals signs in a block, 32 bytes at a time
+ *
+ * Inputs:  pBlock - STRUCTURAL_BLOCK bytes of payload
+ *
+ * Outputs: pnCommas - bit n set if byte n is ','
+ *          pnEquals - bit n set if byte n is '='
+ *
+ * Returns: None
+ *
+ * Notes:   None
+ *
+ *******************************************************************************/
+#ifdef SCANNER_AVX2_DISPATCH
+__attribute__((target("avx2")))
+#endif
+static void StructuralMasksAvx2(const char* pBlock, uint64_t* pnCommas, uint64_t* pnEquals)
+{
+   const __m256i comma  = _mm256_set1_epi8(',');
+   const __m256i equals = _mm256_set1_epi8('=');
+   __m256i data;
+   size_t nOffset       = 0;
+
+   *pnCommas = 0;
+   *pnEquals = 0;
+
+   for (nOffset = 0; nOffset < STRUCTURAL_BLOCK; nOffset += 32)
+   {
+      data = _mm256_loadu_si256((const __m256i*)(pBlock + nOffset));
+      *pnCommas |= (uint64_t)(unsigned int)_mm256_movemask_epi8(_mm256_cmpeq_epi8(data, comma)) << nOffset;
+      *pnEquals |= (uint64_t)(unsigned int)_mm256_movemask_epi8(_mm256_cmpeq_epi8(data, equals)) << nOffset;
+   }
+}
+#endif
+
+#if defined(SCANNER_NEON) && defined(__aarch64__)
+/********************************************************************************
+ *
+ * Name:    NeonMask64
+ *
+ * Purpose: Packs four compare results into a 64 bit mask, one bit per byte
+ *
+ * Inputs:  match0 - match3 - compare results for 64 consecutive bytes
+ *
+ * Outputs: None
+ *
+ * Returns: Bit n set if byte n matched
+ *
+ * Notes:   Each byte keeps one bit of its position in a group of 8, then
+ *          pairwise adds fold the groups together.
+ *
+ *******************************************************************************/
+static uint64_t NeonMask64(uint8x16_t match0, uint8x16_t match1, uint8x16_t match2, uint8x16_t match3)
+{
+   const uint8x16_t weights = { 1, 2, 4, 8, 16, 32, 64, 128, 1, 2, 4, 8, 16, 32, 64, 128 };
+   uint8x16_t sum0 = vpaddq_u8(vandq_u8(match0, weights), vandq_u8(match1, weights));
+   uint8x16_t sum1 = vpaddq_u8(vandq_u8(match2, weights), vandq_u8(match3, weights));
+
+   sum0 = vpaddq_u8(sum0, sum1);
+   sum0 = vpaddq_u8(sum0, sum0);
+
+   return vgetq_lane_u64(vreinterpretq_u64_u8(sum0), 0);
+}
+
+/********************************************************************************
+ *
+ * Name:    StructuralMasksNeon
+ *
+ * Purpose: Marks the commas and equals signs in a block, 16 bytes at a time
+ *
+ * Inputs:  pBlock - STRUCTURAL_BLOCK bytes of payload
+ *
+ * Outputs: pnCommas - bit n set if byte n is ','
+ *          pnEquals - bit n set if byte n is '='
+ *
+ * Returns: None
+ *
+ * Notes:   AArch64 only, it needs the 128 bit pairwise add.
+ *
+ *******************************************************************************/
+static void StructuralMasksNeon(const char* pBlock, uint64_t* pnCommas, uint64_t* pnEquals)
+{
+   const uint8x16_t comma  = vdupq_n_u8(',');
+   const uint8x16_t equals = vdupq_n_u8('=');
+   uint8x16_t data0 = vld1q_u8((const uint8_t*)pBlock);
+   uint8x16_t data1 = vld1q_u8((const uint8_t*)pBlock + 16);
+   uint8x16_t data2 = vld1q_u8((const uint8_t*)pBlock + 32);
+   uint8x16_t data3 = vld1q_u8((const uint8_t*)pBlock + 48);
+
+   *pnCommas = NeonMask64(vceqq_u8(data0, comma),  vceqq_u8(data1, comma),
+                          vceqq_u8(data2, comma),  vceqq_u8(data3, comma));
+   *pnEquals = NeonMask64(vceqq_u8(data0, equals), vceqq_u8(data1, equals),
+                          vceqq_u8(data2, equals), vceqq_u8(data3, equals));
+}
+#endif
+
+/********************************************************************************
+ *
+ * Name:    StructuralMasks
+ *
+ * Purpose: Marks the commas and equals signs in a block
+ *
+ * Inputs:  pBlock - STRUCTURAL_BLOCK bytes of payload
+ *
+ * Outputs: pnCommas - bit n set if byte n is ','
+ *          pnEquals - bit n set if byte n is '='
+ *
+ * Returns: None
+ *
+ * Notes:   Picks the widest compare the build and CPU support.
+ *
+ *******************************************************************************/
+static void StructuralMasks(const char* pBlock, uint64_t* pnCommas, uint64_t* pnEquals)
+{
+#if defined(SCANNER_AVX2_DISPATCH)
+   FnStructuralMasks fpStructuralMasks = LOAD_ACQUIRE(m_fpStructuralMasks);
+
+   if (fpStructuralMasks == NULL)
+   {
+      __builtin_cpu_init();
+      fpStructuralMasks = __builtin_cpu_supports("avx2") ? StructuralMasksAvx2 : StructuralMasksSse2;
+      STORE_RELEASE(m_fpStructuralMasks, fpStructuralMasks);
+   }
+
+   fpStructuralMasks(pBlock, pnCommas, pnEquals);
+#elif defined(SCANNER_AVX2)
+   StructuralMasksAvx2(pBlock, pnCommas, pnEquals);
+#elif defined(SCANNER_SSE2)
+   StructuralMasksSse2(pBlock, pnCommas, pnEquals);
+#elif defined(SCANNER_NEON) && defined(__aarch64__)
+   StructuralMasksNeon(pBlock, pnCommas, pnEquals);
+#else
+   StructuralMasksScalar(pBlock, pnCommas, pnEquals);
+#endif
+}
+
+/********************************************************************************
+ *
+ * Name:    BuildFieldIndex
+ *
+ * Purpose: Finds every ',' and '=' in an ASCII payload in one pass
+ *
+ * Inputs:  pData   - payload, not NULL terminated
+ *          nLength - number of bytes in pData, must be under 256
+ *
+ * Outputs: pIndex - start, '=' and end of each field
+ *
+ * Returns: false if the payload is too long to index
+ *
+ * Notes:   Each block of 64 bytes is compared once against both delimiters.
+ *          The set bits are then walked in order, so finding a field is a
+ *          table lookup instead of a search. The last partial block is
+ *          copied into a padded buffer so no load reads past the payload.
+ *
+ *******************************************************************************/
+LIB_API
+bool BuildFieldIndex(const char* pData, size_t nLength, FieldIndex* pIndex)
+{
+   char szBlock[STRUCTURAL_BLOCK];
+   const char* pBlock = NULL;
+   uint64_t nCommas   = 0;
+   uint64_t nEquals   = 0;
+   uint64_t nMask     = 0;
+   size_t nOffset     = 0;
+   size_t nBit        = 0;
+   size_t nField      = 0;
+   bool bEqualsFound  = false;
+   bool bBuilt        = false;
+
+   if (pIndex != NULL)
+   {
+      pIndex->pData      = pData;
+      pIndex->nFields    = 0;
+      pIndex->bTruncated = false;
+
+      if (pData != NULL && nLength <= UINT8_MAX)
+      {
+         pIndex->nStart[0] = 0;
+
+         for (nOffset = 0; nOffset < nLength && !pIndex->bTruncated; nOffset += STRUCTURAL_BLOCK)
+         {
+            pBlock = pData + nOffset;
+
+            if (nLength - nOffset < STRUCTURAL_BLOCK)
+            {
+               memset(szBlock, 0, sizeof(szBlock));
+               memcpy(szBlock, pBlock, nLength - nOffset);
+               pBlock = szBlock;
+            }
+
+            StructuralMasks(pBlock, &nCommas, &nEquals);
+
+            for (nMask = nCommas | nEquals; nMask != 0 && !pIndex->bTruncated; nMask &= nMask - 1)
+            {
+               nBit = FirstSetBit(nMask);
+
+               if ((nCommas >> nBit) & 1)
+               {
+                  // close this field, the next starts after the comma
+                  pIndex->nEnd[nField] = (uint8_t)(nOffset + nBit);
+
+                  if (!bEqualsFound)
+                  {
+                     pIndex->nEquals[nField] = pIndex->nEnd[nField];
+                  }
+
+                  if (++nField == FIELD_INDEX_MAX)
+                  {
+                     pIndex->bTruncated = true;
+                  }
+                  else
+                  {
+                     pIndex->nStart[nField] = (uint8_t)(nOffset + nBit + 1);
+                     bEqualsFound = false;
+                  }
+               }
+               else if (!bEqualsFound)
+               {
+                  pIndex->nEquals[nField] = (uint8_t)(nOffset + nBit);
+                  bEqualsFound = true;
+               }
+            }
+         }
+
+         // last field runs to the end of the payload
+         if (!pIndex->bTruncated)
+         {
+            pIndex->nEnd[nField] = (uint8_t)nLength;
+
+            if (!bEqualsFound)
+            {
+               pIndex->nEquals[nField] = (uint8_t)nLength;
+            }
+
+            nField++;
+         }
+
+         pIndex->nFields = (uint8_t)nField;
+         bBuilt = true;
+      }
+   }
+
+   return bBuilt;
+}
+
+/********************************************************************************
+ *
+ * Name:    FieldIndex_Field
+ *
+ * Purpose: Returns a whole field
+ *
+ * Inputs:  pIndex - index from BuildFieldIndex
+ *          nField - field number, the command code is field 0
+ *
+ * Outputs: pField - the field, without its comma
+ *
+ * Returns: false if the payload has no such field
+ *
+ * Notes:   None
+ *
+ *******************************************************************************/
+LIB_API
+bool FieldIndex_Field(const FieldIndex* pIndex, size_t nField, FrameView* pField)
+{
+   bool bFound = (pIndex != NULL && nField < pIndex->nFields);
+
+   if (bFound)
+   {
+      pField->pData   = pIndex->pData + pIndex->nStart[nField];
+      pField->nLength = (size_t)(pIndex->nEnd[nField] - pIndex->nStart[nField]);
+   }
+
+   return bFound;
+}
+
+/********************************************************************************
+ *
+ * Name:    FieldIndex_TagAndValue
+ *
+ * Purpose: Returns the tag and value of a TAG=value field
+ *
+ * Inputs:  pIndex - index from BuildFieldIndex
+ *          nField - field number, the command code is field 0
+ *
+ * Outputs: pTag   - text before the first '='
+ *          pValue - text after it
+ *
+ * Returns: false if the payload has no such field
+ *
+ * Notes:   A field without '=' is all tag and an empty value.
+ *
+ *******************************************************************************/
+LIB_API
+bool FieldIndex_TagAndValue(const FieldIndex* pIndex, size_t nField, FrameView* pTag, FrameView* pValue)
+{
+   bool bFound = (pIndex != NULL && nField < pIndex->nFields);
+   size_t nEquals = 0;
+   size_t nEnd    = 0;
+
+   if (bFound)
+   {
+      nEquals = pIndex->nEquals[nField];
+      nEnd    = pIndex->nEnd[nField];
+
+      pTag->pData     = pIndex->pData + pIndex->nStart[nField];
+      pTag->nLength   = nEquals - pIndex->nStart[nField];
+      pValue->pData   = pIndex->pData + ((nEquals < nEnd) ? nEquals + 1 : nEnd);
+      pValue->nLength = (nEquals < nEnd) ? nEnd - nEquals - 1 : 0;
+   }
+
+   return bFound;
+}
@@ -0,0 +1,1309 @@
+/*********************************************************************************
+*
+*                          Proprietary Information of
+*
+*                            Precision Systems, Inc.
+*                    1355 Business Center Drive, Suite C
+*                                 Horsham, PA
+*                               (215) 672-1860
+*
+*                   Copyright (C) 2020, Precision Systems, Inc.
+*                            All Rights Reserved
+*
+*             The information and design as detailed in this document is
+*     the property of Precision Systems, Inc., and/or its Associates
+*     and must be returned on demand. It is issued on the strict
+*     condition that except with our written permission it must not be
+*     reproduced, copied or communicated to any third party, nor be
+*     used for any purpose other than that stated in the particular
+*     inquiry, order or contract with which it is issued. The
+*     reservation of copyright in this document extends from each date
+*     appearing thereon and in respect of the subject matter as it
+*     appeared at the relevant date.
+*
+********************************************************************************/
+/********************************************************************************
+*
+* PROJECT:     Project MIDAS
+*
+* COMPILER:    
+*
+* TOOLS:       Microsoft Visual Studio 2019
+*
+* DESCRIPTION: Protocol sessions, one per connected device
+*
+* NOTES:       The current session is kept per thread. Every CmdSession
+*              function enters its session and leaves it before returning,
+*              so they may be nested, e.g. from inside a handler.
+*
+*              The lookup tables built on first use (CRC, binary tags,
+*              checksum and scanner code paths) are the same for every
+*              session. CmdSession_Init builds them, so sessions initialised
+*              before their threads start never race to build them.
+*
+********************************************************************************/
+#include <string.h>
+#include "commandAtomic.h"
+#include "commandSession.h"
+#include "commandDispatch.h"
+#include "commandBinary.h"
+#include "commandBuilder.h"
+#include "commandChecksum.h"
+#include "commandScanner.h"
+
+/********************************************************************************
+*                          D E F I N I T I O N S
+********************************************************************************/
+// bytes run through each shared routine, long enough for the vector paths
+#define WARM_UP_BYTES 128
+
+/*********************************************************************************
+*                               D A T A
+*********************************************************************************/
+// used outside CmdSession_Enter. All zero is a valid session with no
+// handlers, sum8 frames and ASCII payloads
+static CmdSession m_defaultSession;
+
+// current session of this thread, NULL for m_defaultSession
+static THREAD_LOCAL CmdSession* m_pCurrent = NULL;
+
+/*********************************************************************************
+*                        H E L P E R   F U N C T I O N S
+*********************************************************************************/
+/********************************************************************************
+ *
+ * Name:    BuildSharedTables
+ *
+ * Purpose: Picks the CPU routines and builds the tag table the library
+ *          otherwise sets up on first use
+ *
+ * Inputs:  None
+ *
+ * Outputs: None
+ *
+ * Returns: None
+ *
+ * Notes:   Runs a dummy payload through each of them. Setting them up on
+ *          first use is thread safe as well, this only keeps that cost off
+ *          the first command. The CRC tables are constants and need none.
+ *
+ *******************************************************************************/
+static void BuildSharedTables(void)
+{
+   char szBytes[WARM_UP_BYTES];
+   ChecksumState checksum;
+   FieldIndex index;
+   size_t nIdx = 0;
+
+   for (nIdx = 0; nIdx < sizeof(szBytes); nIdx++)
+   {
+      szBytes[nIdx] = (nIdx % 2 == 0) ? 'A' : ',';
+   }
+
+   ChecksumInit(&checksum);
+   ChecksumUpdate(&checksum, szBytes, sizeof(szBytes));
+   ScanForByte(szBytes, sizeof(szBytes), STX);
+   BuildFieldIndex(szBytes, sizeof(szBytes), &index);
+   ParamTagLookup(TAG_O2_MIX, sizeof(TAG_O2_MIX) - 1);
+}
+
+/********************************************************************************
+ *
+ * Name:    DispatchReceived
+ *
+ * Purpose: Runs a received frame and writes its response
+ *
+ * Inputs:  pSession - session
+ *          pFrame   - received frame
+ *
+ * Outputs: None
+ *
+ * Returns: None
+ *
+ * Notes:   A frame with no response from DispatchFrame is a response, ACK,
+ *          NAK or transport fragment, unless its command went to an async
+ *          handler.
+ *
+ *          Commands CanDispatch refuses go to fpResponse with no request,
+ *          so the application can answer them. Without fpResponse they
+ *          are answered with EOpNotAllowed.
+ *
+ *******************************************************************************/
+static void DispatchReceived(CmdSession* pSession, const MessageFrame* pFrame)
+{
+   PendingRequest request;
+   MsgPayload response;
+   EHandlerResponse eResponse = EOpNotAllowed;
+   FrameView payload;
+
+   payload.pData   = pFrame->payload.szPayload;
+   payload.nLength = pFrame->payload.nLength;
+
+   if (pFrame->bChecksumOk
+   &&  pSession->fpResponse != NULL
+   &&  !CanDispatch(pFrame->eCmdType)
+   &&  !IsResponsePayload(&payload))
+   {
+      // a command the application runs itself, e.g. a log list
+      pSession->fpResponse(pSession->pContext, pFrame, NULL);
+   }
+   else
+   {
+      eResponse = DispatchFrame(pFrame, &response);
+
+      if (response.nLength > 0)
+      {
+         CmdSession_SendPayload(pSession, &response);
+      }
+      else if (eResponse != EPending && pFrame->bChecksumOk && pSession->fpResponse != NULL)
+      {
+         if (pFrame->payload.bSequenced
+         &&  RequestTable_Complete(&pSession->requests, pFrame->payload.nSequence, pFrame->eCmdType, &request))
+         {
+            pSession->fpResponse(pSession->pContext, pFrame, &request);
+         }
+         else
+         {
+            pSession->fpResponse(pSession->pContext, pFrame, NULL);
+         }
+      }
+   }
+}
+
+/********************************************************************************
+ *
+ * Name:    TakeReceivedSetpoint
+ *
+ * Purpose: Takes a received setpoint held for merging
+ *
+ * Inputs:  pSession - session
+ *
+ * Outputs: pFrame - the setpoint as a received frame
+ *
+ * Returns: false if no setpoint is held
+ *
+ * Notes:   None.
+ *
+ *******************************************************************************/
+static bool TakeReceivedSetpoint(CmdSession* pSession, MessageFrame* pFrame)
+{
+   bool bTaken = SetpointQueue_Flush(&pSession->rxSetpoints, &pFrame->eCmdType, &pFrame->payload);
+
+   if (bTaken)
+   {
+      pFrame->eIntegrity  = pSession->eIntegrity;
+      pFrame->bStxFound   = true;
+      pFrame->bEtxFound   = true;
+      pFrame->bChecksumOk = true;
+   }
+
+   return bTaken;
+}
+
+/********************************************************************************
+ *
+ * Name:    RunReceivedSetpoints
+ *
+ * Purpose: Runs the received setpoints held for merging
+ *
+ * Inputs:  pSession - session
+ *
+ * Outputs: None
+ *
+ * Returns: None
+ *
+ * Notes:   None.
+ *
+ *******************************************************************************/
+static void RunReceivedSetpoints(CmdSession* pSession)
+{
+   MessageFrame frame;
+
+   while (TakeReceivedSetpoint(pSession, &frame))
+   {
+      DispatchReceived(pSession, &frame);
+   }
+}
+
+/********************************************************************************
+ *
+ * Name:    MergeReceivedSetpoint
+ *
+ * Purpose: Holds a received setpoint command, replacing an older one
+ *
+ * Inputs:  pSession - session
+ *          pFrame   - received setpoint command
+ *
+ * Outputs: None
+ *
+ * Returns: false if the frame couldn't be held and must be run now
+ *
+ * Notes:   The command replaced is answered as accepted.
+ *
+ *******************************************************************************/
+static bool MergeReceivedSetpoint(CmdSession* pSession, const MessageFrame* pFrame)
+{
+   MsgPayload replaced;
+   MsgPayload response;
+   ESetpointResult eResult = SetpointQueue_Put(&pSession->rxSetpoints, pFrame->eCmdType, &pFrame->payload, 0, &replaced);
+
+   if (eResult == ESetpointReplaced)
+   {
+      BuildCommandEchoResponse(EResponseOk, pFrame->eCmdType, &replaced, &response);
+
+      // answered with the sequence number it was asked with
+      response.bSequenced = replaced.bSequenced;
+      response.nSequence  = replaced.nSequence;
+      CmdSession_SendPayload(pSession, &response);
+   }
+
+   return eResult != ESetpointNotQueued;
+}
+
+/********************************************************************************
+ *
+ * Name:    RunHeldFrames
+ *
+ * Purpose: Runs the received commands held by a session
+ *
+ * Inputs:  pSession - session
+ *
+ * Outputs: None
+ *
+ * Returns: None
+ *
+ * Notes:   The lanes run highest class first. Control commands run before
+ *          a safety command are counted against the ones it must wait for.
+ *          Setpoints held for merging came after every held safety command,
+ *          see HoldReceived, so they run once the safety lane is empty and
+ *          ahead of the other control commands.
+ *
+ *******************************************************************************/
+static void RunHeldFrames(CmdSession* pSession)
+{
+   FrameLane* pSafety  = &pSession->lanes.received[ECommandPrioritySafety];
+   FrameLane* pControl = &pSession->lanes.received[ECommandPriorityControl];
+   FrameLane* pBulk    = &pSession->lanes.received[ECommandPriorityBulk];
+   FrameLane* pLane    = NULL;
+   size_t nControlRun  = 0;
+
+   do
+   {
+      pLane = NULL;
+
+      if (FrameLane_Head(pSafety) == NULL)
+      {
+         RunReceivedSetpoints(pSession);
+      }
+
+      if (FrameLane_Head(pSafety) != NULL && FrameLane_Head(pSafety)->nControlFirst <= nControlRun)
+      {
+         pLane = pSafety;
+      }
+      else if (FrameLane_Head(pControl) != NULL)
+      {
+         pLane = pControl;
+         nControlRun++;
+      }
+      else if (FrameLane_Head(pBulk) != NULL)
+      {
+         pLane = pBulk;
+      }
+
+      if (pLane != NULL)
+      {
+         DispatchReceived(pSession, &FrameLane_Head(pLane)->frame);
+         FrameLane_Pop(pLane);
+      }
+   } while (pLane != NULL);
+}
+
+/********************************************************************************
+ *
+ * Name:    LaneReceivedSetpoints
+ *
+ * Purpose: Moves the received setpoints held for merging to the control lane
+ *
+ * Inputs:  pSession - session
+ *
+ * Outputs: None
+ *
+ * Returns: None
+ *
+ * Notes:   Done before a safety command is held behind another one, so
+ *          the setpoints that came between them are counted among the
+ *          control commands it waits for. If one doesn't fit in the lane,
+ *          everything held runs first and then it.
+ *
+ *******************************************************************************/
+static void LaneReceivedSetpoints(CmdSession* pSession)
+{
+   FrameLane* pControl = &pSession->lanes.received[ECommandPriorityControl];
+   MessageFrame frame;
+
+   while (TakeReceivedSetpoint(pSession, &frame))
+   {
+      if (!FrameLane_Put(pControl, &frame, 0))
+      {
+         RunHeldFrames(pSession);
+         DispatchReceived(pSession, &frame);
+      }
+   }
+}
+
+/********************************************************************************
+ *
+ * Name:    HoldReceived
+ *
+ * Purpose: Holds a received command in the lane of its class
+ *
+ * Inputs:  pSession - session
+ *          pFrame   - received command
+ *
+ * Outputs: None
+ *
+ * Returns: false if its lane is full and it must be run now
+ *
+ * Notes:   A safety command overtakes held control commands, except that
+ *          setpoints held before it, in the control lane or for merging,
+ *          still run first.
+ *
+ *******************************************************************************/
+static bool HoldReceived(CmdSession* pSession, const MessageFrame* pFrame)
+{
+   PriorityLanes* pLanes      = &pSession->lanes;
+   ECommandPriority ePriority = CommandPriority(pFrame->eCmdType);
+   size_t nControlFirst       = 0;
+
+   if (ePriority == ECommandPrioritySafety)
+   {
+      // setpoints held for merging came before it, so they run before it
+      if (FrameLane_Head(&pLanes->received[ECommandPrioritySafety]) == NULL)
+      {
+         RunReceivedSetpoints(pSession);
+      }
+      else
+      {
+         LaneReceivedSetpoints(pSession);
+      }
+
+      nControlFirst = FrameLane_CountToLastSetpoint(&pLanes->received[ECommandPriorityControl]);
+   }
+
+   return FrameLane_Put(&pLanes->received[ePriority], pFrame, nControlFirst);
+}
+
+/********************************************************************************
+ *
+ * Name:    SessionFrameDecoded
+ *
+ * Purpose: Handles a frame received by a session's decoder
+ *
+ * Inputs:  pContext - session
+ *          eResult  - MFR_OK, or why the frame was rejected
+ *          pFrame   - received frame
+ *
+ * Outputs: None
+ *
+ * Returns: None
+ *
+ * Notes:   Frames that failed their check are passed to DispatchFrame so
+ *          the device is told. Held commands run before any frame that
+ *          isn't held.
+ *
+ *******************************************************************************/
+static void SessionFrameDecoded(void* pContext, MessageFrameResult eResult, MessageFrame* pFrame)
+{
+   CmdSession* pSession = (CmdSession*)pContext;
+   FrameView payload;
+   bool bHeld           = false;
+
+   if (eResult == MFR_OK || eResult == MFR_CHKSUM_ERR)
+   {
+      payload.pData   = pFrame->payload.szPayload;
+      payload.nLength = pFrame->payload.nLength;
+
+      if (pSession->bMergeReceived
+      &&  pFrame->bChecksumOk
+      &&  IsSetpointCommand(pFrame->eCmdType)
+      && !IsResponsePayload(&payload))
+      {
+         bHeld = MergeReceivedSetpoint(pSession, pFrame);
+      }
+
+      if (!bHeld
+      &&  pSession->bPrioritizeReceived
+      &&  pFrame->bChecksumOk
+      &&  CanDispatch(pFrame->eCmdType)
+      && !IsResponsePayload(&payload))
+      {
+         bHeld = HoldReceived(pSession, pFrame);
+      }
+
+      if (!bHeld)
+      {
+         RunHeldFrames(pSession);
+         DispatchReceived(pSession, pFrame);
+      }
+   }
+}
+
+/********************************************************************************
+ *
+ * Name:    SendRequest
+ *
+ * Purpose: Sends a request and records it in the request table
+ *
+ * Inputs:  pSession        - session
+ *          pRequest        - request payload, built and ready for framing
+ *          eCode           - command code of the request
+ *          nNow            - current time
+ *          pRequestContext - handed back with the response
+ *
+ * Outputs: pRequest - sequence number set
+ *
+ * Returns: false if the request table is full or it couldn't be written
+ *
+ * Notes:   A request that couldn't be written is taken out of the table.
+ *
+ *******************************************************************************/
+static bool SendRequest(CmdSession* pSession, MsgPayload* pRequest, ECommandCode eCode, uint32_t nNow, void* pRequestContext)
+{
+   bool bSent = RequestTable_Add(&pSession->requests, pRequest, eCode, nNow, pRequestContext);
+
+   if (bSent && !CmdSession_SendPayload(pSession, pRequest))
+   {
+      RequestTable_Complete(&pSession->requests, pRequest->nSequence, eCode, NULL);
+      bSent = false;
+   }
+
+   return bSent;
+}
+
+/********************************************************************************
+ *
+ * Name:    SendNextSetpoint
+ *
+ * Purpose: Sends the setpoint that has waited longest
+ *
+ * Inputs:  pSession - session
+ *          nNow     - current time
+ *          bAll     - send it even if its window hasn't passed
+ *
+ * Outputs: None
+ *
+ * Returns: false if nothing was due or it couldn't be sent
+ *
+ * Notes:   A setpoint that can't be sent goes back in the queue.
+ *
+ *******************************************************************************/
+static bool SendNextSetpoint(CmdSession* pSession, uint32_t nNow, bool bAll)
+{
+   SetpointQueue* pQueue = &pSession->sendSetpoints;
+   ECommandCode eCode    = ECommandCodeMin;
+   MsgPayload request;
+   bool bSent            = bAll ? SetpointQueue_Flush(pQueue, &eCode, &request)
+                                : SetpointQueue_Take(pQueue, nNow, &eCode, &request);
+
+   if (bSent && !SendRequest(pSession, &request, eCode, nNow, NULL))
+   {
+      SetpointQueue_Put(pQueue, eCode, &request, nNow, NULL);
+      bSent = false;
+   }
+
+   return bSent;
+}
+
+/********************************************************************************
+ *
+ * Name:    SendSetpoints
+ *
+ * Purpose: Sends queued setpoints
+ *
+ * Inputs:  pSession - session
+ *          nNow     - current time
+ *          bAll     - send them even if their window hasn't passed
+ *
+ * Outputs: None
+ *
+ * Returns: Number of setpoints sent
+ *
+ * Notes:   Stops at a setpoint that can't be sent, the rest wait for the
+ *          next poll.
+ *
+ *******************************************************************************/
+static size_t SendSetpoints(CmdSession* pSession, uint32_t nNow, bool bAll)
+{
+   size_t nSent = 0;
+
+   while (SendNextSetpoint(pSession, nNow, bAll))
+   {
+      nSent++;
+   }
+
+   return nSent;
+}
+
+/********************************************************************************
+ *
+ * Name:    SendLaneHead
+ *
+ * Purpose: Sends one frame for the head of a send lane
+ *
+ * Inputs:  pSession  - session
+ *          ePriority - lane, must not be empty
+ *          nNow      - current time
+ *
+ * Outputs: None
+ *
+ * Returns: false if nothing could be sent
+ *
+ * Notes:   A transfer sends its next fragment and leaves the lane after its
+ *          last one. Safety and control commands send a queued setpoint
+ *          instead while there is one, as CmdSession_Send does, so a stop
+ *          can't be undone by an older setpoint.
+ *
+ *******************************************************************************/
+static bool SendLaneHead(CmdSession* pSession, ECommandPriority ePriority, uint32_t nNow)
+{
+   SendLane* pLane   = &pSession->lanes.send[ePriority];
+   QueuedSend* pSend = SendLane_Head(pLane);
+   MsgPayload payload;
+   bool bSent        = false;
+
+   if (ePriority != ECommandPriorityBulk && pSession->sendSetpoints.nQueued > 0)
+   {
+      bSent = SendNextSetpoint(pSession, nNow, true);
+   }
+   else if (pSend->bTransfer && Transport_NextFragment(&pSend->transfer, &payload))
+   {
+      payload.bSequenced = pSend->payload.bSequenced;
+      payload.nSequence  = pSend->payload.nSequence;
+      bSent              = CmdSession_SendPayload(pSession, &payload);
+
+      if (!bSent)
+      {
+         // built again on the next pump
+         pSend->transfer.nNextFragment--;
+      }
+      else if (pSend->transfer.nNextFragment == pSend->transfer.nFragmentCount)
+      {
+         SendLane_Pop(pLane);
+      }
+   }
+   else if (!pSend->bTransfer)
+   {
+      payload = pSend->payload;
+      bSent   = SendRequest(pSession, &payload, pSend->eCode, nNow, pSend->pRequestContext);
+
+      if (bSent)
+      {
+         SendLane_Pop(pLane);
+      }
+   }
+
+   return bSent;
+}
+
+/********************************************************************************
+ *
+ * Name:    SendNextFrame
+ *
+ * Purpose: Sends one frame from the highest class with something waiting
+ *
+ * Inputs:  pSession - session
+ *          nNow     - current time
+ *
+ * Outputs: None
+ *
+ * Returns: false if nothing was sent
+ *
+ * Notes:   Setpoints whose window has passed are control commands.
+ *
+ *******************************************************************************/
+static bool SendNextFrame(CmdSession* pSession, uint32_t nNow)
+{
+   PriorityLanes* pLanes = &pSession->lanes;
+   bool bSent            = false;
+
+   if (SendLane_Head(&pLanes->send[ECommandPrioritySafety]) != NULL)
+   {
+      bSent = SendLaneHead(pSession, ECommandPrioritySafety, nNow);
+   }
+   else
+   {
+      bSent = SendNextSetpoint(pSession, nNow, false);
+
+      if (!bSent && SendLane_Head(&pLanes->send[ECommandPriorityControl]) != NULL)
+      {
+         bSent = SendLaneHead(pSession, ECommandPriorityControl, nNow);
+      }
+      else if (!bSent && SendLane_Head(&pLanes->send[ECommandPriorityBulk]) != NULL)
+      {
+         bSent = SendLaneHead(pSession, ECommandPriorityBulk, nNow);
+      }
+   }
+
+   return bSent;
+}
+
+/*********************************************************************************
+*                    F U N C T I O N   D E F I N I T I O N S
+*********************************************************************************/
+/********************************************************************************
+ *
+ * Name:    CmdSession_Init
+ *
+ * Purpose: Starts a session with no handlers, sum8 frames and ASCII payloads
+ *
+ * Inputs:  fpWrite    - sends framed bytes to the device
+ *          fpResponse - called for responses to requests, may be NULL
+ *          pContext   - passed to fpWrite and fpResponse
+ *
+ * Outputs: pSession - ready to use
+ *
+ * Returns: None
+ *
+ * Notes:   Also sets up the routines and tables shared by all sessions.
+ *
+ *******************************************************************************/
+LIB_API
+void CmdSession_Init(CmdSession* pSession, FnSessionWrite fpWrite, FnSessionResponse fpResponse, void* pContext)
+{
+   BuildSharedTables();
+   memset(pSession, 0, sizeof(*pSession));
+
+   pSession->eIntegrity = EFrameIntegritySum8;
+   pSession->eCodec     = EPayloadCodecAscii;
+   pSession->fpWrite    = fpWrite;
+   pSession->fpResponse = fpResponse;
+   pSession->pContext   = pContext;
+
+   FrameDecoder_Init(&pSession->decoder, SessionFrameDecoded, pSession);
+   RequestTable_Init(&pSession->requests);
+   SetpointQueue_Init(&pSession->sendSetpoints, 0);
+   SetpointQueue_Init(&pSession->rxSetpoints, 0);
+   PriorityLanes_Init(&pSession->lanes);
+}
+
+/********************************************************************************
+ *
+ * Name:    CmdSession_Enter
+ *
+ * Purpose: Makes a session current on the calling thread
+ *
+ * Inputs:  pSession - session, NULL for the default session
+ *
+ * Outputs: None
+ *
+ * Returns: Session that was current, pass it to CmdSession_Leave
+ *
+ * Notes:   None.
+ *
+ *******************************************************************************/
+LIB_API
+CmdSession* CmdSession_Enter(CmdSession* pSession)
+{
+   CmdSession* pPrevious = m_pCurrent;
+
+   m_pCurrent = pSession;
+
+   return pPrevious;
+}
+
+/********************************************************************************
+ *
+ * Name:    CmdSession_Leave
+ *
+ * Purpose: Restores the session that was current before CmdSession_Enter
+ *
+ * Inputs:  pPrevious - return value of CmdSession_Enter
+ *
+ * Outputs: None
+ *
+ * Returns: None
+ *
+ * Notes:   None.
+ *
+ *******************************************************************************/
+LIB_API
+void CmdSession_Leave(CmdSession* pPrevious)
+{
+   m_pCurrent = pPrevious;
+}
+
+/********************************************************************************
+ *
+ * Name:    CmdSession_Current
+ *
+ * Purpose: Returns the current session of the calling thread
+ *
+ * Inputs:  None
+ *
+ * Outputs: None
+ *
+ * Returns: Current session, the default session outside CmdSession_Enter
+ *
+ * Notes:   None.
+ *
+ *******************************************************************************/
+LIB_API
+CmdSession* CmdSession_Current(void)
+{
+   CmdSession* pSession = m_pCurrent;
+
+   return pSession != NULL ? pSession : &m_defaultSession;
+}
+
+/********************************************************************************
+ *
+ * Name:    CmdSession_SetHandlers
+ *
+ * Purpose: Runs SetCommandHandlers for a session.
+ *
+ * Inputs:  pSession  - session
+ *          pHandlers - command handlers
+ *
+ * Outputs: None
+ *
+ * Returns: See SetCommandHandlers
+ *
+ * Notes:   None
+ *
+ *******************************************************************************/
+LIB_API
+bool CmdSession_SetHandlers(CmdSession* pSession, CommandHandlers* pHandlers)
+{
+   CmdSession* pPrevious = CmdSession_Enter(pSession);
+   bool bSet             = SetCommandHandlers(pHandlers);
+
+   CmdSession_Leave(pPrevious);
+
+   return bSet;
+}
+
+/********************************************************************************
+ *
+ * Name:    CmdSession_SetFrameIntegrity
+ *
+ * Purpose: Runs SetFrameIntegrity for a session.
+ *
+ * Inputs:  pSession   - session
+ *          eIntegrity - frame check for the session's frames
+ *
+ * Outputs: None
+ *
+ * Returns: None
+ *
+ * Notes:   None
+ *
+ *******************************************************************************/
+LIB_API
+void CmdSession_SetFrameIntegrity(CmdSession* pSession, EFrameIntegrity eIntegrity)
+{
+   CmdSession* pPrevious = CmdSession_Enter(pSession);
+
+   SetFrameIntegrity(eIntegrity);
+   CmdSession_Leave(pPrevious);
+}
+
+/********************************************************************************
+ *
+ * Name:    CmdSession_SetPayloadCodec
+ *
+ * Purpose: Runs SetPayloadCodec for a session.
+ *
+ * Inputs:  pSession - session
+ *          eCodec   - payload encoding for the session's commands
+ *
+ * Outputs: None
+ *
+ * Returns: None
+ *
+ * Notes:   None
+ *
+ *******************************************************************************/
+LIB_API
+void CmdSession_SetPayloadCodec(CmdSession* pSession, EPayloadCodec eCodec)
+{
+   CmdSession* pPrevious = CmdSession_Enter(pSession);
+
+   SetPayloadCodec(eCodec);
+   CmdSession_Leave(pPrevious);
+}
+
+/********************************************************************************
+ *
+ * Name:    CmdSession_Receive
+ *
+ * Purpose: Handles bytes received from the session's device
+ *
+ * Inputs:  pSession - session
+ *          pBytes   - received data, may start or end in the middle of a frame
+ *          nLength  - number of bytes in pBytes
+ *
+ * Outputs: None
+ *
+ * Returns: Number of frames received
+ *
+ * Notes:   See SessionFrameDecoded. Held commands are run before
+ *          returning.
+ *
+ *******************************************************************************/
+LIB_API
+size_t CmdSession_Receive(CmdSession* pSession, const char* pBytes, size_t nLength)
+{
+   CmdSession* pPrevious = CmdSession_Enter(pSession);
+   size_t nFrames        = FrameDecoder_Feed(&pSession->decoder, pBytes, nLength);
+
+   RunHeldFrames(pSession);
+   CmdSession_Leave(pPrevious);
+
+   return nFrames;
+}
+
+/********************************************************************************
+ *
+ * Name:    CmdSession_Dispatch
+ *
+ * Purpose: Runs DispatchFrame for a session.
+ *
+ * Inputs:  pSession - session
+ *          pFrame   - received frame
+ *
+ * Outputs: pResponse - see DispatchFrame
+ *
+ * Returns: See DispatchFrame
+ *
+ * Notes:   None
+ *
+ *******************************************************************************/
+LIB_API
+EHandlerResponse CmdSession_Dispatch(CmdSession* pSession, const MessageFrame* pFrame, MsgPayload* pResponse)
+{
+   CmdSession* pPrevious      = CmdSession_Enter(pSession);
+   EHandlerResponse eResponse = DispatchFrame(pFrame, pResponse);
+
+   CmdSession_Leave(pPrevious);
+
+   return eResponse;
+}
+
+/********************************************************************************
+ *
+ * Name:    CmdSession_Send
+ *
+ * Purpose: Sends a request, its response is handled when it arrives
+ *
+ * Inputs:  pSession        - session
+ *          pRequest        - request payload, built and ready for framing
+ *          eCode           - command code of the request
+ *          nNow            - current time
+ *          pRequestContext - handed back with the response
+ *
+ * Outputs: pRequest - sequence number set
+ *
+ * Returns: false if the request table is full or it couldn't be written
+ *
+ * Notes:   Returns once the request is written. The response comes back
+ *          through CmdSession_Receive, which passes it to fpResponse with
+ *          pRequestContext. Queued setpoints go first, so the request
+ *          can't overtake them.
+ *
+ *******************************************************************************/
+LIB_API
+bool CmdSession_Send(CmdSession* pSession, MsgPayload* pRequest, ECommandCode eCode, uint32_t nNow, void* pRequestContext)
+{
+   SendSetpoints(pSession, nNow, true);
+
+   return SendRequest(pSession, pRequest, eCode, nNow, pRequestContext);
+}
+
+/********************************************************************************
+ *
+ * Name:    CmdSession_SetSetpointWindow
+ *
+ * Purpose: Sets how long setpoints sent with CmdSession_SendSetpoint are held.
+ *
+ * Inputs:  pSession - session
+ *          nWindow  - time a setpoint is held for newer values
+ *
+ * Outputs: None
+ *
+ * Returns: None
+ *
+ * Notes:   None
+ *
+ *******************************************************************************/
+LIB_API
+void CmdSession_SetSetpointWindow(CmdSession* pSession, uint32_t nWindow)
+{
+   pSession->sendSetpoints.nWindow = nWindow;
+}
+
+/********************************************************************************
+ *
+ * Name:    CmdSession_SendSetpoint
+ *
+ * Purpose: Queues a setpoint request, replacing an older one for the same
+ *          setpoint
+ *
+ * Inputs:  pSession - session
+ *          pRequest - request payload, built and ready for framing
+ *          eCode    - command code of the request
+ *          nNow     - current time
+ *
+ * Outputs: None
+ *
+ * Returns: false if the request couldn't be queued or sent
+ *
+ * Notes:   Anything already due is sent at once, which with no window is
+ *          the request itself.
+ *
+ *******************************************************************************/
+LIB_API
+bool CmdSession_SendSetpoint(CmdSession* pSession, MsgPayload* pRequest, ECommandCode eCode, uint32_t nNow)
+{
+   bool bQueued = SetpointQueue_Put(&pSession->sendSetpoints, eCode, pRequest, nNow, NULL) != ESetpointNotQueued;
+
+   if (bQueued)
+   {
+      SendSetpoints(pSession, nNow, false);
+   }
+
+   return bQueued;
+}
+
+/********************************************************************************
+ *
+ * Name:    CmdSession_Poll
+ *
+ * Purpose: Sends the setpoints whose window has passed.
+ *
+ * Inputs:  pSession - session
+ *          nNow     - current time
+ *
+ * Outputs: None
+ *
+ * Returns: Number of setpoints sent
+ *
+ * Notes:   None
+ *
+ *******************************************************************************/
+LIB_API
+size_t CmdSession_Poll(CmdSession* pSession, uint32_t nNow)
+{
+   return SendSetpoints(pSession, nNow, false);
+}
+
+/********************************************************************************
+ *
+ * Name:    CmdSession_MergeReceivedSetpoints
+ *
+ * Purpose: Turns on merging of received setpoint commands.
+ *
+ * Inputs:  pSession - session
+ *          bMerge   - merge received setpoints
+ *
+ * Outputs: None
+ *
+ * Returns: None
+ *
+ * Notes:   Held setpoints are run when merging is turned off.
+ *
+ *******************************************************************************/
+LIB_API
+void CmdSession_MergeReceivedSetpoints(CmdSession* pSession, bool bMerge)
+{
+   CmdSession* pPrevious = CmdSession_Enter(pSession);
+
+   RunHeldFrames(pSession);
+   pSession->bMergeReceived = bMerge;
+   CmdSession_Leave(pPrevious);
+}
+
+/********************************************************************************
+ *
+ * Name:    CmdSession_Queue
+ *
+ * Purpose: Queues a request in the send lane of its class
+ *
+ * Inputs:  pSession        - session
+ *          pRequest        - request payload, built and ready for framing
+ *          eCode           - command code of the request
+ *          nNow            - current time
+ *          pRequestContext - handed back with the response
+ *
+ * Outputs: None
+ *
+ * Returns: false if its lane is full
+ *
+ * Notes:   Setpoints go in the setpoint queue, see CmdSession_SendSetpoint,
+ *          and get no context back.
+ *
+ *******************************************************************************/
+LIB_API
+bool CmdSession_Queue(CmdSession* pSession, const MsgPayload* pRequest, ECommandCode eCode, uint32_t nNow, void* pRequestContext)
+{
+   bool bQueued = false;
+
+   if (IsSetpointCommand(eCode))
+   {
+      bQueued = SetpointQueue_Put(&pSession->sendSetpoints, eCode, pRequest, nNow, NULL) != ESetpointNotQueued;
+   }
+   else
+   {
+      bQueued = SendLane_PutRequest(&pSession->lanes.send[CommandPriority(eCode)], pRequest, eCode, pRequestContext);
+   }
+
+   return bQueued;
+}
+
+/********************************************************************************
+ *
+ * Name:    CmdSession_QueueTransfer
+ *
+ * Purpose: Queues a logical message to be sent as transport fragments
+ *
+ * Inputs:  pSession - session
+ *          pRequest - request the message answers, may be NULL
+ *          eCode    - command code of the request
+ *          pMessage - logical message
+ *          nLength  - number of bytes in pMessage
+ *
+ * Outputs: None
+ *
+ * Returns: false if its lane is full or the message is empty or too long
+ *
+ * Notes:   Each transfer gets the session's next transport message id.
+ *
+ *******************************************************************************/
+LIB_API
+bool CmdSession_QueueTransfer(CmdSession* pSession,
+                              const MsgPayload* pRequest,
+                              ECommandCode eCode,
+                              const char* pMessage,
+                              size_t nLength)
+{
+   bool bQueued = SendLane_PutTransfer(&pSession->lanes.send[CommandPriority(eCode)],
+                                       pRequest,
+                                       eCode,
+                                       pSession->nTransferId,
+                                       pMessage,
+                                       nLength);
+
+   if (bQueued)
+   {
+      pSession->nTransferId++;
+   }
+
+   return bQueued;
+}
+
+/********************************************************************************
+ *
+ * Name:    CmdSession_Pump
+ *
+ * Purpose: Sends queued frames, highest class first
+ *
+ * Inputs:  pSession   - session
+ *          nNow       - current time
+ *          nMaxFrames - most frames to send
+ *
+ * Outputs: None
+ *
+ * Returns: Number of frames sent
+ *
+ * Notes:   The class is chosen again for every frame, so a transfer gives
+ *          way to a safety command queued between two of its fragments.
+ *          Stops early when nothing more can be sent.
+ *
+ *******************************************************************************/
+LIB_API
+size_t CmdSession_Pump(CmdSession* pSession, uint32_t nNow, size_t nMaxFrames)
+{
+   size_t nSent = 0;
+
+   while (nSent < nMaxFrames && SendNextFrame(pSession, nNow))
+   {
+      nSent++;
+   }
+
+   return nSent;
+}
+
+/********************************************************************************
+ *
+ * Name:    CmdSession_PrioritizeReceived
+ *
+ * Purpose: Turns on running received commands highest class first.
+ *
+ * Inputs:  pSession    - session
+ *          bPrioritize - hold received commands in their lanes
+ *
+ * Outputs: None
+ *
+ * Returns: None
+ *
+ * Notes:   Held commands are run when it is turned off.
+ *
+ *******************************************************************************/
+LIB_API
+void CmdSession_PrioritizeReceived(CmdSession* pSession, bool bPrioritize)
+{
+   CmdSession* pPrevious = CmdSession_Enter(pSession);
+
+   RunHeldFrames(pSession);
+   pSession->bPrioritizeReceived = bPrioritize;
+   CmdSession_Leave(pPrevious);
+}
+
+/********************************************************************************
+ *
+ * Name:    CmdSession_Expire
+ *
+ * Purpose: Runs RequestTable_Expire on the session's requests.
+ *
+ * Inputs:  pSession - session
+ *          nNow     - current time
+ *          nTimeout - time a request may wait for its response
+ *
+ * Outputs: pRequest - the request that timed out, may be NULL
+ *
+ * Returns: false if no request has timed out
+ *
+ * Notes:   None
+ *
+ *******************************************************************************/
+LIB_API
+bool CmdSession_Expire(CmdSession* pSession, uint32_t nNow, uint32_t nTimeout, PendingRequest* pRequest)
+{
+   return RequestTable_Expire(&pSession->requests, nNow, nTimeout, pRequest);
+}
+
+/********************************************************************************
+ *
+ * Name:    CmdSession_CompleteTransport
+ *
+ * Purpose: Runs RequestTable_CompleteTransport on the session's requests.
+ *
+ * Inputs:  pSession - session
+ *          pFrame   - last fragment received
+ *          eResult  - result of Transport_AddFragment for pFrame
+ *          pMessage - message from Transport_AddFragment
+ *
+ * Outputs: pRequest - the request answered, may be NULL
+ *
+ * Returns: false if the message isn't complete or no request matches
+ *
+ * Notes:   None
+ *
+ *******************************************************************************/
+LIB_API
+bool CmdSession_CompleteTransport(CmdSession* pSession,
+                                  const MessageFrame* pFrame,
+                                  ETransportResult eResult,
+                                  const FrameView* pMessage,
+                                  PendingRequest* pRequest)
+{
+   return pFrame->payload.bSequenced
+       && RequestTable_CompleteTransport(&pSession->requests, pFrame->payload.nSequence, eResult, pMessage, pRequest);
+}
+
+/********************************************************************************
+ *
+ * Name:    CmdSession_SendPayload
+ *
+ * Purpose: Frames a payload and writes it to the session's device
+ *
+ * Inputs:  pSession - session
+ *          pPayload - payload, sequence number set if it has one
+ *
+ * Outputs: None
+ *
+ * Returns: false if the session has no fpWrite or the payload won't fit
+ *
+ * Notes:   Framed with the session's frame check.
+ *
+ *******************************************************************************/
+LIB_API
+bool CmdSession_SendPayload(CmdSession* pSession, MsgPayload* pPayload)
+{
+   CmdSession* pPrevious = NULL;
+   const char* pFrame    = NULL;
+   size_t nFrame         = 0;
+
+   if (pSession->fpWrite != NULL)
+   {
+      pPrevious = CmdSession_Enter(pSession);
+      nFrame    = AddMessageFramingInPlace(pPayload, &pFrame);
+      CmdSession_Leave(pPrevious);
+
+      if (nFrame > 0)
+      {
+         pSession->fpWrite(pSession->pContext, pFrame, nFrame);
+      }
+   }
+
+   return nFrame > 0;
+}
+
+/********************************************************************************
+ *
+ * Name:    CmdSession_CompleteCommand
+ *
+ * Purpose: Runs CompleteCommand for a command of the session.
+ *
+ * Inputs:  pSession - session
+ *          token    - token the async handler was given
+ *          eResult  - handler result
+ *
+ * Outputs: None
+ *
+ * Returns: See CompleteCommand
+ *
+ * Notes:   None
+ *
+ *******************************************************************************/
+LIB_API
+EHandlerResponse CmdSession_CompleteCommand(CmdSession* pSession, CommandToken token, EHandlerResponse eResult)
+{
+   CmdSession* pPrevious      = CmdSession_Enter(pSession);
+   EHandlerResponse eResponse = CompleteCommand(token, eResult);
+
+   CmdSession_Leave(pPrevious);
+
+   return eResponse;
+}
+
+/********************************************************************************
+ *
+ * Name:    CmdSession_CompleteReadManufacturerField
+ *
+ * Purpose: Runs CompleteReadManufacturerField for a command of the session.
+ *
+ * Inputs:  pSession - session
+ *          token    - token the async handler was given
+ *          eResult  - handler result
+ *          pszValue - field value
+ *
+ * Outputs: None
+ *
+ * Returns: See CompleteCommand
+ *
+ * Notes:   None
+ *
+ *******************************************************************************/
+LIB_API
+EHandlerResponse CmdSession_CompleteReadManufacturerField(CmdSession* pSession,
+                                                          CommandToken token,
+                                                          EHandlerResponse eResult,
+                                                          const char* pszValue)
+{
+   CmdSession* pPrevious      = CmdSession_Enter(pSession);
+   EHandlerResponse eResponse = CompleteReadManufacturerField(token, eResult, pszValue);
+
+   CmdSession_Leave(pPrevious);
+
+   return eResponse;
+}
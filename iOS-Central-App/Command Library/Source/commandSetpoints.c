@@ -0,0 +1,304 @@
+/*********************************************************************************
+*
+*                          Proprietary Information of
+*
+*                            Precision Systems, Inc.
+*                    1355 Business Center Drive, Suite C
+*                                 Horsham, PA
+*                               (215) 672-1860
+*
+*                   Copyright (C) 2020, Precision Systems, Inc.
+*                            All Rights Reserved
+*
+*             The information and design as detailed in this document is
+*     the property of Precision Systems, Inc., and/or its Associates
+*     and must be returned on demand. It is issued on the strict
+*     condition that except with our written permission it must not be
+*     reproduced, copied or communicated to any third party, nor be
+*     used for any purpose other than that stated in the particular
+*     inquiry, order or contract with which it is issued. The
+*     reservation of copyright in this document extends from each date
+*     appearing thereon and in respect of the subject matter as it
+*     appeared at the relevant date.
+*
+********************************************************************************/
+/********************************************************************************
+*
+* PROJECT:     Project MIDAS
+*
+* COMPILER:    
+*
+* TOOLS:       Microsoft Visual Studio 2019
+*
+* DESCRIPTION: Last writer wins queue for setpoint commands
+*
+* NOTES:       The queue has a fixed slot per setpoint, so a command finds
+*              its slot without a search. Taking walks all the slots, there
+*              are only a few.
+*
+********************************************************************************/
+#include <string.h>
+#include "commandSetpoints.h"
+#include "commandParser.h"
+
+/********************************************************************************
+*                          D E F I N I T I O N S
+********************************************************************************/
+// slots of the setpoints, valves follow from ESetpointSlotValve by gas
+typedef enum _ESetpointSlot
+{
+   ESetpointSlotFlowRate,
+   ESetpointSlotO2Mix,
+   ESetpointSlotValve
+} ESetpointSlot;
+
+// no slot, not a setpoint
+#define SETPOINT_SLOT_NONE SETPOINT_SLOT_COUNT
+
+/*********************************************************************************
+*                        H E L P E R   F U N C T I O N S
+*********************************************************************************/
+/********************************************************************************
+ *
+ * Name:    FindSlot
+ *
+ * Purpose: Finds the queue slot of a setpoint command
+ *
+ * Inputs:  eCode    - command code
+ *          pPayload - command payload
+ *
+ * Outputs: None
+ *
+ * Returns: Slot, SETPOINT_SLOT_NONE if the command isn't a setpoint or the
+ *          gas of a set valve command can't be read
+ *
+ * Notes:   None.
+ *
+ *******************************************************************************/
+static size_t FindSlot(ECommandCode eCode, const MsgPayload* pPayload)
+{
+   size_t nSlot = SETPOINT_SLOT_NONE;
+   EGasId eId   = EO2;
+   FrameView view;
+
+   switch (eCode)
+   {
+   case ESetTotalFlowRate:
+      nSlot = ESetpointSlotFlowRate;
+      break;
+
+   case ESetO2MixPercentage:
+      nSlot = ESetpointSlotO2Mix;
+      break;
+
+   case ESetValve:
+      view.pData   = pPayload->szPayload;
+      view.nLength = pPayload->nLength;
+
+      if (ReadSetValveGasView(&view, &eId) == EResponseOk)
+      {
+         nSlot = ESetpointSlotValve + (size_t)eId;
+      }
+      break;
+
+   default:
+      break;
+   }
+
+   return nSlot;
+}
+
+/********************************************************************************
+ *
+ * Name:    TakeOldest
+ *
+ * Purpose: Takes the setpoint that has waited longest
+ *
+ * Inputs:  pQueue - setpoint queue
+ *          nNow   - current time
+ *          bAll   - take it even if its window hasn't passed
+ *
+ * Outputs: pQueue   - command removed
+ *          peCode   - command code
+ *          pPayload - newest command for the setpoint
+ *
+ * Returns: false if there is nothing to take
+ *
+ * Notes:   Oldest first, so setpoints leave in the order they arrived.
+ *
+ *******************************************************************************/
+static bool TakeOldest(SetpointQueue* pQueue, uint32_t nNow, bool bAll, ECommandCode* peCode, MsgPayload* pPayload)
+{
+   QueuedSetpoint* pOldest = NULL;
+   QueuedSetpoint* pSlot   = NULL;
+   size_t nIdx             = 0;
+
+   for (nIdx = 0; nIdx < SETPOINT_SLOT_COUNT && pQueue->nQueued > 0; nIdx++)
+   {
+      pSlot = &pQueue->setpoints[nIdx];
+
+      if (pSlot->bQueued
+      && (bAll || nNow - pSlot->nQueuedTime >= pQueue->nWindow)
+      && (pOldest == NULL || pSlot->nQueuedTime - pOldest->nQueuedTime > UINT32_MAX / 2))
+      {
+         pOldest = pSlot;
+      }
+   }
+
+   if (pOldest != NULL)
+   {
+      *peCode   = pOldest->eCode;
+      *pPayload = pOldest->payload;
+      pOldest->bQueued = false;
+      pQueue->nQueued--;
+   }
+
+   return pOldest != NULL;
+}
+
+/*********************************************************************************
+*                    F U N C T I O N   D E F I N I T I O N S
+*********************************************************************************/
+/********************************************************************************
+ *
+ * Name:    SetpointQueue_Init
+ *
+ * Purpose: Empties a setpoint queue
+ *
+ * Inputs:  nWindow - time a setpoint is held for newer values
+ *
+ * Outputs: pQueue - no setpoints queued
+ *
+ * Returns: None
+ *
+ * Notes:   None.
+ *
+ *******************************************************************************/
+LIB_API
+void SetpointQueue_Init(SetpointQueue* pQueue, uint32_t nWindow)
+{
+   memset(pQueue, 0, sizeof(*pQueue));
+   pQueue->nWindow = nWindow;
+}
+
+/********************************************************************************
+ *
+ * Name:    IsSetpointCommand
+ *
+ * Purpose: Checks whether a command sets a value a newer command replaces
+ *
+ * Inputs:  eCode - command code
+ *
+ * Outputs: None
+ *
+ * Returns: true for set total flow rate, set O2 mix and set valve
+ *
+ * Notes:   None.
+ *
+ *******************************************************************************/
+LIB_API
+bool IsSetpointCommand(ECommandCode eCode)
+{
+   return eCode == ESetTotalFlowRate || eCode == ESetO2MixPercentage || eCode == ESetValve;
+}
+
+/********************************************************************************
+ *
+ * Name:    SetpointQueue_Put
+ *
+ * Purpose: Queues a setpoint command, replacing an older one for the same
+ *          setpoint
+ *
+ * Inputs:  pQueue   - setpoint queue
+ *          eCode    - command code
+ *          pPayload - command payload, with its sequence number if any
+ *          nNow     - current time
+ *
+ * Outputs: pQueue    - command queued
+ *          pReplaced - the command replaced, may be NULL
+ *
+ * Returns: See ESetpointResult
+ *
+ * Notes:   A replaced command keeps its slot's queued time.
+ *
+ *******************************************************************************/
+LIB_API
+ESetpointResult SetpointQueue_Put(SetpointQueue* pQueue,
+                                  ECommandCode eCode,
+                                  const MsgPayload* pPayload,
+                                  uint32_t nNow,
+                                  MsgPayload* pReplaced)
+{
+   ESetpointResult eResult = ESetpointNotQueued;
+   size_t nSlot            = FindSlot(eCode, pPayload);
+   QueuedSetpoint* pSlot   = NULL;
+
+   if (nSlot != SETPOINT_SLOT_NONE)
+   {
+      pSlot = &pQueue->setpoints[nSlot];
+
+      if (pSlot->bQueued)
+      {
+         if (pReplaced != NULL)
+         {
+            *pReplaced = pSlot->payload;
+         }
+         eResult = ESetpointReplaced;
+      }
+      else
+      {
+         pSlot->bQueued     = true;
+         pSlot->nQueuedTime = nNow;
+         pQueue->nQueued++;
+         eResult = ESetpointQueued;
+      }
+
+      pSlot->eCode   = eCode;
+      pSlot->payload = *pPayload;
+   }
+
+   return eResult;
+}
+
+/********************************************************************************
+ *
+ * Name:    SetpointQueue_Take
+ *
+ * Purpose: Takes a setpoint command whose window has passed.
+ *
+ * Inputs:  pQueue - setpoint queue
+ *          nNow   - current time
+ *
+ * Outputs: peCode, pPayload - newest command for the setpoint
+ *
+ * Returns: false if no window has passed
+ *
+ * Notes:   None
+ *
+ *******************************************************************************/
+LIB_API
+bool SetpointQueue_Take(SetpointQueue* pQueue, uint32_t nNow, ECommandCode* peCode, MsgPayload* pPayload)
+{
+   return TakeOldest(pQueue, nNow, false, peCode, pPayload);
+}
+
+/********************************************************************************
+ *
+ * Name:    SetpointQueue_Flush
+ *
+ * Purpose: Takes a setpoint command whatever its window.
+ *
+ * Inputs:  pQueue - setpoint queue
+ *
+ * Outputs: peCode, pPayload - newest command for the setpoint
+ *
+ * Returns: false if the queue is empty
+ *
+ * Notes:   None
+ *
+ *******************************************************************************/
+LIB_API
+bool SetpointQueue_Flush(SetpointQueue* pQueue, ECommandCode* peCode, MsgPayload* pPayload)
+{
+   return TakeOldest(pQueue, 0, true, peCode, pPayload);
+}
@@ -0,0 +1,377 @@
+/*********************************************************************************
+*
+*                          Proprietary Information of
+*
+*                            Precision Systems, Inc.
+*                    1355 Business Center Drive, Suite C
+*                                 Horsham, PA
+*                               (215) 672-1860
+*
+*                   Copyright (C) 2020, Precision Systems, Inc.
+*                            All Rights Reserved
+*
+*             The information and design as detailed in this document is
+*     the property of Precision Systems, Inc., and/or its Associates
+*     and must be returned on demand. It is issued on the strict
+*     condition that except with our written permission it must not be
+*     reproduced, copied or communicated to any third party, nor be
+*     used for any purpose other than that stated in the particular
+*     inquiry, order or contract with which it is issued. The
+*     reservation of copyright in this document extends from each date
+*     appearing thereon and in respect of the subject matter as it
+*     appeared at the relevant date.
+*
+********************************************************************************/
+/********************************************************************************
+*
+* PROJECT:     Project MIDAS
+*
+* COMPILER:    
+*
+* TOOLS:       Microsoft Visual Studio 2019
+*
+* DESCRIPTION: Transport ("PH+T") fragmentation and reassembly
+*
+* NOTES:       Fragment n of a message always holds the message bytes from
+*              n * TRANSPORT_FRAGMENT_DATA on, so fragments are stored
+*              straight into place however they arrive.
+*
+********************************************************************************/
+#include <string.h>
+#include "commandTransport.h"
+#include "commandFramework.h"
+#include "commandCrc.h"
+#include "commandWriter.h"
+
+/********************************************************************************
+*                          D E F I N I T I O N S
+********************************************************************************/
+// header field offsets
+#define TRANSPORT_ID_OFFSET        (TRANSPORT_MARKER_LENGTH)
+#define TRANSPORT_INDEX_OFFSET     (TRANSPORT_MARKER_LENGTH + 1)
+#define TRANSPORT_COUNT_OFFSET     (TRANSPORT_MARKER_LENGTH + 2)
+#define TRANSPORT_LENGTH_OFFSET    (TRANSPORT_MARKER_LENGTH + 3)
+#define TRANSPORT_CHECKSUM_OFFSET  (TRANSPORT_MARKER_LENGTH + 5)
+
+/*********************************************************************************
+*                        H E L P E R   F U N C T I O N S
+*********************************************************************************/
+/********************************************************************************
+ *
+ * Name:    ReadUint16
+ *
+ * Purpose: Reads a little endian 16 bit header field
+ *
+ * Inputs:  pData - first byte of the field
+ *
+ * Outputs: None
+ *
+ * Returns: Field value
+ *
+ * Notes:   None.
+ *
+ *******************************************************************************/
+static uint16_t ReadUint16(const char* pData)
+{
+   return (uint16_t)((uint8_t)pData[0] | ((uint8_t)pData[1] << 8));
+}
+
+/********************************************************************************
+ *
+ * Name:    WriteUint16
+ *
+ * Purpose: Appends a little endian 16 bit header field
+ *
+ * Inputs:  nValue - field value
+ *
+ * Outputs: pWriter - payload, length and checksum updated
+ *
+ * Returns: None
+ *
+ * Notes:   None.
+ *
+ *******************************************************************************/
+static void WriteUint16(PayloadWriter* pWriter, uint16_t nValue)
+{
+   PayloadWriter_Char(pWriter, (char)(nValue & 0xFF));
+   PayloadWriter_Char(pWriter, (char)(nValue >> 8));
+}
+
+/*********************************************************************************
+*                    F U N C T I O N   D E F I N I T I O N S
+*********************************************************************************/
+/********************************************************************************
+ *
+ * Name:    IsTransportPayload
+ *
+ * Purpose: Checks for the transport fragment header
+ *
+ * Inputs:  pData   - payload bytes
+ *          nLength - number of bytes in pData
+ *
+ * Outputs: None
+ *
+ * Returns: true if the payload is a transport fragment
+ *
+ * Notes:   None.
+ *
+ *******************************************************************************/
+LIB_API
+bool IsTransportPayload(const char* pData, size_t nLength)
+{
+   return pData != NULL
+       && nLength >= TRANSPORT_HEADER_LENGTH
+       && memcmp(pData, HEADER_TRANSPORT, TRANSPORT_MARKER_LENGTH) == 0;
+}
+
+/********************************************************************************
+ *
+ * Name:    TransportChecksum
+ *
+ * Purpose: Calculates the per message checksum
+ *
+ * Inputs:  pMessage - logical message
+ *          nLength  - number of bytes in pMessage
+ *
+ * Outputs: None
+ *
+ * Returns: CRC-16 of the message bytes
+ *
+ * Notes:   A sum misses reordered bytes, which is the failure most likely
+ *          when fragments are put back together, so a CRC is used here.
+ *
+ *******************************************************************************/
+LIB_API
+uint16_t TransportChecksum(const void* pMessage, size_t nLength)
+{
+   return Crc16Update(CRC16_INIT, pMessage, nLength);
+}
+
+/********************************************************************************
+ *
+ * Name:    Transport_BeginSend
+ *
+ * Purpose: Starts splitting a logical message into fragments
+ *
+ * Inputs:  nMessageId - id shared by all fragments of the message
+ *          pMessage   - logical message
+ *          nLength    - number of bytes in pMessage
+ *
+ * Outputs: pSender - ready to produce the first fragment
+ *
+ * Returns: false if the message is empty or too long
+ *
+ * Notes:   None.
+ *
+ *******************************************************************************/
+LIB_API
+bool Transport_BeginSend(TransportSender* pSender, uint8_t nMessageId, const char* pMessage, size_t nLength)
+{
+   bool bStarted = (pMessage != NULL && nLength > 0 && nLength <= TRANSPORT_MAX_MESSAGE);
+
+   pSender->pMessage       = pMessage;
+   pSender->nLength        = 0;
+   pSender->nChecksum      = 0;
+   pSender->nMessageId     = nMessageId;
+   pSender->nFragmentCount = 0;
+   pSender->nNextFragment  = 0;
+
+   if (bStarted)
+   {
+      pSender->nLength        = nLength;
+      pSender->nChecksum      = TransportChecksum(pMessage, nLength);
+      pSender->nFragmentCount = (uint8_t)((nLength + TRANSPORT_FRAGMENT_DATA - 1) / TRANSPORT_FRAGMENT_DATA);
+   }
+
+   return bStarted;
+}
+
+/********************************************************************************
+ *
+ * Name:    Transport_NextFragment
+ *
+ * Purpose: Builds the next fragment payload
+ *
+ * Inputs:  pSender - sender started with Transport_BeginSend
+ *
+ * Outputs: pPayload - fragment payload with length and checksum set
+ *
+ * Returns: false when all fragments have been built
+ *
+ * Notes:   None.
+ *
+ *******************************************************************************/
+LIB_API
+bool Transport_NextFragment(TransportSender* pSender, MsgPayload* pPayload)
+{
+   PayloadWriter writer;
+   size_t nOffset = 0;
+   size_t nData   = 0;
+   bool bBuilt    = (pSender->nNextFragment < pSender->nFragmentCount);
+
+   if (bBuilt)
+   {
+      nOffset = (size_t)pSender->nNextFragment * TRANSPORT_FRAGMENT_DATA;
+      nData   = pSender->nLength - nOffset;
+      nData   = (nData < TRANSPORT_FRAGMENT_DATA) ? nData : TRANSPORT_FRAGMENT_DATA;
+
+      PayloadWriter_Begin(&writer, pPayload);
+      PayloadWriter_Bytes(&writer, HEADER_TRANSPORT, TRANSPORT_MARKER_LENGTH);
+      PayloadWriter_Char(&writer, (char)pSender->nMessageId);
+      PayloadWriter_Char(&writer, (char)pSender->nNextFragment);
+      PayloadWriter_Char(&writer, (char)pSender->nFragmentCount);
+      WriteUint16(&writer, (uint16_t)pSender->nLength);
+      WriteUint16(&writer, pSender->nChecksum);
+      PayloadWriter_Bytes(&writer, pSender->pMessage + nOffset, nData);
+      PayloadWriter_End(&writer);
+
+      pSender->nNextFragment++;
+   }
+
+   return bBuilt;
+}
+
+/********************************************************************************
+ *
+ * Name:    Transport_InitReassembler
+ *
+ * Purpose: Prepares a reassembler
+ *
+ * Inputs:  pBuffer     - storage for the reassembled message
+ *          nBufferSize - size of pBuffer
+ *
+ * Outputs: pReassembler - ready for the first fragment
+ *
+ * Returns: None
+ *
+ * Notes:   None.
+ *
+ *******************************************************************************/
+LIB_API
+void Transport_InitReassembler(TransportReassembler* pReassembler, char* pBuffer, size_t nBufferSize)
+{
+   memset(pReassembler, 0, sizeof(*pReassembler));
+
+   pReassembler->pBuffer     = pBuffer;
+   pReassembler->nBufferSize = nBufferSize;
+}
+
+/********************************************************************************
+ *
+ * Name:    Transport_AddFragment
+ *
+ * Purpose: Stores a received fragment
+ *
+ * Inputs:  pPayload - payload of a received frame
+ *
+ * Outputs: pReassembler - fragment stored
+ *          pMessage     - set to the complete message when
+ *                         ETransportMessageDone is returned
+ *
+ * Returns: Result of adding the fragment
+ *
+ * Notes:   The length, count and checksum carried by every fragment must
+ *          agree, otherwise the fragment starts a new message. A fragment
+ *          whose size doesn't match its place in the message is rejected.
+ *
+ *******************************************************************************/
+LIB_API
+ETransportResult Transport_AddFragment(TransportReassembler* pReassembler,
+                                       const FrameView* pPayload,
+                                       FrameView* pMessage)
+{
+   ETransportResult eResult = ETransportNotFragment;
+   const char* pHeader      = pPayload->pData;
+   size_t nData             = 0;
+   size_t nExpected         = 0;
+   size_t nLength           = 0;
+   uint16_t nChecksum       = 0;
+   uint8_t nMessageId       = 0;
+   uint8_t nIndex           = 0;
+   uint8_t nCount           = 0;
+   uint8_t nBit             = 0;
+
+   if (IsTransportPayload(pPayload->pData, pPayload->nLength))
+   {
+      nMessageId = (uint8_t)pHeader[TRANSPORT_ID_OFFSET];
+      nIndex     = (uint8_t)pHeader[TRANSPORT_INDEX_OFFSET];
+      nCount     = (uint8_t)pHeader[TRANSPORT_COUNT_OFFSET];
+      nLength    = ReadUint16(pHeader + TRANSPORT_LENGTH_OFFSET);
+      nChecksum  = ReadUint16(pHeader + TRANSPORT_CHECKSUM_OFFSET);
+      nData      = pPayload->nLength - TRANSPORT_HEADER_LENGTH;
+
+      // every fragment but the last one is full
+      if (nIndex < nCount
+      &&  nLength >  (size_t)(nCount - 1) * TRANSPORT_FRAGMENT_DATA
+      &&  nLength <= (size_t)nCount * TRANSPORT_FRAGMENT_DATA)
+      {
+         nExpected = nLength - (size_t)nIndex * TRANSPORT_FRAGMENT_DATA;
+         nExpected = (nExpected < TRANSPORT_FRAGMENT_DATA) ? nExpected : TRANSPORT_FRAGMENT_DATA;
+      }
+
+      if (nExpected == 0 || nData != nExpected)
+      {
+         eResult = ETransportBadFragment;
+      }
+      else if (nLength > pReassembler->nBufferSize)
+      {
+         pReassembler->bActive = false;
+         eResult = ETransportTooLong;
+      }
+      else
+      {
+         // first fragment of a new message
+         if (!pReassembler->bActive
+         ||  pReassembler->nMessageId     != nMessageId
+         ||  pReassembler->nFragmentCount != nCount
+         ||  pReassembler->nLength        != nLength
+         ||  pReassembler->nChecksum      != nChecksum)
+         {
+            memset(pReassembler->nReceivedMask, 0, sizeof(pReassembler->nReceivedMask));
+            pReassembler->nMessageId     = nMessageId;
+            pReassembler->nFragmentCount = nCount;
+            pReassembler->nLength        = nLength;
+            pReassembler->nChecksum      = nChecksum;
+            pReassembler->nReceived      = 0;
+            pReassembler->bActive        = true;
+         }
+
+         // repeats are dropped
+         nBit = (uint8_t)(1u << (nIndex & 7));
+
+         if ((pReassembler->nReceivedMask[nIndex >> 3] & nBit) == 0)
+         {
+            memcpy(pReassembler->pBuffer + (size_t)nIndex * TRANSPORT_FRAGMENT_DATA,
+                   pHeader + TRANSPORT_HEADER_LENGTH,
+                   nData);
+            pReassembler->nReceivedMask[nIndex >> 3] |= nBit;
+            pReassembler->nReceived++;
+         }
+
+         eResult = ETransportFragmentOk;
+
+         if (pReassembler->nReceived == pReassembler->nFragmentCount)
+         {
+            pReassembler->bActive = false;
+
+            if (TransportChecksum(pReassembler->pBuffer, nLength) != nChecksum)
+            {
+               eResult = ETransportChecksumError;
+            }
+            else
+            {
+               if (nLength < pReassembler->nBufferSize)
+               {
+                  pReassembler->pBuffer[nLength] = '\0';
+               }
+
+               pMessage->pData   = pReassembler->pBuffer;
+               pMessage->nLength = nLength;
+               eResult = ETransportMessageDone;
+            }
+         }
+      }
+   }
+
+   return eResult;
+}
@@ -0,0 +1,1035 @@
+/*********************************************************************************
+*
+*                          Proprietary Information of
+*
+*                            Precision Systems, Inc.
+*                    1355 Business Center Drive, Suite C
+*                                 Horsham, PA
+*                               (215) 672-1860
+*
+*                   Copyright (C) 2020, Precision Systems, Inc.
+*                            All Rights Reserved
+*
+*             The information and design as detailed in this document is
+*     the property of Precision Systems, Inc., and/or its Associates
+*     and must be returned on demand. It is issued on the strict
+*     condition that except with our written permission it must not be
+*     reproduced, copied or communicated to any third party, nor be
+*     used for any purpose other than that stated in the particular
+*     inquiry, order or contract with which it is issued. The
+*     reservation of copyright in this document extends from each date
+*     appearing thereon and in respect of the subject matter as it
+*     appeared at the relevant date.
+*
+********************************************************************************/
+/********************************************************************************
+*
+* PROJECT:     Project MIDAS
+*
+* COMPILER:    
+*
+* TOOLS:       Microsoft Visual Studio 2019
+*
+* DESCRIPTION: Payload writer used by the command builders
+*
+* NOTES:       Each byte is added to the checksum as it is copied into the
+*              payload. Nothing else reads the payload back, except for the
+*              length byte of a binary list record which is filled in when
+*              the list is closed.
+*
+********************************************************************************/
+#include <stdio.h>
+#include <string.h>
+#include "commandWriter.h"
+#include "commandBinary.h"
+#include "commandBuilder.h"
+#include "commandDecimal.h"
+#include "commandSession.h"
+
+/********************************************************************************
+*                          D E F I N I T I O N S
+********************************************************************************/
+// room for the payload text, one byte is kept for the NULL
+#define WRITER_CAPACITY    (PAYLOAD_LENGTH - 1)
+
+// runs this long or longer are copied and summed in bulk
+#define WRITER_BULK_BYTES  32
+
+// enough for any int in decimal or hex, and for "%f" of a float
+#define INT_DIGITS_SIZE    12
+#define FLOAT_DIGITS_SIZE  64
+
+/*********************************************************************************
+*                    F U N C T I O N   D E F I N I T I O N S
+*********************************************************************************/
+/********************************************************************************
+ *
+ * Name:    SetPayloadCodec
+ *
+ * Purpose: Selects the codec used for payloads built from now on
+ *
+ * Inputs:  eCodec - payload codec
+ *
+ * Outputs: None
+ *
+ * Returns: None
+ *
+ * Notes:   Set for the current session, see CmdSession_Enter.
+ *
+ *******************************************************************************/
+LIB_API
+void SetPayloadCodec(EPayloadCodec eCodec)
+{
+   CmdSession_Current()->eCodec = eCodec;
+}
+
+/********************************************************************************
+ *
+ * Name:    GetPayloadCodec
+ *
+ * Purpose: Returns the codec used for payloads built from now on
+ *
+ * Inputs:  None
+ *
+ * Outputs: None
+ *
+ * Returns: Payload codec
+ *
+ * Notes:   None.
+ *
+ *******************************************************************************/
+LIB_API
+EPayloadCodec GetPayloadCodec(void)
+{
+   return CmdSession_Current()->eCodec;
+}
+
+/********************************************************************************
+ *
+ * Name:    WriteRecord
+ *
+ * Purpose: Appends a binary record
+ *
+ * Inputs:  pszTag       - parameter tag, NULL for a value without a tag
+ *          pValue       - value bytes, may be NULL if nValueLength is 0
+ *          nValueLength - number of value bytes
+ *
+ * Outputs: pWriter - payload, length and checksum updated.
+ *                    nRecordStart is set to the record length byte.
+ *
+ * Returns: None
+ *
+ * Notes:   Tags without a tag id are written out as text. A value too long
+ *          for the length byte is cut short and sets bOverflow.
+ *
+ *******************************************************************************/
+static void WriteRecord(PayloadWriter* pWriter, const char* pszTag, const void* pValue, size_t nValueLength)
+{
+   uint8_t nTagId     = (pszTag != NULL) ? BinaryTagId(pszTag) : BINARY_TAG_NONE;
+   size_t nNameLength = 0;
+   size_t nPrefix     = 0;
+
+   if (nTagId == BINARY_TAG_NAMED)
+   {
+      nNameLength = strlen(pszTag);
+      nNameLength = (nNameLength < BINARY_MAX_VALUE) ? nNameLength : BINARY_MAX_VALUE - 1;
+      nPrefix     = 1 + nNameLength;
+   }
+
+   if (nPrefix + nValueLength > BINARY_MAX_VALUE)
+   {
+      nValueLength = BINARY_MAX_VALUE - nPrefix;
+      pWriter->bOverflow = true;
+   }
+
+   PayloadWriter_Char(pWriter, (char)nTagId);
+   pWriter->nRecordStart = pWriter->nLength;
+   PayloadWriter_Char(pWriter, (char)(nPrefix + nValueLength));
+
+   if (nTagId == BINARY_TAG_NAMED)
+   {
+      PayloadWriter_Char(pWriter, (char)nNameLength);
+      PayloadWriter_Bytes(pWriter, pszTag, nNameLength);
+   }
+
+   if (nValueLength > 0)
+   {
+      PayloadWriter_Bytes(pWriter, (const char*)pValue, nValueLength);
+   }
+}
+
+/********************************************************************************
+ *
+ * Name:    WriteIntRecord
+ *
+ * Purpose: Appends a binary integer record
+ *
+ * Inputs:  pszTag - parameter tag, NULL for a value without a tag
+ *          nValue - parameter value
+ *
+ * Outputs: pWriter - payload, length and checksum updated
+ *
+ * Returns: None
+ *
+ * Notes:   None.
+ *
+ *******************************************************************************/
+static void WriteIntRecord(PayloadWriter* pWriter, const char* pszTag, int nValue)
+{
+   uint8_t nBytes[BINARY_INT_BYTES];
+   size_t nLength = BinaryEncodeInt(nValue, nBytes);
+
+   WriteRecord(pWriter, pszTag, nBytes, nLength);
+}
+
+/********************************************************************************
+ *
+ * Name:    PatchRecordLength
+ *
+ * Purpose: Fills in the length byte of the open binary list record
+ *
+ * Inputs:  nRecordEnd - payload offset just past the end of the record
+ *
+ * Outputs: pWriter - length byte and checksum updated
+ *
+ * Returns: None
+ *
+ * Notes:   The length byte was summed with its placeholder value when it
+ *          was written, so only the difference is added to the checksum.
+ *
+ *******************************************************************************/
+static void PatchRecordLength(PayloadWriter* pWriter, size_t nRecordEnd)
+{
+   size_t nRecordLength = nRecordEnd - pWriter->nRecordStart - 1;
+
+   if (nRecordLength > BINARY_MAX_VALUE)
+   {
+      nRecordLength = BINARY_MAX_VALUE;
+      pWriter->bOverflow = true;
+   }
+
+   // placeholder from WriteRecord already covers the name of a named tag
+   nRecordLength -= (uint8_t)pWriter->pData[pWriter->nRecordStart];
+   pWriter->pData[pWriter->nRecordStart] += (char)nRecordLength;
+   pWriter->checksum.nSum += (uint32_t)nRecordLength;
+}
+
+/********************************************************************************
+ *
+ * Name:    WriteResponseHeader
+ *
+ * Purpose: Writes the response header in the selected codec, "RSP,code"
+ *
+ * Inputs:  eCode - code of the command being answered
+ *
+ * Outputs: pWriter - positioned after the command code
+ *
+ * Returns: None
+ *
+ * Notes:   None.
+ *
+ *******************************************************************************/
+static void WriteResponseHeader(PayloadWriter* pWriter, ECommandCode eCode)
+{
+   pWriter->eCodec = GetPayloadCodec();
+
+   if (pWriter->eCodec == EPayloadCodecBinary)
+   {
+      PayloadWriter_Bytes(pWriter, HEADER_BIN, BINARY_MARKER_LENGTH);
+      PayloadWriter_Char(pWriter, (char)eCode);
+      PayloadWriter_Char(pWriter, BINARY_FLAG_RESPONSE);
+   }
+   else
+   {
+      PayloadWriter_String(pWriter, RESPONSE_PREFIX);
+      PayloadWriter_Char(pWriter, ',');
+      PayloadWriter_Int(pWriter, (int)eCode);
+   }
+}
+
+/********************************************************************************
+ *
+ * Name:    PayloadWriter_Begin
+ *
+ * Purpose: Starts writing a new payload
+ *
+ * Inputs:  pPayload - payload to write into
+ *
+ * Outputs: pWriter  - ready to write at the start of the payload
+ *
+ * Returns: None
+ *
+ * Notes:   The payload is written as is, no codec header is added.
+ *
+ *******************************************************************************/
+LIB_API
+void PayloadWriter_Begin(PayloadWriter* pWriter, MsgPayload* pPayload)
+{
+   PayloadWriter_BeginMessage(pWriter, pPayload->szPayload, WRITER_CAPACITY + 1);
+   pWriter->pPayload = pPayload;
+
+   pPayload->nLength    = 0;
+   pPayload->nChecksum  = 0;
+   pPayload->bSequenced = false;
+   pPayload->nSequence  = 0;
+}
+
+/********************************************************************************
+ *
+ * Name:    PayloadWriter_BeginMessage
+ *
+ * Purpose: Starts writing a message into a caller supplied buffer
+ *
+ * Inputs:  pBuffer     - buffer to write into
+ *          nBufferSize - size of pBuffer, including room for the NULL
+ *
+ * Outputs: pWriter - ready to write at the start of the buffer
+ *
+ * Returns: None
+ *
+ * Notes:   Used for logical messages longer than a payload, which are sent
+ *          with the transport layer. The message is written as is, no
+ *          codec header is added.
+ *
+ *******************************************************************************/
+LIB_API
+void PayloadWriter_BeginMessage(PayloadWriter* pWriter, char* pBuffer, size_t nBufferSize)
+{
+   pWriter->pPayload     = NULL;
+   pWriter->pData        = pBuffer;
+   pWriter->nCapacity    = (nBufferSize > 0) ? nBufferSize - 1 : 0;
+   pWriter->nLength      = 0;
+   pWriter->eCodec       = EPayloadCodecAscii;
+   pWriter->nRecordStart = 0;
+   pWriter->nItems       = 0;
+   pWriter->nItemValues  = 0;
+   pWriter->bOverflow    = false;
+   ChecksumInit(&pWriter->checksum);
+
+   if (nBufferSize > 0)
+   {
+      pBuffer[0] = '\0';
+   }
+}
+
+/********************************************************************************
+ *
+ * Name:    PayloadWriter_BeginCommand
+ *
+ * Purpose: Starts a command payload in the selected codec
+ *
+ * Inputs:  pPayload - payload to write into
+ *          eCode    - command code
+ *
+ * Outputs: pWriter - positioned after the command code
+ *
+ * Returns: None
+ *
+ * Notes:   ACK and NAK are sent as their control character in ASCII.
+ *
+ *******************************************************************************/
+LIB_API
+void PayloadWriter_BeginCommand(PayloadWriter* pWriter, MsgPayload* pPayload, ECommandCode eCode)
+{
+   PayloadWriter_Begin(pWriter, pPayload);
+   pWriter->eCodec = GetPayloadCodec();
+
+   if (pWriter->eCodec == EPayloadCodecBinary)
+   {
+      PayloadWriter_Bytes(pWriter, HEADER_BIN, BINARY_MARKER_LENGTH);
+      PayloadWriter_Char(pWriter, (char)eCode);
+      PayloadWriter_Char(pWriter, 0);
+   }
+   else if (eCode == EAck || eCode == ENak)
+   {
+      PayloadWriter_Char(pWriter, (char)eCode);
+   }
+   else
+   {
+      PayloadWriter_Int(pWriter, (int)eCode);
+   }
+}
+
+/********************************************************************************
+ *
+ * Name:    PayloadWriter_BeginResponse
+ *
+ * Purpose: Starts a response payload in the selected codec, "RSP,code"
+ *
+ * Inputs:  pPayload - payload to write into
+ *          eCode    - code of the command being answered
+ *
+ * Outputs: pWriter - positioned after the command code
+ *
+ * Returns: None
+ *
+ * Notes:   None.
+ *
+ *******************************************************************************/
+LIB_API
+void PayloadWriter_BeginResponse(PayloadWriter* pWriter, MsgPayload* pPayload, ECommandCode eCode)
+{
+   PayloadWriter_Begin(pWriter, pPayload);
+   WriteResponseHeader(pWriter, eCode);
+}
+
+/********************************************************************************
+ *
+ * Name:    PayloadWriter_BeginResponseMessage
+ *
+ * Purpose: Starts a response message in the selected codec
+ *
+ * Inputs:  pBuffer     - buffer to write into
+ *          nBufferSize - size of pBuffer, including room for the NULL
+ *          eCode       - code of the command being answered
+ *
+ * Outputs: pWriter - positioned after the command code
+ *
+ * Returns: None
+ *
+ * Notes:   For responses too long for one payload, sent with the
+ *          transport layer.
+ *
+ *******************************************************************************/
+LIB_API
+void PayloadWriter_BeginResponseMessage(PayloadWriter* pWriter, char* pBuffer, size_t nBufferSize, ECommandCode eCode)
+{
+   PayloadWriter_BeginMessage(pWriter, pBuffer, nBufferSize);
+   WriteResponseHeader(pWriter, eCode);
+}
+
+/********************************************************************************
+ *
+ * Name:    PayloadWriter_Bytes
+ *
+ * Purpose: Appends raw bytes and adds them to the checksum
+ *
+ * Inputs:  pBytes  - data to append
+ *          nLength - number of bytes in pBytes
+ *
+ * Outputs: pWriter - payload, length and checksum updated
+ *
+ * Returns: None
+ *
+ * Notes:   Short runs are summed in the copy loop. Longer runs are copied
+ *          with memcpy and summed by ChecksumUpdate while still in cache.
+ *
+ *******************************************************************************/
+LIB_API
+void PayloadWriter_Bytes(PayloadWriter* pWriter, const char* pBytes, size_t nLength)
+{
+   char* pDest   = NULL;
+   uint32_t nSum = 0;
+   size_t nCount = 0;
+
+   // drop what does not fit
+   if (nLength > pWriter->nCapacity - pWriter->nLength)
+   {
+      nLength = pWriter->nCapacity - pWriter->nLength;
+      pWriter->bOverflow = true;
+   }
+
+   pDest = pWriter->pData + pWriter->nLength;
+
+   if (nLength < WRITER_BULK_BYTES)
+   {
+      nSum = pWriter->checksum.nSum;
+
+      for (nCount = 0; nCount < nLength; nCount++)
+      {
+         pDest[nCount] = pBytes[nCount];
+         nSum += (uint8_t)pBytes[nCount];
+      }
+
+      pWriter->checksum.nSum = nSum;
+   }
+   else
+   {
+      memcpy(pDest, pBytes, nLength);
+      ChecksumUpdate(&pWriter->checksum, pDest, nLength);
+   }
+
+   pWriter->nLength += nLength;
+}
+
+/********************************************************************************
+ *
+ * Name:    PayloadWriter_Char
+ *
+ * Purpose: Appends a single character
+ *
+ * Inputs:  ch - character to append
+ *
+ * Outputs: pWriter - payload, length and checksum updated
+ *
+ * Returns: None
+ *
+ * Notes:   None.
+ *
+ *******************************************************************************/
+LIB_API
+void PayloadWriter_Char(PayloadWriter* pWriter, char ch)
+{
+   if (pWriter->nLength < pWriter->nCapacity)
+   {
+      pWriter->pData[pWriter->nLength++] = ch;
+      pWriter->checksum.nSum += (uint8_t)ch;
+   }
+   else
+   {
+      pWriter->bOverflow = true;
+   }
+}
+
+/********************************************************************************
+ *
+ * Name:    PayloadWriter_String
+ *
+ * Purpose: Appends a NULL terminated string
+ *
+ * Inputs:  pszValue - string to append
+ *
+ * Outputs: pWriter - payload, length and checksum updated
+ *
+ * Returns: None
+ *
+ * Notes:   A NULL string appends nothing.
+ *
+ *******************************************************************************/
+LIB_API
+void PayloadWriter_String(PayloadWriter* pWriter, const char* pszValue)
+{
+   if (pszValue != NULL)
+   {
+      PayloadWriter_Bytes(pWriter, pszValue, strlen(pszValue));
+   }
+}
+
+/********************************************************************************
+ *
+ * Name:    PayloadWriter_Int
+ *
+ * Purpose: Appends an integer in decimal
+ *
+ * Inputs:  nValue - value to append
+ *
+ * Outputs: pWriter - payload, length and checksum updated
+ *
+ * Returns: None
+ *
+ * Notes:   Output matches "%d".
+ *
+ *******************************************************************************/
+LIB_API
+void PayloadWriter_Int(PayloadWriter* pWriter, int nValue)
+{
+   char szDigits[INT_DIGITS_SIZE];
+
+   PayloadWriter_Bytes(pWriter, szDigits, DecimalFormatInt(szDigits, nValue));
+}
+
+/********************************************************************************
+ *
+ * Name:    PayloadWriter_Hex
+ *
+ * Purpose: Appends an integer in upper case hex
+ *
+ * Inputs:  nValue - value to append
+ *
+ * Outputs: pWriter - payload, length and checksum updated
+ *
+ * Returns: None
+ *
+ * Notes:   Output matches "%X".
+ *
+ *******************************************************************************/
+LIB_API
+void PayloadWriter_Hex(PayloadWriter* pWriter, unsigned int nValue)
+{
+   static const char szHex[] = "0123456789ABCDEF";
+   char szDigits[INT_DIGITS_SIZE];
+   char* pDigit = szDigits + sizeof(szDigits);
+
+   do
+   {
+      *--pDigit = szHex[nValue & 0xF];
+      nValue >>= 4;
+   } while (nValue != 0);
+
+   PayloadWriter_Bytes(pWriter, pDigit, (size_t)(szDigits + sizeof(szDigits) - pDigit));
+}
+
+/********************************************************************************
+ *
+ * Name:    PayloadWriter_Float
+ *
+ * Purpose: Appends a float
+ *
+ * Inputs:  dValue - value to append
+ *
+ * Outputs: pWriter - payload, length and checksum updated
+ *
+ * Returns: None
+ *
+ * Notes:   Output matches "%f". Very large values are cut short and set
+ *          bOverflow, they would not have fit in a payload anyway.
+ *
+ *******************************************************************************/
+LIB_API
+void PayloadWriter_Float(PayloadWriter* pWriter, float dValue)
+{
+   char szDigits[FLOAT_DIGITS_SIZE];
+   int nWritten = snprintf(szDigits, sizeof(szDigits), "%f", dValue);
+
+   if (nWritten < 0)
+   {
+      pWriter->bOverflow = true;
+   }
+   else if ((size_t)nWritten >= sizeof(szDigits))
+   {
+      PayloadWriter_Bytes(pWriter, szDigits, sizeof(szDigits) - 1);
+      pWriter->bOverflow = true;
+   }
+   else
+   {
+      PayloadWriter_Bytes(pWriter, szDigits, (size_t)nWritten);
+   }
+}
+
+/********************************************************************************
+ *
+ * Name:    PayloadWriter_Tag
+ *
+ * Purpose: Appends the start of a parameter, ",TAG="
+ *
+ * Inputs:  pszTag - parameter tag
+ *
+ * Outputs: pWriter - payload, length and checksum updated
+ *
+ * Returns: None
+ *
+ * Notes:   None.
+ *
+ *******************************************************************************/
+LIB_API
+void PayloadWriter_Tag(PayloadWriter* pWriter, const char* pszTag)
+{
+   PayloadWriter_Char(pWriter, ',');
+   PayloadWriter_String(pWriter, pszTag);
+   PayloadWriter_Char(pWriter, '=');
+}
+
+/********************************************************************************
+ *
+ * Name:    PayloadWriter_IntParam
+ *
+ * Purpose: Appends an integer parameter, ",TAG=n"
+ *
+ * Inputs:  pszTag - parameter tag
+ *          nValue - parameter value
+ *
+ * Outputs: pWriter - payload, length and checksum updated
+ *
+ * Returns: None
+ *
+ * Notes:   None.
+ *
+ *******************************************************************************/
+LIB_API
+void PayloadWriter_IntParam(PayloadWriter* pWriter, const char* pszTag, int nValue)
+{
+   if (pWriter->eCodec == EPayloadCodecBinary)
+   {
+      WriteIntRecord(pWriter, pszTag, nValue);
+   }
+   else
+   {
+      PayloadWriter_Tag(pWriter, pszTag);
+      PayloadWriter_Int(pWriter, nValue);
+   }
+}
+
+/********************************************************************************
+ *
+ * Name:    PayloadWriter_StringParam
+ *
+ * Purpose: Appends a string parameter, ",TAG=value"
+ *
+ * Inputs:  pszTag   - parameter tag
+ *          pszValue - parameter value
+ *
+ * Outputs: pWriter - payload, length and checksum updated
+ *
+ * Returns: None
+ *
+ * Notes:   None.
+ *
+ *******************************************************************************/
+LIB_API
+void PayloadWriter_StringParam(PayloadWriter* pWriter, const char* pszTag, const char* pszValue)
+{
+   if (pWriter->eCodec == EPayloadCodecBinary)
+   {
+      WriteRecord(pWriter, pszTag, pszValue, (pszValue != NULL) ? strlen(pszValue) : 0);
+   }
+   else
+   {
+      PayloadWriter_Tag(pWriter, pszTag);
+      PayloadWriter_String(pWriter, pszValue);
+   }
+}
+
+/********************************************************************************
+ *
+ * Name:    PayloadWriter_FloatParam
+ *
+ * Purpose: Appends a float parameter, ",TAG=%f"
+ *
+ * Inputs:  pszTag - parameter tag
+ *          dValue - parameter value
+ *
+ * Outputs: pWriter - payload, length and checksum updated
+ *
+ * Returns: None
+ *
+ * Notes:   Binary payloads get the 4 byte IEEE value, little endian.
+ *
+ *******************************************************************************/
+LIB_API
+void PayloadWriter_FloatParam(PayloadWriter* pWriter, const char* pszTag, float dValue)
+{
+   uint32_t nBits = 0;
+
+   if (pWriter->eCodec == EPayloadCodecBinary)
+   {
+      memcpy(&nBits, &dValue, sizeof(nBits));
+      WriteIntRecord(pWriter, pszTag, (int)nBits);
+   }
+   else
+   {
+      PayloadWriter_Tag(pWriter, pszTag);
+      PayloadWriter_Float(pWriter, dValue);
+   }
+}
+
+/********************************************************************************
+ *
+ * Name:    PayloadWriter_VersionParam
+ *
+ * Purpose: Appends a firmware version parameter, ",TAG=major.minor.revision"
+ *
+ * Inputs:  pszTag   - parameter tag
+ *          pVersion - firmware version
+ *
+ * Outputs: pWriter - payload, length and checksum updated
+ *
+ * Returns: None
+ *
+ * Notes:   ASCII version numbers are sent in hex. Binary payloads get a
+ *          record of three varints.
+ *
+ *******************************************************************************/
+LIB_API
+void PayloadWriter_VersionParam(PayloadWriter* pWriter, const char* pszTag, const FirmwareVersion* pVersion)
+{
+   uint8_t nBytes[3 * BINARY_VARINT_BYTES];
+   size_t nLength = 0;
+
+   if (pWriter->eCodec == EPayloadCodecBinary)
+   {
+      nLength += BinaryEncodeVarint(pVersion->nMajor, nBytes + nLength);
+      nLength += BinaryEncodeVarint(pVersion->nMinor, nBytes + nLength);
+      nLength += BinaryEncodeVarint(pVersion->nRevision, nBytes + nLength);
+      WriteRecord(pWriter, pszTag, nBytes, nLength);
+   }
+   else
+   {
+      PayloadWriter_Tag(pWriter, pszTag);
+      PayloadWriter_Hex(pWriter, (unsigned int)pVersion->nMajor);
+      PayloadWriter_Char(pWriter, '.');
+      PayloadWriter_Hex(pWriter, (unsigned int)pVersion->nMinor);
+      PayloadWriter_Char(pWriter, '.');
+      PayloadWriter_Hex(pWriter, (unsigned int)pVersion->nRevision);
+   }
+}
+
+/********************************************************************************
+ *
+ * Name:    PayloadWriter_Value
+ *
+ * Purpose: Appends an integer without a tag, ",n"
+ *
+ * Inputs:  nValue - value to append
+ *
+ * Outputs: pWriter - payload, length and checksum updated
+ *
+ * Returns: None
+ *
+ * Notes:   None.
+ *
+ *******************************************************************************/
+LIB_API
+void PayloadWriter_Value(PayloadWriter* pWriter, int nValue)
+{
+   if (pWriter->eCodec == EPayloadCodecBinary)
+   {
+      WriteIntRecord(pWriter, NULL, nValue);
+   }
+   else
+   {
+      PayloadWriter_Char(pWriter, ',');
+      PayloadWriter_Int(pWriter, nValue);
+   }
+}
+
+/********************************************************************************
+ *
+ * Name:    PayloadWriter_BeginList
+ *
+ * Purpose: Starts a list parameter, ",TAG="
+ *
+ * Inputs:  pszTag - parameter tag
+ *
+ * Outputs: pWriter - ready for the first item
+ *
+ * Returns: None
+ *
+ * Notes:   Binary payloads get an empty record, its length is filled in by
+ *          PayloadWriter_EndList.
+ *
+ *******************************************************************************/
+LIB_API
+void PayloadWriter_BeginList(PayloadWriter* pWriter, const char* pszTag)
+{
+   if (pWriter->eCodec == EPayloadCodecBinary)
+   {
+      WriteRecord(pWriter, pszTag, NULL, 0);
+   }
+   else
+   {
+      PayloadWriter_Tag(pWriter, pszTag);
+   }
+
+   pWriter->nItems = 0;
+}
+
+/********************************************************************************
+ *
+ * Name:    PayloadWriter_BeginItem
+ *
+ * Purpose: Starts a list item
+ *
+ * Inputs:  None
+ *
+ * Outputs: pWriter - ready for the first item value
+ *
+ * Returns: None
+ *
+ * Notes:   ASCII items are in braces and separated by commas.
+ *
+ *******************************************************************************/
+LIB_API
+void PayloadWriter_BeginItem(PayloadWriter* pWriter)
+{
+   if (pWriter->eCodec != EPayloadCodecBinary)
+   {
+      if (pWriter->nItems > 0)
+      {
+         PayloadWriter_Char(pWriter, ',');
+      }
+
+      PayloadWriter_Char(pWriter, '{');
+   }
+
+   pWriter->nItems++;
+   pWriter->nItemValues = 0;
+   pWriter->nItemStart  = pWriter->nLength;
+}
+
+/********************************************************************************
+ *
+ * Name:    PayloadWriter_ItemInt
+ *
+ * Purpose: Appends an integer to the open list item
+ *
+ * Inputs:  nValue - value to append
+ *
+ * Outputs: pWriter - payload, length and checksum updated
+ *
+ * Returns: None
+ *
+ * Notes:   None.
+ *
+ *******************************************************************************/
+LIB_API
+void PayloadWriter_ItemInt(PayloadWriter* pWriter, int nValue)
+{
+   uint8_t nBytes[BINARY_VARINT_BYTES];
+
+   if (pWriter->eCodec == EPayloadCodecBinary)
+   {
+      PayloadWriter_Bytes(pWriter, (const char*)nBytes, BinaryEncodeVarint(nValue, nBytes));
+   }
+   else
+   {
+      if (pWriter->nItemValues > 0)
+      {
+         PayloadWriter_Char(pWriter, ',');
+      }
+
+      PayloadWriter_Int(pWriter, nValue);
+   }
+
+   pWriter->nItemValues++;
+}
+
+/********************************************************************************
+ *
+ * Name:    PayloadWriter_ItemString
+ *
+ * Purpose: Appends a string to the open list item
+ *
+ * Inputs:  pszValue - value to append
+ *
+ * Outputs: pWriter - payload, length and checksum updated
+ *
+ * Returns: None
+ *
+ * Notes:   Binary strings longer than a length byte can hold are cut short.
+ *
+ *******************************************************************************/
+LIB_API
+void PayloadWriter_ItemString(PayloadWriter* pWriter, const char* pszValue)
+{
+   size_t nLength = (pszValue != NULL) ? strlen(pszValue) : 0;
+
+   if (pWriter->eCodec == EPayloadCodecBinary)
+   {
+      if (nLength > BINARY_MAX_VALUE)
+      {
+         nLength = BINARY_MAX_VALUE;
+         pWriter->bOverflow = true;
+      }
+
+      PayloadWriter_Char(pWriter, (char)nLength);
+      PayloadWriter_Bytes(pWriter, pszValue, nLength);
+   }
+   else
+   {
+      if (pWriter->nItemValues > 0)
+      {
+         PayloadWriter_Char(pWriter, ',');
+      }
+
+      PayloadWriter_Bytes(pWriter, pszValue, nLength);
+   }
+
+   pWriter->nItemValues++;
+}
+
+/********************************************************************************
+ *
+ * Name:    PayloadWriter_EndItem
+ *
+ * Purpose: Closes the open list item
+ *
+ * Inputs:  None
+ *
+ * Outputs: pWriter - payload, length and checksum updated
+ *
+ * Returns: None
+ *
+ * Notes:   A binary list that outgrows its record is continued in a new
+ *          record with the same tag, starting with the item just written.
+ *          Lists under a tag without a tag id are not continued.
+ *
+ *******************************************************************************/
+LIB_API
+void PayloadWriter_EndItem(PayloadWriter* pWriter)
+{
+   size_t nItemLength = pWriter->nLength - pWriter->nItemStart;
+   uint8_t nTagId     = 0;
+
+   if (pWriter->eCodec != EPayloadCodecBinary)
+   {
+      PayloadWriter_Char(pWriter, '}');
+   }
+   else if (pWriter->nItems > 1
+        &&  pWriter->nRecordStart > 0
+        &&  pWriter->nLength - pWriter->nRecordStart - 1 > BINARY_MAX_VALUE
+        &&  pWriter->nCapacity - pWriter->nLength >= 2)
+   {
+      nTagId = (uint8_t)pWriter->pData[pWriter->nRecordStart - 1];
+
+      if (nTagId != BINARY_TAG_NAMED)
+      {
+         // close the record before this item, then open a new one for it
+         PatchRecordLength(pWriter, pWriter->nItemStart);
+
+         memmove(pWriter->pData + pWriter->nItemStart + 2, pWriter->pData + pWriter->nItemStart, nItemLength);
+         pWriter->pData[pWriter->nItemStart]     = (char)nTagId;
+         pWriter->pData[pWriter->nItemStart + 1] = 0;
+         pWriter->checksum.nSum += nTagId;
+
+         pWriter->nRecordStart = pWriter->nItemStart + 1;
+         pWriter->nLength     += 2;
+      }
+   }
+}
+
+/********************************************************************************
+ *
+ * Name:    PayloadWriter_EndList
+ *
+ * Purpose: Closes the open list parameter
+ *
+ * Inputs:  None
+ *
+ * Outputs: pWriter - binary record length filled in
+ *
+ * Returns: None
+ *
+ * Notes:   None.
+ *
+ *******************************************************************************/
+LIB_API
+void PayloadWriter_EndList(PayloadWriter* pWriter)
+{
+   if (pWriter->eCodec == EPayloadCodecBinary
+   &&  pWriter->nRecordStart < pWriter->nLength)
+   {
+      PatchRecordLength(pWriter, pWriter->nLength);
+   }
+}
+
+/********************************************************************************
+ *
+ * Name:    PayloadWriter_End
+ *
+ * Purpose: Finishes the payload
+ *
+ * Inputs:  pWriter - writer used to build the payload
+ *
+ * Outputs: pWriter->pPayload - NULL terminated, nLength and nChecksum set
+ *
+ * Returns: true if everything written fit in the payload
+ *
+ * Notes:   A message started with PayloadWriter_BeginMessage is only NULL
+ *          terminated, its length is in pWriter->nLength.
+ *
+ *******************************************************************************/
+LIB_API
+bool PayloadWriter_End(PayloadWriter* pWriter)
+{
+   MsgPayload* pPayload = pWriter->pPayload;
+
+   pWriter->pData[pWriter->nLength] = '\0';
+
+   if (pPayload != NULL)
+   {
+      pPayload->nLength   = pWriter->nLength;
+      pPayload->nChecksum = ChecksumFinal(&pWriter->checksum);
+   }
+
+   return !pWriter->bOverflow;
+}
@@ -0,0 +1,107 @@
+/*********************************************************************************
+*
+*                          Proprietary Information of
+*
+*                            Precision Systems, Inc.
+*                    1355 Business Center Drive, Suite C
+*                                 Horsham, PA
+*                               (215) 672-1860
+*
+*                   Copyright (C) 2020, Precision Systems, Inc.
+*                            All Rights Reserved
+*
+*             The information and design as detailed in this document is
+*     the property of Precision Systems, Inc., and/or its Associates
+*     and must be returned on demand. It is issued on the strict
+*     condition that except with our written permission it must not be
+*     reproduced, copied or communicated to any third party, nor be
+*     used for any purpose other than that stated in the particular
+*     inquiry, order or contract with which it is issued. The
+*     reservation of copyright in this document extends from each date
+*     appearing thereon and in respect of the subject matter as it
+*     appeared at the relevant date.
+*
+********************************************************************************/
+/********************************************************************************
+*
+* PROJECT:     Project MIDAS
+*
+* COMPILER:    
+*
+* TOOLS:       Microsoft Visual Studio 2019
+*
+* DESCRIPTION: Atomic loads, stores, counters and compare exchange, and
+*              thread local storage
+*
+* NOTES:       For data one thread publishes and others read, e.g. a lookup
+*              table built on first use or a function pointer picked for
+*              the CPU. Store the data, then STORE_RELEASE the flag or
+*              pointer; a reader that sees it with LOAD_ACQUIRE also sees
+*              the data.
+*
+*              The _SEQ_CST forms and the counters are full barriers, for
+*              two threads that each store one variable and then load the
+*              other, e.g. a reader count and the pointer it guards.
+*
+*              GCC and clang use their __atomic builtins. With MSVC the
+*              variable must be volatile, which /volatile:ms (the default
+*              for x86 and x64) makes acquire and release.
+*
+********************************************************************************/
+#ifndef COMMAND_ATOMIC_H
+#define COMMAND_ATOMIC_H
+/********************************************************************************
+*                              I N C L U D E S
+********************************************************************************/
+#include <stdbool.h>
+
+#if defined(_MSC_VER) && !defined(__clang__)
+   #include <intrin.h>
+#endif
+
+/********************************************************************************
+*                          D E F I N I T I O N S
+********************************************************************************/
+#if defined(__GNUC__) || defined(__clang__)
+   #define LOAD_ACQUIRE(p)       __atomic_load_n(&(p), __ATOMIC_ACQUIRE)
+   #define STORE_RELEASE(p, v)   __atomic_store_n(&(p), (v), __ATOMIC_RELEASE)
+
+   // true if p held expected and now holds desired, expected must be an lvalue
+   #define COMPARE_EXCHANGE(p, expected, desired) \
+      __atomic_compare_exchange_n(&(p), &(expected), (desired), false, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)
+
+   #define LOAD_SEQ_CST(p)       __atomic_load_n(&(p), __ATOMIC_SEQ_CST)
+   #define STORE_SEQ_CST(p, v)   __atomic_store_n(&(p), (v), __ATOMIC_SEQ_CST)
+   #define ATOMIC_INCREMENT(p)   __atomic_add_fetch(&(p), 1, __ATOMIC_SEQ_CST)
+   #define ATOMIC_DECREMENT(p)   __atomic_sub_fetch(&(p), 1, __ATOMIC_SEQ_CST)
+#elif defined(_MSC_VER)
+   #define LOAD_ACQUIRE(p)       (p)
+   #define STORE_RELEASE(p, v)   ((p) = (v))
+
+   #define COMPARE_EXCHANGE(p, expected, desired)                                                \
+      ((sizeof(p) == 1)                                                                          \
+       ? (_InterlockedCompareExchange8((volatile char*)&(p), (char)(desired), (char)(expected))  \
+          == (char)(expected))                                                                   \
+       : (_InterlockedCompareExchange((volatile long*)&(p), (long)(desired), (long)(expected))   \
+          == (long)(expected)))
+
+   // the interlocked operations are the barriers, so with MSVC STORE_SEQ_CST
+   // is for pointers and the counters must be long
+   #define LOAD_SEQ_CST(p)       (p)
+   #define STORE_SEQ_CST(p, v)   ((void)_InterlockedExchangePointer((void* volatile*)&(p), (void*)(v)))
+   #define ATOMIC_INCREMENT(p)   _InterlockedIncrement((volatile long*)&(p))
+   #define ATOMIC_DECREMENT(p)   _InterlockedDecrement((volatile long*)&(p))
+#else
+   #error "commandAtomic.h: no atomic operations for this compiler"
+#endif
+
+#if defined(_MSC_VER)
+   #define THREAD_LOCAL __declspec(thread)
+#elif defined(__GNUC__) || defined(__clang__)
+   #define THREAD_LOCAL __thread
+#else
+   // no thread local storage, sessions must all be used on one thread
+   #define THREAD_LOCAL
+#endif
+
+#endif // COMMAND_ATOMIC_H
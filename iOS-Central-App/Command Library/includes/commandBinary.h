@@ -0,0 +1,186 @@
+/*********************************************************************************
+*
+*                          Proprietary Information of
+*
+*                            Precision Systems, Inc.
+*                    1355 Business Center Drive, Suite C
+*                                 Horsham, PA
+*                               (215) 672-1860
+*
+*                   Copyright (C) 2020, Precision Systems, Inc.
+*                            All Rights Reserved
+*
+*             The information and design as detailed in this document is
+*     the property of Precision Systems, Inc., and/or its Associates
+*     and must be returned on demand. It is issued on the strict
+*     condition that except with our written permission it must not be
+*     reproduced, copied or communicated to any third party, nor be
+*     used for any purpose other than that stated in the particular
+*     inquiry, order or contract with which it is issued. The
+*     reservation of copyright in this document extends from each date
+*     appearing thereon and in respect of the subject matter as it
+*     appeared at the relevant date.
+*
+********************************************************************************/
+/********************************************************************************
+*
+* PROJECT:     Project MIDAS
+*
+* COMPILER:    
+*
+* TOOLS:       Microsoft Visual Studio 2019
+*
+* DESCRIPTION: Binary ("PH+B") payload encoding
+*
+* NOTES:       A binary payload starts with HEADER_BIN, the command code and
+*              a flags byte. It is followed by records, each made of a tag id,
+*              a value length and the value bytes. Integers are sent little
+*              endian in as few bytes as hold them. List items (log entries)
+*              use zigzag varints and length prefixed strings.
+*
+*              The frame around the payload is the same as for ASCII
+*              payloads, so the receiver tells them apart by the header.
+*
+********************************************************************************/
+#ifndef COMMAND_BINARY_H
+#define COMMAND_BINARY_H
+/********************************************************************************
+*                              I N C L U D E S
+********************************************************************************/
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "commandParameters.h"
+
+/********************************************************************************
+*                          D E F I N I T I O N S
+********************************************************************************/
+// "PH+B", command code and flags
+#define BINARY_MARKER_LENGTH   4
+#define BINARY_HEADER_LENGTH   (BINARY_MARKER_LENGTH + 2)
+
+// flags byte
+#define BINARY_FLAG_RESPONSE   0x01
+
+// record tag ids that are not parameter tags
+#define BINARY_TAG_NONE        0x00   // value without a tag (NAK error code)
+#define BINARY_TAG_NAMED       0xFF   // tag sent as text: name length, name, value
+
+// largest record value, the length is a single byte
+#define BINARY_MAX_VALUE       0xFF
+
+// bytes needed for any int
+#define BINARY_INT_BYTES       4
+#define BINARY_VARINT_BYTES    5
+
+/*********************************************************************************
+*                            S T R U C T U R E S
+*********************************************************************************/
+// one record read from a binary payload
+typedef struct _BinaryRecord
+{
+   uint8_t   nTagId;
+   FrameView name;      // parameter tag text, empty for BINARY_TAG_NONE
+   FrameView value;     // value bytes, points into the payload
+} BinaryRecord;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+   LIB_API
+   bool IsBinaryPayload(const char* pData, size_t nLength);
+   // Checks for the binary payload header
+   // Inputs:  pData   - payload bytes
+   //          nLength - number of bytes in pData
+   // Outputs: None.
+   // Returns: true if the payload is binary
+   // Notes:   None.
+
+   LIB_API
+   bool BinaryReadHeader(FrameView* pReader, ECommandCode* peCode, uint8_t* pnFlags);
+   // Reads the binary payload header
+   // Inputs:  pReader - binary payload, advanced to the first record
+   // Outputs: peCode  - command code
+   //          pnFlags - flags byte, may be NULL
+   // Returns: true if the header was read
+   // Notes:   None.
+
+   LIB_API
+   bool BinaryNextRecord(FrameView* pReader, BinaryRecord* pRecord);
+   // Reads the next record
+   // Inputs:  pReader - remaining records, advanced past the record
+   // Outputs: pRecord - tag and value of the record
+   // Returns: true if a complete record was read
+   // Notes:   Tag names and values point into the payload or the tag table.
+
+   LIB_API
+   EParamTag ParamTagLookup(const char* pTag, size_t nLength);
+   // Maps parameter tag text to its id
+   // Inputs:  pTag    - tag text, not NULL terminated, e.g. a parsed field
+   //          nLength - number of bytes in pTag
+   // Outputs: None.
+   // Returns: Tag id, ETagNone if the text isn't a parameter tag
+   // Notes:   Perfect hash, one final compare.
+
+   LIB_API
+   uint8_t BinaryTagId(const char* pszTag);
+   // Looks up the record tag id of a parameter tag
+   // Inputs:  pszTag - parameter tag, e.g. TAG_O2_FLOW
+   // Outputs: None.
+   // Returns: Tag id, BINARY_TAG_NAMED if the tag has no id
+   // Notes:   None.
+
+   LIB_API
+   const char* BinaryTagName(uint8_t nTagId);
+   // Looks up the parameter tag of a record tag id
+   // Inputs:  nTagId - record tag id
+   // Outputs: None.
+   // Returns: Parameter tag, NULL if the id is unknown
+   // Notes:   None.
+
+   LIB_API
+   size_t BinaryEncodeInt(int nValue, uint8_t* pBytes);
+   // Encodes an integer record value
+   // Inputs:  nValue - value to encode
+   // Outputs: pBytes - BINARY_INT_BYTES or fewer bytes written
+   // Returns: Number of bytes written
+   // Notes:   Little endian, shortest form that sign extends to nValue.
+
+   LIB_API
+   int BinaryValueToInt(const FrameView* pValue);
+   // Decodes an integer record value
+   // Inputs:  pValue - record value
+   // Outputs: None.
+   // Returns: Decoded value, 0 for an empty value
+   // Notes:   None.
+
+   LIB_API
+   size_t BinaryEncodeVarint(int nValue, uint8_t* pBytes);
+   // Encodes a list item integer
+   // Inputs:  nValue - value to encode
+   // Outputs: pBytes - BINARY_VARINT_BYTES or fewer bytes written
+   // Returns: Number of bytes written
+   // Notes:   Zigzag varint, small values of either sign take one byte.
+
+   LIB_API
+   bool BinaryReadVarint(FrameView* pReader, int* pValue);
+   // Reads a list item integer
+   // Inputs:  pReader - list data, advanced past the value
+   // Outputs: pValue - decoded value
+   // Returns: true if a complete value was read
+   // Notes:   None.
+
+   LIB_API
+   bool BinaryReadString(FrameView* pReader, FrameView* pValue);
+   // Reads a length prefixed list item string
+   // Inputs:  pReader - list data, advanced past the value
+   // Outputs: pValue - string bytes, points into the list data
+   // Returns: true if a complete value was read
+   // Notes:   None.
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -60,7 +60,7 @@ extern "C" {
 #define RESPONSE_PREFIX       "RSP"
 #define ERROR_PREFIX          "ERR"
 
-// Parameter tags
+// Parameter tags, a new tag also needs a TAG_SCHEMA row in commandSchema.h
 #define TAG_O2_MIX            "O2"
 #define TAG_TOGGLE_PIN        "PIN_EN"
 #define TAG_PIN_RESP          "PIN"
@@ -120,7 +120,7 @@ void BuildCommandNoParameter(ECommandCode eId, MsgPayload* pPayload);
    // Returns: None.
    // Notes:   None.
    LIB_API
-   void BuildCommandEchoResponse(EHandlerResponse eResponse, ECommandCode eCode,  MsgPayload* pReceived, MsgPayload* pResponse);
+   void BuildCommandEchoResponse(EHandlerResponse eResponse, ECommandCode eCode,  const MsgPayload* pReceived, MsgPayload* pResponse);
 
    // Builds command error response
    // Inputs:  eResponse - result from command handler
@@ -131,6 +131,27 @@ void BuildCommandNoParameter(ECommandCode eId, MsgPayload* pPayload);
    LIB_API
    void BuildCommandErrorResponse(EHandlerResponse eResponse, ECommandCode eCode, MsgPayload* pResponse);
 
+   // Builds a command payload from its COMMAND_SCHEMA row
+   // Inputs:  eCode  - command code
+   //          nValue - parameter value, SET_BOOL and SET_INT rows only
+   // Outputs: pPayload - populated the message buffer, length & checksum
+   // Returns: None.
+   // Notes:   SET_BOOL and SET_INT rows write their tag and nValue, other
+   //          rows are built without parameters. There is no range check,
+   //          that happens in the command handler.
+   LIB_API
+   void BuildSchemaCommand(ECommandCode eCode, int nValue, MsgPayload* pPayload);
+
+   // Builds the response of a GET_INT row of COMMAND_SCHEMA
+   // Inputs:  eResponse - result from command handler
+   //          eCode     - command code
+   //          nValue    - value from the command handler
+   // Outputs: pPayload - payload for command response
+   // Returns: None.
+   // Notes:   Codes that aren't GET_INT rows are answered with EOpNotAllowed.
+   LIB_API
+   void BuildSchemaResponse(EHandlerResponse eResponse, ECommandCode eCode, int nValue, MsgPayload* pPayload);
+
    // Builds vacuum increase command payload
    // Inputs:  None
    // Outputs: pPayload - populated the message buffer, length & checksum
@@ -471,7 +492,7 @@ void BuildCommandNoParameter(ECommandCode eId, MsgPayload* pPayload);
    LIB_API
    void BuildReadManufacturerFieldCommandResponse(EHandlerResponse eResponse, 
                                                   const char* pValue,
-                                                  MsgPayload* pPayload, 
+                                                  const MsgPayload* pPayload, 
                                                   MsgPayload* pResponse);
 
    // Builds the ACK command
@@ -650,6 +671,38 @@ void BuildCommandNoParameter(ECommandCode eId, MsgPayload* pPayload);
 
    LIB_API
    void BuildGetProcedureLogEntryListCommandResponse(EHandlerResponse eResponse, int nCount, LogEntry* pEntries, MsgPayload* pPayload);
+
+   // Builds the procedure log list response as one logical message, for lists
+   // too long for a single payload
+   // Inputs:  eResponse   - command handler response code
+   //          nCount      - the number of records in the response
+   //          pEntries    - pointer to array of nCount number of records.
+   //          nBufferSize - size of pBuffer
+   // Outputs: pBuffer - NULL terminated response message
+   // Returns: Length of the message, 0 if it didn't fit
+   // Notes:   Send the message with Transport_BeginSend/Transport_NextFragment.
+   LIB_API
+   size_t BuildGetProcedureLogListMessageResponse(EHandlerResponse eResponse,
+                                                  int nCount,
+                                                  const ProcedureLog* pEntries,
+                                                  char* pBuffer,
+                                                  size_t nBufferSize);
+
+   // Builds the procedure log entry list response as one logical message, so
+   // a whole procedure log is returned to one request
+   // Inputs:  eResponse   - command handler response code
+   //          nCount      - the number of records in the response
+   //          pEntries    - pointer to array of nCount number of records.
+   //          nBufferSize - size of pBuffer
+   // Outputs: pBuffer - NULL terminated response message
+   // Returns: Length of the message, 0 if it didn't fit
+   // Notes:   Send the message with Transport_BeginSend/Transport_NextFragment.
+   LIB_API
+   size_t BuildGetProcedureLogEntryListMessageResponse(EHandlerResponse eResponse,
+                                                       int nCount,
+                                                       const LogEntry* pEntries,
+                                                       char* pBuffer,
+                                                       size_t nBufferSize);
    
  
    // Builds payload for get alarm log list command
@@ -0,0 +1,101 @@
+/*********************************************************************************
+*
+*                          Proprietary Information of
+*
+*                            Precision Systems, Inc.
+*                    1355 Business Center Drive, Suite C
+*                                 Horsham, PA
+*                               (215) 672-1860
+*
+*                   Copyright (C) 2020, Precision Systems, Inc.
+*                            All Rights Reserved
+*
+*             The information and design as detailed in this document is
+*     the property of Precision Systems, Inc., and/or its Associates
+*     and must be returned on demand. It is issued on the strict
+*     condition that except with our written permission it must not be
+*     reproduced, copied or communicated to any third party, nor be
+*     used for any purpose other than that stated in the particular
+*     inquiry, order or contract with which it is issued. The
+*     reservation of copyright in this document extends from each date
+*     appearing thereon and in respect of the subject matter as it
+*     appeared at the relevant date.
+*
+********************************************************************************/
+/********************************************************************************
+*
+* PROJECT:     Project MIDAS
+*
+* COMPILER:    
+*
+* TOOLS:       Microsoft Visual Studio 2019
+*
+* DESCRIPTION: Frame checksum calculation
+*
+* NOTES:       The frame checksum is the sum of the payload bytes, modulo 256.
+*              It can be calculated in one call or accumulated a piece at a
+*              time while a payload is written or received.
+*
+********************************************************************************/
+#ifndef COMMAND_CHECKSUM_H
+#define COMMAND_CHECKSUM_H
+/********************************************************************************
+*                              I N C L U D E S
+********************************************************************************/
+#include <stddef.h>
+#include <stdint.h>
+#include "commandParameters.h"
+
+/*********************************************************************************
+*                            S T R U C T U R E S
+*********************************************************************************/
+// running checksum. Only the low 8 bits are sent.
+typedef struct _ChecksumState
+{
+   uint32_t nSum;
+} ChecksumState;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+   LIB_API
+   void ChecksumInit(ChecksumState* pState);
+   // Starts a new checksum
+   // Inputs:  None.
+   // Outputs: pState - cleared
+   // Returns: None.
+   // Notes:   None.
+
+   LIB_API
+   void ChecksumUpdate(ChecksumState* pState, const void* pBytes, size_t nLength);
+   // Adds bytes to a running checksum
+   // Inputs:  pBytes  - data to add
+   //          nLength - number of bytes in pBytes
+   // Outputs: pState - updated with the data
+   // Returns: None.
+   // Notes:   Data can be added in pieces of any size, the result is the
+   //          same as adding it all at once.
+
+   LIB_API
+   uint8_t ChecksumFinal(const ChecksumState* pState);
+   // Returns the frame checksum for the data added so far
+   // Inputs:  pState - running checksum
+   // Outputs: None.
+   // Returns: 8 bit frame checksum
+   // Notes:   None.
+
+   LIB_API
+   uint8_t ChecksumBytes(const void* pBytes, size_t nLength);
+   // Calculates the frame checksum of a buffer in one call
+   // Inputs:  pBytes  - data to sum
+   //          nLength - number of bytes in pBytes
+   // Outputs: None.
+   // Returns: 8 bit frame checksum
+   // Notes:   None.
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,140 @@
+/*********************************************************************************
+*
+*                          Proprietary Information of
+*
+*                            Precision Systems, Inc.
+*                    1355 Business Center Drive, Suite C
+*                                 Horsham, PA
+*                               (215) 672-1860
+*
+*                   Copyright (C) 2020, Precision Systems, Inc.
+*                            All Rights Reserved
+*
+*             The information and design as detailed in this document is
+*     the property of Precision Systems, Inc., and/or its Associates
+*     and must be returned on demand. It is issued on the strict
+*     condition that except with our written permission it must not be
+*     reproduced, copied or communicated to any third party, nor be
+*     used for any purpose other than that stated in the particular
+*     inquiry, order or contract with which it is issued. The
+*     reservation of copyright in this document extends from each date
+*     appearing thereon and in respect of the subject matter as it
+*     appeared at the relevant date.
+*
+********************************************************************************/
+/********************************************************************************
+*
+* PROJECT:     Project MIDAS
+*
+* COMPILER:    
+*
+* TOOLS:       Microsoft Visual Studio 2019
+*
+* DESCRIPTION: Completion of commands run by async handlers
+*
+* NOTES:       A slow command, e.g. a firmware download, can be handed to an
+*              async handler so the thread parsing frames isn't held up.
+*              DispatchFrame keeps a copy of the request and gives the
+*              handler a token. The handler returns EPending, DispatchFrame
+*              sends nothing, and the handler later calls CompleteCommand
+*              from any thread. The response is built there and passed to
+*              the fpSendResponse handler.
+*
+*              Tokens are only handed out by the thread that calls
+*              DispatchFrame. Each token is completed once, a stale or
+*              repeated token is refused. Tokens belong to the current
+*              session, complete them with CmdSession_CompleteCommand from
+*              a thread outside the session.
+*
+********************************************************************************/
+#ifndef COMMAND_COMPLETION_H
+#define COMMAND_COMPLETION_H
+/********************************************************************************
+*                              I N C L U D E S
+********************************************************************************/
+#include <stdbool.h>
+#include <stddef.h>
+#include "commandParameters.h"
+#include "commandHandlers.h"
+
+/********************************************************************************
+*                          D E F I N I T I O N S
+********************************************************************************/
+// most commands waiting for an async handler at once, per session
+#define PENDING_COMMAND_MAX 4
+
+/********************************************************************************
+*                          S T R U C T U R E S
+********************************************************************************/
+// one command waiting for its async handler
+typedef struct _PendingCommand
+{
+   volatile uint32_t nState;     // state and generation, handed between threads
+   ECommandCode      eCode;
+   MsgPayload        request;
+} PendingCommand;
+
+// commands of one session waiting for their async handlers
+typedef struct _PendingTable
+{
+   PendingCommand commands[PENDING_COMMAND_MAX];
+} PendingTable;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+   LIB_API
+   bool BeginPendingCommand(const MsgPayload* pRequest, ECommandCode eCode, CommandToken* pToken);
+   // Keeps a command for an async handler
+   // Inputs:  pRequest - received command payload
+   //          eCode    - command code
+   // Outputs: pToken - token for the handler
+   // Returns: false if PENDING_COMMAND_MAX commands are already pending
+   // Notes:   Called by DispatchFrame. If the handler doesn't return
+   //          EPending the command is released with CancelPendingCommand.
+
+   LIB_API
+   void CancelPendingCommand(CommandToken token);
+   // Releases a pending command without answering it
+   // Inputs:  token - token from BeginPendingCommand
+   // Outputs: None.
+   // Returns: None.
+   // Notes:   None.
+
+   LIB_API
+   EHandlerResponse CompleteCommand(CommandToken token, EHandlerResponse eResult);
+   // Answers a command an async handler has finished
+   // Inputs:  token   - token the handler was given
+   //          eResult - handler result, EResponseOk or an error
+   // Outputs: None.
+   // Returns: EResponseOk if the response was sent, EInvalidParameters
+   //          for an unknown or completed token, EOpNotAllowed if there
+   //          is no fpSendResponse handler and the session has no fpWrite
+   // Notes:   Success echoes the command, errors are answered with the
+   //          error response. The response carries the sequence number
+   //          of the command. The token is released either way.
+
+   LIB_API
+   EHandlerResponse CompleteReadManufacturerField(CommandToken token, EHandlerResponse eResult, const char* pszValue);
+   // Answers a read manufacturer field command, see CompleteCommand
+   // Inputs:  token    - token the handler was given
+   //          eResult  - handler result, EResponseOk or an error
+   //          pszValue - field value, used when eResult is EResponseOk
+   // Outputs: None.
+   // Returns: See CompleteCommand
+   // Notes:   None.
+
+   LIB_API
+   size_t PendingCommandCount(void);
+   // Counts the commands waiting for an async handler
+   // Inputs:  None.
+   // Outputs: None.
+   // Returns: Number of pending commands
+   // Notes:   None.
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // COMMAND_COMPLETION_H
@@ -0,0 +1,91 @@
+/*********************************************************************************
+*
+*                          Proprietary Information of
+*
+*                            Precision Systems, Inc.
+*                    1355 Business Center Drive, Suite C
+*                                 Horsham, PA
+*                               (215) 672-1860
+*
+*                   Copyright (C) 2020, Precision Systems, Inc.
+*                            All Rights Reserved
+*
+*             The information and design as detailed in this document is
+*     the property of Precision Systems, Inc., and/or its Associates
+*     and must be returned on demand. It is issued on the strict
+*     condition that except with our written permission it must not be
+*     reproduced, copied or communicated to any third party, nor be
+*     used for any purpose other than that stated in the particular
+*     inquiry, order or contract with which it is issued. The
+*     reservation of copyright in this document extends from each date
+*     appearing thereon and in respect of the subject matter as it
+*     appeared at the relevant date.
+*
+********************************************************************************/
+/********************************************************************************
+*
+* PROJECT:     Project MIDAS
+*
+* COMPILER:    
+*
+* TOOLS:       Microsoft Visual Studio 2019
+*
+* DESCRIPTION: CRC-16/CCITT and CRC-32C frame checks
+*
+* NOTES:       Used in place of the 8 bit frame checksum when the frame
+*              asks for it, see SetFrameIntegrity. Unlike a sum, a CRC
+*              catches swapped bytes and errors that cancel each other out.
+*
+*              CRC-16/CCITT: polynomial 0x1021, initial value 0xFFFF, not
+*              reflected, no final XOR ("123456789" gives 0x29B1).
+*              CRC-32C: Castagnoli polynomial, reflected, initial value and
+*              final XOR 0xFFFFFFFF ("123456789" gives 0xE3069283).
+*
+********************************************************************************/
+#ifndef COMMAND_CRC_H
+#define COMMAND_CRC_H
+/********************************************************************************
+*                              I N C L U D E S
+********************************************************************************/
+#include <stddef.h>
+#include <stdint.h>
+#include "commandParameters.h"
+
+/********************************************************************************
+*                          D E F I N I T I O N S
+********************************************************************************/
+// starting value for Crc16Update
+#define CRC16_INIT   0xFFFF
+
+// starting value for Crc32cUpdate
+#define CRC32C_INIT  0
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+   LIB_API
+   uint16_t Crc16Update(uint16_t nCrc, const void* pBytes, size_t nLength);
+   // Adds bytes to a CRC-16/CCITT
+   // Inputs:  nCrc    - CRC so far, CRC16_INIT to start
+   //          pBytes  - data to add
+   //          nLength - number of bytes in pBytes
+   // Outputs: None.
+   // Returns: CRC of everything added so far
+   // Notes:   None.
+
+   LIB_API
+   uint32_t Crc32cUpdate(uint32_t nCrc, const void* pBytes, size_t nLength);
+   // Adds bytes to a CRC-32C
+   // Inputs:  nCrc    - CRC so far, CRC32C_INIT to start
+   //          pBytes  - data to add
+   //          nLength - number of bytes in pBytes
+   // Outputs: None.
+   // Returns: CRC of everything added so far
+   // Notes:   Uses the CPU CRC32 instruction where there is one.
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,118 @@
+/*********************************************************************************
+*
+*                          Proprietary Information of
+*
+*                            Precision Systems, Inc.
+*                    1355 Business Center Drive, Suite C
+*                                 Horsham, PA
+*                               (215) 672-1860
+*
+*                   Copyright (C) 2020, Precision Systems, Inc.
+*                            All Rights Reserved
+*
+*             The information and design as detailed in this document is
+*     the property of Precision Systems, Inc., and/or its Associates
+*     and must be returned on demand. It is issued on the strict
+*     condition that except with our written permission it must not be
+*     reproduced, copied or communicated to any third party, nor be
+*     used for any purpose other than that stated in the particular
+*     inquiry, order or contract with which it is issued. The
+*     reservation of copyright in this document extends from each date
+*     appearing thereon and in respect of the subject matter as it
+*     appeared at the relevant date.
+*
+********************************************************************************/
+/********************************************************************************
+*
+* PROJECT:     Project MIDAS
+*
+* COMPILER:    
+*
+* TOOLS:       Microsoft Visual Studio 2019
+*
+* DESCRIPTION: Decimal number parsing and formatting
+*
+* NOTES:       Used for the frame length, sequence and checksum fields and
+*              for integer parameters, in place of strtol and sprintf.
+*              Every routine is given the length of its text, so none of
+*              them rely on a NULL terminator or read past the end.
+*
+********************************************************************************/
+#ifndef COMMAND_DECIMAL_H
+#define COMMAND_DECIMAL_H
+/********************************************************************************
+*                              I N C L U D E S
+********************************************************************************/
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "commandParameters.h"
+
+/********************************************************************************
+*                          D E F I N I T I O N S
+********************************************************************************/
+// longest int in decimal, "-2147483648"
+#define DECIMAL_INT_DIGITS    11
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+   LIB_API
+   size_t DecimalDigitRun(const char* pText, size_t nLength);
+   // Counts the decimal digits at the start of some text
+   // Inputs:  pText   - text to check
+   //          nLength - number of bytes in pText
+   // Outputs: None.
+   // Returns: Number of leading digits, nLength if they all are
+   // Notes:   None.
+
+   LIB_API
+   bool DecimalParse(const char* pText, size_t nLength, uint32_t* pValue);
+   // Converts text that must be nothing but decimal digits
+   // Inputs:  pText   - digits to convert
+   //          nLength - number of digits, 0 gives a value of 0
+   // Outputs: pValue - converted value, unchanged on failure
+   // Returns: false if there is a non digit or the value overflows 32 bits
+   // Notes:   Leading zeros are allowed, so this also reads fixed width fields.
+
+   LIB_API
+   bool DecimalParseInt(const char* pText, size_t nLength, int* pValue);
+   // Converts text that must be nothing but a signed decimal value
+   // Inputs:  pText   - text to convert
+   //          nLength - number of bytes in pText
+   // Outputs: pValue - converted value, unchanged on failure
+   // Returns: false if there are no digits, a non digit or the value overflows an int
+   // Notes:   An optional leading sign is allowed.
+
+   LIB_API
+   size_t DecimalFormatUnsigned(char* pDest, uint32_t nValue);
+   // Writes an unsigned value in decimal
+   // Inputs:  nValue - value to write
+   // Outputs: pDest - digits written, room for DECIMAL_INT_DIGITS needed
+   // Returns: Number of digits written
+   // Notes:   Output matches "%u", no NULL is written.
+
+   LIB_API
+   size_t DecimalFormatInt(char* pDest, int nValue);
+   // Writes a signed value in decimal
+   // Inputs:  nValue - value to write
+   // Outputs: pDest - digits written, room for DECIMAL_INT_DIGITS needed
+   // Returns: Number of bytes written
+   // Notes:   Output matches "%d", no NULL is written.
+
+   LIB_API
+   bool DecimalFormatFixed(char* pDest, uint32_t nValue, size_t nDigits);
+   // Writes a fixed width, zero padded decimal value
+   // Inputs:  nValue  - value to write
+   //          nDigits - number of digits to write
+   // Outputs: pDest - nDigits digits written
+   // Returns: false if nValue needs more than nDigits digits
+   // Notes:   Output matches "%0*u". A value that doesn't fit keeps its
+   //          low digits, so exactly nDigits bytes are always written.
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,554 @@
+/*********************************************************************************
+*
+*                          Proprietary Information of
+*
+*                            Precision Systems, Inc.
+*                    1355 Business Center Drive, Suite C
+*                                 Horsham, PA
+*                               (215) 672-1860
+*
+*                   Copyright (C) 2020, Precision Systems, Inc.
+*                            All Rights Reserved
+*
+*             The information and design as detailed in this document is
+*     the property of Precision Systems, Inc., and/or its Associates
+*     and must be returned on demand. It is issued on the strict
+*     condition that except with our written permission it must not be
+*     reproduced, copied or communicated to any third party, nor be
+*     used for any purpose other than that stated in the particular
+*     inquiry, order or contract with which it is issued. The
+*     reservation of copyright in this document extends from each date
+*     appearing thereon and in respect of the subject matter as it
+*     appeared at the relevant date.
+*
+********************************************************************************/
+/********************************************************************************
+*
+* PROJECT:     Project MIDAS
+*
+* COMPILER:    C++17
+*
+* TOOLS:       Microsoft Visual Studio 2019
+*
+* DESCRIPTION: Typed C++ command descriptors over the C library
+*
+* NOTES:       Header only, for host code. Firmware keeps using the C API,
+*              nothing here changes it.
+*
+*              Descriptor<eCode> is expanded from COMMAND_SCHEMA, so the
+*              code, shape, tag and range of a command are compile time
+*              constants. Messages<eCode> adds the typed request and
+*              response and the functions that encode and decode them:
+*
+*                 MsgPayload payload;
+*                 command::Encode<ESetTotalFlowRate>({ 250 }, payload);
+*
+*                 command::Response<EGetFlowRates> rates;
+*                 EHandlerResponse eResponse = command::Decode<EGetFlowRates>(frame.payload, rates);
+*
+*              A command without a typed form fails to compile rather than
+*              being built with the wrong parameters.
+*
+********************************************************************************/
+#ifndef COMMAND_DESCRIPTORS_HPP
+#define COMMAND_DESCRIPTORS_HPP
+/********************************************************************************
+*                              I N C L U D E S
+********************************************************************************/
+#include <cstddef>
+#include <cstdint>
+#include <climits>
+#include <string_view>
+#include "commandBuilder.h"
+#include "commandBinary.h"
+#include "commandDecimal.h"
+#include "commandScanner.h"
+
+namespace command
+{
+   /*****************************************************************************
+   *                          D E F I N I T I O N S
+   *****************************************************************************/
+   // how a command is parsed, run and answered, see COMMAND_SCHEMA
+   enum class Shape
+   {
+      NONE,
+      SET_BOOL,
+      SET_INT,
+      GET_INT,
+      VIEW,
+      RUN,
+      FRAME
+   };
+
+   // request or response without parameters
+   struct NoFields
+   {
+   };
+
+   struct BoolValue
+   {
+      bool bEnabled;
+   };
+
+   struct IntValue
+   {
+      int nValue;
+   };
+
+   constexpr std::string_view TagText(EParamTag eTag)
+   {
+      switch (eTag)
+      {
+#define DESCRIPTOR_TAG_TEXT(eTag, szTag) case eTag: return szTag;
+         TAG_SCHEMA(DESCRIPTOR_TAG_TEXT)
+#undef DESCRIPTOR_TAG_TEXT
+         default:
+            break;
+      }
+
+      return std::string_view();
+   }
+   // Tag text of a parameter tag
+   // Inputs:  eTag - parameter tag
+   // Outputs: None.
+   // Returns: Tag text, empty for ETagNone
+   // Notes:   constexpr, Descriptor<eCode>::tagText is computed by the compiler.
+
+   /*****************************************************************************
+   *                          D E S C R I P T O R S
+   *****************************************************************************/
+   // constants of one COMMAND_SCHEMA row, only declared for real commands
+   template <ECommandCode eCode>
+   struct Descriptor;
+
+#define DESCRIPTOR_ROW(eCode, eShape, eTag, nMin, nMax, handler) \
+   template <> \
+   struct Descriptor<eCode> \
+   { \
+      static constexpr ECommandCode     code    = eCode; \
+      static constexpr Shape            shape   = Shape::eShape; \
+      static constexpr EParamTag        tag     = eTag; \
+      static constexpr std::string_view tagText = TagText(eTag); \
+      static constexpr int              minimum = nMin; \
+      static constexpr int              maximum = nMax; \
+   };
+
+   COMMAND_SCHEMA(DESCRIPTOR_ROW)
+#undef DESCRIPTOR_ROW
+
+   template <ECommandCode eCode>
+   constexpr bool InRange(int nValue)
+   {
+      return nValue >= Descriptor<eCode>::minimum && nValue <= Descriptor<eCode>::maximum;
+   }
+   // Checks a SET_INT value against the schema range
+   // Inputs:  nValue - value to send
+   // Outputs: None.
+   // Returns: true if the command handler accepts the value
+   // Notes:   Encode doesn't check, same as the C builders.
+
+   /*****************************************************************************
+   *                          R E S P O N S E S
+   *****************************************************************************/
+   // parameters of a received response, ASCII or binary
+   class ResponseReader
+   {
+   public:
+      ResponseReader(const FrameView& payload, ECommandCode eCode)
+         : m_payload(payload), m_bBinary(false), m_eStatus(EInvalidParameters)
+      {
+         FrameView header = payload;
+         FrameView code;
+         ECommandCode eReceived = ECommandCodeMin;
+         uint8_t nFlags = 0;
+         uint32_t nCode = 0;
+         int nError = 0;
+
+         m_bBinary = BinaryReadHeader(&header, &eReceived, &nFlags);
+
+         if (m_bBinary)
+         {
+            m_records = header;
+
+            if ((nFlags & BINARY_FLAG_RESPONSE) != 0 && eReceived == eCode)
+            {
+               m_eStatus = EResponseOk;
+            }
+         }
+         else if (BuildFieldIndex(payload.pData, payload.nLength, &m_fields)
+              &&  FieldIndex_Field(&m_fields, 0, &code)
+              &&  std::string_view(code.pData, code.nLength) == RESPONSE_PREFIX
+              &&  FieldIndex_Field(&m_fields, 1, &code)
+              &&  DecimalParse(code.pData, code.nLength, &nCode)
+              &&  nCode == (uint32_t)eCode)
+         {
+            m_eStatus = EResponseOk;
+         }
+
+         // an error response carries the handler result
+         if (m_eStatus == EResponseOk && Int(ETagError, nError))
+         {
+            m_eStatus = (EHandlerResponse)nError;
+         }
+      }
+      // Inputs:  payload - received payload, e.g. MessageFrame.payload
+      //          eCode   - command the response should answer
+
+      EHandlerResponse Status() const
+      {
+         return m_eStatus;
+      }
+      // Returns: EResponseOk, the ERR value of an error response, or
+      //          EInvalidParameters if the payload doesn't answer eCode
+
+      bool Value(EParamTag eTag, FrameView& value) const
+      {
+         std::string_view tagText = TagText(eTag);
+         FrameView records        = m_records;
+         FrameView tag;
+         BinaryRecord record;
+         bool bFound              = false;
+
+         if (m_bBinary)
+         {
+            while (!bFound && BinaryNextRecord(&records, &record))
+            {
+               bFound = std::string_view(record.name.pData, record.name.nLength) == tagText;
+               value  = record.value;
+            }
+         }
+         else
+         {
+            // after RSP and the command code
+            for (size_t nField = 2; !bFound && FieldIndex_TagAndValue(&m_fields, nField, &tag, &value); nField++)
+            {
+               bFound = std::string_view(tag.pData, tag.nLength) == tagText;
+            }
+         }
+
+         return bFound;
+      }
+      // Finds a parameter by tag
+      // Outputs: value - parameter value, points into the payload
+      // Returns: true if the response has the parameter
+
+      bool Int(EParamTag eTag, int& nValue) const
+      {
+         FrameView value;
+         bool bRead = Value(eTag, value);
+
+         if (bRead && m_bBinary)
+         {
+            nValue = BinaryValueToInt(&value);
+            bRead  = value.nLength > 0 && value.nLength <= BINARY_INT_BYTES;
+         }
+         else if (bRead)
+         {
+            bRead = DecimalParseInt(value.pData, value.nLength, &nValue);
+         }
+
+         return bRead;
+      }
+      // Reads an integer parameter by tag
+      // Outputs: nValue - parameter value
+      // Returns: true if the response has the parameter and it is a number
+
+      template <class TEnum>
+      bool Enum(EParamTag eTag, TEnum& eValue) const
+      {
+         int nValue = 0;
+         bool bRead = Int(eTag, nValue);
+
+         if (bRead)
+         {
+            eValue = (TEnum)nValue;
+         }
+
+         return bRead;
+      }
+      // Reads an enumerated parameter by tag, see Int
+
+   private:
+      FrameView        m_payload;
+      FrameView        m_records = { nullptr, 0 };   // binary records
+      FieldIndex       m_fields  = {};               // ASCII fields
+      bool             m_bBinary;
+      EHandlerResponse m_eStatus;
+   };
+
+   /*****************************************************************************
+   *                           M E S S A G E S
+   *****************************************************************************/
+   // typed request and response of a command. The shapes below cover most
+   // commands, VIEW and RUN commands are written out further down
+   template <ECommandCode eCode, Shape eShape = Descriptor<eCode>::shape>
+   struct Messages;
+
+   // answered with an echo of the command
+   template <ECommandCode eCode>
+   struct EchoResponse
+   {
+      using Response = NoFields;
+
+      static EHandlerResponse Decode(const FrameView& payload, Response&)
+      {
+         return ResponseReader(payload, eCode).Status();
+      }
+   };
+
+   template <ECommandCode eCode>
+   struct Messages<eCode, Shape::NONE> : EchoResponse<eCode>
+   {
+      using Request = NoFields;
+
+      static void Encode(const Request&, MsgPayload& payload)
+      {
+         BuildSchemaCommand(eCode, 0, &payload);
+      }
+   };
+
+   template <ECommandCode eCode>
+   struct Messages<eCode, Shape::SET_BOOL> : EchoResponse<eCode>
+   {
+      using Request = BoolValue;
+
+      static void Encode(const Request& request, MsgPayload& payload)
+      {
+         BuildSchemaCommand(eCode, request.bEnabled ? ENABLED : DISABLED, &payload);
+      }
+   };
+
+   template <ECommandCode eCode>
+   struct Messages<eCode, Shape::SET_INT> : EchoResponse<eCode>
+   {
+      using Request = IntValue;
+
+      static void Encode(const Request& request, MsgPayload& payload)
+      {
+         BuildSchemaCommand(eCode, request.nValue, &payload);
+      }
+   };
+
+   template <ECommandCode eCode>
+   struct Messages<eCode, Shape::GET_INT>
+   {
+      using Request  = NoFields;
+      using Response = IntValue;
+
+      static void Encode(const Request&, MsgPayload& payload)
+      {
+         BuildSchemaCommand(eCode, 0, &payload);
+      }
+
+      static EHandlerResponse Decode(const FrameView& payload, Response& response)
+      {
+         ResponseReader reader(payload, eCode);
+         EHandlerResponse eResponse = reader.Status();
+
+         if (eResponse == EResponseOk && !reader.Int(Descriptor<eCode>::tag, response.nValue))
+         {
+            eResponse = EInvalidParameters;
+         }
+
+         return eResponse;
+      }
+   };
+
+   // RUN command without request parameters that answers one enumerated value
+   template <ECommandCode eCode, class TEnum, EParamTag eTag>
+   struct EnumMessages
+   {
+      using Request = NoFields;
+
+      struct Response
+      {
+         TEnum eValue;
+      };
+
+      static void Encode(const Request&, MsgPayload& payload)
+      {
+         BuildSchemaCommand(eCode, 0, &payload);
+      }
+
+      static EHandlerResponse Decode(const FrameView& payload, Response& response)
+      {
+         ResponseReader reader(payload, eCode);
+         EHandlerResponse eResponse = reader.Status();
+
+         if (eResponse == EResponseOk && !reader.Enum(eTag, response.eValue))
+         {
+            eResponse = EInvalidParameters;
+         }
+
+         return eResponse;
+      }
+   };
+
+   template <>
+   struct Messages<EGetLanguage, Shape::RUN> : EnumMessages<EGetLanguage, ELanguage, ETagLanguage>
+   {
+   };
+
+   template <>
+   struct Messages<EGetMixStepSize, Shape::RUN> : EnumMessages<EGetMixStepSize, EMixStepSize, ETagMixStep>
+   {
+   };
+
+   template <>
+   struct Messages<EGetFlowRateStepSize, Shape::RUN> : EnumMessages<EGetFlowRateStepSize, EFlowRateStepSize, ETagFlowStep>
+   {
+   };
+
+   template <>
+   struct Messages<EGetClockFormat, Shape::RUN> : EnumMessages<EGetClockFormat, EClockFormat, ETagClockFormat>
+   {
+   };
+
+   template <>
+   struct Messages<EGetBtStatus, Shape::RUN> : EnumMessages<EGetBtStatus, EBtStatus, ETagBtStatus>
+   {
+   };
+
+   template <>
+   struct Messages<EGetFlowRates, Shape::RUN>
+   {
+      using Request = NoFields;
+
+      struct Response
+      {
+         int nO2;
+         int nN2O;
+         int nScavenger;
+      };
+
+      static void Encode(const Request&, MsgPayload& payload)
+      {
+         BuildSchemaCommand(EGetFlowRates, 0, &payload);
+      }
+
+      static EHandlerResponse Decode(const FrameView& payload, Response& response)
+      {
+         ResponseReader reader(payload, EGetFlowRates);
+         EHandlerResponse eResponse = reader.Status();
+
+         if (eResponse == EResponseOk
+         && !(reader.Int(ETagO2Flow, response.nO2)
+         &&   reader.Int(ETagN2OFlow, response.nN2O)
+         &&   reader.Int(ETagScavFlow, response.nScavenger)))
+         {
+            eResponse = EInvalidParameters;
+         }
+
+         return eResponse;
+      }
+   };
+
+   template <>
+   struct Messages<ESetValve, Shape::VIEW> : EchoResponse<ESetValve>
+   {
+      struct Request
+      {
+         EGasId eId;
+         int    nPosition;
+      };
+
+      static void Encode(const Request& request, MsgPayload& payload)
+      {
+         BuildSetValveCommand(request.nPosition, request.eId, &payload);
+      }
+   };
+
+   template <>
+   struct Messages<EGetValve, Shape::RUN>
+   {
+      struct Request
+      {
+         EGasId eId;
+      };
+
+      struct Response
+      {
+         EGasId eId;
+         int    nPosition;
+      };
+
+      static void Encode(const Request& request, MsgPayload& payload)
+      {
+         BuildGetValveCommand(request.eId, &payload);
+      }
+
+      static EHandlerResponse Decode(const FrameView& payload, Response& response)
+      {
+         ResponseReader reader(payload, EGetValve);
+         EHandlerResponse eResponse = reader.Status();
+
+         if (eResponse == EResponseOk
+         && !(reader.Enum(ETagGasSelection, response.eId)
+         &&   reader.Int(ETagValvePos, response.nPosition)))
+         {
+            eResponse = EInvalidParameters;
+         }
+
+         return eResponse;
+      }
+   };
+
+   template <>
+   struct Messages<EEnableGasFlow, Shape::VIEW> : EchoResponse<EEnableGasFlow>
+   {
+      struct Request
+      {
+         EGasId eId;
+         bool   bEnabled;
+      };
+
+      static void Encode(const Request& request, MsgPayload& payload)
+      {
+         BuildEnableGasFlowCommand(request.eId, request.bEnabled, &payload);
+      }
+   };
+
+   /*****************************************************************************
+   *                          F U N C T I O N S
+   *****************************************************************************/
+   template <ECommandCode eCode>
+   using Request = typename Messages<eCode>::Request;
+
+   template <ECommandCode eCode>
+   using Response = typename Messages<eCode>::Response;
+
+   template <ECommandCode eCode>
+   inline void Encode(const Request<eCode>& request, MsgPayload& payload)
+   {
+      Messages<eCode>::Encode(request, payload);
+   }
+   // Builds a command payload from its typed request
+   // Inputs:  request - command parameters, e.g. Encode<ESetO2MixPercentage>({ 40 }, payload)
+   // Outputs: payload - populated the message buffer, length & checksum
+   // Returns: None.
+   // Notes:   Written in the codec picked with SetPayloadCodec.
+
+   template <ECommandCode eCode>
+   inline EHandlerResponse Decode(const FrameView& payload, Response<eCode>& response)
+   {
+      return Messages<eCode>::Decode(payload, response);
+   }
+   // Reads the typed response to a command
+   // Inputs:  payload - received payload
+   // Outputs: response - values from the response, set when EResponseOk
+   // Returns: EResponseOk, the handler result of an error response, or
+   //          EInvalidParameters if the payload isn't a response to eCode
+   // Notes:   ASCII and binary responses are both read.
+
+   template <ECommandCode eCode>
+   inline EHandlerResponse Decode(const MsgPayload& payload, Response<eCode>& response)
+   {
+      FrameView view = { payload.szPayload, payload.nLength };
+
+      return Decode<eCode>(view, response);
+   }
+   // Reads the typed response held in a MsgPayload, see above
+}
+
+#endif // COMMAND_DESCRIPTORS_HPP
@@ -0,0 +1,94 @@
+/*********************************************************************************
+*
+*                          Proprietary Information of
+*
+*                            Precision Systems, Inc.
+*                    1355 Business Center Drive, Suite C
+*                                 Horsham, PA
+*                               (215) 672-1860
+*
+*                   Copyright (C) 2020, Precision Systems, Inc.
+*                            All Rights Reserved
+*
+*             The information and design as detailed in this document is
+*     the property of Precision Systems, Inc., and/or its Associates
+*     and must be returned on demand. It is issued on the strict
+*     condition that except with our written permission it must not be
+*     reproduced, copied or communicated to any third party, nor be
+*     used for any purpose other than that stated in the particular
+*     inquiry, order or contract with which it is issued. The
+*     reservation of copyright in this document extends from each date
+*     appearing thereon and in respect of the subject matter as it
+*     appeared at the relevant date.
+*
+********************************************************************************/
+/********************************************************************************
+*
+* PROJECT:     Project MIDAS
+*
+* COMPILER:    
+*
+* TOOLS:       Microsoft Visual Studio 2019
+*
+* DESCRIPTION: Command dispatcher for received frames
+*
+* NOTES:       DispatchFrame takes a received command from parsing to its
+*              response in one call: the parser for the command code reads
+*              the payload and calls the handler set with SetCommandHandlers,
+*              then the matching Build*Response function writes the answer.
+*
+*              Commands are looked up in a table indexed by command code,
+*              so the cost is the same for every command.
+*
+********************************************************************************/
+#ifndef COMMAND_DISPATCH_H
+#define COMMAND_DISPATCH_H
+/********************************************************************************
+*                              I N C L U D E S
+********************************************************************************/
+#include <stdbool.h>
+#include <stddef.h>
+#include "commandParameters.h"
+#include "commandHandlers.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+   LIB_API
+   EHandlerResponse DispatchFrame(const MessageFrame* pFrame, MsgPayload* pResponse);
+   // Runs a received command and builds its response
+   // Inputs:  pFrame - received frame, e.g. from ParseMessageFrames
+   // Outputs: pResponse - response to send, nLength is 0 if there is none
+   // Returns: Result from the command handler, or why it wasn't called
+   // Notes:   The response carries the sequence number of the command.
+   //          A frame that failed its check is answered with EDataCorrupt.
+   //          ACK, NAK, transport fragments and responses are not
+   //          commands and get no response. Commands CanDispatch refuses
+   //          are answered with EOpNotAllowed.
+   //          Returns EPending with no response when an async handler
+   //          keeps the command, see commandCompletion.h.
+
+   LIB_API
+   bool IsResponsePayload(const FrameView* pPayload);
+   // Checks whether a payload is a response rather than a command
+   // Inputs:  pPayload - received payload
+   // Outputs: None.
+   // Returns: true for a response
+   // Notes:   Responses carry the code of the command they answer.
+
+   LIB_API
+   bool CanDispatch(ECommandCode eCode);
+   // Checks whether DispatchFrame runs a command
+   // Inputs:  eCode - command code
+   // Outputs: None.
+   // Returns: true if DispatchFrame has a parser and response for the code
+   // Notes:   Log lists may need more than one frame for their response,
+   //          and the log entry commands have no response builder yet.
+   //          The caller runs these itself.
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -44,6 +44,7 @@
 #include <stdint.h>
 #include <stddef.h>
 #include "commandParameters.h"
+#include "commandChecksum.h"
 
 #define TMP_BUFF_SIZE 256
 #define TMP_STR_SIZE 256
@@ -62,13 +63,50 @@
 #define HEADER_ASCII       "PH+A"
 #define HEADER_BIN         "PH+B"
 #define HEADER_TRANSPORT   "PH+T"
+// number of ascii digits in the frame length and checksum fields
+#define FRAME_LENGTH_DIGITS   4
+#define FRAME_CHECKSUM_DIGITS 3
+#define FRAME_CRC16_DIGITS    4
+#define FRAME_CRC32C_DIGITS   8
+
+// character after the frame length, selects the frame check
+#define FRAME_SEPARATOR        ','
+#define FRAME_SEPARATOR_CRC16  ';'
+#define FRAME_SEPARATOR_CRC32C ':'
 /*********************************************************************************
 *                            E N U M S
 *********************************************************************************/
+// position of the streaming decoder within a frame
+typedef enum _EFrameDecoderState
+{
+   EDecodeStx,
+   EDecodeLength,
+   EDecodeSeparator,
+   EDecodePayload,
+   EDecodeChecksum,
+   EDecodeEtx
+} EFrameDecoderState;
 
 /*********************************************************************************
 *                            S T R U C T U R E S
 *********************************************************************************/
+// called by the streaming decoder for every completed (or rejected) frame
+typedef void(*FnFrameDecoded)(void* pContext, MessageFrameResult eResult, MessageFrame* pFrame);
+
+// resumable decoder state, one per link
+typedef struct _FrameDecoder
+{
+   EFrameDecoderState eState;
+   size_t         nDigits;       // digits read in the current length/checksum field
+   size_t         nReceived;     // payload bytes received so far
+   size_t         nSkipped;      // garbage bytes skipped between frames
+   MessageFrame   frame;         // frame being assembled
+   ChecksumState  checksum;      // accumulated as payload bytes arrive
+   uint32_t       nCrc;          // accumulated as payload bytes arrive, CRC frames
+   uint32_t       nFrameCheck;   // check value read from the trailer
+   FnFrameDecoded fpCallback;
+   void*          pContext;
+} FrameDecoder;
 
 
 #ifdef __cplusplus
@@ -83,13 +121,105 @@ extern "C" {
    // Returns: None.
    // Notes:   The command buffer should contain a full message containing all framing
 
+   LIB_API
+   MessageFrameResult ParsePayloadCommandCode(const FrameView* pPayload, ECommandCode* peCmdType);
+   // Reads the command code of a payload
+   // Inputs:  pPayload - payload, e.g. a message from Transport_AddFragment
+   // Outputs: peCmdType - command code, ETransport for a transport fragment
+   // Returns: MFR_OK if the command code is valid, MFR_COMMAND_ERR otherwise
+   // Notes:   A response gives the code of the command it answers.
+
+   LIB_API
+   MessageFrameResult ParseMessageFrameView(const char* pBuffer, size_t nBufferSize, MessageFrameView* pFrame);
+   // Validates message framing without copying the payload
+   // Inputs:  pBuffer     - receive buffer holding one complete frame
+   //          nBufferSize - number of bytes in pBuffer
+   // Outputs: pFrame - payload view points into pBuffer
+   // Returns: MFR_OK if the frame is valid, error code otherwise
+   // Notes:   pBuffer must stay unchanged for as long as the view is used.
+   //          A sequence number is taken off the payload into nSequence.
+
+   LIB_API
+   size_t ParseMessageFrameBatch(const char* pBuffer,
+                                 size_t nBufferSize,
+                                 FrameBatchEntry* pFrames,
+                                 size_t nMaxFrames,
+                                 size_t* pnTrailing);
+   // Validates all frames in a buffer of back to back frames in one pass
+   // Inputs:  pBuffer     - receive buffer, e.g. the data from one Read()
+   //          nBufferSize - number of bytes in pBuffer
+   //          nMaxFrames  - number of entries in pFrames
+   // Outputs: pFrames    - result, offset and payload view of each frame
+   //          pnTrailing - bytes left at the end of the buffer, the start of
+   //                       an incomplete frame or frames that didn't fit
+   // Returns: Number of entries written to pFrames
+   // Notes:   Payload views point into pBuffer
+
+   LIB_API
+   void SetFrameIntegrity(EFrameIntegrity eIntegrity);
+   // Selects the frame check used for frames built from now on
+   // Inputs:  eIntegrity - frame check
+   // Outputs: None.
+   // Returns: None.
+   // Notes:   The 8 bit sum is used until this is called. Only switch to a
+   //          CRC once the peer is known to accept it. Received frames are
+   //          checked with whichever check they carry.
+
+   LIB_API
+   EFrameIntegrity GetFrameIntegrity(void);
+   // Returns the frame check used for frames built from now on
+   // Inputs:  None.
+   // Outputs: None.
+   // Returns: Frame check
+   // Notes:   None.
+
+   LIB_API
+   bool ReadFrameSeparator(char ch, EFrameIntegrity* peIntegrity);
+   // Reads the frame check selected by the character after the length
+   // Inputs:  ch - character after the length digits
+   // Outputs: peIntegrity - frame check
+   // Returns: false if the character isn't a separator
+   // Notes:   None.
+
+   LIB_API
+   size_t FrameCheckDigits(EFrameIntegrity eIntegrity);
+   // Returns the number of digits in the check field of a frame
+   // Inputs:  eIntegrity - frame check
+   // Outputs: None.
+   // Returns: Number of check digits
+   // Notes:   None.
+
    LIB_API
    void AddMessageFraming(MsgPayload* pPayload, size_t cmdBufferSize, char* pCmdBuffer);
    // Adds framing
    // Inputs:  None.
    // Outputs: None.
    // Returns: None.
-   // Notes:   None.
+   // Notes:   A payload with bSequenced set gets its sequence number written
+   //          in front of it. It must then be FRAME_SEQUENCE_LENGTH bytes
+   //          shorter than other payloads. CRC frames take the extra check
+   //          digits from the payload the same way.
+
+   LIB_API
+   size_t AddMessageFramingInPlace(MsgPayload* pPayload, const char** ppFrame);
+   // Adds framing in the headroom and tailroom around the payload
+   // Inputs:  pPayload - payload with nLength and nChecksum set
+   // Outputs: pPayload - header and trailer written around szPayload
+   //          ppFrame  - start of the framed bytes, ready for Write()
+   // Returns: Number of framed bytes, 0 if the payload is too long
+   // Notes:   The trailer overwrites the NULL after the payload, the framed
+   //          bytes are NULL terminated instead. Rebuild the payload before
+   //          reading szPayload as a string again. The frame starts part way
+   //          into szHeadroom if there is no sequence number.
+
+   LIB_API
+   size_t AddMessageFramingSegments(const MsgPayload* pPayload, FrameSegments* pSegments);
+   // Adds framing as separate header, payload and trailer pieces
+   // Inputs:  pPayload - payload with nLength and nChecksum set
+   // Outputs: pSegments - header and trailer built, payload piece points
+   //                      into pPayload
+   // Returns: Number of framed bytes, 0 if the payload is too long
+   // Notes:   pPayload is not changed and must outlive pSegments.
 
    LIB_API
    uint8_t CalculateChecksum(MsgPayload* pPayload);
@@ -99,6 +229,34 @@ extern "C" {
    // Outputs: None.
    // Returns: None.
    // Notes:   None.
+
+   LIB_API
+   void FrameDecoder_Init(FrameDecoder* pDecoder, FnFrameDecoded fpCallback, void* pContext);
+   // Initializes a streaming frame decoder
+   // Inputs:  fpCallback - called for each completed frame
+   //          pContext   - passed back to fpCallback
+   // Outputs: pDecoder - reset and ready to receive bytes
+   // Returns: None.
+   // Notes:   None.
+
+   LIB_API
+   void FrameDecoder_Reset(FrameDecoder* pDecoder);
+   // Discards any partially received frame
+   // Inputs:  None.
+   // Outputs: pDecoder - waiting for the next STX
+   // Returns: None.
+   // Notes:   None.
+
+   LIB_API
+   size_t FrameDecoder_Feed(FrameDecoder* pDecoder, const char* pBytes, size_t nLength);
+   // Consumes a chunk of received bytes
+   // Inputs:  pBytes  - received data, may start or end in the middle of a frame
+   //          nLength - number of bytes in pBytes
+   // Outputs: pDecoder - position is kept between calls
+   // Returns: Number of frames passed to the callback
+   // Notes:   The callback is called with MFR_OK for valid frames and with an
+   //          error code for rejected frames. The frame is only valid during
+   //          the callback. Bytes outside of a frame are discarded.
    
 #ifdef __cplusplus
 }
@@ -15,10 +15,15 @@ typedef enum EHandlerResponse
    EOutOfRangeHigh,
    EResponseOk,
    EDataCorrupt,
+   EPending,               // async handler, answered later by CompleteCommand
    EMaxEHandlerResponse
 }
 EHandlerResponse;
 
+// identifies a command an async handler is still running, see CompleteCommand
+typedef uint32_t CommandToken;
+#define COMMAND_TOKEN_NONE 0
+
 typedef EHandlerResponse(*FnHandleNoParameterCommand)(void);
 
 typedef EHandlerResponse(*FnHandleEnableGasFlow)(EGasId eId, bool bEnabled);
@@ -56,6 +61,17 @@ typedef EHandlerResponse(*FnHandleReadManufacturerField)(const char* pFieldName,
 typedef EHandlerResponse(*FnHandleGetScavengerInfo)(ScavengerInfo* pInfo);
 typedef EHandlerResponse(*FnHandleGetGasVolumeInfo)(GasVolumeInfo* pInfo);
 
+// async forms of the slow commands. The handler either finishes and returns
+// its result, or keeps the token, returns EPending and later calls CompleteCommand
+typedef EHandlerResponse(*FnHandleAsyncCommand)(CommandToken token);
+// The read manufacturer field handler passes the value to
+// CompleteReadManufacturerField, which it may call before returning EPending.
+// pFieldName is only valid during the call, copy it to keep it
+typedef EHandlerResponse(*FnHandleReadManufacturerFieldAsync)(const char* pFieldName, CommandToken token);
+
+// sends a response built by CompleteCommand, on the thread that called it
+typedef void(*FnSendResponse)(const MsgPayload* pResponse);
+
 
 typedef struct __CommandHandlers
 {
@@ -118,22 +134,72 @@ typedef struct __CommandHandlers
    FnHandleSetIntValueCommand          fpHandleSetClockFormat;
    FnHandleGetBtStatusCommand          fpHandleGetBtStatus;
    FnHandleSetIntValueCommand          fpHandleSetBtStatus;
+
+   // optional, used by DispatchFrame instead of the handlers above when set
+   FnHandleAsyncCommand                fpHandleFirmwareDownloadAsync;
+   FnHandleAsyncCommand                fpHandleBtFirmwareDownloadAsync;
+   FnHandleReadManufacturerFieldAsync  fpHandleReadManufacturerFieldAsync;
+   FnSendResponse                      fpSendResponse;
    
 }CommandHandlers;
 
-extern CommandHandlers m_pHandlers;
+// copies SetCommandHandlers writes the new handlers into. A table is
+// written again only once no command is using it
+#define HANDLER_TABLE_COUNT 4
+
+// passes SetCommandHandlers makes over the spare tables before giving up
+#define HANDLER_SWAP_ATTEMPTS 4096
+
+// handlers of one session, swapped through one pointer
+typedef struct _HandlerTable
+{
+   CommandHandlers           tables[HANDLER_TABLE_COUNT];
+   volatile long             nReaders[HANDLER_TABLE_COUNT];  // commands using each table
+   CommandHandlers* volatile pActive;   // NULL until the first swap, tables[0] is active
+} HandlerTable;
 
 #ifdef __cplusplus
 extern "C" {
 #endif
 
    LIB_API
-   void SetCommandHandlers(CommandHandlers* pHandlers);
+   bool SetCommandHandlers(CommandHandlers* pHandlers);
    // Sets function pointers to command handlers
    // Inputs:  pHandlers - pointer to command handler structure. 
    // Outputs: None.
+   // Returns: false if every spare table is still in use, try again later
+   // Notes:   Safe while other threads parse commands, they finish on the
+   //          table they started with. Called from one thread at a time.
+   //          Sets the handlers of the current session, see CmdSession_Enter.
+   //          A table is in use until every command that acquired it has
+   //          returned, so a handler that blocks holds its table. This spins
+   //          over the spare tables HANDLER_SWAP_ATTEMPTS times and then
+   //          gives up rather than wait for it.
+
+   LIB_API
+   const CommandHandlers* AcquireCommandHandlers(void);
+   // Returns the active command handlers
+   // Inputs:  None.
+   // Outputs: None.
+   // Returns: Table set by the last SetCommandHandlers in the current session
+   // Notes:   Read once per command and used for all of it, so a swap
+   //          never mixes handlers from two tables. The table is not
+   //          reused until it is handed back with ReleaseCommandHandlers.
+   //          A thread already holding a table of the session gets that
+   //          table again, e.g. the parser inside DispatchFrame.
+   //          Each acquire and release is a locked read-modify-write on the
+   //          table's count, with two full barrier reads of the active
+   //          table around the first. DispatchFrame and its parser acquire
+   //          twice per command.
+
+   LIB_API
+   void ReleaseCommandHandlers(const CommandHandlers* pHandlers);
+   // Hands back a table from AcquireCommandHandlers
+   // Inputs:  pHandlers - table from AcquireCommandHandlers
+   // Outputs: None.
    // Returns: None.
-   // Notes:   None.
+   // Notes:   Call once for each AcquireCommandHandlers, in the same session,
+   //          after the last handler from the table has returned.
 
 #ifdef __cplusplus
 }
@@ -4,6 +4,7 @@
 
 #include <stdbool.h>
 #include <stdint.h>
+#include "commandSchema.h"
 
 #ifdef _WIN32
    #ifdef DLL_EXPORT
@@ -25,8 +26,31 @@
 #define PREAMBLE_LENGTH 10
 #define PAYLOAD_LENGTH (256 - TOTAL_FRAMING_BYTES)
 
+// optional sequence number, "#nnn," at the start of the framed payload.
+// Counted in the frame length and checksum, not in MsgPayload.nLength.
+#define FRAME_SEQUENCE_MARKER '#'
+#define FRAME_SEQUENCE_DIGITS 3
+#define FRAME_SEQUENCE_LENGTH (FRAME_SEQUENCE_DIGITS + 2)
+#define FRAME_SEQUENCE_COUNT  1000
+
+// STX, 4 byte length and Comma
+#define FRAME_HEADER_LENGTH 6
+
+// longest frame check field, CRC-32C in hex
+#define FRAME_CHECK_MAX_DIGITS 8
+
+// space kept on each side of a payload so framing can be added in place
+// frame header and sequence number
+#define FRAME_HEADROOM (FRAME_HEADER_LENGTH + FRAME_SEQUENCE_LENGTH)
+// 3 byte checksum, ETX and NULL
+#define FRAME_TAILROOM 5
+
 // header file content
 
+// enum entries expanded from commandSchema.h
+#define SCHEMA_COMMAND_CODE(eCode, eShape, eTag, nMin, nMax, handler) eCode,
+#define SCHEMA_PARAM_TAG(eTag, szTag) eTag,
+
 /*********************************************************************************
 *                          E N U M E R A T I O N S
 *********************************************************************************/
@@ -35,63 +59,9 @@ typedef enum _ECommandCode
 {
    EAck  = 0x06,
    ENak  = 0x15,
-   ECommandCodeMin = 0x20, // add command below
-   EVacuumIncrease,
-   EVacuumDecrease,
-   EStartProcedure,
-   EEndProcedure,
-   EEnableDisablePin,
-   EGetProcedureLogCount,
-   EGetProcedureList,
-   EGetProcedureLog,
-   EGetProcedureEntryCount,
-   EGetProcedureEntryList,
-   EGetProcedureEntry,
-   EGetAlarmLogList,
-   EGetAlarmLogEntry,
-   EResetLogs,
-   ESetLanguage,
-   EGetLanguage,
-   ESetTotalFlowRate,
-   EGetTotalFlowRate,
-   EGetFlowRates,
-   ESetO2MixPercentage,
-   EGetO2MixPercentage,
-   EStopGas,
-   EEnableDisableBT,
-   EEnableDisableVacuum,
-   ERestoreDefaults,
-   EChangePin,
-   EMuteAlarm,
-   EEnableDisablePower,
-   EGetTimeAndDate,
-   ESetTimeAndDate,
-   EGetGasVolume,
-   EResetGasVolume,
-   EGetScavengerInfo,
-   EFlushO2,
-   EHeartbeat ,
-   EScreenReady,
-   ESyncData,
-   EGetFirmwareVersion,
-   EGetFirmwareInfo,
-   EGetConfigData,
-   ESetValve,
-   EGetValve,
-   EFirmwareDownload,
-   EEnableGasFlow,
-   EBtFirmwareDownload,
-   EWriteManufacturerField,
-   EReadManufacturerField,
-   ESetN2OMax,
-   EGetN2OMax,
-   EGetMixStepSize,
-   ESetMixStepSize,
-   EGetFlowRateStepSize,
-   ESetFlowRateStepSize,
-   EGetClockFormat,
-   ESetClockFormat,
-   EGetBtStatus,
+   ETransport = 0x1E,      // transport fragment, code is in the reassembled message
+   ECommandCodeMin = 0x20, // add commands to COMMAND_SCHEMA
+   COMMAND_SCHEMA(SCHEMA_COMMAND_CODE)
    ECommandCodeMax
 
 } ECommandCode;
@@ -117,6 +87,15 @@ typedef enum _EClockFormat
    ETwentyFourHour
 }EClockFormat;
 
+// dense ids of the parameter tags in TAG_SCHEMA, in the same order.
+// Also the binary record tag ids, so append only.
+typedef enum _EParamTag
+{
+   ETagNone,            // not a parameter tag
+   TAG_SCHEMA(SCHEMA_PARAM_TAG)
+   ETagMax
+}EParamTag;
+
 typedef enum _ELanguage
 {
    ELanguageMin,
@@ -165,6 +144,14 @@ typedef enum _EBtStatus
    EConnected
 }EBtStatus;
 
+// frame check in the trailer, chosen by the character after the length
+typedef enum _EFrameIntegrity
+{
+   EFrameIntegritySum8,    // ',' and 3 decimal digits, 8 bit sum
+   EFrameIntegrityCrc16,   // ';' and 4 hex digits, CRC-16/CCITT
+   EFrameIntegrityCrc32c   // ':' and 8 hex digits, CRC-32C
+} EFrameIntegrity;
+
 typedef enum _MessageFrameResult
 {
    MFR_OK           = 0,
@@ -180,22 +167,71 @@ typedef enum _MessageFrameResult
 *                          S T R U C T U R E S
 *********************************************************************************/
 
+// szHeadroom, szPayload and szTailroom are contiguous, a framed payload
+// is sent straight from szHeadroom. bSequenced/nSequence add the sequence
+// number to the frame, a response copies them from its request.
 typedef struct _MsgPayload
 {
    int nChecksum;
    size_t nLength;
+   bool bSequenced;
+   uint16_t nSequence;
+   char szHeadroom[FRAME_HEADROOM];
    char szPayload[PAYLOAD_LENGTH];
+   char szTailroom[FRAME_TAILROOM];
 }MsgPayload;
 
 typedef struct _MessageFrame
 {
    MsgPayload  payload;
    ECommandCode eCmdType;
+   EFrameIntegrity eIntegrity;
    bool bStxFound;
    bool bEtxFound;
    bool bChecksumOk;
 } MessageFrame;
 
+// read-only slice of a buffer. Not NULL terminated.
+typedef struct _FrameView
+{
+   const char* pData;
+   size_t nLength;
+}FrameView;
+
+// message frame validated in place, payload points into the receive buffer
+typedef struct _MessageFrameView
+{
+   FrameView payload;            // sequence number field not included
+   int nChecksum;                // 8 bit sum frames only
+   uint32_t nCrc;                // CRC frames only
+   EFrameIntegrity eIntegrity;
+   bool bSequenced;
+   uint16_t nSequence;
+   ECommandCode eCmdType;
+   bool bStxFound;
+   bool bEtxFound;
+   bool bChecksumOk;
+} MessageFrameView;
+
+// framed payload as three pieces for scattered output (writev style).
+// Header and trailer are held here, the payload piece points at szPayload.
+#define FRAME_SEGMENT_COUNT 3
+typedef struct _FrameSegments
+{
+   FrameView segments[FRAME_SEGMENT_COUNT];   // header, payload, trailer
+   char szHeader[FRAME_HEADROOM];
+   char szTrailer[FRAME_CHECK_MAX_DIGITS + 2];
+} FrameSegments;
+
+// one frame found in a buffer of back to back frames
+typedef struct _FrameBatchEntry
+{
+   MessageFrameView frame;
+   MessageFrameResult eResult;
+   size_t nOffset;      // offset of the frame from the start of the buffer
+   size_t nLength;      // number of bytes consumed, including framing
+} FrameBatchEntry;
+
 // contains configuration data
 typedef struct _ConfigData
 {
@@ -292,6 +328,13 @@ typedef struct _ScavengerInfo
    uint8_t nFlowRate;   // 0 -100
 }ScavengerInfo;
 
+// tokenizer position, owned by the caller so strings can be tokenized
+// on several threads, or interleaved on one
+typedef struct _TokenCursor
+{
+   char* pNext;         // start of the next token, NULL when all are read
+}TokenCursor;
+
 
 // C++ guard
 #ifdef __cplusplus
@@ -299,6 +342,8 @@ extern "C" {
 #endif
 
    // library functions go here
+   // Notes:   Only needed after StrTokenize. The View functions below
+   //          read payloads without writing to them.
    void RestoreDelimiterAndMovePast(char** pCmdBuffer, char delimiter);
 
    // strtok replacement function for STM8 micro
@@ -306,9 +351,65 @@ extern "C" {
    // subsequent calls with s = NULL return the next delimiter
    // Inputs:  s - string to tokenize
    //          delim - array of delimiters
-   //          savePtr - the last token position
+   // Notes:   Keeps its position in a single hidden cursor so it isn't
+   //          reentrant. Use StrTokenizeBegin/StrTokenizeNext instead.
    char* StrTokenize(char* s, const char* delim);
 
+   void StrTokenizeBegin(TokenCursor* pCursor, char* s);
+   // Starts tokenizing a string
+   // Inputs:  pCursor - caller owned position
+   //          s       - NULL terminated string to tokenize
+   // Outputs: pCursor - positioned at the first token
+   // Returns: None.
+   // Notes:   None.
+
+   char* StrTokenizeNext(TokenCursor* pCursor, const char* delim);
+   // Returns the next token, replacing the delimiter after it with a NULL
+   // Inputs:  pCursor - position from StrTokenizeBegin
+   //          delim   - array of delimiters that end this token
+   // Outputs: pCursor - advanced past the delimiter
+   // Returns: Token, or NULL once the string is used up
+   // Notes:   The last token runs to the end of the string. Every call may
+   //          use different delimiters.
+
+   bool ViewNextField(FrameView* pReader, char delimiter, FrameView* pField);
+   // Splits the next field off the front of a view, without writing to it
+   // Inputs:  pReader   - remaining text, advanced past the field and delimiter
+   //          delimiter - character that ends the field
+   // Outputs: pField - the field, without the delimiter
+   // Returns: true if the delimiter was found
+   // Notes:   If the delimiter isn't found the field is the rest of the text.
+
+   bool ViewEquals(const FrameView* pView, const char* pszText);
+   // Compares a view against a NULL terminated string
+   // Inputs:  pView   - text to compare
+   //          pszText - string to compare against
+   // Outputs: None.
+   // Returns: true if the view holds exactly pszText
+   // Notes:   None.
+
+   int ViewToInt(const FrameView* pView);
+   // Converts a decimal value held in a view
+   // Inputs:  pView - text to convert
+   // Outputs: None.
+   // Returns: Converted value
+   // Notes:   Stops at the first non digit, same as strtol.
+
+   bool ViewParseInt(const FrameView* pView, int* pValue);
+   // Converts a view that must hold nothing but a decimal value
+   // Inputs:  pView - text to convert
+   // Outputs: pValue - converted value, unchanged on failure
+   // Returns: false if the view is empty, has a non digit or overflows an int
+   // Notes:   None.
+
+   void ViewToString(const FrameView* pView, char* szBuffer, size_t nBufferSize);
+   // Copies a view into a NULL terminated string
+   // Inputs:  pView       - text to copy
+   //          nBufferSize - size of szBuffer
+   // Outputs: szBuffer - the text, truncated to fit
+   // Returns: None.
+   // Notes:   None.
+
 // end C++ guard
 #ifdef __cplusplus
 } // closing brace for extern "C"
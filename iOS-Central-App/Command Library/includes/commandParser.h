@@ -423,6 +423,15 @@ extern "C" {
    LIB_API
    EHandlerResponse FirmwareDownload(void);
 
+   // Places micro in boot loader mode, answered later by CompleteCommand
+   // Inputs:  token - token from BeginPendingCommand
+   // Outputs: None
+   // Returns: EPending from the async handler, EResponseOk or an error code
+   //          if it answers at once, EOpNotAllowed if there is none
+   // Notes:   fpHandleFirmwareDownloadAsync
+   LIB_API
+   EHandlerResponse FirmwareDownloadAsync(CommandToken token);
+
    // Enables gas flow
    // Inputs:  m_cmdBuffer - command payload buffer
    //          cmdBufferSize - payload buffer length
@@ -472,6 +481,14 @@ extern "C" {
    LIB_API
    EHandlerResponse BtFirmwareDownload(void);
 
+   // Places BT chip in firmware download mode, answered later by CompleteCommand
+   // Inputs:  token - token from BeginPendingCommand
+   // Outputs: None
+   // Returns: See FirmwareDownloadAsync
+   // Notes:   fpHandleBtFirmwareDownloadAsync
+   LIB_API
+   EHandlerResponse BtFirmwareDownloadAsync(CommandToken token);
+
    // Writes a manufacturer field to flash
    // Inputs:  m_cmdBuffer      - command payload buffer
    //          cmdBufferSize  - length of payload buffer
@@ -576,6 +593,131 @@ extern "C" {
    LIB_API
    EHandlerResponse ResetGasVolume(MsgPayload* pPayload);
 
+   // The parsers below read the command payload in place from a view into
+   // the receive buffer (see ParseMessageFrameView). The payload is never
+   // copied or written to. Each one behaves the same as the parser of the
+   // same name without the View suffix.
+   // Inputs:  pPayload - view of the command payload, not NULL terminated
+   // Returns: EResponseOk if successful, error code otherwise
+   LIB_API
+   EHandlerResponse GetProcedureLogListView(const FrameView* pPayload, ProcedureLog* pEntries, int* pCount);
+
+   LIB_API
+   EHandlerResponse GetProcedureLogEntryListView(const FrameView* pPayload, LogEntry* pEntries, int* pCount);
+
+   LIB_API
+   EHandlerResponse GetProcedureLogEntryView(const FrameView* pPayload, LogDetails* pDetails);
+
+   LIB_API
+   EHandlerResponse GetAlarmLogEntryView(const FrameView* pPayload, LogDetails* pDetails);
+
+   LIB_API
+   EHandlerResponse WriteManufacturerFieldView(const FrameView* pPayload);
+
+   LIB_API
+   EHandlerResponse ReadManufacturerFieldView(const FrameView* pPayload, char* pField);
+
+   // Reads a manufacturer field, answered later by CompleteReadManufacturerField
+   // Inputs:  pPayload - view of the command payload
+   //          token    - token from BeginPendingCommand
+   // Outputs: None.
+   // Returns: EPending from the async handler, else as ReadManufacturerFieldView
+   // Notes:   fpHandleReadManufacturerFieldAsync. The field value only
+   //          comes back through CompleteReadManufacturerField.
+   LIB_API
+   EHandlerResponse ReadManufacturerFieldAsyncView(const FrameView* pPayload, CommandToken token);
+
+   LIB_API
+   EHandlerResponse SetConfigurationDataView(const FrameView* pPayload);
+
+   LIB_API
+   EHandlerResponse SetTimeAndDateView(const FrameView* pPayload);
+
+   LIB_API
+   EHandlerResponse SetO2MixPercentageView(const FrameView* pPayload);
+
+   LIB_API
+   EHandlerResponse SetTotalFlowRateView(const FrameView* pPayload);
+
+   LIB_API
+   EHandlerResponse SetLanguageView(const FrameView* pPayload);
+
+   LIB_API
+   EHandlerResponse EnableDisablePinView(const FrameView* pPayload);
+
+   LIB_API
+   EHandlerResponse ChangePinView(const FrameView* pPayload);
+
+   LIB_API
+   EHandlerResponse SetValvePositionView(const FrameView* pPayload);
+
+   // Reads which gas a set valve command is for, without running it
+   // Inputs:  pPayload - view of the command payload
+   // Outputs: peId - gas of the valve
+   // Returns: EResponseOk if successful, error code otherwise
+   // Notes:   Used to coalesce set valve commands per gas.
+   LIB_API
+   EHandlerResponse ReadSetValveGasView(const FrameView* pPayload, EGasId* peId);
+
+   LIB_API
+   EHandlerResponse GetValvePositionView(const FrameView* pPayload, EGasId* pId, int* pPosition);
+
+   LIB_API
+   EHandlerResponse EnableDisableVacuumView(const FrameView* pPayload);
+
+   LIB_API
+   EHandlerResponse EnableDisableTouchscreenPowerView(const FrameView* pPayload);
+
+   LIB_API
+   EHandlerResponse EnableGasFlowView(const FrameView* pPayload);
+
+   LIB_API
+   EHandlerResponse FlushO2View(const FrameView* pPayload);
+
+   LIB_API
+   EHandlerResponse WriteManufacturersFieldView(const FrameView* pPayload);
+
+   LIB_API
+   EHandlerResponse ReadManufacturersFieldView(const FrameView* pPayload, char* pszValue);
+
+   LIB_API
+   EHandlerResponse SetMaxN2OView(const FrameView* pPayload);
+
+   LIB_API
+   EHandlerResponse SetMixStepSizeView(const FrameView* pPayload);
+
+   LIB_API
+   EHandlerResponse SetFlowRateStepSizeView(const FrameView* pPayload);
+
+   LIB_API
+   EHandlerResponse SetClockFormatView(const FrameView* pPayload);
+
+   LIB_API
+   EHandlerResponse EnableDisableBtView(const FrameView* pPayload);
+
+   LIB_API
+   EHandlerResponse ResetGasVolumeView(const FrameView* pPayload);
+
+   // Parses and runs a command whose response echoes the command
+   // Inputs:  eCode    - command code
+   //          pPayload - view of the command payload, not used by NONE rows
+   // Outputs: None
+   // Returns: EResponseOk if successful, error code otherwise
+   // Notes:   Runs the NONE, SET_BOOL, SET_INT and VIEW rows of
+   //          COMMAND_SCHEMA, other codes give EOpNotAllowed. Values out
+   //          of the schema range give EInvalidParameters.
+   LIB_API
+   EHandlerResponse HandleSchemaCommand(ECommandCode eCode, const FrameView* pPayload);
+
+   // Runs a command that returns a single integer
+   // Inputs:  eCode - command code
+   // Outputs: pValue - value from the command handler
+   // Returns: EResponseOk if successful, error code otherwise
+   // Notes:   Runs the GET_INT rows of COMMAND_SCHEMA, other codes give
+   //          EOpNotAllowed. The response is BuildSchemaResponse.
+   LIB_API
+   EHandlerResponse GetSchemaValue(ECommandCode eCode, int* pValue);
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,224 @@
+/*********************************************************************************
+*
+*                          Proprietary Information of
+*
+*                            Precision Systems, Inc.
+*                    1355 Business Center Drive, Suite C
+*                                 Horsham, PA
+*                               (215) 672-1860
+*
+*                   Copyright (C) 2020, Precision Systems, Inc.
+*                            All Rights Reserved
+*
+*             The information and design as detailed in this document is
+*     the property of Precision Systems, Inc., and/or its Associates
+*     and must be returned on demand. It is issued on the strict
+*     condition that except with our written permission it must not be
+*     reproduced, copied or communicated to any third party, nor be
+*     used for any purpose other than that stated in the particular
+*     inquiry, order or contract with which it is issued. The
+*     reservation of copyright in this document extends from each date
+*     appearing thereon and in respect of the subject matter as it
+*     appeared at the relevant date.
+*
+********************************************************************************/
+/********************************************************************************
+*
+* PROJECT:     Project MIDAS
+*
+* COMPILER:    
+*
+* TOOLS:       Microsoft Visual Studio 2019
+*
+* DESCRIPTION: Priority lanes for sending and running commands
+*
+* NOTES:       Commands are sorted into three classes. Safety commands stop
+*              gas, mute an alarm or end a procedure. Bulk commands move
+*              logs, firmware or manufacturer fields. Everything else is
+*              control.
+*
+*              Each class has its own first in, first out lane and the
+*              highest class with something waiting is served first. A
+*              transfer, a logical message sent as transport fragments,
+*              stays at the head of its lane until its last fragment is
+*              sent but gives way to a higher class between fragments. A
+*              safety command so waits for at most one fragment, not a
+*              whole log page.
+*
+*              The lanes only hold commands, the session decides when to
+*              serve them, see commandSession.h.
+*
+********************************************************************************/
+#ifndef COMMAND_PRIORITY_H
+#define COMMAND_PRIORITY_H
+/********************************************************************************
+*                              I N C L U D E S
+********************************************************************************/
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "commandParameters.h"
+#include "commandTransport.h"
+
+/********************************************************************************
+*                          D E F I N I T I O N S
+********************************************************************************/
+// commands each lane holds
+#define PRIORITY_LANE_DEPTH 8
+
+/*********************************************************************************
+*                            E N U M S
+*********************************************************************************/
+// command classes, highest first
+typedef enum _ECommandPriority
+{
+   ECommandPrioritySafety,    // stop gas, mute alarm, end procedure
+   ECommandPriorityControl,   // setpoints, status and settings
+   ECommandPriorityBulk,      // logs, firmware and manufacturer fields
+   ECommandPriorityMax
+} ECommandPriority;
+
+/*********************************************************************************
+*                            S T R U C T U R E S
+*********************************************************************************/
+// a request, or a transfer answering one, waiting to be sent
+typedef struct _QueuedSend
+{
+   ECommandCode    eCode;
+   void*           pRequestContext;  // handed back with the response
+   bool            bTransfer;        // fragments of a logical message
+   TransportSender transfer;         // next fragment of a transfer
+   MsgPayload      payload;          // request, or the request a transfer answers
+} QueuedSend;
+
+typedef struct _SendLane
+{
+   QueuedSend sends[PRIORITY_LANE_DEPTH];
+   size_t     nHead;
+   size_t     nCount;
+} SendLane;
+
+// a received command waiting to be run
+typedef struct _QueuedFrame
+{
+   MessageFrame frame;
+   size_t       nControlFirst;   // control commands that must run before it
+} QueuedFrame;
+
+typedef struct _FrameLane
+{
+   QueuedFrame frames[PRIORITY_LANE_DEPTH];
+   size_t      nHead;
+   size_t      nCount;
+} FrameLane;
+
+// one lane per class each way
+typedef struct _PriorityLanes
+{
+   SendLane  send[ECommandPriorityMax];
+   FrameLane received[ECommandPriorityMax];
+} PriorityLanes;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+   LIB_API
+   ECommandPriority CommandPriority(ECommandCode eCode);
+   // Finds the class of a command
+   // Inputs:  eCode - command code
+   // Outputs: None.
+   // Returns: Command class, control for a code that isn't listed
+   // Notes:   None.
+
+   LIB_API
+   void PriorityLanes_Init(PriorityLanes* pLanes);
+   // Empties all lanes
+   // Inputs:  None.
+   // Outputs: pLanes - nothing queued
+   // Returns: None.
+   // Notes:   None.
+
+   LIB_API
+   bool SendLane_PutRequest(SendLane* pLane, const MsgPayload* pRequest, ECommandCode eCode, void* pRequestContext);
+   // Queues a request at the tail of a lane
+   // Inputs:  pRequest        - request payload, built and ready for framing
+   //          eCode           - command code of the request
+   //          pRequestContext - handed back with the response
+   // Outputs: pLane - request queued
+   // Returns: false if the lane is full
+   // Notes:   None.
+
+   LIB_API
+   bool SendLane_PutTransfer(SendLane* pLane,
+                             const MsgPayload* pRequest,
+                             ECommandCode eCode,
+                             uint8_t nMessageId,
+                             const char* pMessage,
+                             size_t nLength);
+   // Queues a logical message at the tail of a lane
+   // Inputs:  pRequest   - request the message answers, its sequence number
+   //                       goes on every fragment, may be NULL
+   //          eCode      - command code of the request
+   //          nMessageId - transport message id, see Transport_BeginSend
+   //          pMessage   - logical message
+   //          nLength    - number of bytes in pMessage
+   // Outputs: pLane - transfer queued
+   // Returns: false if the lane is full or the message is empty or too long
+   // Notes:   pMessage must stay unchanged until the last fragment is sent.
+
+   LIB_API
+   QueuedSend* SendLane_Head(SendLane* pLane);
+   // Returns the request or transfer to send next from a lane
+   // Inputs:  pLane - lane
+   // Outputs: None.
+   // Returns: Head of the lane, NULL if it is empty
+   // Notes:   It stays queued until SendLane_Pop.
+
+   LIB_API
+   void SendLane_Pop(SendLane* pLane);
+   // Removes the head of a lane
+   // Inputs:  None.
+   // Outputs: pLane - head removed
+   // Returns: None.
+   // Notes:   None.
+
+   LIB_API
+   bool FrameLane_Put(FrameLane* pLane, const MessageFrame* pFrame, size_t nControlFirst);
+   // Queues a received command at the tail of a lane
+   // Inputs:  pFrame        - received command
+   //          nControlFirst - control commands that must run before it
+   // Outputs: pLane - command queued
+   // Returns: false if the lane is full
+   // Notes:   None.
+
+   LIB_API
+   QueuedFrame* FrameLane_Head(FrameLane* pLane);
+   // Returns the command to run next from a lane
+   // Inputs:  pLane - lane
+   // Outputs: None.
+   // Returns: Head of the lane, NULL if it is empty
+   // Notes:   It stays queued until FrameLane_Pop.
+
+   LIB_API
+   void FrameLane_Pop(FrameLane* pLane);
+   // Removes the head of a lane
+   // Inputs:  None.
+   // Outputs: pLane - head removed
+   // Returns: None.
+   // Notes:   None.
+
+   LIB_API
+   size_t FrameLane_CountToLastSetpoint(const FrameLane* pLane);
+   // Counts the commands from the head of a lane to its last setpoint
+   // Inputs:  pLane - lane
+   // Outputs: None.
+   // Returns: Number of commands up to and including the last setpoint
+   //          command, 0 if the lane holds none
+   // Notes:   See IsSetpointCommand.
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // COMMAND_PRIORITY_H
@@ -0,0 +1,165 @@
+/*********************************************************************************
+*
+*                          Proprietary Information of
+*
+*                            Precision Systems, Inc.
+*                    1355 Business Center Drive, Suite C
+*                                 Horsham, PA
+*                               (215) 672-1860
+*
+*                   Copyright (C) 2020, Precision Systems, Inc.
+*                            All Rights Reserved
+*
+*             The information and design as detailed in this document is
+*     the property of Precision Systems, Inc., and/or its Associates
+*     and must be returned on demand. It is issued on the strict
+*     condition that except with our written permission it must not be
+*     reproduced, copied or communicated to any third party, nor be
+*     used for any purpose other than that stated in the particular
+*     inquiry, order or contract with which it is issued. The
+*     reservation of copyright in this document extends from each date
+*     appearing thereon and in respect of the subject matter as it
+*     appeared at the relevant date.
+*
+********************************************************************************/
+/********************************************************************************
+*
+* PROJECT:     Project MIDAS
+*
+* COMPILER:    
+*
+* TOOLS:       Microsoft Visual Studio 2019
+*
+* DESCRIPTION: Outstanding request table for pipelined requests
+*
+* NOTES:       Each request sent through the table gets a frame sequence
+*              number. The peer copies it into the response, so several
+*              requests can be in flight on one link and their responses
+*              can come back in any order.
+*
+*              The library has no clock. Times are passed in by the caller
+*              in whatever unit it uses for timeouts.
+*
+********************************************************************************/
+#ifndef COMMAND_REQUESTS_H
+#define COMMAND_REQUESTS_H
+/********************************************************************************
+*                              I N C L U D E S
+********************************************************************************/
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "commandParameters.h"
+#include "commandTransport.h"
+
+/********************************************************************************
+*                          D E F I N I T I O N S
+********************************************************************************/
+// most requests in flight on one link
+#define REQUEST_TABLE_SIZE 16
+
+/*********************************************************************************
+*                            S T R U C T U R E S
+*********************************************************************************/
+// a request waiting for its response
+typedef struct _PendingRequest
+{
+   bool         bInUse;
+   uint16_t     nSequence;
+   ECommandCode eCode;        // command sent
+   uint32_t     nSentTime;
+   void*        pContext;     // caller data, handed back with the response
+} PendingRequest;
+
+typedef struct _RequestTable
+{
+   PendingRequest requests[REQUEST_TABLE_SIZE];
+   size_t         nOutstanding;
+   uint16_t       nNextSequence;
+} RequestTable;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+   LIB_API
+   void RequestTable_Init(RequestTable* pTable);
+   // Empties a request table
+   // Inputs:  None.
+   // Outputs: pTable - no requests outstanding
+   // Returns: None.
+   // Notes:   None.
+
+   LIB_API
+   bool RequestTable_Add(RequestTable* pTable,
+                         MsgPayload* pRequest,
+                         ECommandCode eCode,
+                         uint32_t nNow,
+                         void* pContext);
+   // Records a request about to be sent
+   // Inputs:  pRequest - request payload, built and ready for framing
+   //          eCode    - command code of the request
+   //          nNow     - current time
+   //          pContext - caller data returned with the response
+   // Outputs: pTable   - request added
+   //          pRequest - bSequenced and nSequence set
+   // Returns: false if the table is full, the request should wait
+   // Notes:   None.
+
+   LIB_API
+   bool RequestTable_Complete(RequestTable* pTable,
+                              uint16_t nSequence,
+                              ECommandCode eCode,
+                              PendingRequest* pRequest);
+   // Matches a response to its request and removes the request
+   // Inputs:  nSequence - sequence number of the response frame
+   //          eCode     - command code of the response frame
+   // Outputs: pTable   - request removed
+   //          pRequest - the request answered, may be NULL
+   // Returns: false if no outstanding request matches
+   // Notes:   A response matches when the sequence number is the same and
+   //          the code is the request code, ACK or NAK. Transport fragments
+   //          don't match, see RequestTable_CompleteTransport.
+
+   LIB_API
+   bool RequestTable_CompleteTransport(RequestTable* pTable,
+                                       uint16_t nSequence,
+                                       ETransportResult eResult,
+                                       const FrameView* pMessage,
+                                       PendingRequest* pRequest);
+   // Matches a transport response to its request once it is whole
+   // Inputs:  nSequence - sequence number of the fragment frames
+   //          eResult   - result of Transport_AddFragment for the last fragment
+   //          pMessage  - message from Transport_AddFragment
+   // Outputs: pTable   - request removed
+   //          pRequest - the request answered, may be NULL
+   // Returns: false if the message isn't complete or no request matches
+   // Notes:   Only ETransportMessageDone completes the request, and only
+   //          if the command code inside the message is the request's.
+
+   LIB_API
+   bool RequestTable_Expire(RequestTable* pTable,
+                            uint32_t nNow,
+                            uint32_t nTimeout,
+                            PendingRequest* pRequest);
+   // Removes a request that has waited too long
+   // Inputs:  nNow     - current time
+   //          nTimeout - time a request may wait for its response
+   // Outputs: pTable   - request removed
+   //          pRequest - the request that timed out, may be NULL
+   // Returns: false if no request has timed out
+   // Notes:   Call until it returns false to collect every timed out request.
+
+   LIB_API
+   size_t RequestTable_Outstanding(const RequestTable* pTable);
+   // Returns the number of requests waiting for a response
+   // Inputs:  None.
+   // Outputs: None.
+   // Returns: Number of outstanding requests
+   // Notes:   None.
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,129 @@
+/*********************************************************************************
+*
+*                          Proprietary Information of
+*
+*                            Precision Systems, Inc.
+*                    1355 Business Center Drive, Suite C
+*                                 Horsham, PA
+*                               (215) 672-1860
+*
+*                   Copyright (C) 2020, Precision Systems, Inc.
+*                            All Rights Reserved
+*
+*             The information and design as detailed in this document is
+*     the property of Precision Systems, Inc., and/or its Associates
+*     and must be returned on demand. It is issued on the strict
+*     condition that except with our written permission it must not be
+*     reproduced, copied or communicated to any third party, nor be
+*     used for any purpose other than that stated in the particular
+*     inquiry, order or contract with which it is issued. The
+*     reservation of copyright in this document extends from each date
+*     appearing thereon and in respect of the subject matter as it
+*     appeared at the relevant date.
+*
+********************************************************************************/
+/********************************************************************************
+*
+* PROJECT:     Project MIDAS
+*
+* COMPILER:    
+*
+* TOOLS:       Microsoft Visual Studio 2019
+*
+* DESCRIPTION: Fast search of receive buffers for frame boundaries, and of
+*              payloads for parameter delimiters
+*
+* NOTES:       Uses SSE2/AVX2 on x86 and NEON on ARM when available, plain
+*              byte search everywhere else (STM8).
+*
+********************************************************************************/
+#ifndef COMMAND_SCANNER_H
+#define COMMAND_SCANNER_H
+/********************************************************************************
+*                              I N C L U D E S
+********************************************************************************/
+#include <stddef.h>
+#include "commandParameters.h"
+
+/********************************************************************************
+*                          D E F I N I T I O N S
+********************************************************************************/
+// fields kept by a FieldIndex, more than any command has
+#define FIELD_INDEX_MAX 32
+
+/*********************************************************************************
+*                          S T R U C T U R E S
+*********************************************************************************/
+// comma separated fields of an ASCII payload, and the '=' in each
+// offsets are from the start of the payload
+typedef struct _FieldIndex
+{
+   const char* pData;                     // indexed payload
+   uint8_t nFields;                       // fields indexed
+   bool    bTruncated;                    // payload had more than FIELD_INDEX_MAX fields
+   uint8_t nStart[FIELD_INDEX_MAX];       // first byte of each field
+   uint8_t nEquals[FIELD_INDEX_MAX];      // first '=' in each field, nEnd if none
+   uint8_t nEnd[FIELD_INDEX_MAX];         // comma after each field, or end of payload
+} FieldIndex;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+   LIB_API
+   size_t ScanForByte(const char* pBuffer, size_t nLength, char ch);
+   // Finds the first occurrence of a byte in a buffer
+   // Inputs:  pBuffer - data to search
+   //          nLength - number of bytes in pBuffer
+   //          ch      - byte to look for
+   // Outputs: None.
+   // Returns: Offset of the byte, nLength if it isn't found
+   // Notes:   None.
+
+   LIB_API
+   size_t FindNextFrame(const char* pBuffer, size_t nLength);
+   // Resynchronizes after a bad frame. Finds the next STX that starts a
+   // plausible frame: 4 digit length prefix, comma, and ETX at the offset
+   // given by the length.
+   // Inputs:  pBuffer - data to search, normally starts just past a bad STX
+   //          nLength - number of bytes in pBuffer
+   // Outputs: None.
+   // Returns: Number of garbage bytes skipped before the next frame. nLength
+   //          if no frame starts in the buffer.
+   // Notes:   A candidate cut off by the end of the buffer is accepted as far
+   //          as it can be checked, so it can be completed by the next read.
+
+   LIB_API
+   bool BuildFieldIndex(const char* pData, size_t nLength, FieldIndex* pIndex);
+   // Finds every ',' and '=' in an ASCII payload in one pass
+   // Inputs:  pData   - payload, not NULL terminated
+   //          nLength - number of bytes in pData, must be under 256
+   // Outputs: pIndex - start, '=' and end of each field
+   // Returns: false if the payload is too long to index
+   // Notes:   The payload isn't copied, it must outlive the index. Fields
+   //          past FIELD_INDEX_MAX aren't indexed and bTruncated is set.
+
+   LIB_API
+   bool FieldIndex_Field(const FieldIndex* pIndex, size_t nField, FrameView* pField);
+   // Returns a whole field
+   // Inputs:  pIndex - index from BuildFieldIndex
+   //          nField - field number, the command code is field 0
+   // Outputs: pField - the field, without its comma
+   // Returns: false if the payload has no such field
+   // Notes:   None.
+
+   LIB_API
+   bool FieldIndex_TagAndValue(const FieldIndex* pIndex, size_t nField, FrameView* pTag, FrameView* pValue);
+   // Returns the tag and value of a TAG=value field
+   // Inputs:  pIndex - index from BuildFieldIndex
+   //          nField - field number, the command code is field 0
+   // Outputs: pTag   - text before the first '='
+   //          pValue - text after it
+   // Returns: false if the payload has no such field
+   // Notes:   A field without '=' is all tag and an empty value.
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,256 @@
+/*********************************************************************************
+*
+*                          Proprietary Information of
+*
+*                            Precision Systems, Inc.
+*                    1355 Business Center Drive, Suite C
+*                                 Horsham, PA
+*                               (215) 672-1860
+*
+*                   Copyright (C) 2020, Precision Systems, Inc.
+*                            All Rights Reserved
+*
+*             The information and design as detailed in this document is
+*     the property of Precision Systems, Inc., and/or its Associates
+*     and must be returned on demand. It is issued on the strict
+*     condition that except with our written permission it must not be
+*     reproduced, copied or communicated to any third party, nor be
+*     used for any purpose other than that stated in the particular
+*     inquiry, order or contract with which it is issued. The
+*     reservation of copyright in this document extends from each date
+*     appearing thereon and in respect of the subject matter as it
+*     appeared at the relevant date.
+*
+********************************************************************************/
+/********************************************************************************
+*
+* PROJECT:     Project MIDAS
+*
+* COMPILER:    
+*
+* TOOLS:       Microsoft Visual Studio 2019
+*
+* DESCRIPTION: Command schema, the one list of commands, tags and parameters
+*
+* NOTES:       Each list is an X macro: the file that needs the list defines
+*              X to pick the columns it wants and expands the list, e.g.
+*
+*                 #define CODE_ENUM(eCode, eShape, eTag, nMin, nMax, handler) eCode,
+*                 COMMAND_SCHEMA(CODE_ENUM)
+*
+*              The command codes, tag ids, binary tag table, parameter
+*              tables, the single value parsers and builders, the multi-field
+*              command builders and the dispatch table are all expanded from
+*              here, so a command is added by adding its row.
+*
+*              Not everything is generated. The FRAME commands (the logs,
+*              reset logs and sync data) answer with lists or several frames
+*              into buffers the caller owns, so the caller runs them. The RUN
+*              getters keep their own functions because their handlers take
+*              typed outputs (EMixStepSize*, ConfigData*, ...) that are part
+*              of the public API. The VIEW commands take text or more than
+*              one value; their parsers are written out but decode through
+*              the field lists below where they can.
+*
+*              Tag ids and command codes are sent over the link. Rows are
+*              only ever appended, in code order.
+*
+********************************************************************************/
+#ifndef COMMAND_SCHEMA_H
+#define COMMAND_SCHEMA_H
+
+/*********************************************************************************
+*                                T A G S
+*********************************************************************************/
+// X(eTag, szTag), in tag id order. The TAG_ strings are in commandBuilder.h
+#define TAG_SCHEMA(X) \
+   X(ETagError,         ERROR_PREFIX) \
+   X(ETagO2Mix,         TAG_O2_MIX) \
+   X(ETagTogglePin,     TAG_TOGGLE_PIN) \
+   X(ETagPinResp,       TAG_PIN_RESP) \
+   X(ETagChangePin,     TAG_CHANGE_PIN) \
+   X(ETagFlowRate,      TAG_FLOW_RATE) \
+   X(ETagO2Flow,        TAG_O2_FLOW) \
+   X(ETagN2OFlow,       TAG_N2O_FLOW) \
+   X(ETagScavFlow,      TAG_SCAV_FLOW) \
+   X(ETagN2OMax,        TAG_N2O_MAX) \
+   X(ETagMixStep,       TAG_MIX_STEP) \
+   X(ETagFlowStep,      TAG_FLOW_STEP) \
+   X(ETagClockFormat,   TAG_CLOCK_FORMAT) \
+   X(ETagLanguage,      TAG_LANGUAGE) \
+   X(ETagTAndD,         TAG_T_AND_D) \
+   X(ETagTsPower,       TAG_TS_POWER) \
+   X(ETagInProgress,    TAG_IN_PROGRESS) \
+   X(ETagEnding,        TAG_ENDING) \
+   X(ETagStopGas,       TAG_STOP_GAS) \
+   X(ETagFwConfig,      TAG_FW_CONFIG) \
+   X(ETagFwMain,        TAG_FW_MAIN) \
+   X(ETagFwBt,          TAG_FW_BT) \
+   X(ETagBtStatus,      TAG_BT_STATUS) \
+   X(ETagBtEnabled,     TAG_BT_ENABLED) \
+   X(ETagFwGui,         TAG_FW_GUI) \
+   X(ETagFwScav,        TAG_FW_SCAV) \
+   X(ETagFwVersion,     TAG_FW_VERSION) \
+   X(ETagValvePos,      TAG_VALVE_POS) \
+   X(ETagSendMsg,       TAG_SEND_MSG) \
+   X(ETagEnableGasFlow, TAG_ENABLE_GAS_FLOW) \
+   X(ETagMfField,       TAG_MF_FIELD) \
+   X(ETagLogIdx,        TAG_LOG_IDX) \
+   X(ETagScavEnabled,   TAG_SCAV_ENABLED) \
+   X(ETagScavValve,     TAG_SCAV_VALVE) \
+   X(ETagScavSensor,    TAG_SCAV_SENSOR) \
+   X(ETagGasSelection,  TAG_GAS_SELECTION) \
+   X(ETagGvO2,          TAG_GV_O2) \
+   X(ETagGvN2O,         TAG_GV_N2O) \
+   X(ETagGvResetO2,     TAG_GV_RESET_O2) \
+   X(ETagGvResetN2O,    TAG_GV_RESET_N2O) \
+   X(ETagFlushO2,       TAG_FLUSH_O2) \
+   X(ETagPLogCount,     TAG_P_LOG_COUNT) \
+   X(ETagLogEntries,    TAG_LOG_ENTRIES) \
+   X(ETagIndex,         TAG_INDEX) \
+   X(ETagOffset,        TAG_OFFSET) \
+   X(ETagCount,         TAG_COUNT)
+
+/*********************************************************************************
+*                            C O M M A N D S
+*********************************************************************************/
+// X(eCode, eShape, eTag, nMin, nMax, handler), in command code order.
+//
+// eShape says how the command is parsed, run and answered:
+//    NONE     no parameters, handler is the CommandHandlers slot
+//    SET_BOOL eTag is 0 or 1, handler is the CommandHandlers slot
+//    SET_INT  eTag is nMin - nMax, handler is the CommandHandlers slot
+//    GET_INT  no parameters, answered with eTag, handler is the slot
+//    VIEW     handler is the parser, the response echoes the command
+//    RUN      handler is the commandDispatch.c function that parses,
+//             runs and builds the response
+//    FRAME    not dispatched, the caller runs it, see CanDispatch
+//
+// Columns a shape doesn't use are ETagNone, 0 or NONE. The O2 mix and flow
+// rate limits depend on the device, their handlers check them.
+#define COMMAND_SCHEMA(X) \
+   X(EVacuumIncrease,         NONE,     ETagNone,         0,            0,               fpHandleIncreaseVacuumFlow) \
+   X(EVacuumDecrease,         NONE,     ETagNone,         0,            0,               fpHandleDecreaseVacuumFlow) \
+   X(EStartProcedure,         NONE,     ETagNone,         0,            0,               fpHandleStartProcedure) \
+   X(EEndProcedure,           NONE,     ETagNone,         0,            0,               fpHandleEndProcedure) \
+   X(EEnableDisablePin,       SET_BOOL, ETagTogglePin,    0,            1,               fpHandleEnableDisablePin) \
+   X(EGetProcedureLogCount,   GET_INT,  ETagPLogCount,    0,            0,               fpHandleGetProcedureLogCount) \
+   X(EGetProcedureList,       FRAME,    ETagNone,         0,            0,               NONE) \
+   X(EGetProcedureLog,        FRAME,    ETagNone,         0,            0,               NONE) \
+   X(EGetProcedureEntryCount, FRAME,    ETagNone,         0,            0,               NONE) \
+   X(EGetProcedureEntryList,  FRAME,    ETagNone,         0,            0,               NONE) \
+   X(EGetProcedureEntry,      FRAME,    ETagNone,         0,            0,               NONE) \
+   X(EGetAlarmLogList,        FRAME,    ETagNone,         0,            0,               NONE) \
+   X(EGetAlarmLogEntry,       FRAME,    ETagNone,         0,            0,               NONE) \
+   X(EResetLogs,              FRAME,    ETagNone,         0,            0,               NONE) \
+   X(ESetLanguage,            SET_INT,  ETagLanguage,     EEnglish,     French,          fpHandleSetLanguage) \
+   X(EGetLanguage,            RUN,      ETagNone,         0,            0,               RunGetLanguage) \
+   X(ESetTotalFlowRate,       SET_INT,  ETagFlowRate,     INT_MIN,      INT_MAX,         fpHandleSetTotalFlowRate) \
+   X(EGetTotalFlowRate,       GET_INT,  ETagFlowRate,     0,            0,               fpHandleGetTotalFlowRate) \
+   X(EGetFlowRates,           RUN,      ETagNone,         0,            0,               RunGetFlowRates) \
+   X(ESetO2MixPercentage,     SET_INT,  ETagO2Mix,        INT_MIN,      INT_MAX,         fpHandleSetO2MixPercent) \
+   X(EGetO2MixPercentage,     GET_INT,  ETagO2Mix,        0,            0,               fpHandleGetO2MixPercent) \
+   X(EStopGas,                NONE,     ETagNone,         0,            0,               fpHandleStopGasFlow) \
+   X(EEnableDisableBT,        SET_BOOL, ETagBtEnabled,    0,            1,               fpHandleEnableDisableBt) \
+   X(EEnableDisableVacuum,    SET_BOOL, ETagScavEnabled,  0,            1,               fpHandleEnableDisableVacuum) \
+   X(ERestoreDefaults,        NONE,     ETagNone,         0,            0,               fpHandleRestoreDefaultSettings) \
+   X(EChangePin,              VIEW,     ETagNone,         0,            0,               ChangePinView) \
+   X(EMuteAlarm,              NONE,     ETagNone,         0,            0,               fpHandleMuteAlarm) \
+   X(EEnableDisablePower,     SET_BOOL, ETagTsPower,      0,            1,               fpHandleEnableDisablePower) \
+   X(EGetTimeAndDate,         RUN,      ETagNone,         0,            0,               RunGetTimeAndDate) \
+   X(ESetTimeAndDate,         VIEW,     ETagNone,         0,            0,               SetTimeAndDateView) \
+   X(EGetGasVolume,           RUN,      ETagNone,         0,            0,               RunGetGasVolumeInfo) \
+   X(EResetGasVolume,         SET_INT,  ETagGasSelection, EO2,          EGasIdMax - 1,   fpHandleResetGasVolumeInfo) \
+   X(EGetScavengerInfo,       RUN,      ETagNone,         0,            0,               RunGetScavengerInfo) \
+   X(EFlushO2,                SET_BOOL, ETagFlushO2,      0,            1,               fpHandleO2Flush) \
+   X(EHeartbeat,              NONE,     ETagNone,         0,            0,               fpHandleHeartbeat) \
+   X(EScreenReady,            RUN,      ETagNone,         0,            0,               RunScreenReady) \
+   X(ESyncData,               FRAME,    ETagNone,         0,            0,               NONE) \
+   X(EGetFirmwareVersion,     RUN,      ETagNone,         0,            0,               RunGetFirmwareVersion) \
+   X(EGetFirmwareInfo,        RUN,      ETagNone,         0,            0,               RunGetFirmwareInfo) \
+   X(EGetConfigData,          RUN,      ETagNone,         0,            0,               RunGetConfigurationData) \
+   X(ESetValve,               VIEW,     ETagNone,         0,            0,               SetValvePositionView) \
+   X(EGetValve,               RUN,      ETagNone,         0,            0,               RunGetValvePosition) \
+   X(EFirmwareDownload,       NONE,     ETagNone,         0,            0,               fpHandleFirmwareDownload) \
+   X(EEnableGasFlow,          VIEW,     ETagNone,         0,            0,               EnableGasFlowView) \
+   X(EBtFirmwareDownload,     NONE,     ETagNone,         0,            0,               fpHandleBtFirmwareDownload) \
+   X(EWriteManufacturerField, VIEW,     ETagNone,         0,            0,               WriteManufacturerFieldView) \
+   X(EReadManufacturerField,  RUN,      ETagNone,         0,            0,               RunReadManufacturerField) \
+   X(ESetN2OMax,              SET_INT,  ETagN2OMax,       0,            100,             fpHandleSetMaxN2OMixPercent) \
+   X(EGetN2OMax,              GET_INT,  ETagN2OMax,       0,            0,               fpHandleGetMaxN2OMixPercent) \
+   X(EGetMixStepSize,         RUN,      ETagNone,         0,            0,               RunGetMixStepSize) \
+   X(ESetMixStepSize,         SET_INT,  ETagMixStep,      EOnePercent,  EFivePercent,    fpHandleSetMixStepSize) \
+   X(EGetFlowRateStepSize,    RUN,      ETagNone,         0,            0,               RunGetFlowRateStepSize) \
+   X(ESetFlowRateStepSize,    SET_INT,  ETagFlowStep,     EPointOneLPM, EPointFiveLPM,   fpHandleSetFlowRateStepSize) \
+   X(EGetClockFormat,         RUN,      ETagNone,         0,            0,               RunGetClockFormat) \
+   X(ESetClockFormat,         SET_INT,  ETagClockFormat,  ETwelveHour,  ETwentyFourHour, fpHandleSetClockFormat) \
+   X(EGetBtStatus,            RUN,      ETagNone,         0,            0,               RunGetBtStatus)
+
+/*********************************************************************************
+*                          P A R A M E T E R S
+*********************************************************************************/
+// fields of the multi-field commands, X(eSlot, eTag, eType, nMin, nMax, bRequired)
+// eSlot is the field's slot in the decoded values, eType EParamInt or EParamText
+
+// set configuration data, X also takes the ConfigData member.
+// Any field left out keeps its current value
+#define CONFIG_FIELDS(X) \
+   X(EConfigN2OMax,      ETagN2OMax,      EParamInt,  0,            100,                     false, nMaxN20) \
+   X(EConfigMixStep,     ETagMixStep,     EParamInt,  EOnePercent,  EFivePercent,            false, eMixStepSize) \
+   X(EConfigFlowStep,    ETagFlowStep,    EParamInt,  EPointOneLPM, EPointFiveLPM,           false, eFlowStepSize) \
+   X(EConfigClockFormat, ETagClockFormat, EParamInt,  ETwelveHour,  ETwentyFourHour,         false, eClockFormat) \
+   X(EConfigLanguage,    ETagLanguage,    EParamInt,  EEnglish,     French,                  false, eLanguage) \
+   X(EConfigTime,        ETagTAndD,       EParamText, 1,            DATE_TIME_BUFF_SIZE - 1, false, szTime)
+
+// procedure log list, index isn't used
+#define LOG_LIST_FIELDS(X) \
+   X(ELogListIndex,  ETagIndex,  EParamInt, 0, INT_MAX, false) \
+   X(ELogListOffset, ETagOffset, EParamInt, 0, INT_MAX, true) \
+   X(ELogListCount,  ETagCount,  EParamInt, 0, INT_MAX, true)
+
+// procedure log entry list, same slots as LOG_LIST_FIELDS
+#define LOG_ENTRY_LIST_FIELDS(X) \
+   X(ELogListIndex,  ETagIndex,  EParamInt, 0, INT_MAX, true) \
+   X(ELogListOffset, ETagOffset, EParamInt, 0, INT_MAX, true) \
+   X(ELogListCount,  ETagCount,  EParamInt, 0, INT_MAX, true)
+
+// gas selection and valve position
+#define VALVE_FIELDS(X) \
+   X(EGasSelection, ETagGasSelection, EParamInt, EO2, EGasIdMax - 1, true) \
+   X(EGasValue,     ETagValvePos,     EParamInt, 0,   100,           true)
+
+// gas selection alone
+#define GAS_SELECTION_FIELDS(X) \
+   X(EGasSelection, ETagGasSelection, EParamInt, EO2, EGasIdMax - 1, true)
+
+// gas selection and flow enable, same slots as VALVE_FIELDS
+#define GAS_FLOW_FIELDS(X) \
+   X(EGasSelection, ETagGasSelection,  EParamInt, EO2, EGasIdMax - 1, true) \
+   X(EGasValue,     ETagEnableGasFlow, EParamInt, 0,   1,             true)
+
+/*********************************************************************************
+*                                S L O T S
+*********************************************************************************/
+// slot of each field in its list, shared by the parser and the builders
+#define SCHEMA_FIELD_SLOT(eSlot, eTag, eType, nMin, nMax, bRequired) eSlot,
+#define SCHEMA_CONFIG_SLOT(eSlot, eTag, eType, nMin, nMax, bRequired, member) eSlot,
+
+typedef enum _EConfigField
+{
+   CONFIG_FIELDS(SCHEMA_CONFIG_SLOT)
+   EConfigFieldCount
+} EConfigField;
+
+typedef enum _ELogListField
+{
+   LOG_LIST_FIELDS(SCHEMA_FIELD_SLOT)
+   ELogListFieldCount
+} ELogListField;
+
+typedef enum _EGasField
+{
+   VALVE_FIELDS(SCHEMA_FIELD_SLOT)
+   EGasFieldCount
+} EGasField;
+
+#endif // COMMAND_SCHEMA_H
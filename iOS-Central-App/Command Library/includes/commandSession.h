@@ -0,0 +1,371 @@
+/*********************************************************************************
+*
+*                          Proprietary Information of
+*
+*                            Precision Systems, Inc.
+*                    1355 Business Center Drive, Suite C
+*                                 Horsham, PA
+*                               (215) 672-1860
+*
+*                   Copyright (C) 2020, Precision Systems, Inc.
+*                            All Rights Reserved
+*
+*             The information and design as detailed in this document is
+*     the property of Precision Systems, Inc., and/or its Associates
+*     and must be returned on demand. It is issued on the strict
+*     condition that except with our written permission it must not be
+*     reproduced, copied or communicated to any third party, nor be
+*     used for any purpose other than that stated in the particular
+*     inquiry, order or contract with which it is issued. The
+*     reservation of copyright in this document extends from each date
+*     appearing thereon and in respect of the subject matter as it
+*     appeared at the relevant date.
+*
+********************************************************************************/
+/********************************************************************************
+*
+* PROJECT:     Project MIDAS
+*
+* COMPILER:    
+*
+* TOOLS:       Microsoft Visual Studio 2019
+*
+* DESCRIPTION: Protocol sessions, one per connected device
+*
+* NOTES:       A CmdSession holds everything the library changes while it
+*              runs: the command handlers, the frame check and payload
+*              codec for frames it builds, the frame decoder, the requests
+*              waiting for a response, the commands waiting for an async
+*              handler and the transport. One process can talk to many
+*              devices by giving each one a session, with no state shared
+*              between them.
+*
+*              The CmdSession functions make their session current on the
+*              calling thread while they run. The older functions, e.g.
+*              SetCommandHandlers, SetPayloadCodec or the Build* functions,
+*              use the current session, so a handler called for a session
+*              builds its payloads with that session's codec. Outside a
+*              session they use a default session, which keeps existing
+*              single device code working unchanged.
+*
+*              Setpoint commands can be merged both ways, see
+*              commandSetpoints.h. Setpoints sent with
+*              CmdSession_SendSetpoint wait for the session's window and go
+*              out with CmdSession_Poll. Received setpoints can be merged
+*              with CmdSession_MergeReceivedSetpoints. Setpoints never
+*              overtake other commands, or a stop could be undone by an
+*              older setpoint.
+*
+*              Commands can also be sent and run by class, see
+*              commandPriority.h. CmdSession_Queue and
+*              CmdSession_QueueTransfer put requests and transport transfers
+*              in the send lanes and CmdSession_Pump sends them a frame at
+*              a time, highest class first. CmdSession_Send still sends at
+*              once. CmdSession_PrioritizeReceived holds the commands of one
+*              CmdSession_Receive call and runs them highest class first.
+*
+*              A session is used by one thread at a time, except for
+*              CmdSession_CompleteCommand. Different sessions may be used
+*              on different threads at once.
+*
+********************************************************************************/
+#ifndef COMMAND_SESSION_H
+#define COMMAND_SESSION_H
+/********************************************************************************
+*                              I N C L U D E S
+********************************************************************************/
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "commandParameters.h"
+#include "commandHandlers.h"
+#include "commandFramework.h"
+#include "commandWriter.h"
+#include "commandRequests.h"
+#include "commandCompletion.h"
+#include "commandSetpoints.h"
+#include "commandPriority.h"
+
+/********************************************************************************
+*                          D E F I N I T I O N S
+********************************************************************************/
+// writes framed bytes to the session's device
+typedef void(*FnSessionWrite)(void* pContext, const char* pBytes, size_t nLength);
+
+// a response or ACK/NAK received for the session. pRequest is the request it
+// answers, NULL if it matches none. Also called, with pRequest NULL, for
+// received commands DispatchFrame doesn't run, see CanDispatch
+typedef void(*FnSessionResponse)(void* pContext, const MessageFrame* pFrame, const PendingRequest* pRequest);
+
+/*********************************************************************************
+*                            S T R U C T U R E S
+*********************************************************************************/
+// protocol state for one device, see CmdSession_Init
+typedef struct _CmdSession
+{
+   HandlerTable      handlers;      // SetCommandHandlers
+   PendingTable      pending;       // commands waiting for async handlers
+   EFrameIntegrity   eIntegrity;    // SetFrameIntegrity
+   EPayloadCodec     eCodec;        // SetPayloadCodec
+   TokenCursor       tokenCursor;   // StrTokenize
+   FrameDecoder      decoder;       // bytes received from the device
+   RequestTable      requests;      // requests sent, waiting for a response
+   SetpointQueue     sendSetpoints; // setpoints waiting to be sent
+   SetpointQueue     rxSetpoints;   // setpoints received, merged until the next command
+   bool              bMergeReceived;
+   PriorityLanes     lanes;         // commands waiting for their class to be served
+   bool              bPrioritizeReceived;
+   uint8_t           nTransferId;   // transport message id of the next transfer
+   FnSessionWrite    fpWrite;
+   FnSessionResponse fpResponse;
+   void*             pContext;      // passed to fpWrite and fpResponse
+} CmdSession;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+   LIB_API
+   void CmdSession_Init(CmdSession* pSession, FnSessionWrite fpWrite, FnSessionResponse fpResponse, void* pContext);
+   // Starts a session with no handlers, sum8 frames and ASCII payloads
+   // Inputs:  fpWrite    - sends framed bytes to the device
+   //          fpResponse - called for responses to requests and for commands
+   //                       the session can't run, may be NULL
+   //          pContext   - passed to fpWrite and fpResponse
+   // Outputs: pSession - ready to use
+   // Returns: None.
+   // Notes:   None.
+
+   LIB_API
+   CmdSession* CmdSession_Enter(CmdSession* pSession);
+   // Makes a session current on the calling thread
+   // Inputs:  pSession - session, NULL for the default session
+   // Outputs: None.
+   // Returns: Session that was current, pass it to CmdSession_Leave
+   // Notes:   Only needed to call the older functions for a session.
+
+   LIB_API
+   void CmdSession_Leave(CmdSession* pPrevious);
+   // Restores the session that was current before CmdSession_Enter
+   // Inputs:  pPrevious - return value of CmdSession_Enter
+   // Outputs: None.
+   // Returns: None.
+   // Notes:   None.
+
+   LIB_API
+   CmdSession* CmdSession_Current(void);
+   // Returns the current session of the calling thread
+   // Inputs:  None.
+   // Outputs: None.
+   // Returns: Current session, the default session outside CmdSession_Enter
+   // Notes:   None.
+
+   LIB_API
+   bool CmdSession_SetHandlers(CmdSession* pSession, CommandHandlers* pHandlers);
+   // Sets the command handlers of a session, see SetCommandHandlers
+   // Inputs:  pHandlers - command handlers
+   // Outputs: pSession - handlers swapped
+   // Returns: false if every spare table is still in use, try again later
+   // Notes:   May be called while the session is receiving.
+
+   LIB_API
+   void CmdSession_SetFrameIntegrity(CmdSession* pSession, EFrameIntegrity eIntegrity);
+   // Selects the frame check for frames the session sends
+   // Inputs:  eIntegrity - frame check
+   // Outputs: pSession - frame check set
+   // Returns: None.
+   // Notes:   None.
+
+   LIB_API
+   void CmdSession_SetPayloadCodec(CmdSession* pSession, EPayloadCodec eCodec);
+   // Selects the codec for payloads built for the session
+   // Inputs:  eCodec - payload codec
+   // Outputs: pSession - codec set
+   // Returns: None.
+   // Notes:   None.
+
+   LIB_API
+   size_t CmdSession_Receive(CmdSession* pSession, const char* pBytes, size_t nLength);
+   // Handles bytes received from the session's device
+   // Inputs:  pBytes  - received data, may start or end in the middle of a frame
+   //          nLength - number of bytes in pBytes
+   // Outputs: pSession - commands dispatched, responses matched
+   // Returns: Number of frames received
+   // Notes:   Commands are run by DispatchFrame and their responses are
+   //          written with fpWrite. Responses are matched to the requests
+   //          sent with CmdSession_Send and passed to fpResponse.
+   //          Commands CanDispatch refuses are passed to fpResponse too.
+
+   LIB_API
+   EHandlerResponse CmdSession_Dispatch(CmdSession* pSession, const MessageFrame* pFrame, MsgPayload* pResponse);
+   // Runs DispatchFrame for a session
+   // Inputs:  pFrame - received frame
+   // Outputs: pResponse - see DispatchFrame, not written to the device
+   // Returns: See DispatchFrame
+   // Notes:   For frames parsed by the caller instead of CmdSession_Receive.
+
+   LIB_API
+   bool CmdSession_Send(CmdSession* pSession, MsgPayload* pRequest, ECommandCode eCode, uint32_t nNow, void* pRequestContext);
+   // Sends a request, its response is handled when it arrives
+   // Inputs:  pRequest        - request payload, built and ready for framing
+   //          eCode           - command code of the request
+   //          nNow            - current time
+   //          pRequestContext - handed back with the response
+   // Outputs: pRequest - sequence number set
+   // Returns: false if REQUEST_TABLE_SIZE requests are already waiting
+   // Notes:   Returns once the request is written, without waiting. The
+   //          response is passed to fpResponse by CmdSession_Receive.
+   //          Setpoints queued by CmdSession_SendSetpoint are sent first.
+
+   LIB_API
+   void CmdSession_SetSetpointWindow(CmdSession* pSession, uint32_t nWindow);
+   // Sets how long setpoints sent with CmdSession_SendSetpoint are held
+   // Inputs:  nWindow - time a setpoint is held for newer values
+   // Outputs: pSession - window set
+   // Returns: None.
+   // Notes:   0, the default, sends each setpoint at once.
+
+   LIB_API
+   bool CmdSession_SendSetpoint(CmdSession* pSession, MsgPayload* pRequest, ECommandCode eCode, uint32_t nNow);
+   // Queues a setpoint request, replacing an older one for the same setpoint
+   // Inputs:  pRequest - request payload, built and ready for framing
+   //          eCode    - command code of the request
+   //          nNow     - current time
+   // Outputs: None.
+   // Returns: false if the request couldn't be queued or sent
+   // Notes:   Commands that aren't setpoints are sent by CmdSession_Send.
+   //          Only the value sent gets a response.
+
+   LIB_API
+   size_t CmdSession_Poll(CmdSession* pSession, uint32_t nNow);
+   // Sends the setpoints whose window has passed
+   // Inputs:  nNow - current time
+   // Outputs: pSession - setpoints sent
+   // Returns: Number of setpoints sent
+   // Notes:   Call at least once per window.
+
+   LIB_API
+   void CmdSession_MergeReceivedSetpoints(CmdSession* pSession, bool bMerge);
+   // Turns on merging of received setpoint commands
+   // Inputs:  bMerge - merge received setpoints
+   // Outputs: pSession - setting changed
+   // Returns: None.
+   // Notes:   Setpoints received in a row are held until the end of the
+   //          CmdSession_Receive call or the next frame that isn't held, and only
+   //          the newest for each setpoint is run. The ones it replaces are
+   //          answered as accepted without calling their handler.
+
+   LIB_API
+   bool CmdSession_Queue(CmdSession* pSession, const MsgPayload* pRequest, ECommandCode eCode, uint32_t nNow, void* pRequestContext);
+   // Queues a request in the send lane of its class
+   // Inputs:  pRequest        - request payload, built and ready for framing
+   //          eCode           - command code of the request
+   //          nNow            - current time
+   //          pRequestContext - handed back with the response
+   // Outputs: pSession - request queued
+   // Returns: false if its lane is full
+   // Notes:   Sent by CmdSession_Pump. Setpoints are queued as with
+   //          CmdSession_SendSetpoint and get no context back.
+
+   LIB_API
+   bool CmdSession_QueueTransfer(CmdSession* pSession,
+                                 const MsgPayload* pRequest,
+                                 ECommandCode eCode,
+                                 const char* pMessage,
+                                 size_t nLength);
+   // Queues a logical message to be sent as transport fragments
+   // Inputs:  pRequest - request the message answers, its sequence number
+   //                     goes on every fragment, may be NULL
+   //          eCode    - command code of the request, sets the class
+   //          pMessage - logical message, e.g. from
+   //                     BuildGetProcedureLogEntryListMessageResponse
+   //          nLength  - number of bytes in pMessage
+   // Outputs: pSession - transfer queued
+   // Returns: false if its lane is full or the message is empty or too long
+   // Notes:   pMessage must stay unchanged until the last fragment is sent.
+
+   LIB_API
+   size_t CmdSession_Pump(CmdSession* pSession, uint32_t nNow, size_t nMaxFrames);
+   // Sends queued frames, highest class first
+   // Inputs:  nNow       - current time
+   //          nMaxFrames - most frames to send
+   // Outputs: pSession - frames sent removed from the lanes
+   // Returns: Number of frames sent
+   // Notes:   One frame at a time, so a transfer gives way to a safety
+   //          command between fragments. Setpoints whose window has passed
+   //          are sent as control commands. Safety and control commands
+   //          don't overtake queued setpoints, see CmdSession_Send; bulk
+   //          ones do.
+
+   LIB_API
+   void CmdSession_PrioritizeReceived(CmdSession* pSession, bool bPrioritize);
+   // Turns on running received commands highest class first
+   // Inputs:  bPrioritize - hold received commands in their lanes
+   // Outputs: pSession - setting changed
+   // Returns: None.
+   // Notes:   Commands of one CmdSession_Receive call are held and run once
+   //          it has decoded them all, safety first and bulk last. A safety
+   //          command still runs after setpoints received before it. A
+   //          command whose lane is full, or a frame that isn't a command,
+   //          runs the held ones first.
+
+   LIB_API
+   bool CmdSession_Expire(CmdSession* pSession, uint32_t nNow, uint32_t nTimeout, PendingRequest* pRequest);
+   // Removes a request that has waited too long, see RequestTable_Expire
+   // Inputs:  nNow     - current time
+   //          nTimeout - time a request may wait for its response
+   // Outputs: pRequest - the request that timed out, may be NULL
+   // Returns: false if no request has timed out
+   // Notes:   Call until it returns false.
+
+   LIB_API
+   bool CmdSession_CompleteTransport(CmdSession* pSession,
+                                     const MessageFrame* pFrame,
+                                     ETransportResult eResult,
+                                     const FrameView* pMessage,
+                                     PendingRequest* pRequest);
+   // Matches a reassembled transport response to its request
+   // Inputs:  pFrame   - last fragment received
+   //          eResult  - result of Transport_AddFragment for pFrame
+   //          pMessage - message from Transport_AddFragment
+   // Outputs: pRequest - the request answered, may be NULL
+   // Returns: false if the message isn't complete or no request matches
+   // Notes:   Fragments reach fpResponse with no request. Call this from
+   //          fpResponse once Transport_AddFragment has the whole message,
+   //          see RequestTable_CompleteTransport.
+
+   LIB_API
+   bool CmdSession_SendPayload(CmdSession* pSession, MsgPayload* pPayload);
+   // Frames a payload and writes it to the session's device
+   // Inputs:  pPayload - payload, sequence number set if it has one
+   // Outputs: None.
+   // Returns: false if the session has no fpWrite or the payload won't fit
+   // Notes:   None.
+
+   LIB_API
+   EHandlerResponse CmdSession_CompleteCommand(CmdSession* pSession, CommandToken token, EHandlerResponse eResult);
+   // Runs CompleteCommand for a command of the session
+   // Inputs:  token   - token the async handler was given
+   //          eResult - handler result
+   // Outputs: None.
+   // Returns: See CompleteCommand
+   // Notes:   May be called from any thread.
+
+   LIB_API
+   EHandlerResponse CmdSession_CompleteReadManufacturerField(CmdSession* pSession,
+                                                             CommandToken token,
+                                                             EHandlerResponse eResult,
+                                                             const char* pszValue);
+   // Runs CompleteReadManufacturerField for a command of the session
+   // Inputs:  token    - token the async handler was given
+   //          eResult  - handler result
+   //          pszValue - field value
+   // Outputs: None.
+   // Returns: See CompleteCommand
+   // Notes:   May be called from any thread.
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // COMMAND_SESSION_H
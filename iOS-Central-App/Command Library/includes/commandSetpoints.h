@@ -0,0 +1,155 @@
+/*********************************************************************************
+*
+*                          Proprietary Information of
+*
+*                            Precision Systems, Inc.
+*                    1355 Business Center Drive, Suite C
+*                                 Horsham, PA
+*                               (215) 672-1860
+*
+*                   Copyright (C) 2020, Precision Systems, Inc.
+*                            All Rights Reserved
+*
+*             The information and design as detailed in this document is
+*     the property of Precision Systems, Inc., and/or its Associates
+*     and must be returned on demand. It is issued on the strict
+*     condition that except with our written permission it must not be
+*     reproduced, copied or communicated to any third party, nor be
+*     used for any purpose other than that stated in the particular
+*     inquiry, order or contract with which it is issued. The
+*     reservation of copyright in this document extends from each date
+*     appearing thereon and in respect of the subject matter as it
+*     appeared at the relevant date.
+*
+********************************************************************************/
+/********************************************************************************
+*
+* PROJECT:     Project MIDAS
+*
+* COMPILER:    
+*
+* TOOLS:       Microsoft Visual Studio 2019
+*
+* DESCRIPTION: Last writer wins queue for setpoint commands
+*
+* NOTES:       Dragging a slider sends a burst of set flow rate, set O2 mix
+*              or set valve commands, and only the last value matters.
+*              The queue holds one command per setpoint, the total flow
+*              rate, the O2 mix and one valve per gas. A newer command for
+*              the same setpoint replaces the queued one.
+*
+*              A setpoint is held for the window after its first value was
+*              queued, then taken with the newest value. The window keeps
+*              running while the value is replaced, so a long drag is sent
+*              once per window rather than held back until it stops.
+*
+*              The library has no clock. Times are passed in by the caller
+*              in whatever unit it uses for the window.
+*
+********************************************************************************/
+#ifndef COMMAND_SETPOINTS_H
+#define COMMAND_SETPOINTS_H
+/********************************************************************************
+*                              I N C L U D E S
+********************************************************************************/
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "commandParameters.h"
+
+/********************************************************************************
+*                          D E F I N I T I O N S
+********************************************************************************/
+// total flow rate, O2 mix and one valve per gas
+#define SETPOINT_SLOT_COUNT (2 + EGasIdMax)
+
+/*********************************************************************************
+*                            E N U M S
+*********************************************************************************/
+// what SetpointQueue_Put did with a command
+typedef enum _ESetpointResult
+{
+   ESetpointNotQueued,     // not a setpoint command, or its payload is bad
+   ESetpointQueued,        // queued, nothing was waiting for the setpoint
+   ESetpointReplaced       // replaced the command waiting for the setpoint
+} ESetpointResult;
+
+/*********************************************************************************
+*                            S T R U C T U R E S
+*********************************************************************************/
+// newest command for one setpoint
+typedef struct _QueuedSetpoint
+{
+   bool         bQueued;
+   ECommandCode eCode;
+   uint32_t     nQueuedTime;   // when the first value still waiting was queued
+   MsgPayload   payload;
+} QueuedSetpoint;
+
+typedef struct _SetpointQueue
+{
+   QueuedSetpoint setpoints[SETPOINT_SLOT_COUNT];
+   uint32_t       nWindow;     // time a setpoint is held for newer values
+   size_t         nQueued;
+} SetpointQueue;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+   LIB_API
+   void SetpointQueue_Init(SetpointQueue* pQueue, uint32_t nWindow);
+   // Empties a setpoint queue
+   // Inputs:  nWindow - time a setpoint is held for newer values, 0 to
+   //                    take each command as soon as it is queued
+   // Outputs: pQueue - no setpoints queued
+   // Returns: None.
+   // Notes:   None.
+
+   LIB_API
+   bool IsSetpointCommand(ECommandCode eCode);
+   // Checks whether a command sets a value a newer command fully replaces
+   // Inputs:  eCode - command code
+   // Outputs: None.
+   // Returns: true for set total flow rate, set O2 mix and set valve
+   // Notes:   None.
+
+   LIB_API
+   ESetpointResult SetpointQueue_Put(SetpointQueue* pQueue,
+                                     ECommandCode eCode,
+                                     const MsgPayload* pPayload,
+                                     uint32_t nNow,
+                                     MsgPayload* pReplaced);
+   // Queues a setpoint command, replacing an older one for the same setpoint
+   // Inputs:  eCode    - command code
+   //          pPayload - command payload, with its sequence number if any
+   //          nNow     - current time
+   // Outputs: pQueue    - command queued
+   //          pReplaced - the command replaced, may be NULL
+   // Returns: See ESetpointResult
+   // Notes:   Set valve commands are kept apart by gas.
+
+   LIB_API
+   bool SetpointQueue_Take(SetpointQueue* pQueue, uint32_t nNow, ECommandCode* peCode, MsgPayload* pPayload);
+   // Takes a setpoint command whose window has passed
+   // Inputs:  nNow - current time
+   // Outputs: pQueue   - command removed
+   //          peCode   - command code
+   //          pPayload - newest command for the setpoint
+   // Returns: false if no window has passed
+   // Notes:   Call until it returns false. Unsigned time differences, so
+   //          the clock may wrap.
+
+   LIB_API
+   bool SetpointQueue_Flush(SetpointQueue* pQueue, ECommandCode* peCode, MsgPayload* pPayload);
+   // Takes a setpoint command whatever its window
+   // Inputs:  None.
+   // Outputs: See SetpointQueue_Take
+   // Returns: false if the queue is empty
+   // Notes:   Used before a command that must not overtake the setpoints.
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // COMMAND_SETPOINTS_H
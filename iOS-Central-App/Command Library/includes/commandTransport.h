@@ -0,0 +1,183 @@
+/*********************************************************************************
+*
+*                          Proprietary Information of
+*
+*                            Precision Systems, Inc.
+*                    1355 Business Center Drive, Suite C
+*                                 Horsham, PA
+*                               (215) 672-1860
+*
+*                   Copyright (C) 2020, Precision Systems, Inc.
+*                            All Rights Reserved
+*
+*             The information and design as detailed in this document is
+*     the property of Precision Systems, Inc., and/or its Associates
+*     and must be returned on demand. It is issued on the strict
+*     condition that except with our written permission it must not be
+*     reproduced, copied or communicated to any third party, nor be
+*     used for any purpose other than that stated in the particular
+*     inquiry, order or contract with which it is issued. The
+*     reservation of copyright in this document extends from each date
+*     appearing thereon and in respect of the subject matter as it
+*     appeared at the relevant date.
+*
+********************************************************************************/
+/********************************************************************************
+*
+* PROJECT:     Project MIDAS
+*
+* COMPILER:    
+*
+* TOOLS:       Microsoft Visual Studio 2019
+*
+* DESCRIPTION: Transport ("PH+T") fragmentation and reassembly
+*
+* NOTES:       A logical message too long for one payload is sent as a
+*              numbered series of fragment payloads. Each fragment is framed
+*              and checked like any other payload. The reassembled message is
+*              checked again against the message length and checksum that
+*              every fragment carries.
+*
+*              Fragment payload: HEADER_TRANSPORT, message id, fragment
+*              index, fragment count, message length (16 bit) and message
+*              checksum (16 bit), little endian, then up to
+*              TRANSPORT_FRAGMENT_DATA bytes of the message.
+*
+********************************************************************************/
+#ifndef COMMAND_TRANSPORT_H
+#define COMMAND_TRANSPORT_H
+/********************************************************************************
+*                              I N C L U D E S
+********************************************************************************/
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "commandParameters.h"
+
+/********************************************************************************
+*                          D E F I N I T I O N S
+********************************************************************************/
+#define TRANSPORT_MARKER_LENGTH  4
+#define TRANSPORT_HEADER_LENGTH  (TRANSPORT_MARKER_LENGTH + 7)
+
+// message bytes carried by one fragment. The payload keeps room for a NULL
+// and for a frame sequence number.
+#define TRANSPORT_FRAGMENT_DATA  (PAYLOAD_LENGTH - 1 - TRANSPORT_HEADER_LENGTH - FRAME_SEQUENCE_LENGTH)
+
+#define TRANSPORT_MAX_FRAGMENTS  255
+
+// longest logical message
+#define TRANSPORT_MAX_MESSAGE    (TRANSPORT_MAX_FRAGMENTS * TRANSPORT_FRAGMENT_DATA)
+
+/*********************************************************************************
+*                            E N U M S
+*********************************************************************************/
+// result of adding a fragment to a reassembler
+typedef enum _ETransportResult
+{
+   ETransportFragmentOk,      // fragment stored, more to come
+   ETransportMessageDone,     // last fragment stored, message is complete
+   ETransportNotFragment,     // payload has no transport header
+   ETransportBadFragment,     // header fields don't agree with the message
+   ETransportTooLong,         // message won't fit in the reassembly buffer
+   ETransportChecksumError    // all fragments received, message checksum bad
+} ETransportResult;
+
+/*********************************************************************************
+*                            S T R U C T U R E S
+*********************************************************************************/
+// splits one logical message into fragment payloads
+typedef struct _TransportSender
+{
+   const char* pMessage;
+   size_t      nLength;
+   uint16_t    nChecksum;
+   uint8_t     nMessageId;
+   uint8_t     nFragmentCount;
+   uint8_t     nNextFragment;
+} TransportSender;
+
+// collects fragments into a caller supplied buffer, one per link
+typedef struct _TransportReassembler
+{
+   char*    pBuffer;
+   size_t   nBufferSize;
+   size_t   nLength;          // length of the message being reassembled
+   uint16_t nChecksum;        // checksum of the message being reassembled
+   uint8_t  nMessageId;
+   uint8_t  nFragmentCount;
+   uint8_t  nReceived;        // number of different fragments stored
+   bool     bActive;
+   uint8_t  nReceivedMask[(TRANSPORT_MAX_FRAGMENTS + 7) / 8];
+} TransportReassembler;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+   LIB_API
+   bool IsTransportPayload(const char* pData, size_t nLength);
+   // Checks for the transport fragment header
+   // Inputs:  pData   - payload bytes
+   //          nLength - number of bytes in pData
+   // Outputs: None.
+   // Returns: true if the payload is a transport fragment
+   // Notes:   None.
+
+   LIB_API
+   uint16_t TransportChecksum(const void* pMessage, size_t nLength);
+   // Calculates the per message checksum
+   // Inputs:  pMessage - logical message
+   //          nLength  - number of bytes in pMessage
+   // Returns: CRC-16/CCITT of the message bytes
+   // Notes:   None.
+
+   LIB_API
+   bool Transport_BeginSend(TransportSender* pSender, uint8_t nMessageId, const char* pMessage, size_t nLength);
+   // Starts splitting a logical message into fragments
+   // Inputs:  nMessageId - id shared by all fragments of the message,
+   //                       change it for every message sent
+   //          pMessage   - logical message
+   //          nLength    - number of bytes in pMessage
+   // Outputs: pSender - ready to produce the first fragment
+   // Returns: false if the message is empty or too long
+   // Notes:   pMessage must stay unchanged until the last fragment is built.
+
+   LIB_API
+   bool Transport_NextFragment(TransportSender* pSender, MsgPayload* pPayload);
+   // Builds the next fragment payload
+   // Inputs:  pSender - sender started with Transport_BeginSend
+   // Outputs: pPayload - fragment payload with length and checksum set,
+   //                     ready for AddMessageFraming
+   // Returns: false when all fragments have been built
+   // Notes:   None.
+
+   LIB_API
+   void Transport_InitReassembler(TransportReassembler* pReassembler, char* pBuffer, size_t nBufferSize);
+   // Prepares a reassembler
+   // Inputs:  pBuffer     - storage for the reassembled message
+   //          nBufferSize - size of pBuffer
+   // Outputs: pReassembler - ready for the first fragment
+   // Returns: None.
+   // Notes:   None.
+
+   LIB_API
+   ETransportResult Transport_AddFragment(TransportReassembler* pReassembler,
+                                          const FrameView* pPayload,
+                                          FrameView* pMessage);
+   // Stores a received fragment
+   // Inputs:  pPayload - payload of a received frame
+   // Outputs: pReassembler - fragment stored
+   //          pMessage     - set to the complete message when
+   //                         ETransportMessageDone is returned
+   // Returns: Result of adding the fragment
+   // Notes:   Fragments may arrive in any order and repeats are ignored. A
+   //          fragment of a different message abandons the one in progress.
+   //          The message is NULL terminated if the buffer has room and
+   //          stays in the buffer until the next fragment is added.
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
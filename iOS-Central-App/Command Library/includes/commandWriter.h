@@ -0,0 +1,317 @@
+/*********************************************************************************
+*
+*                          Proprietary Information of
+*
+*                            Precision Systems, Inc.
+*                    1355 Business Center Drive, Suite C
+*                                 Horsham, PA
+*                               (215) 672-1860
+*
+*                   Copyright (C) 2020, Precision Systems, Inc.
+*                            All Rights Reserved
+*
+*             The information and design as detailed in this document is
+*     the property of Precision Systems, Inc., and/or its Associates
+*     and must be returned on demand. It is issued on the strict
+*     condition that except with our written permission it must not be
+*     reproduced, copied or communicated to any third party, nor be
+*     used for any purpose other than that stated in the particular
+*     inquiry, order or contract with which it is issued. The
+*     reservation of copyright in this document extends from each date
+*     appearing thereon and in respect of the subject matter as it
+*     appeared at the relevant date.
+*
+********************************************************************************/
+/********************************************************************************
+*
+* PROJECT:     Project MIDAS
+*
+* COMPILER:    
+*
+* TOOLS:       Microsoft Visual Studio 2019
+*
+* DESCRIPTION: Payload writer used by the command builders
+*
+* NOTES:       The writer appends fields straight into a MsgPayload and keeps
+*              the length and checksum up to date as it goes, so the payload
+*              is complete when the last field is written. Messages too long
+*              for one payload are written into a caller supplied buffer and
+*              sent with the transport layer, see commandTransport.h.
+*
+*              Payloads started with PayloadWriter_BeginCommand or
+*              PayloadWriter_BeginResponse are written in the codec chosen
+*              with SetPayloadCodec, ASCII text or binary records.
+*
+********************************************************************************/
+#ifndef COMMAND_WRITER_H
+#define COMMAND_WRITER_H
+/********************************************************************************
+*                              I N C L U D E S
+********************************************************************************/
+#include <stdbool.h>
+#include <stddef.h>
+#include "commandParameters.h"
+#include "commandChecksum.h"
+
+/*********************************************************************************
+*                            E N U M S
+*********************************************************************************/
+// payload encoding
+typedef enum _EPayloadCodec
+{
+   EPayloadCodecAscii,     // "code,TAG=value,..."
+   EPayloadCodecBinary     // HEADER_BIN and records, see commandBinary.h
+} EPayloadCodec;
+
+/*********************************************************************************
+*                            S T R U C T U R E S
+*********************************************************************************/
+// output state for one payload
+typedef struct _PayloadWriter
+{
+   MsgPayload*   pPayload;      // NULL when writing a message buffer
+   char*         pData;
+   size_t        nCapacity;     // bytes pData can hold, not counting the NULL
+   size_t        nLength;
+   ChecksumState checksum;
+   EPayloadCodec eCodec;
+   size_t        nRecordStart;  // length byte of the open binary list record
+   size_t        nItemStart;    // first byte of the open list item
+   int           nItems;        // items written to the open list
+   int           nItemValues;   // values written to the open list item
+   bool          bOverflow;     // set when a write did not fit
+} PayloadWriter;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+   LIB_API
+   void SetPayloadCodec(EPayloadCodec eCodec);
+   // Selects the codec used for payloads built from now on
+   // Inputs:  eCodec - payload codec
+   // Outputs: None.
+   // Returns: None.
+   // Notes:   ASCII is used until this is called. Received payloads are
+   //          decoded in whichever codec they arrive in.
+
+   LIB_API
+   EPayloadCodec GetPayloadCodec(void);
+   // Returns the codec used for payloads built from now on
+   // Inputs:  None.
+   // Outputs: None.
+   // Returns: Payload codec
+   // Notes:   None.
+
+   LIB_API
+   void PayloadWriter_Begin(PayloadWriter* pWriter, MsgPayload* pPayload);
+   // Starts writing a new payload
+   // Inputs:  pPayload - payload to write into
+   // Outputs: pWriter  - ready to write at the start of the payload
+   //          pPayload - emptied
+   // Returns: None.
+   // Notes:   The payload buffer is not cleared. Only the bytes written and
+   //          the terminating NULL are touched.
+
+   LIB_API
+   void PayloadWriter_BeginMessage(PayloadWriter* pWriter, char* pBuffer, size_t nBufferSize);
+   // Starts writing a message into a caller supplied buffer
+   // Inputs:  pBuffer     - buffer to write into
+   //          nBufferSize - size of pBuffer, including room for the NULL
+   // Outputs: pWriter - ready to write at the start of the buffer
+   // Returns: None.
+   // Notes:   For messages longer than a payload. The length written is in
+   //          pWriter->nLength after PayloadWriter_End.
+
+   LIB_API
+   void PayloadWriter_BeginCommand(PayloadWriter* pWriter, MsgPayload* pPayload, ECommandCode eCode);
+   // Starts a command payload in the selected codec
+   // Inputs:  pPayload - payload to write into
+   //          eCode    - command code
+   // Outputs: pWriter - positioned after the command code
+   // Returns: None.
+   // Notes:   ACK and NAK are sent as their control character in ASCII.
+
+   LIB_API
+   void PayloadWriter_BeginResponse(PayloadWriter* pWriter, MsgPayload* pPayload, ECommandCode eCode);
+   // Starts a response payload in the selected codec
+   // Inputs:  pPayload - payload to write into
+   //          eCode    - code of the command being answered
+   // Outputs: pWriter - positioned after the command code
+   // Returns: None.
+   // Notes:   None.
+
+   LIB_API
+   void PayloadWriter_BeginResponseMessage(PayloadWriter* pWriter, char* pBuffer, size_t nBufferSize, ECommandCode eCode);
+   // Starts a response message in the selected codec
+   // Inputs:  pBuffer     - buffer to write into
+   //          nBufferSize - size of pBuffer, including room for the NULL
+   //          eCode       - code of the command being answered
+   // Outputs: pWriter - positioned after the command code
+   // Returns: None.
+   // Notes:   For responses too long for one payload.
+
+   LIB_API
+   void PayloadWriter_Bytes(PayloadWriter* pWriter, const char* pBytes, size_t nLength);
+   // Appends raw bytes
+   // Inputs:  pBytes  - data to append
+   //          nLength - number of bytes in pBytes
+   // Outputs: pWriter - payload, length and checksum updated
+   // Returns: None.
+   // Notes:   Data that does not fit is dropped and bOverflow is set.
+
+   LIB_API
+   void PayloadWriter_Char(PayloadWriter* pWriter, char ch);
+   // Appends a single character
+   // Inputs:  ch - character to append
+   // Outputs: pWriter - payload, length and checksum updated
+   // Returns: None.
+   // Notes:   None.
+
+   LIB_API
+   void PayloadWriter_String(PayloadWriter* pWriter, const char* pszValue);
+   // Appends a NULL terminated string
+   // Inputs:  pszValue - string to append, NULL appends nothing
+   // Outputs: pWriter - payload, length and checksum updated
+   // Returns: None.
+   // Notes:   None.
+
+   LIB_API
+   void PayloadWriter_Int(PayloadWriter* pWriter, int nValue);
+   // Appends an integer in decimal, same as "%d"
+   // Inputs:  nValue - value to append
+   // Outputs: pWriter - payload, length and checksum updated
+   // Returns: None.
+   // Notes:   None.
+
+   LIB_API
+   void PayloadWriter_Hex(PayloadWriter* pWriter, unsigned int nValue);
+   // Appends an integer in upper case hex, same as "%X"
+   // Inputs:  nValue - value to append
+   // Outputs: pWriter - payload, length and checksum updated
+   // Returns: None.
+   // Notes:   None.
+
+   LIB_API
+   void PayloadWriter_Float(PayloadWriter* pWriter, float dValue);
+   // Appends a float, same as "%f"
+   // Inputs:  dValue - value to append
+   // Outputs: pWriter - payload, length and checksum updated
+   // Returns: None.
+   // Notes:   None.
+
+   LIB_API
+   void PayloadWriter_Tag(PayloadWriter* pWriter, const char* pszTag);
+   // Appends the start of a parameter, ",TAG="
+   // Inputs:  pszTag - parameter tag
+   // Outputs: pWriter - payload, length and checksum updated
+   // Returns: None.
+   // Notes:   The value is written with one of the calls above.
+
+   LIB_API
+   void PayloadWriter_IntParam(PayloadWriter* pWriter, const char* pszTag, int nValue);
+   // Appends an integer parameter, ",TAG=n"
+   // Inputs:  pszTag - parameter tag
+   //          nValue - parameter value
+   // Outputs: pWriter - payload, length and checksum updated
+   // Returns: None.
+   // Notes:   Binary payloads get an integer record.
+
+   LIB_API
+   void PayloadWriter_StringParam(PayloadWriter* pWriter, const char* pszTag, const char* pszValue);
+   // Appends a string parameter, ",TAG=value"
+   // Inputs:  pszTag   - parameter tag
+   //          pszValue - parameter value
+   // Outputs: pWriter - payload, length and checksum updated
+   // Returns: None.
+   // Notes:   Binary payloads get a record holding the string bytes.
+
+   LIB_API
+   void PayloadWriter_FloatParam(PayloadWriter* pWriter, const char* pszTag, float dValue);
+   // Appends a float parameter, ",TAG=%f"
+   // Inputs:  pszTag - parameter tag
+   //          dValue - parameter value
+   // Outputs: pWriter - payload, length and checksum updated
+   // Returns: None.
+   // Notes:   Binary payloads get the 4 byte IEEE value, little endian.
+
+   LIB_API
+   void PayloadWriter_VersionParam(PayloadWriter* pWriter, const char* pszTag, const FirmwareVersion* pVersion);
+   // Appends a firmware version parameter, ",TAG=%X.%X.%X"
+   // Inputs:  pszTag   - parameter tag
+   //          pVersion - firmware version
+   // Outputs: pWriter - payload, length and checksum updated
+   // Returns: None.
+   // Notes:   Binary payloads get a record of three varints.
+
+   LIB_API
+   void PayloadWriter_Value(PayloadWriter* pWriter, int nValue);
+   // Appends an integer without a tag, ",n"
+   // Inputs:  nValue - value to append
+   // Outputs: pWriter - payload, length and checksum updated
+   // Returns: None.
+   // Notes:   Used for the NAK error code.
+
+   LIB_API
+   void PayloadWriter_BeginList(PayloadWriter* pWriter, const char* pszTag);
+   // Starts a list parameter, ",TAG="
+   // Inputs:  pszTag - parameter tag
+   // Outputs: pWriter - ready for the first item
+   // Returns: None.
+   // Notes:   Items are written with PayloadWriter_BeginItem ... EndItem,
+   //          the list is closed with PayloadWriter_EndList.
+
+   LIB_API
+   void PayloadWriter_BeginItem(PayloadWriter* pWriter);
+   // Starts a list item, "{" or ",{"
+   // Inputs:  None.
+   // Outputs: pWriter - ready for the first item value
+   // Returns: None.
+   // Notes:   None.
+
+   LIB_API
+   void PayloadWriter_ItemInt(PayloadWriter* pWriter, int nValue);
+   // Appends an integer to the open list item
+   // Inputs:  nValue - value to append
+   // Outputs: pWriter - payload, length and checksum updated
+   // Returns: None.
+   // Notes:   Binary payloads get a zigzag varint.
+
+   LIB_API
+   void PayloadWriter_ItemString(PayloadWriter* pWriter, const char* pszValue);
+   // Appends a string to the open list item
+   // Inputs:  pszValue - value to append
+   // Outputs: pWriter - payload, length and checksum updated
+   // Returns: None.
+   // Notes:   Binary payloads get a length byte and the string bytes.
+
+   LIB_API
+   void PayloadWriter_EndItem(PayloadWriter* pWriter);
+   // Closes the open list item, "}"
+   // Inputs:  None.
+   // Outputs: pWriter - payload, length and checksum updated
+   // Returns: None.
+   // Notes:   A binary list longer than one record carries on in further
+   //          records with the same tag.
+
+   LIB_API
+   void PayloadWriter_EndList(PayloadWriter* pWriter);
+   // Closes the open list parameter
+   // Inputs:  None.
+   // Outputs: pWriter - binary record length filled in
+   // Returns: None.
+   // Notes:   Nothing is written for ASCII payloads.
+
+   LIB_API
+   bool PayloadWriter_End(PayloadWriter* pWriter);
+   // Finishes the payload
+   // Inputs:  pWriter - writer used to build the payload
+   // Outputs: pWriter->pPayload - NULL terminated, nLength and nChecksum set
+   // Returns: true if everything written fit in the payload
+   // Notes:   None.
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif